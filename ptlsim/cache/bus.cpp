@@ -91,6 +91,21 @@ int BusInterconnect::access_fast_path(Controller *controller,
 	return -1;
 }
 
+bool BusInterconnect::warmup(Controller *controller,
+		MemoryRequest *request)
+{
+	bool shared = false;
+
+	/* Broadcast to all other controllers like a bus request */
+	foreach(i, controllers.count()) {
+		Controller *receiver = controllers[i]->controller;
+		if(receiver != controller)
+			shared |= receiver->warmup(this, request);
+	}
+
+	return shared;
+}
+
 void BusInterconnect::annul_request(MemoryRequest *request)
 {
 	foreach(i, controllers.count()) {
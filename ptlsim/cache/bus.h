@@ -97,6 +97,7 @@ class BusInterconnect : public Interconnect
 		void register_controller(Controller *controller);
 		int access_fast_path(Controller *controller,
 				MemoryRequest *request);
+		bool warmup(Controller *controller, MemoryRequest *request);
 		void print_map(ostream& os);
 		void annul_request(MemoryRequest *request);
 		void dump_configuration(YAML::Emitter &out) const;
@@ -44,6 +44,26 @@ namespace Memory{
 	const int REQUEST_POOL_SIZE = 1024;
 	const double REQUEST_POOL_LOW_RATIO = 0.1;
 
+	/*
+	 * Minimum allocations between two garbage collection passes while
+	 * request pool is low
+	 */
+	const int REQUEST_POOL_GC_INTERVAL = 32;
+
+	/*
+	 * Size of per request history ring buffer, must be power of 2
+	 * Only allocated when history is enabled with -mem-req-history
+	 */
+	const int MEM_REQ_HISTORY_SIZE = 256;
+
+	/*
+	 * Memory hierarchy event queue
+	 * Wheel size must be a power of 2, events scheduled further than
+	 * wheel size cycles in future are kept in overflow heap
+	 */
+	const int EVENT_QUEUE_SIZE = 2048;
+	const int EVENT_WHEEL_SIZE = 512;
+
 	/* CPU Controller */
 	const int CPU_CONT_PENDING_REQ_SIZE = 128;
 	const int CPU_CONT_ICACHE_BUF_SIZE = 32;
@@ -61,6 +81,30 @@ namespace Memory{
 	 */
 	const int MEM_BANKS = 64;
 
+	/*
+	 * Stacked DRAM access latency histogram, last bucket counts all
+	 * larger latencies
+	 */
+	const int STACKED_DRAM_HIST_BUCKETS = 32;
+	const int STACKED_DRAM_HIST_BUCKET_CYCLES = 8;
+
+	/*
+	 * 2D mesh interconnect, largest supported mesh and number of low
+	 * address bits that select the same bank of a distributed cache
+	 */
+	const int MESH_MAX_NODES = 64;
+	const int MESH_LINKS = 4 * MESH_MAX_NODES;
+	const int MESH_BANK_LINE_BITS = 6;
+
+	/*
+	 * Split phase bus snoop filter, default associativity and line size
+	 * it tracks. A controller bit vector limits buses with snoop filter to
+	 * 64 controllers.
+	 */
+	const int SNOOP_FILTER_ASSOC = 8;
+	const int SNOOP_FILTER_LINE_BITS = 6;
+	const int SNOOP_FILTER_MAX_CONTROLLERS = 64;
+
 	/* Average wait dealy for retrying (general) */
 	const int AVG_WAIT_DELAY = 12;
 }
@@ -35,11 +35,10 @@
 
 #include <memoryHierarchy.h>
 #include <cacheController.h>
+#include <runtimeCacheLines.h>
 
 #include <machine.h>
 
-//#include <dram.h>
-
 /* Remove following comments to debug this file's code
 
 #ifdef memdebug
@@ -64,7 +63,7 @@ CacheController::CacheController(W8 coreid, const char *name,
 {
     memoryHierarchy_->add_cache_mem_controller(this);
 
-    cacheLines_ = get_cachelines(type);
+    cacheLines_ = create_cachelines(memoryHierarchy_, name, type);
 
     if(!memoryHierarchy_->get_machine().get_option(name, "last_private", isLowestPrivate_)) {
         isLowestPrivate_ = false;
@@ -73,8 +72,6 @@ CacheController::CacheController(W8 coreid, const char *name,
     cacheLineBits_ = cacheLines_->get_line_bits();
     cacheAccessLatency_ = cacheLines_->get_access_latency();
 
-    customDRAM = dramInitializerWrapper();
-
 	cacheLines_->init();
 
     SET_SIGNAL_CB(name, "_Cache_Hit", cacheHit_, &CacheController::cache_hit_cb);
@@ -119,25 +116,23 @@ CacheQueueEntry* CacheController::find_dependency(MemoryRequest *request)
 	W64 requestLineAddress = get_line_address(request);
 
 	CacheQueueEntry* queueEntry;
-	foreach_list_mutable(pendingRequests_.list(), queueEntry, entry,
-			prevEntry) {
+	foreach_indexed_mutable(pendingRequests_, requestLineAddress,
+			queueEntry, i, next_i) {
 
 		if(request == queueEntry->request || queueEntry->annuled)
 			continue;
 
-		if(get_line_address(queueEntry->request) == requestLineAddress) {
-			// Found an entry with same line address, check if other
-			// entry also depends on this entry or not and to
-			// maintain a chain of dependent entries, return the
-			// last entry in the chain
-			while(queueEntry->depends >= 0) {
-                if(pendingRequests_[queueEntry->depends].annuled)
-                    break;
-				queueEntry = &pendingRequests_[queueEntry->depends];
-            }
-
-			return queueEntry;
+		// Found an entry with same line address, check if other
+		// entry also depends on this entry or not and to
+		// maintain a chain of dependent entries, return the
+		// last entry in the chain
+		while(queueEntry->depends >= 0) {
+			if(pendingRequests_[queueEntry->depends].annuled)
+				break;
+			queueEntry = &pendingRequests_[queueEntry->depends];
 		}
+
+		return queueEntry;
 	}
 	return NULL;
 }
@@ -145,8 +140,8 @@ CacheQueueEntry* CacheController::find_dependency(MemoryRequest *request)
 CacheQueueEntry* CacheController::find_match(MemoryRequest *request)
 {
 	CacheQueueEntry* queueEntry;
-	foreach_list_mutable(pendingRequests_.list(), queueEntry, entry,
-			prevEntry) {
+	foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+			queueEntry, i, next_i) {
 		if(request == queueEntry->request)
 			return queueEntry;
 	}
@@ -200,6 +195,7 @@ bool CacheController::handle_interconnect_cb(void *arg)
 		}
 
 		queueEntry->request = msg->request;
+		pendingRequests_.index(queueEntry, get_line_address(msg->request));
 		queueEntry->sender = sender;
 		queueEntry->source = (Controller*)msg->origin;
 		queueEntry->dest = (Controller*)msg->dest;
@@ -315,6 +311,8 @@ bool CacheController::handle_interconnect_cb(void *arg)
 					}
 
 					newEntry->request = msg->request;
+					pendingRequests_.index(newEntry,
+							get_line_address(msg->request));
 					newEntry->sender = sender;
 					newEntry->source = (Controller*)msg->origin;
 					newEntry->dest = (Controller*)msg->dest;
@@ -391,6 +389,47 @@ int CacheController::access_fast_path(Interconnect *interconnect,
 	return -1;
 }
 
+/**
+ * @brief Functional warmup of cache line for a request
+ *
+ * @param interconnect Interconnect that sent the request
+ * @param request Memory Request
+ *
+ * @return Always false as this cache has no coherence
+ *
+ * Misses and write-through writes are passed to lower interconnect.
+ */
+bool CacheController::warmup(Interconnect *interconnect,
+		MemoryRequest *request)
+{
+	if(interconnect != NULL && interconnect == lowerInterconnect_)
+		return false;
+
+	CacheLine *line = cacheLines_->probe(request);
+	bool is_write = (request->get_type() == MEMORY_OP_WRITE);
+
+	if(line && line->state) {
+		if(!is_write)
+			return false;
+
+		if(wt_disabled_) {
+			line->state = LINE_MODIFIED;
+			return false;
+		}
+	} else {
+		W64 oldTag = InvalidTag<W64>::INVALID;
+		line = cacheLines_->insert(request, oldTag);
+		line->state = (is_write && wt_disabled_) ? LINE_MODIFIED :
+			LINE_VALID;
+		line->init(cacheLines_->tagOf(request->get_physical_address()));
+	}
+
+	if(lowerInterconnect_)
+		lowerInterconnect_->warmup(this, request);
+
+	return false;
+}
+
 void CacheController::register_interconnect(Interconnect *interconnect,
         int type)
 {
@@ -551,17 +590,6 @@ bool CacheController::cache_access_cb(void *arg)
         //			hit = true;
 
 		OP_TYPE type = queueEntry->request->get_type();
-
-
-		int customDRAMLatency = 0;
-		target_ulong paddr = queueEntry->request->get_physical_address();
-		if(type == MEMORY_OP_READ || type == MEMORY_OP_WRITE){
-			customDRAMLatency = getCustomDRAMLatencyWrapper(customDRAM, paddr, CustomRead);
-		} else if(type == MEMORY_OP_UPDATE){
-			customDRAMLatency = getCustomDRAMLatencyWrapper(customDRAM, paddr, CustomWrite);
-		}
-
-
 		bool kernel_req = queueEntry->request->is_kernel();
 		Signal *signal = NULL;
 		int delay;
@@ -786,9 +814,11 @@ bool CacheController::clear_entry_cb(void *arg)
 			}
 
 			// make sure that no pending entry will wake up the removed entry (in the case of annuled)
+			// dependency chains only link entries of same line address
 			int removed_idx = queueEntry->idx;
 			CacheQueueEntry *tmpEntry;
-			foreach_list_mutable(pendingRequests_.list(), tmpEntry, entry, nextentry) {
+			foreach_indexed_mutable(pendingRequests_,
+					pendingRequests_.key(queueEntry), tmpEntry, i, next_i) {
 				if(tmpEntry->depends == removed_idx) {
 					tmpEntry->depends = -1;
 					tmpEntry->dependsAddr = -1;
@@ -811,9 +841,11 @@ bool CacheController::clear_entry_cb(void *arg)
 
 void CacheController::annul_request(MemoryRequest *request)
 {
+	/* Matching entries have same physical address, so only entries of
+	 * same line are checked */
 	CacheQueueEntry *queueEntry;
-	foreach_list_mutable(pendingRequests_.list(), queueEntry,
-			entry, nextentry) {
+	foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+			queueEntry, i, next_i) {
 		if(queueEntry->request->is_same(request)) {
             queueEntry->eventFlags.reset();
             clear_entry_cb(queueEntry);
@@ -847,6 +879,7 @@ bool CacheController::send_update_message(CacheQueueEntry *queueEntry,
 	}
 
 	new_entry->request = request;
+	pendingRequests_.index(new_entry, get_line_address(request));
 	new_entry->sender = NULL;
 	new_entry->sendTo = lowerInterconnect_;
 	request->incRefCounter();
@@ -887,6 +920,7 @@ void CacheController::do_prefetch(MemoryRequest *request, int additional_delay)
 	assert(new_entry);
 
 	new_entry->request = new_request;
+	pendingRequests_.index(new_entry, get_line_address(new_request));
 	new_entry->sender = NULL;
 	new_entry->sendTo = lowerInterconnect_;
 	new_entry->prefetch = true;
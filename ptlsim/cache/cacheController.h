@@ -35,11 +35,10 @@
 #include <cacheConstants.h>
 #include <memoryStats.h>
 #include <cacheLines.h>
+#include <mshrIndex.h>
 
 #include <statsBuilder.h>
 
-#include <dram.h>
-
 namespace Memory {
 
 enum CacheLineState {
@@ -147,10 +146,8 @@ class CacheController : public Controller
 		// Cache Access Latency
 		int cacheAccessLatency_;
 
-		Dram *customDRAM;
-
 		// A Queue conatining pending requests for this cache
-		FixStateList<CacheQueueEntry, 128> pendingRequests_;
+		IndexedStateList<CacheQueueEntry, 128> pendingRequests_;
 
 		// Flag to indicate if this cache is lowest private
 		// level cache
@@ -207,6 +204,7 @@ class CacheController : public Controller
 		bool handle_interconnect_cb(void *arg);
 		int access_fast_path(Interconnect *interconnect,
 				MemoryRequest *request);
+		bool warmup(Interconnect *interconnect, MemoryRequest *request);
 
 		void register_interconnect(Interconnect *interconnect, int type);
 		void register_upper_interconnect(Interconnect *interconnect);
@@ -249,14 +247,6 @@ class CacheController : public Controller
 			return false;
 		}
 
-		Dram *dramInitializerWrapper() {
-			return dramInitializer();
-		}
-
-		int getCustomDRAMLatencyWrapper(Dram *d, target_ulong paddr, MemAccessType type){
-			return getCustomDRAMLatency(d, paddr, type);
-		}
-
 		void print_map(ostream& os)
 		{
 			os << "Cache-Controller: " << get_name() << endl;
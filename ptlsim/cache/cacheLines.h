@@ -74,6 +74,7 @@ namespace Memory {
     struct CacheLinesBase
     {
         public:
+            virtual ~CacheLinesBase() {}
             virtual void init()=0;
             virtual W64 tagOf(W64 address)=0;
             virtual int latency() const =0;
@@ -89,6 +90,8 @@ namespace Memory {
 			virtual int get_set_count() const=0;
 			virtual int get_way_count() const=0;
 			virtual int get_line_size() const=0;
+			virtual int get_read_ports() const=0;
+			virtual int get_write_ports() const=0;
     };
 
     template <int SET_COUNT, int WAY_COUNT, int LINE_SIZE, int LATENCY>
@@ -163,6 +166,14 @@ namespace Memory {
             int get_access_latency() const {
                 return LATENCY;
             }
+
+            int get_read_ports() const {
+                return readPorts_;
+            }
+
+            int get_write_ports() const {
+                return writePorts_;
+            }
     };
 
     template <int SET_COUNT, int WAY_COUNT, int LINE_SIZE, int LATENCY>
@@ -66,6 +66,20 @@ namespace Memory {
                 virtual void invalidate_line(CacheLine *line)              = 0;
                 virtual void handle_response(CacheQueueEntry *entry,
                         Message &message) = 0;
+
+                /*
+                 * Functional warmup (-fast-fwd-warmup), see
+                 * CacheController::warmup():
+                 * warmup_hit() returns true if a local access is done in
+                 * this cache, otherwise it is sent to lower level and
+                 * warmup_fill() sets the line's new state.
+                 * warmup_snoop() updates the line for a peer's access and
+                 * returns true if the line was valid.
+                 */
+                virtual bool warmup_hit(CacheLine *line, bool is_write)    = 0;
+                virtual void warmup_fill(CacheLine *line, bool is_write,
+                        bool isShared)                                     = 0;
+                virtual bool warmup_snoop(CacheLine *line, bool is_write)  = 0;
 				virtual void dump_configuration(YAML::Emitter &out) const = 0;
 
                 CacheController* controller;
@@ -36,11 +36,10 @@
 #include <memoryHierarchy.h>
 #include <coherentCache.h>
 #include <mesiLogic.h>
+#include <runtimeCacheLines.h>
 
 #include <machine.h>
 
-#define useCustomDRAM 1 // 0: default impl, 1: use custom dram delay
-
 using namespace Memory;
 using namespace Memory::CoherentCache;
 
@@ -57,9 +56,7 @@ CacheController::CacheController(W8 coreid, const char *name,
     memoryHierarchy_->add_cache_mem_controller(this);
     new_stats = new MESIStats(name, &memoryHierarchy->get_machine());
 
-    customDRAM = dramInitializerWrapper(); // initianlize DRAM
-
-    cacheLines_ = get_cachelines(type);
+    cacheLines_ = create_cachelines(memoryHierarchy_, name, type);
 
     if(!memoryHierarchy_->get_machine().get_option(name, "last_private", isLowestPrivate_)) {
         isLowestPrivate_ = false;
@@ -103,24 +100,22 @@ CacheQueueEntry* CacheController::find_dependency(MemoryRequest *request)
     W64 requestLineAddress = get_line_address(request);
 
     CacheQueueEntry* queueEntry;
-    foreach_list_mutable(pendingRequests_.list(), queueEntry, entry,
-            prevEntry) {
+    foreach_indexed_mutable(pendingRequests_, requestLineAddress,
+            queueEntry, i, next_i) {
 
         if(request == queueEntry->request || queueEntry->annuled)
             continue;
 
-        if(get_line_address(queueEntry->request) == requestLineAddress) {
-            /*
-             * Found an entry with same line address, check if other
-             * entry also depends on this entry or not and to
-             * maintain a chain of dependent entries, return the
-             * last entry in the chain
-             */
-            while(queueEntry->depends >= 0)
-                queueEntry = &pendingRequests_[queueEntry->depends];
+        /*
+         * Found an entry with same line address, check if other
+         * entry also depends on this entry or not and to
+         * maintain a chain of dependent entries, return the
+         * last entry in the chain
+         */
+        while(queueEntry->depends >= 0)
+            queueEntry = &pendingRequests_[queueEntry->depends];
 
-            return queueEntry;
-        }
+        return queueEntry;
     }
     return NULL;
 }
@@ -131,23 +126,15 @@ bool CacheController::is_line_in_use(W64 tag)
         return false;
     }
 
-    /* Check each local cache request for same line tag */
-    CacheQueueEntry* queueEntry;
-    foreach_list_mutable(pendingRequests_.list(), queueEntry, entry,
-            prevEntry) {
-        if (get_line_address(queueEntry->request) == tag) {
-            return true;
-        }
-    }
-
-    return false;
+    /* Check if any local cache request has same line tag */
+    return pendingRequests_.contains(tag);
 }
 
 CacheQueueEntry* CacheController::find_match(MemoryRequest *request)
 {
     CacheQueueEntry* queueEntry;
-    foreach_list_mutable(pendingRequests_.list(), queueEntry, entry,
-            prevEntry) {
+    foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+            queueEntry, i, next_i) {
         if(request == queueEntry->request)
             return queueEntry;
     }
@@ -181,6 +168,7 @@ bool CacheController::handle_upper_interconnect(Message &message)
     }
 
     queueEntry->request = message.request;
+    pendingRequests_.index(queueEntry, get_line_address(message.request));
     queueEntry->sender  = (Interconnect*)message.sender;
     queueEntry->isSnoop = false;
     queueEntry->m_arg   = message.arg;
@@ -216,6 +204,19 @@ bool CacheController::handle_upper_interconnect(Message &message)
     return true;
 }
 
+/**
+ * @brief Count coherence message that arrives after this cache's core was
+ * simulated past the cycle of the message in -sync-quantum mode
+ *
+ * @param message Snoop or eviction message from lower interconnect
+ */
+void CacheController::check_late_coherence(Message &message)
+{
+    if(is_private() && memoryHierarchy_->is_late_message(idx))
+        N_STAT_UPDATE(new_stats->late_coherence, ++,
+                message.request->is_kernel());
+}
+
 bool CacheController::handle_lower_interconnect(Message &message)
 {
     memdebug(get_name() <<
@@ -243,9 +244,12 @@ bool CacheController::handle_lower_interconnect(Message &message)
         if (message.hasData)
             return true;
 
+        check_late_coherence(message);
+
         CacheQueueEntry *newEntry = pendingRequests_.alloc();
         assert(newEntry);
         newEntry->request = message.request;
+        pendingRequests_.index(newEntry, get_line_address(message.request));
         newEntry->isSnoop = true;
         newEntry->sender  = (Interconnect*)message.sender;
         newEntry->source  = (Controller*)message.origin;
@@ -261,11 +265,15 @@ bool CacheController::handle_lower_interconnect(Message &message)
             /* check if request is cache eviction */
             if(message.request->get_type() == MEMORY_OP_EVICT ||
                     message.request->get_type() == MEMORY_OP_UPDATE) {
+                check_late_coherence(message);
+
                 /* alloc new queueentry and evict the cache line if present */
                 CacheQueueEntry *evictEntry = pendingRequests_.alloc();
                 assert(evictEntry);
 
                 evictEntry->request = message.request;
+                pendingRequests_.index(evictEntry,
+                        get_line_address(message.request));
                 evictEntry->request->incRefCounter();
                 evictEntry->isSnoop = true;
                 evictEntry->m_arg   = message.arg;
@@ -308,6 +316,7 @@ void CacheController::send_message(CacheQueueEntry *queueEntry,
     }
 
     evictEntry->request = request;
+    pendingRequests_.index(evictEntry, get_line_address(request));
     evictEntry->sender  = NULL;
     evictEntry->sendTo  = interconn;
     evictEntry->dest    = queueEntry->dest;
@@ -445,6 +454,83 @@ int CacheController::access_fast_path(Interconnect *interconnect,
     return -1;
 }
 
+/**
+ * @brief Functional warmup of cache line for a request
+ *
+ * @param interconnect Interconnect that sent the request
+ * @param request Memory Request
+ *
+ * @return true if line is shared with another cache
+ *
+ * Request from lower interconnect is a snoop of a peer cache's access,
+ * others are local accesses. Local access that can't be completed in this
+ * cache goes to Global Directory or lower interconnect, same as a miss,
+ * and its response decides the new line state. Write backs of evicted
+ * dirty lines are not modeled.
+ */
+bool CacheController::warmup(Interconnect *interconnect,
+        MemoryRequest *request)
+{
+    CacheLine *line = cacheLines_->probe(request);
+
+    if (interconnect != NULL && interconnect == lowerInterconnect_) {
+        bool invalidate = (request->get_type() != MEMORY_OP_READ);
+
+        if (!line)
+            return false;
+
+        bool shared = coherence_logic_->warmup_snoop(line, invalidate);
+
+        if (invalidate && is_lowest_private())
+            warmup_upper(request);
+
+        return shared;
+    }
+
+    bool is_write = (request->get_type() == MEMORY_OP_WRITE);
+
+    if (!line) {
+        W64 oldTag = InvalidTag<W64>::INVALID;
+        line = cacheLines_->insert(request, oldTag);
+
+        if (oldTag != InvalidTag<W64>::INVALID && is_line_valid(line) &&
+                is_lowest_private()) {
+            /* Remove replaced line from upper caches */
+            MemoryRequest evict;
+            evict.init(request);
+            evict.set_physical_address(oldTag);
+            evict.set_op_type(MEMORY_OP_EVICT);
+            warmup_upper(&evict);
+        }
+
+        coherence_logic_->invalidate_line(line);
+        line->init(cacheLines_->tagOf(request->get_physical_address()));
+    }
+
+    if (coherence_logic_->warmup_hit(line, is_write))
+        return false;
+
+    bool shared = false;
+
+    if (directory_)
+        shared = directory_->warmup(lowerInterconnect_, request);
+    else if (lowerInterconnect_)
+        shared = lowerInterconnect_->warmup(this, request);
+
+    coherence_logic_->warmup_fill(line, is_write, shared);
+
+    return shared;
+}
+
+void CacheController::warmup_upper(MemoryRequest *request)
+{
+    if (upperInterconnect_)
+        upperInterconnect_->warmup(this, request);
+
+    if (upperInterconnect2_)
+        upperInterconnect2_->warmup(this, request);
+}
+
 void CacheController::print_map(ostream& os)
 {
     os << "Cache-Controller: " << get_name() << endl;
@@ -680,21 +766,6 @@ bool CacheController::cache_access_cb(void *arg)
                         kernel_req);
         }
       }
-
-
-      if (useCustomDRAM) {
-        int customDRAMLatency = 0;
-        target_ulong paddr = queueEntry->request->get_physical_address();
-        if (type == MEMORY_OP_READ || type == MEMORY_OP_WRITE) {
-          customDRAMLatency = getCustomDRAMLatencyWrapper(customDRAM, paddr, CustomRead);
-        } else if (type == MEMORY_OP_UPDATE) {
-          customDRAMLatency = getCustomDRAMLatencyWrapper(customDRAM, paddr, CustomWrite);
-        }
-
-        delay = customDRAMLatency;
-      }
-
-
     }
     marss_add_event(signal, delay,
                     (void *) queueEntry);
@@ -848,9 +919,11 @@ bool CacheController::clear_entry_cb(void *arg)
 
 void CacheController::annul_request(MemoryRequest *request)
 {
+    /* Matching entries have same physical address, so only entries of
+     * same line are checked */
     CacheQueueEntry *queueEntry;
-    foreach_list_mutable(pendingRequests_.list(), queueEntry,
-            entry, nextentry) {
+    foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+            queueEntry, i, next_i) {
         if (queueEntry->request->is_same(request)) {
             queueEntry->annuled = true;
             /* Fix dependency chain if this entry was waiting for
@@ -36,8 +36,7 @@
 #include <memoryStats.h>
 #include <statsBuilder.h>
 #include <cacheLines.h>
-
-#include <dram.h>
+#include <mshrIndex.h>
 
 namespace Memory {
 
@@ -168,16 +167,15 @@ namespace Memory {
                 CacheType       type_;
                 CacheLinesBase *cacheLines_;
 
-		Dram *customDRAM;
-
-// No of bits needed to find Cache Line address
+                // No of bits needed to find Cache Line address
                 int cacheLineBits_;
 
                 // Cache Access Latency
                 int cacheAccessLatency_;
 
-                // A Queue conatining pending requests for this cache
-                FixStateList<CacheQueueEntry, 256> pendingRequests_;
+                // A Queue conatining pending requests for this cache,
+                // indexed on cache line address
+                IndexedStateList<CacheQueueEntry, 256> pendingRequests_;
 
                 // Flag to indicate if this cache is lowest private
                 // level cache
@@ -223,6 +221,8 @@ namespace Memory {
 
                 bool handle_lower_interconnect(Message &message);
 
+                void check_late_coherence(Message &message);
+
                 void handle_cache_insert(CacheQueueEntry *queueEntry,
                         W64 oldTag);
                 bool is_line_valid(CacheLine *line);
@@ -233,6 +233,8 @@ namespace Memory {
 
                 void get_directory(Interconnect *interconn);
 
+                void warmup_upper(MemoryRequest *request);
+
             public:
                 CacheController(W8 coreid, const char *name,
                         MemoryHierarchy *memoryHierarchy, CacheType type);
@@ -240,6 +242,8 @@ namespace Memory {
                 bool handle_interconnect_cb(void *arg);
                 int access_fast_path(Interconnect *interconnect,
                         MemoryRequest *request);
+                bool warmup(Interconnect *interconnect,
+                        MemoryRequest *request);
                 void print_map(ostream& os);
 
                 void register_interconnect(Interconnect *interconnect, int type);
@@ -306,16 +310,9 @@ namespace Memory {
                 Interconnect* get_lower_intrconn() { return lowerInterconnect_;}
                 Controller* get_directory() { return directory_; }
 				Controller* get_lower_cont() { return lowerCont_; }
+                /* Caller sets the request of returned entry, entry is
+                 * not visible to line address lookups */
                 CacheQueueEntry* get_new_queue_entry();
-
-		Dram *dramInitializerWrapper() {
-			return dramInitializer();
-		}
-
-		int getCustomDRAMLatencyWrapper(Dram *d, target_ulong paddr, MemAccessType type){
-			return getCustomDRAMLatency(d, paddr, type);
-		}
-
         };
 
     };
@@ -110,6 +110,15 @@ class Controller
 		virtual bool handle_interconnect_cb(void* arg)=0;
 		virtual int access_fast_path(Interconnect *interconnect,
 				MemoryRequest *request) { return -1; };
+		/*
+		 * Functional warmup (-fast-fwd-warmup): update cache lines and
+		 * coherence state for request without delay, messages or stats.
+		 * Request from 'interconnect' is a local access if it comes from
+		 * upper level and a snoop if it comes from lower level. Returns
+		 * true if the line is shared with another cache.
+		 */
+		virtual bool warmup(Interconnect *interconnect,
+				MemoryRequest *request) { return false; }
         virtual void register_interconnect(Interconnect* interconnect,
                 int conn_type)=0;
 		virtual void print_map(ostream& os)=0;
@@ -81,7 +81,8 @@ bool CPUController::handle_interconnect_cb(void *arg)
 CPUControllerQueueEntry* CPUController::find_entry(MemoryRequest *request)
 {
 	CPUControllerQueueEntry* entry;
-	foreach_list_mutable(pendingRequests_.list(), entry, entry_t, prev_t) {
+	foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+			entry, i, next_i) {
 		if(entry->request == request)
 			return entry;
 	}
@@ -90,9 +91,11 @@ CPUControllerQueueEntry* CPUController::find_entry(MemoryRequest *request)
 
 void CPUController::annul_request(MemoryRequest *request)
 {
+	/* Matching entries have same physical address, so only entries of
+	 * same line are checked */
 	CPUControllerQueueEntry *entry;
-	foreach_list_mutable(pendingRequests_.list(), entry,
-			entry_t, nextentry_t) {
+	foreach_indexed_mutable(pendingRequests_, get_line_address(request),
+			entry, i, next_i) {
 		if(entry->request->is_same(request)) {
 			entry->annuled = true;
 			entry->request->decRefCounter();
@@ -137,14 +140,10 @@ bool CPUController::is_icache_buffer_hit(MemoryRequest *request)
 
 	memdebug("ICache Line Address is : ", lineAddress, endl);
 
-	CPUControllerBufferEntry* entry;
-	foreach_list_mutable(icacheBuffer_.list(), entry, entry_t,
-			prev_t) {
-		if(entry->lineAddress == lineAddress) {
-			N_STAT_UPDATE(stats.cpurequest.count.hit.read.hit, ++, request->is_kernel());
-            N_STAT_UPDATE(stats.icache_latency, [1]++, request->is_kernel());
-			return true;
-		}
+	if(icacheBuffer_.contains(lineAddress)) {
+		N_STAT_UPDATE(stats.cpurequest.count.hit.read.hit, ++, request->is_kernel());
+		N_STAT_UPDATE(stats.icache_latency, [1]++, request->is_kernel());
+		return true;
 	}
 
 	N_STAT_UPDATE(stats.cpurequest.count.miss.read, ++, request->is_kernel());
@@ -198,6 +197,7 @@ int CPUController::access_fast_path(Interconnect *interconnect,
 	}
 
 	queueEntry->request = request;
+	pendingRequests_.index(queueEntry, get_line_address(request));
 
 	if(dependentEntry &&
 			dependentEntry->request->get_type() == request->get_type()) {
@@ -232,6 +232,19 @@ int CPUController::access_fast_path(Interconnect *interconnect,
 	return -1;
 }
 
+bool CPUController::warmup(Interconnect *interconnect,
+		MemoryRequest *request)
+{
+	/* Only requests from CPU are passed to L1 caches */
+	if(interconnect != NULL)
+		return false;
+
+	if(request->is_instruction())
+		return int_L1_i_->warmup(this, request);
+
+	return int_L1_d_->warmup(this, request);
+}
+
 bool CPUController::is_cache_availabe(bool is_icache)
 {
 	assert(0);
@@ -244,27 +257,24 @@ CPUControllerQueueEntry* CPUController::find_dependency(
 	W64 requestLineAddr = get_line_address(request);
 
 	CPUControllerQueueEntry* queueEntry;
-	foreach_list_mutable(pendingRequests_.list(), queueEntry, entry_t,
-			prev_t) {
+	foreach_indexed_mutable(pendingRequests_, requestLineAddr, queueEntry,
+			i, next_i) {
 		assert(queueEntry);
 		if unlikely (request == queueEntry->request)
 			continue;
 
-		if(get_line_address(queueEntry->request) == requestLineAddr) {
-
-            /*
-             * The dependency is handled as chained, so all the
-             * entries maintain an index to their next dependent
-             * entry. Find the last entry of the chain which has
-             * the depends value set to -1 and return that entry
-             */
+        /*
+         * The dependency is handled as chained, so all the
+         * entries maintain an index to their next dependent
+         * entry. Find the last entry of the chain which has
+         * the depends value set to -1 and return that entry
+         */
 
-			CPUControllerQueueEntry *retEntry = queueEntry;
-			while(retEntry->depends >= 0) {
-				retEntry = &pendingRequests_[retEntry->depends];
-			}
-			return retEntry;
+		CPUControllerQueueEntry *retEntry = queueEntry;
+		while(retEntry->depends >= 0) {
+			retEntry = &pendingRequests_[retEntry->depends];
 		}
+		return retEntry;
 	}
 	return NULL;
 }
@@ -309,6 +319,7 @@ void CPUController::finalize_request(CPUControllerQueueEntry *queueEntry)
 		}
 		CPUControllerBufferEntry *bufEntry = icacheBuffer_.alloc();
 		bufEntry->lineAddress = lineAddress;
+		icacheBuffer_.index(bufEntry, lineAddress);
         N_STAT_UPDATE(stats.icache_latency, [req_latency]++, kernel_req);
 	} else {
         N_STAT_UPDATE(stats.dcache_latency, [req_latency]++, kernel_req);
@@ -382,6 +393,7 @@ bool CPUController::queue_access_cb(void *arg)
 	}
 
 	queueEntry->request = request;
+	pendingRequests_.index(queueEntry, get_line_address(request));
 
 	CPUControllerQueueEntry *dependentEntry = find_dependency(request);
 
@@ -431,6 +443,33 @@ void CPUController::clock()
 	}
 }
 
+/* Return cycle in which clock() will finalize next pending entry, or -1
+ * if no entry is counting down */
+W64 CPUController::get_next_finalize_cycle()
+{
+	W64 next_cycle = W64(-1);
+	CPUControllerQueueEntry* queueEntry;
+	foreach_list_mutable(pendingRequests_.list(), queueEntry, entry_t,
+			prev_t) {
+		if(queueEntry->cycles > 0)
+			next_cycle = min(next_cycle,
+					sim_cycle + queueEntry->cycles - 1);
+	}
+	return next_cycle;
+}
+
+/* Same as calling clock() for given number of cycles in which no entry
+ * reaches zero */
+void CPUController::skip_cycles(int cycles)
+{
+	CPUControllerQueueEntry* queueEntry;
+	foreach_list_mutable(pendingRequests_.list(), queueEntry, entry_t,
+			prev_t) {
+		assert(queueEntry->cycles <= 0 || queueEntry->cycles > cycles);
+		queueEntry->cycles -= cycles;
+	}
+}
+
 void CPUController::print(ostream& os) const
 {
 	os << "---CPU-Controller: "<< get_name()<< endl;
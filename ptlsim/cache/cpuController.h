@@ -32,6 +32,7 @@
 #include <interconnect.h>
 #include <superstl.h>
 #include <memoryStats.h>
+#include <mshrIndex.h>
 //#include <logic.h>
 
 namespace Memory {
@@ -114,9 +115,10 @@ class CPUController : public Controller
         // Stats Objects
         CPUControllerStats stats;
 
-		FixStateList<CPUControllerQueueEntry, \
+		/* Pending requests and icache buffer are indexed on line address */
+		IndexedStateList<CPUControllerQueueEntry, \
 			CPU_CONT_PENDING_REQ_SIZE> pendingRequests_;
-		FixStateList<CPUControllerBufferEntry, \
+		IndexedStateList<CPUControllerBufferEntry, \
 			CPU_CONT_ICACHE_BUF_SIZE> icacheBuffer_;
 
 		bool is_icache_buffer_hit(MemoryRequest *request) ;
@@ -145,7 +147,11 @@ class CPUController : public Controller
 
 		int access_fast_path(Interconnect *interconnect,
 				MemoryRequest *request);
+		bool warmup(Interconnect *interconnect, MemoryRequest *request);
 		void clock();
+		W64 get_next_finalize_cycle();
+		void skip_cycles(int cycles);
+		int get_pending_count() const { return pendingRequests_.count(); }
         void register_interconnect(Interconnect *interconnect, int type);
 		void register_interconnect_L1_d(Interconnect *interconnect);
 		void register_interconnect_L1_i(Interconnect *interconnect);
@@ -0,0 +1,199 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#include <directoryBank.h>
+
+using namespace Memory;
+
+static W16 line_bits = log2(DIR_LINE_SIZE);
+
+static W64 get_line_addr(W64 addr)
+{
+    return addr >> line_bits;
+}
+
+/**
+ * @brief Reset the directory entry
+ */
+void DirectoryEntry::reset()
+{
+    present.reset();
+    tag   = -1;
+    owner = -1;
+    dirty = 0;
+	locked = 0;
+}
+
+void DirectoryEntry::init(W64 tag_)
+{
+    tag   = tag_;
+    dirty = 0;
+    owner = -1;
+	locked = 0;
+    present.reset();
+}
+
+Directory* Directory::banks_[DIR_MAX_BANKS] = {0};
+int Directory::numBanks_ = 0;
+
+Directory::Directory(int sets, int ways, int latency, int ports)
+    : sets_(sets)
+    , ways_(ways)
+    , latency_(latency)
+    , ports_(ports)
+    , useClock_(0)
+{
+    assert(sets > 0 && ways > 0);
+    assert(latency >= 0 && ports >= 0);
+
+    entries_ = new DirectoryEntry[sets * ways];
+    lastUse_ = new W64[sets * ways];
+    portFree_ = new W64[ports + 1];
+
+    foreach (i, sets * ways) {
+        lastUse_[i] = 0;
+    }
+
+    foreach (i, ports + 1) {
+        portFree_[i] = 0;
+    }
+}
+
+Directory::~Directory()
+{
+    remove_bank(this);
+
+    delete [] entries_;
+    delete [] lastUse_;
+    delete [] portFree_;
+}
+
+int Directory::add_bank(Directory *bank)
+{
+    assert(numBanks_ < DIR_MAX_BANKS);
+    banks_[numBanks_] = bank;
+    return numBanks_++;
+}
+
+void Directory::remove_bank(Directory *bank)
+{
+    foreach (i, numBanks_) {
+        if (banks_[i] != bank)
+            continue;
+
+        for (int j = i; j < numBanks_ - 1; j++)
+            banks_[j] = banks_[j + 1];
+        numBanks_--;
+        return;
+    }
+}
+
+int Directory::get_bank_index(W64 addr)
+{
+    assert(numBanks_ > 0);
+    return get_line_addr(addr) % numBanks_;
+}
+
+/* Lines of a bank are the ones with same bank index, so skip its bits */
+DirectoryEntry* Directory::get_set(W64 addr) const
+{
+    W64 set = (get_line_addr(addr) / max(numBanks_, 1)) % sets_;
+    return &entries_[set * ways_];
+}
+
+DirectoryEntry* Directory::probe(W64 addr)
+{
+    W64 tag = tag_of(addr);
+    DirectoryEntry *set = get_set(addr);
+
+    foreach (i, ways_) {
+        if (set[i].tag == tag) {
+            lastUse_[&set[i] - entries_] = ++useClock_;
+            return &set[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* Lower cost entries are replaced first */
+int Directory::victim_cost(const DirectoryEntry &entry) const
+{
+    if (entry.tag == (W64)-1)
+        return 0;
+
+    int sharers = entry.present.popcount();
+    int cost = (sharers) ? (2 + 2 * sharers + entry.dirty) : 1;
+
+    /* Unlocked entries cost at most 3 + 2 * NUM_SIM_CORES */
+    if (entry.locked)
+        cost += 4 + 2 * NUM_SIM_CORES;
+
+    return cost;
+}
+
+DirectoryEntry* Directory::insert(W64 addr, W64 &old_tag)
+{
+    DirectoryEntry *entry = probe(addr);
+
+    if (entry) {
+        old_tag = (W64)-1;
+        return entry;
+    }
+
+    DirectoryEntry *set = get_set(addr);
+    int victim = 0;
+    int best_cost = victim_cost(set[0]);
+
+    for (int i = 1; i < ways_; i++) {
+        int cost = victim_cost(set[i]);
+        int idx = &set[i] - entries_;
+
+        if (cost < best_cost || (cost == best_cost &&
+                    lastUse_[idx] < lastUse_[&set[victim] - entries_])) {
+            victim = i;
+            best_cost = cost;
+        }
+    }
+
+    entry = &set[victim];
+    old_tag = entry->tag;
+    lastUse_[entry - entries_] = ++useClock_;
+
+    return entry;
+}
+
+int Directory::invalidate(W64 addr)
+{
+    DirectoryEntry *entry = probe(addr);
+
+    if (!entry)
+        return 0;
+
+    entry->reset();
+    return 1;
+}
+
+int Directory::access(W64 cycle, int &wait)
+{
+    wait = 0;
+
+    if (ports_ > 0) {
+        int port = 0;
+
+        for (int i = 1; i < ports_; i++) {
+            if (portFree_[i] < portFree_[port])
+                port = i;
+        }
+
+        W64 start = max(cycle, portFree_[port]);
+        portFree_[port] = start + 1;
+        wait = start - cycle;
+    }
+
+    return latency_ + wait;
+}
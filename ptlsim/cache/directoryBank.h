@@ -0,0 +1,120 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef DIRECTORY_BANK_H
+#define DIRECTORY_BANK_H
+
+#include <globals.h>
+#include <superstl.h>
+
+namespace Memory {
+
+#define DIR_LINE_SIZE 64
+
+/* Default size and timing of each directory bank */
+#define DIR_SET 4096
+#define DIR_WAY 16
+#define DIR_ACCESS_DELAY 10
+
+/* Most directory banks, one per directory controller */
+#define DIR_MAX_BANKS 64
+
+/**
+ * @brief A Directory entry containing information for one line
+ */
+struct DirectoryEntry {
+    bitvec<NUM_SIM_CORES> present;
+    bool dirty;
+    W64  tag;
+    W8   owner;
+	bool locked;
+
+    DirectoryEntry() { reset(); }
+    void reset();
+    void init(W64 tag_);
+
+    ostream& print(ostream &os) const {
+        os << "tag:" << (void*)tag << " dirty:" << dirty << " owner:" << owner;
+        os << " present:" << present;
+        return os;
+    }
+};
+
+static inline ostream& operator <<(ostream &os, const DirectoryEntry &e)
+{
+    return e.print(os);
+}
+
+/**
+ * @brief One bank of the sparse directory
+ *
+ * Lines are interleaved across banks on their line address, and each
+ * bank is a set-associative structure whose size, access latency and
+ * number of ports are set at run time. A port starts one access per
+ * cycle; accesses that find all ports used wait in queue for the next
+ * free one.
+ *
+ * On replacement a bank picks the victim that needs the fewest
+ * back-invalidations: a free entry, then an entry with no sharers, then
+ * a clean entry with fewest sharers, oldest first. Locked entries are
+ * replaced only if all ways are locked.
+ */
+class Directory {
+    private:
+        int sets_;
+        int ways_;
+        int latency_;
+        int ports_;
+
+        DirectoryEntry *entries_;
+        W64 *lastUse_;
+        W64 *portFree_;
+        W64 useClock_;
+
+        static Directory *banks_[DIR_MAX_BANKS];
+        static int numBanks_;
+
+        DirectoryEntry *get_set(W64 addr) const;
+        int victim_cost(const DirectoryEntry &entry) const;
+
+    public:
+        /* ports == 0 models unlimited ports */
+        Directory(int sets, int ways, int latency, int ports);
+        ~Directory();
+
+        DirectoryEntry *insert(W64 addr, W64 &old_tag);
+        DirectoryEntry *probe(W64 addr);
+        int             invalidate(W64 addr);
+
+        /**
+         * Reserve a port for an access at 'cycle', returns cycles until the
+         * access completes and sets 'wait' to its queueing delay
+         */
+        int access(W64 cycle, int &wait);
+
+        int get_sets() const { return sets_; }
+        int get_ways() const { return ways_; }
+        int get_latency() const { return latency_; }
+        int get_ports() const { return ports_; }
+
+        static W64 tag_of(W64 addr) {
+            return addr & ~(W64)(DIR_LINE_SIZE - 1);
+        }
+
+        /* Banks, in order of creation */
+        static int add_bank(Directory *bank);
+        static void remove_bank(Directory *bank);
+        static int get_bank_count() { return numBanks_; }
+        static int get_bank_index(W64 addr);
+        static Directory& get_bank(W64 addr) {
+            return *banks_[get_bank_index(addr)];
+        }
+};
+
+};
+
+#endif // DIRECTORY_BANK_H
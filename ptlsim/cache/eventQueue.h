@@ -0,0 +1,477 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Copyright 2009 Avadh Patel <apatel@cs.binghamton.edu>
+ * Copyright 2009 Furat Afram <fafram@cs.binghamton.edu>
+ *
+ */
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <globals.h>
+#include <superstl.h>
+#include <statelist.h>
+
+namespace Memory {
+
+  class Event : public FixStateListObject
+  {
+    private:
+      Signal *signal_;
+      W64    clock_;
+      void   *arg_;
+
+    public:
+      /* Link used by EventWheel buckets and free list */
+      Event  *next_;
+
+      /* Insertion order, used to keep FIFO order among same-clock events */
+      W64    seq_;
+
+      void init() {
+        signal_ = NULL;
+        clock_ = -1;
+        arg_ = NULL;
+        next_ = NULL;
+        seq_ = 0;
+      }
+
+      void setup(Signal *signal, W64 clock, void *arg) {
+        signal_ = signal;
+        clock_ = clock;
+        arg_ = arg;
+      }
+
+      bool execute() {
+        return signal_->emit(arg_);
+      }
+
+      Signal* get_signal() {
+        return signal_;
+      }
+
+      void* get_arg() {
+        return arg_;
+      }
+
+      W64 get_clock() const {
+        return clock_;
+      }
+
+      ostream& print(ostream& os) const {
+        os << "Event< ";
+        if(signal_)
+          os << "Signal:" << signal_->get_name() << " ";
+        os << "Clock:" << clock_ << " ";
+        os << "arg:" << arg_ ;
+        os << ">" << endl, flush;
+        return os;
+      }
+
+      bool operator ==(Event &event) {
+        if(clock_ == event.clock_)
+          return true;
+        return false;
+      }
+
+      bool operator >(Event &event) {
+        if(clock_ > event.clock_)
+          return true;
+        return false;
+      }
+
+      bool operator <(Event &event) {
+        if(clock_ < event.clock_)
+          return true;
+        return false;
+      }
+
+      bool operator >=(Event &event) {
+        if (clock_ >= event.clock_)
+          return true;
+        return false;
+      }
+  };
+
+  static inline ostream& operator <<(ostream& os, const Event& event) {
+    return event.print(os);
+  }
+
+  /*
+   * Execute given event. Signal and argument are read before the caller
+   * releases the event so the slot can be reused by events scheduled from
+   * within the signal handler.
+   */
+  static inline void execute_event(Signal *signal, void *arg)
+  {
+    if (!signal->emit(arg))
+      assert(0);
+  }
+
+  /*
+   * ListEventQueue
+   *
+   * Sorted linked-list scheduler. Every insert walks the queue from the
+   * head to find its slot, so cost grows with number of pending events.
+   * Kept as the reference implementation for EventWheel.
+   */
+  template <int SIZE>
+  class ListEventQueue
+  {
+    private:
+      FixStateList<Event, SIZE> queue_;
+
+      void sort_event(Event *event) {
+        // No need to sort if only 1 event
+        if(queue_.count() == 1)
+          return;
+
+        Event* entryEvent;
+        foreach_list_mutable(queue_.list(), entryEvent, entry, preventry) {
+          if(*event < *entryEvent) {
+            queue_.unlink(event);
+            queue_.insert_after(event, (Event*)(entryEvent->prev));
+            return;
+          }
+        }
+
+        // Entry is already at the tail of queue, keep it there
+      }
+
+    public:
+      void reset() {
+        queue_.reset();
+      }
+
+      void schedule(Signal *signal, W64 clock, void *arg) {
+        Event *event = queue_.alloc();
+        assert(event);
+        event->setup(signal, clock, arg);
+        sort_event(event);
+      }
+
+      void run_until(W64 now) {
+        while(!queue_.empty()) {
+          Event *event = queue_.head();
+          if(event->get_clock() > now)
+            break;
+
+          Signal *signal = event->get_signal();
+          void *arg = event->get_arg();
+          queue_.free(event);
+          execute_event(signal, arg);
+        }
+      }
+
+      int count() const {
+        return queue_.count();
+      }
+
+      bool empty() {
+        return queue_.empty();
+      }
+
+      /* Return clock of earliest pending event or -1 if queue is empty */
+      W64 next_event_clock() {
+        if(queue_.empty())
+          return W64(-1);
+        return queue_.head()->get_clock();
+      }
+
+      ostream& print(ostream& os) const {
+        os << queue_;
+        return os;
+      }
+  };
+
+  /*
+   * EventWheel
+   *
+   * Timing wheel scheduler. Events due within WHEEL_SIZE cycles of the
+   * current cycle are appended to the bucket of their clock, so insert and
+   * pop are O(1). Events due further out are kept in a binary heap ordered
+   * on (clock, seq) and moved into the wheel as it advances. Events of the
+   * same clock execute in the order they were scheduled, which matches
+   * ListEventQueue.
+   */
+  template <int WHEEL_SIZE, int SIZE>
+  class EventWheel
+  {
+    private:
+      struct Bucket {
+        Event *head;
+        Event *tail;
+      };
+
+      Event  pool_[SIZE];
+      Event  *freeList_;
+      Bucket buckets_[WHEEL_SIZE];
+      Event  *heap_[SIZE];
+      int    heapCount_;
+      int    wheelCount_;
+      int    count_;
+      W64    curCycle_;
+      W64    nextSeq_;
+
+      static const W64 WHEEL_MASK = WHEEL_SIZE - 1;
+
+      static bool heap_less(const Event *a, const Event *b) {
+        if(a->get_clock() != b->get_clock())
+          return a->get_clock() < b->get_clock();
+        return a->seq_ < b->seq_;
+      }
+
+      void heap_push(Event *event) {
+        int i = heapCount_++;
+        while(i > 0) {
+          int parent = (i - 1) >> 1;
+          if(!heap_less(event, heap_[parent]))
+            break;
+          heap_[i] = heap_[parent];
+          i = parent;
+        }
+        heap_[i] = event;
+      }
+
+      Event* heap_pop() {
+        Event *top = heap_[0];
+        Event *last = heap_[--heapCount_];
+        int i = 0;
+        while(true) {
+          int child = (i << 1) + 1;
+          if(child >= heapCount_)
+            break;
+          if(child + 1 < heapCount_ &&
+              heap_less(heap_[child + 1], heap_[child]))
+            child++;
+          if(!heap_less(heap_[child], last))
+            break;
+          heap_[i] = heap_[child];
+          i = child;
+        }
+        heap_[i] = last;
+        return top;
+      }
+
+      void bucket_append(Event *event) {
+        bucket_append(event, event->get_clock());
+      }
+
+      void bucket_append(Event *event, W64 clock) {
+        Bucket &bucket = buckets_[clock & WHEEL_MASK];
+        event->next_ = NULL;
+        if(bucket.tail)
+          bucket.tail->next_ = event;
+        else
+          bucket.head = event;
+        bucket.tail = event;
+        wheelCount_++;
+      }
+
+      /* Move heap events that now fall within the wheel window */
+      void migrate() {
+        while(heapCount_ > 0 &&
+            heap_[0]->get_clock() < curCycle_ + WHEEL_SIZE) {
+          bucket_append(heap_pop());
+        }
+      }
+
+      void free_event(Event *event) {
+        event->next_ = freeList_;
+        freeList_ = event;
+        count_--;
+      }
+
+      /* Execute all events in current bucket, including the ones added
+       * to it by executed signals */
+      void drain_bucket() {
+        Bucket &bucket = buckets_[curCycle_ & WHEEL_MASK];
+        while(bucket.head) {
+          Event *event = bucket.head;
+          bucket.head = event->next_;
+          if(!bucket.head)
+            bucket.tail = NULL;
+          wheelCount_--;
+
+          Signal *signal = event->get_signal();
+          void *arg = event->get_arg();
+          free_event(event);
+          execute_event(signal, arg);
+        }
+      }
+
+      /* Execute events of current bucket with clock up to 'now' and keep
+       * the rest in order. Used when a core clocked behind the wheel in
+       * relaxed synchronization mode runs its past due events. */
+      void drain_past_due(W64 now) {
+        Bucket &bucket = buckets_[curCycle_ & WHEEL_MASK];
+        Event *prev = NULL;
+        Event *event = bucket.head;
+        while(event) {
+          if(event->get_clock() > now) {
+            prev = event;
+            event = event->next_;
+            continue;
+          }
+
+          if(prev)
+            prev->next_ = event->next_;
+          else
+            bucket.head = event->next_;
+          if(bucket.tail == event)
+            bucket.tail = prev;
+          wheelCount_--;
+
+          Signal *signal = event->get_signal();
+          void *arg = event->get_arg();
+          free_event(event);
+          execute_event(signal, arg);
+
+          // Signal may have appended events to this bucket
+          event = prev ? prev->next_ : bucket.head;
+        }
+      }
+
+    public:
+      EventWheel() {
+        assert((WHEEL_SIZE & (WHEEL_SIZE - 1)) == 0);
+        reset();
+      }
+
+      void reset() {
+        freeList_ = NULL;
+        for(int i = SIZE - 1; i >= 0; i--) {
+          pool_[i].init();
+          pool_[i].next_ = freeList_;
+          freeList_ = &pool_[i];
+        }
+        foreach(i, WHEEL_SIZE) {
+          buckets_[i].head = buckets_[i].tail = NULL;
+        }
+        heapCount_ = 0;
+        wheelCount_ = 0;
+        count_ = 0;
+        curCycle_ = 0;
+        nextSeq_ = 0;
+      }
+
+      void schedule(Signal *signal, W64 clock, void *arg) {
+        Event *event = freeList_;
+        assert(event);
+        freeList_ = event->next_;
+        count_++;
+
+        event->setup(signal, clock, arg);
+        event->seq_ = nextSeq_++;
+
+        if(clock < curCycle_) {
+          // Past due events keep their clock in current bucket and are
+          // executed on next call to run_until with a cycle >= clock
+          bucket_append(event, curCycle_);
+        } else if(clock < curCycle_ + WHEEL_SIZE) {
+          bucket_append(event);
+        } else {
+          heap_push(event);
+        }
+      }
+
+      void run_until(W64 now) {
+        if(now < curCycle_) {
+          drain_past_due(now);
+          return;
+        }
+
+        while(curCycle_ <= now) {
+          drain_bucket();
+
+          if(curCycle_ == now)
+            break;
+
+          if(wheelCount_ == 0) {
+            // Nothing in the wheel, jump directly to next heap event
+            if(heapCount_ == 0) {
+              curCycle_ = now;
+              break;
+            }
+            curCycle_ = min(now, heap_[0]->get_clock());
+          } else {
+            curCycle_++;
+          }
+
+          migrate();
+        }
+      }
+
+      int count() const {
+        return count_;
+      }
+
+      bool empty() const {
+        return count_ == 0;
+      }
+
+      /* Return clock of earliest pending event or -1 if queue is empty */
+      W64 next_event_clock() const {
+        if(wheelCount_) {
+          foreach(i, WHEEL_SIZE) {
+            const Bucket &bucket = buckets_[(curCycle_ + i) & WHEEL_MASK];
+            if(bucket.head)
+              return bucket.head->get_clock();
+          }
+        }
+        if(heapCount_)
+          return heap_[0]->get_clock();
+        return W64(-1);
+      }
+
+      ostream& print(ostream& os) const {
+        os << "EventWheel< cycle:" << curCycle_ << " events:" << count_;
+        os << " wheel:" << wheelCount_ << " heap:" << heapCount_ << " >\n";
+        foreach(i, WHEEL_SIZE) {
+          const Bucket &bucket = buckets_[(curCycle_ + i) & WHEEL_MASK];
+          for(Event *event = bucket.head; event; event = event->next_)
+            os << *event;
+        }
+        foreach(i, heapCount_) {
+          os << *heap_[i];
+        }
+        return os;
+      }
+  };
+
+  template <int SIZE>
+  static inline ostream& operator <<(ostream& os,
+      const ListEventQueue<SIZE>& queue)
+  {
+    return queue.print(os);
+  }
+
+  template <int WHEEL_SIZE, int SIZE>
+  static inline ostream& operator <<(ostream& os,
+      const EventWheel<WHEEL_SIZE, SIZE>& wheel)
+  {
+    return wheel.print(os);
+  }
+
+};
+
+#endif // EVENT_QUEUE_H
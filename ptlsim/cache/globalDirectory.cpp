@@ -19,85 +19,41 @@ static W64 get_line_addr(W64 addr)
 }
 
 
-/**
- * @brief Reset the directory entry
- */
-void DirectoryEntry::reset()
-{
-    present.reset();
-    tag   = -1;
-    owner = -1;
-    dirty = 0;
-	locked = 0;
-}
-
-void DirectoryEntry::init(W64 tag_)
-{
-    tag   = tag_;
-    dirty = 0;
-    owner = -1;
-	locked = 0;
-    present.reset();
-}
-
-Directory::Directory()
-{
-    entries = new base_t();
-}
-
-DirectoryEntry* Directory::insert(MemoryRequest *req, W64& old_tag)
-{
-    W64 phys_addr = req->get_physical_address();
-    DirectoryEntry* entry = entries->select(phys_addr, old_tag);
-
-    return entry;
-}
-
-DirectoryEntry* Directory::probe(MemoryRequest *req)
-{
-    W64 phys_addr = req->get_physical_address();
-    DirectoryEntry* entry = entries->probe(phys_addr);
-
-    return entry;
-}
-
-int Directory::invalidate(MemoryRequest *req)
-{
-    return entries->invalidate(req->get_physical_address());
-}
-
-Directory* Directory::dir = NULL;
 FixStateList<DirContBufferEntry, REQ_Q_SIZE>*
 DirectoryController::pendingRequests_ = NULL;
 
-/**
- * @brief Get the global directory
- *
- * @return reference to global Directory
- */
-Directory& Directory::get_directory()
-{
-    if (dir == NULL) {
-        dir = new Directory();
-        DirectoryController::pendingRequests_ =
-            new FixStateList<DirContBufferEntry, REQ_Q_SIZE>();
-    }
-
-    return *dir;
-}
-
 Controller* DirectoryController::controllers[NUM_SIM_CORES] = {0};
 Controller* DirectoryController::lower_cont = NULL;
 
 DirectoryController* DirectoryController::dir_controllers[NUM_SIM_CORES] = {0};
+DirectoryController* DirectoryController::bank_controllers[DIR_MAX_BANKS] = {0};
 
 DirectoryController::DirectoryController(W8 idx, const char *name,
         MemoryHierarchy *memoryHierarchy)
     : Controller(idx, name, memoryHierarchy)
-      , dir_(Directory::get_directory())
 {
     memoryHierarchy_->add_cache_mem_controller(this);
 
+    BaseMachine &machine = memoryHierarchy_->get_machine();
+    int sets = DIR_SET, ways = DIR_WAY;
+    int latency = DIR_ACCESS_DELAY, ports = 0;
+
+    machine.get_option(name, "dir_sets", sets);
+    machine.get_option(name, "dir_ways", ways);
+    machine.get_option(name, "dir_latency", latency);
+    machine.get_option(name, "dir_ports", ports);
+
+    /* This controller's bank of the directory */
+    dir_ = new Directory(sets, ways, latency, ports);
+    bank_controllers[Directory::add_bank(dir_)] = this;
+
+    if (pendingRequests_ == NULL) {
+        pendingRequests_ = new FixStateList<DirContBufferEntry, REQ_Q_SIZE>();
+    }
+
+    new_stats = new DirectoryStats(name, &machine);
+    new_stats->set_default_stats(user_stats);
+
     req_handlers[MEMORY_OP_READ]   = &DirectoryController::
         handle_read_miss;
     req_handlers[MEMORY_OP_WRITE]  = &DirectoryController::
@@ -125,6 +81,12 @@ DirectoryController::DirectoryController(W8 idx, const char *name,
             &DirectoryController::send_msg_cb);
 }
 
+DirectoryController::~DirectoryController()
+{
+    delete dir_;
+    delete new_stats;
+}
+
 bool DirectoryController::handle_interconnect_cb(void *arg)
 {
     Message *message = (Message*)arg;
@@ -164,9 +126,9 @@ void DirectoryController::register_interconnect(Interconnect *interconn,
                         /* This controller is lower in hierarchy */
                         cont = machine.controller_hash.get(sg->controller);
                         assert(cont);
-                        if (lower_cont) {
-                            assert(lower_cont == *cont);
-                        } else {
+                        /* With a banked lower cache all banks are on the
+                         * same interconnect, which selects the bank */
+                        if (!lower_cont) {
                             lower_cont = *cont;
                         }
                         break;
@@ -307,6 +269,8 @@ bool DirectoryController::read_miss_cb(void *arg)
     assert(dir_entry);
     queueEntry->entry = dir_entry;
 
+    int delay = get_access_delay(queueEntry->request);
+
     memdebug("Read miss handling in Directory with entry: " <<
             *dir_entry << endl);
 
@@ -318,12 +282,12 @@ bool DirectoryController::read_miss_cb(void *arg)
 
         if (sig_dir == this && dir_entry->owner != queueEntry->cont->idx) {
             queueEntry->responder = controllers[dir_entry->owner];
-            marss_add_event(&send_response, DIR_ACCESS_DELAY,
+            marss_add_event(&send_response, delay,
                     queueEntry);
         } else {
             queueEntry->responder = lower_cont;
             marss_add_event(&sig_dir->send_update,
-                    DIR_ACCESS_DELAY, queueEntry);
+                    delay, queueEntry);
         }
 
         return true;
@@ -342,7 +306,7 @@ bool DirectoryController::read_miss_cb(void *arg)
         queueEntry->responder = lower_cont;
 
     // Send response back
-    marss_add_event(&send_response, DIR_ACCESS_DELAY,
+    marss_add_event(&send_response, delay,
             queueEntry);
 
     return true;
@@ -365,6 +329,8 @@ bool DirectoryController::write_miss_cb(void *arg)
     assert(dir_entry);
     queueEntry->entry = dir_entry;
 
+    int delay = get_access_delay(queueEntry->request);
+
     memdebug("Write miss handling in Directory with entry: " <<
             *dir_entry << endl);
 
@@ -378,7 +344,7 @@ bool DirectoryController::write_miss_cb(void *arg)
         queueEntry->responder = lower_cont;
         sig_dir               = dir_controllers[dir_entry->owner];
         marss_add_event(&sig_dir->send_evict,
-                DIR_ACCESS_DELAY, queueEntry);
+                delay, queueEntry);
         return true;
     } else {
         // Check if it was present in only requested cache
@@ -389,7 +355,7 @@ bool DirectoryController::write_miss_cb(void *arg)
             queueEntry->responder = lower_cont;
             sig_dir               = dir_controllers[dir_entry->owner];
             marss_add_event(&sig_dir->send_evict,
-                    DIR_ACCESS_DELAY, queueEntry);
+                    delay, queueEntry);
             return true;
         }
 
@@ -403,7 +369,7 @@ bool DirectoryController::write_miss_cb(void *arg)
     }
 
     marss_add_event(&send_response,
-            DIR_ACCESS_DELAY, queueEntry);
+            delay, queueEntry);
 
     return true;
 }
@@ -778,13 +744,83 @@ DirContBufferEntry* DirectoryController::find_dependent_enry(
     return NULL;
 }
 
+/**
+ * @brief Functional warmup of directory entry for a cache's request
+ *
+ * @param interconnect Interconnect of requesting cache
+ * @param request Memory Request
+ *
+ * @return true if line is shared with another cache
+ *
+ * Requesting cache calls this directly on its miss. Other caches that
+ * have the line are snooped, like send_update and send_evict, and lower
+ * controller is accessed if no other cache can supply the line.
+ */
+bool DirectoryController::warmup(Interconnect *interconnect,
+        MemoryRequest *request)
+{
+    int cont_id = request->get_coreid();
+    bool is_write = (request->get_type() == MEMORY_OP_WRITE);
+    DirectoryEntry *entry = Directory::get_bank(
+            request->get_physical_address()).probe(
+            request->get_physical_address());
+
+    if (!entry) {
+        W64 old_tag = InvalidTag<W64>::INVALID;
+        entry = insert_directory_entry(request, old_tag);
+        assert(entry);
+
+        /* Replaced entry's line is removed from all caches */
+        if ((old_tag != InvalidTag<W64>::INVALID && old_tag != (W64)-1) &&
+                entry->present.nonzero()) {
+            MemoryRequest evict;
+            evict.init(request);
+            evict.set_physical_address(old_tag);
+            evict.set_op_type(MEMORY_OP_EVICT);
+
+            foreach (i, NUM_SIM_CORES) {
+                if (entry->present.test(i) && controllers[i])
+                    controllers[i]->warmup(interconn_, &evict);
+            }
+        }
+
+        entry->init(Directory::tag_of(request->get_physical_address()));
+    }
+
+    bool shared = false;
+
+    foreach (i, NUM_SIM_CORES) {
+        if (i == cont_id || !entry->present.test(i) || !controllers[i])
+            continue;
+
+        shared |= controllers[i]->warmup(interconn_, request);
+        if (is_write)
+            entry->present.reset(i);
+    }
+
+    if (is_write || !shared)
+        lower_cont->warmup(interconn_, request);
+
+    entry->present.set(cont_id);
+    if (is_write) {
+        entry->owner = cont_id;
+        entry->dirty = 1;
+    } else if (!shared) {
+        entry->owner = cont_id;
+        entry->dirty = 0;
+    }
+
+    return shared;
+}
+
 DirectoryEntry* DirectoryController::get_directory_entry(
         MemoryRequest *req, bool must_present)
 {
-    DirectoryEntry *entry = dir_.probe(req);
+    DirectoryEntry *entry = Directory::get_bank(
+            req->get_physical_address()).probe(req->get_physical_address());
 
     if (!entry && must_present) {
-        W64 tag_t = dir_.tag_of(req->get_physical_address());
+        W64 tag_t = Directory::tag_of(req->get_physical_address());
         foreach (i, REQ_Q_SIZE) {
             DirectoryEntry* d_entry = &dummy_entries[i];
             if (d_entry->tag == tag_t) {
@@ -797,7 +833,7 @@ DirectoryEntry* DirectoryController::get_directory_entry(
 
     if (!entry) {
         W64 old_tag = InvalidTag<W64>::INVALID;
-        entry = dir_.insert(req, old_tag);
+        entry = insert_directory_entry(req, old_tag);
         assert(entry);
 
         /* If we are removing any entry with cached line then we
@@ -831,12 +867,60 @@ DirectoryEntry* DirectoryController::get_directory_entry(
             }
         }
 
-        entry->init(dir_.tag_of(req->get_physical_address()));
+        entry->init(Directory::tag_of(req->get_physical_address()));
+    }
+
+    return entry;
+}
+
+/**
+ * @brief Allocate entry for request's line in its directory bank
+ *
+ * @param old_tag Set to line address of replaced entry, whose sharers
+ * must be invalidated by caller
+ *
+ * @return Directory entry that still has replaced line's state
+ */
+DirectoryEntry* DirectoryController::insert_directory_entry(
+        MemoryRequest *req, W64 &old_tag)
+{
+    W64 addr = req->get_physical_address();
+    DirectoryEntry *entry = Directory::get_bank(addr).insert(addr, old_tag);
+    DirectoryStats *stats = bank_controllers[
+        Directory::get_bank_index(addr)]->new_stats;
+    bool kernel = req->is_kernel();
+
+    if (old_tag != (W64)-1) {
+        N_STAT_UPDATE(stats->evictions, ++, kernel);
+        if (entry->present.nonzero())
+            N_STAT_UPDATE(stats->back_invalidations, ++, kernel);
     }
 
     return entry;
 }
 
+/**
+ * @brief Access request's directory bank
+ *
+ * @return Cycles until the access is complete, including wait for a free
+ * port of the bank
+ */
+int DirectoryController::get_access_delay(MemoryRequest *req)
+{
+    W64 addr = req->get_physical_address();
+    int bank = Directory::get_bank_index(addr);
+    DirectoryStats *stats = bank_controllers[bank]->new_stats;
+    bool kernel = req->is_kernel();
+    int wait;
+
+    int delay = Directory::get_bank(addr).access(sim_cycle, wait);
+
+    N_STAT_UPDATE(stats->accesses, ++, kernel);
+    N_STAT_UPDATE(stats->port_wait_cycles, += wait, kernel);
+
+    return delay;
+}
+
 /**
  * @brief Return a free dummy Directory Entry
  *
@@ -965,10 +1049,13 @@ void DirectoryController::dump_configuration(YAML::Emitter &out) const
 	out << YAML::Key << get_name() << YAML::Value << YAML::BeginMap;
 
 	YAML_KEY_VAL(out, "type", "directory");
-	YAML_KEY_VAL(out, "size", DIR_SET * DIR_WAY);
+	YAML_KEY_VAL(out, "size", dir_->get_sets() * dir_->get_ways());
 	YAML_KEY_VAL(out, "line_size", DIR_LINE_SIZE);
-	YAML_KEY_VAL(out, "sets", DIR_SET);
-	YAML_KEY_VAL(out, "ways", DIR_WAY);
+	YAML_KEY_VAL(out, "sets", dir_->get_sets());
+	YAML_KEY_VAL(out, "ways", dir_->get_ways());
+	YAML_KEY_VAL(out, "latency", dir_->get_latency());
+	YAML_KEY_VAL(out, "ports", dir_->get_ports());
+	YAML_KEY_VAL(out, "banks", Directory::get_bank_count());
 
 	out << YAML::EndMap;
 }
@@ -18,76 +18,13 @@
 #include <memoryHierarchy.h>
 
 #include <machine.h>
+#include <memoryStats.h>
+#include <directoryBank.h>
 
 using namespace Memory;
 
-#define DIR_SET 4096
-#define DIR_WAY 16
-#define DIR_LINE_SIZE 64
-#define DIR_ACCESS_DELAY 10
 #define REQ_Q_SIZE 128
 
-/**
- * @brief A Directory entry containing information for one line
- */
-struct DirectoryEntry {
-    bitvec<NUM_SIM_CORES> present;
-    bool dirty;
-    W64  tag;
-    W8   owner;
-	bool locked;
-
-    DirectoryEntry() { reset(); }
-    void reset();
-    void init(W64 tag_);
-
-    ostream& print(ostream &os) const {
-        os << "tag:" << (void*)tag << " dirty:" << dirty << " owner:" << owner;
-        os << " present:" << present;
-        return os;
-    }
-};
-
-static inline ostream& operator <<(ostream &os, const DirectoryEntry &e)
-{
-    return e.print(os);
-}
-
-/**
- * @brief A Directory containing cacheline informations.
- *
- * This is a singleton class so there is only one Global directory.
- * All directory controllers get access to this directory and should
- * simulate appropriate access delay. This directory is a set-assoc
- * structure. The size of the directory is statically set.
- *
- * TODO:
- *	- Allow configuration options to dynamically set directory size.
- *	- Simulate limited port access
- */
-class Directory {
-    private:
-        Directory();
-        static Directory* dir;
-
-        typedef AssociativeArray<W64, DirectoryEntry, DIR_SET,
-                DIR_WAY, DIR_LINE_SIZE> base_t;
-        typedef FullyAssociativeArray<W64, DirectoryEntry, DIR_WAY,
-                NullAssociativeArrayStatisticsCollector<W64,
-                DirectoryEntry> > Set;
-
-        base_t* entries;
-
-    public:
-        static Directory& get_directory();
-
-        DirectoryEntry *insert(MemoryRequest *req, W64&old_tag);
-        DirectoryEntry *probe(MemoryRequest *req);
-        int             invalidate(MemoryRequest *req);
-
-        W64 tag_of(W64 addr) { return base_t::tagof(addr); }
-};
-
 struct DirContBufferEntry : public FixStateListObject
 {
     MemoryRequest  *request;
@@ -151,12 +88,18 @@ static inline ostream& operator << (ostream& os, const
  * the global directory then in case of cache-eviction, the initiating
  * controller can send 'evict' message to all other controllers.
  * In such scenarios, each controller should simulate some delay.
+ *
+ * Each controller owns one bank of the directory, and lines are
+ * interleaved across the banks of all controllers. Bank size and timing
+ * are set with options 'dir_sets', 'dir_ways', 'dir_latency' and
+ * 'dir_ports' (0 for unlimited ports).
  */
 class DirectoryController : public Controller {
 
     private:
-        Directory    &dir_;
+        Directory    *dir_;
         Interconnect *interconn_;
+        DirectoryStats *new_stats;
 
         DirectoryEntry dummy_entries[REQ_Q_SIZE];
 
@@ -177,9 +120,13 @@ class DirectoryController : public Controller {
         static Controller   *lower_cont;
 
         static DirectoryController *dir_controllers[NUM_SIM_CORES];
+
+        /* Controller that owns each directory bank */
+        static DirectoryController *bank_controllers[DIR_MAX_BANKS];
     public:
         DirectoryController(W8 idx, const char *name,
                 MemoryHierarchy *memoryHierachy);
+        ~DirectoryController();
 
         static FixStateList<DirContBufferEntry, REQ_Q_SIZE> *pendingRequests_;
 
@@ -190,6 +137,7 @@ class DirectoryController : public Controller {
         void print(ostream &os) const;
         bool is_full(bool flag=false) const;
         void annul_request(MemoryRequest *request);
+        bool warmup(Interconnect *interconnect, MemoryRequest *request);
 		void dump_configuration(YAML::Emitter &out) const;
 
         bool handle_read_miss(Message *message);
@@ -214,6 +162,9 @@ class DirectoryController : public Controller {
 
         DirectoryEntry* get_directory_entry(MemoryRequest *req,
                 bool must_present=0);
+        DirectoryEntry* insert_directory_entry(MemoryRequest *req,
+                W64 &old_tag);
+        int get_access_delay(MemoryRequest *req);
         DirectoryEntry* get_dummy_entry(DirectoryEntry *entry, W64 old_tag);
 };
 
@@ -67,6 +67,10 @@ class Interconnect
 		virtual void register_controller(Controller *controller)=0;
 		virtual int access_fast_path(Controller *controller,
 				MemoryRequest *request)=0;
+		/* Pass warmup request from controller to the other controllers,
+		 * returns true if any of them shares the line */
+		virtual bool warmup(Controller *controller,
+				MemoryRequest *request) { return false; }
 		virtual void print_map(ostream& os)=0;
 		virtual void print(ostream& os) const = 0;
 		virtual int get_delay()=0;
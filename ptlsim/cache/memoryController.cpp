@@ -43,6 +43,8 @@ using namespace Memory;
 MemoryController::MemoryController(W8 coreid, const char *name,
 		MemoryHierarchy *memoryHierarchy) :
 	Controller(coreid, name, memoryHierarchy)
+    , primaryModel_(-1)
+    , compareAll_(false)
     , new_stats(name, &memoryHierarchy->get_machine())
 {
     memoryHierarchy_->add_cache_mem_controller(this);
@@ -54,6 +56,8 @@ MemoryController::MemoryController(W8 coreid, const char *name,
     /* Convert latency from ns to cycles */
     latency_ = ns_to_simcycles(latency_);
 
+    setup_dram_models(name);
+
     SET_SIGNAL_CB(name, "_Access_Completed", accessCompleted_,
             &MemoryController::access_completed_cb);
 
@@ -67,6 +71,91 @@ MemoryController::MemoryController(W8 coreid, const char *name,
 	}
 }
 
+MemoryController::~MemoryController()
+{
+    foreach(i, dramModels_.count()) {
+        delete dramModels_[i];
+        delete dramStats_[i];
+    }
+    dramModels_.clear();
+    dramStats_.clear();
+}
+
+/*
+ * @brief: create stacked DRAM models from controller options
+ *
+ * 'dram_org' selects the organisation used for access latency, either one
+ * of stacked_dram_org_names or 'compare_all'. Without it the controller
+ * uses fixed 'latency'. In compare_all mode every organisation is
+ * simulated and 'dram_primary_org' selects the one that provides timing.
+ *
+ * @param: name - controller name used to look up options
+ *
+ */
+void MemoryController::setup_dram_models(const char *name)
+{
+    BaseMachine &machine = memoryHierarchy_->get_machine();
+    stringbuf org_name;
+    stringbuf primary_name;
+
+    if(!machine.get_option(name, "dram_org", org_name))
+        return;
+
+    StackedDramConfig &c = dramConfig_;
+    machine.get_option(name, "dram_layers", c.layers);
+    machine.get_option(name, "dram_tiles", c.tiles);
+    machine.get_option(name, "dram_buffers_per_layer", c.buffers_per_layer);
+    machine.get_option(name, "dram_size_bits", c.size_bits);
+    machine.get_option(name, "dram_dimms", c.dimms);
+    machine.get_option(name, "dram_banks", c.banks);
+    machine.get_option(name, "dram_row_bits", c.row_bits);
+    machine.get_option(name, "dram_col_high_bits", c.col_high_bits);
+    machine.get_option(name, "dram_col_low_bits", c.col_low_bits);
+    machine.get_option(name, "dram_bus_latency", c.bus_latency);
+    machine.get_option(name, "dram_row_read_latency", c.row_read_latency);
+    machine.get_option(name, "dram_row_write_latency", c.row_write_latency);
+    machine.get_option(name, "dram_row_buffer_latency",
+            c.row_buffer_latency);
+    machine.get_option(name, "dram_layer_latency", c.layer_latency);
+    machine.get_option(name, "dram_tile_base_latency", c.tile_base_latency);
+    machine.get_option(name, "dram_tile_latency", c.tile_latency);
+
+    compareAll_ = (org_name == "compare_all");
+    if(compareAll_) {
+        if(!machine.get_option(name, "dram_primary_org", primary_name))
+            primary_name = stacked_dram_org_names[STACKED_DRAM_VAULT_TILES];
+    } else {
+        primary_name = org_name;
+    }
+
+    int primary = get_stacked_dram_org(primary_name);
+    if(primary < 0) {
+        stringbuf err;
+        err << "::ERROR::Invalid stacked DRAM organisation '" <<
+            primary_name << "' for " << name << ", valid values:";
+        foreach(i, NUM_STACKED_DRAM_ORGS) {
+            err << " " << stacked_dram_org_names[i];
+        }
+        err << endl;
+        ptl_logfile << err;
+        cerr << err;
+        assert_fail(__STRING(primary >= 0), __FILE__, __LINE__,
+                __PRETTY_FUNCTION__);
+    }
+
+    foreach(i, NUM_STACKED_DRAM_ORGS) {
+        if(!compareAll_ && i != primary)
+            continue;
+
+        if(i == primary)
+            primaryModel_ = dramModels_.count();
+
+        dramModels_.push(new StackedDram(StackedDramOrg(i), dramConfig_));
+        dramStats_.push(new StackedDramStats(stacked_dram_org_names[i],
+                    &new_stats));
+    }
+}
+
 /*
  * @brief: get bank id from input address using
  *         cache line interleaving address mapping
@@ -82,6 +171,49 @@ int MemoryController::get_bank_id(W64 addr)
     return lowbits(addr >> 6, bankBits_);
 }
 
+/*
+ * @brief: get latency of memory access, called when the request is issued
+ *         to its bank
+ *
+ * @param: queueEntry - entry of the request being issued
+ *
+ * @return: access latency in cycles
+ *
+ */
+int MemoryController::get_access_latency(MemoryQueueEntry *queueEntry)
+{
+    if(primaryModel_ < 0)
+        return latency_;
+
+    MemoryRequest *request = queueEntry->request;
+    W64 addr = request->get_physical_address();
+    bool is_write = (request->get_type() == MEMORY_OP_UPDATE);
+    bool kernel = request->is_kernel();
+    int primary_latency = 0;
+
+    foreach(i, dramModels_.count()) {
+        bool row_hit = false;
+        int latency = dramModels_[i]->access(addr, is_write, row_hit);
+        StackedDramStats &stats = *dramStats_[i];
+
+        if(row_hit) {
+            N_STAT_UPDATE(stats.row_buffer_hit, ++, kernel);
+        } else {
+            N_STAT_UPDATE(stats.row_buffer_miss, ++, kernel);
+        }
+
+        int bucket = min(latency / STACKED_DRAM_HIST_BUCKET_CYCLES,
+                STACKED_DRAM_HIST_BUCKETS - 1);
+        N_STAT_UPDATE(stats.total_latency, += latency, kernel);
+        N_STAT_UPDATE(stats.latency_hist, [bucket]++, kernel);
+
+        if(i == primaryModel_)
+            primary_latency = latency;
+    }
+
+    return primary_latency;
+}
+
 void MemoryController::register_interconnect(Interconnect *interconnect,
         int type)
 {
@@ -171,7 +303,7 @@ bool MemoryController::handle_interconnect_cb(void *arg)
 	if(banksUsed_[bank_no] == 0) {
 		banksUsed_[bank_no] = 1;
 		queueEntry->inUse = true;
-		marss_add_event(&accessCompleted_, latency_,
+		marss_add_event(&accessCompleted_, get_access_latency(queueEntry),
 				queueEntry);
 	}
 
@@ -184,6 +316,9 @@ void MemoryController::print(ostream& os) const
 	if(pendingRequests_.count() > 0)
 		os << "Queue : ", pendingRequests_, endl;
     os << "banksUsed_: ", banksUsed_, endl;
+    foreach(i, dramModels_.count()) {
+        os << *dramModels_[i];
+    }
 	os << "---End Memory-Controller: ", get_name(), endl;
 }
 
@@ -224,7 +359,7 @@ bool MemoryController::access_completed_cb(void *arg)
         if(bank_no == bank_no_2 && entry->inUse == false) {
             entry->inUse = true;
             marss_add_event(&accessCompleted_,
-                    latency_, entry);
+                    get_access_latency(entry), entry);
             banksUsed_[bank_no] = 1;
             break;
         }
@@ -331,6 +466,28 @@ void MemoryController::dump_configuration(YAML::Emitter &out) const
 	YAML_KEY_VAL(out, "latency", latency_);
 	YAML_KEY_VAL(out, "latency_ns", simcycles_to_ns(latency_));
 	YAML_KEY_VAL(out, "pending_queue_size", pendingRequests_.size());
+	if(primaryModel_ >= 0) {
+		StackedDram *primary = dramModels_[primaryModel_];
+		YAML_KEY_VAL(out, "dram_org", (compareAll_ ? "compare_all" :
+				stacked_dram_org_names[primary->get_org()]));
+		YAML_KEY_VAL(out, "dram_primary_org",
+				stacked_dram_org_names[primary->get_org()]);
+		YAML_KEY_VAL(out, "dram_layers", dramConfig_.layers);
+		YAML_KEY_VAL(out, "dram_tiles", dramConfig_.tiles);
+		YAML_KEY_VAL(out, "dram_buffers", primary->get_buffer_count());
+		YAML_KEY_VAL(out, "dram_row_bits", dramConfig_.row_bits);
+		YAML_KEY_VAL(out, "dram_bus_latency", dramConfig_.bus_latency);
+		YAML_KEY_VAL(out, "dram_row_read_latency",
+				dramConfig_.row_read_latency);
+		YAML_KEY_VAL(out, "dram_row_write_latency",
+				dramConfig_.row_write_latency);
+		YAML_KEY_VAL(out, "dram_row_buffer_latency",
+				dramConfig_.row_buffer_latency);
+		YAML_KEY_VAL(out, "dram_layer_latency", dramConfig_.layer_latency);
+		YAML_KEY_VAL(out, "dram_tile_base_latency",
+				dramConfig_.tile_base_latency);
+		YAML_KEY_VAL(out, "dram_tile_latency", dramConfig_.tile_latency);
+	}
 
 	out << YAML::EndMap;
 }
@@ -32,6 +32,7 @@
 #include <interconnect.h>
 #include <superstl.h>
 #include <memoryStats.h>
+#include <stackedDram.h>
 
 namespace Memory {
 
@@ -79,11 +80,27 @@ class MemoryController : public Controller
 		int bankBits_;
 		int get_bank_id(W64 addr);
 
+        /*
+         * Optional 3D-stacked DRAM row buffer models. When present, the
+         * primary model provides the access latency instead of fixed
+         * latency_. In compare_all mode the other organisations run as
+         * shadow models that only update their stats.
+         */
+        dynarray<StackedDram*> dramModels_;
+        dynarray<StackedDramStats*> dramStats_;
+        int primaryModel_;
+        bool compareAll_;
+        StackedDramConfig dramConfig_;
+
+        void setup_dram_models(const char *name);
+        int get_access_latency(MemoryQueueEntry *queueEntry);
+
         RAMStats new_stats;
 
 	public:
 		MemoryController(W8 coreid, const char *name,
 				 MemoryHierarchy *memoryHierarchy);
+		~MemoryController();
 		virtual bool handle_interconnect_cb(void *arg);
 		void print(ostream& os) const;
 
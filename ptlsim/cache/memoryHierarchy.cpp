@@ -55,6 +55,11 @@ MemoryHierarchy::MemoryHierarchy(BaseMachine& machine) :
 {
   coreNo_ = machine_.get_num_cores();
 
+  relaxedSync_ = false;
+  foreach(i, NUM_SIM_CORES) {
+    coreClock_[i] = 0;
+  }
+
   foreach(i, NUM_SIM_CORES) {
     RequestPool* pool = new RequestPool();
     requestPool_.push(pool);
@@ -88,6 +93,15 @@ bool MemoryHierarchy::access_cache(MemoryRequest *request)
   return false;
 }
 
+void MemoryHierarchy::warmup(MemoryRequest *request)
+{
+  W8 coreid = request->get_coreid();
+  CPUController *cpuController = (CPUController*)cpuControllers_[coreid];
+  assert(cpuController != NULL);
+
+  cpuController->warmup(NULL, request);
+}
+
 void MemoryHierarchy::clock()
 {
   // First clock all the cpu controllers
@@ -97,16 +111,62 @@ void MemoryHierarchy::clock()
     cpuController->clock();
   }
 
-  Event *event;
-  while(!eventQueue_.empty()) {
-    event = eventQueue_.head();
-    if(event->get_clock() <= sim_cycle) {
-      memdebug("Executing event: " << *event);
-      eventQueue_.free(event);
-      assert(event->execute());
-    } else {
-      break;
-    }
+  eventQueue_.run_until(sim_cycle);
+}
+
+void MemoryHierarchy::clock_core(W8 coreid)
+{
+  assert(coreid < cpuControllers_.count());
+
+  CPUController *cpuController = (CPUController*)(
+      cpuControllers_[coreid]);
+  cpuController->clock();
+
+  eventQueue_.run_until(sim_cycle);
+}
+
+void MemoryHierarchy::set_relaxed_sync(bool flag)
+{
+  relaxedSync_ = flag;
+  foreach(i, NUM_SIM_CORES) {
+    coreClock_[i] = sim_cycle;
+  }
+}
+
+W64 MemoryHierarchy::get_next_event_cycle()
+{
+  W64 next_cycle = eventQueue_.next_event_clock();
+
+  foreach(i, cpuControllers_.count()) {
+    CPUController *cpuController = (CPUController*)(
+        cpuControllers_[i]);
+    next_cycle = min(next_cycle, cpuController->get_next_finalize_cycle());
+  }
+
+  return next_cycle;
+}
+
+int MemoryHierarchy::get_pending_count()
+{
+  int count = eventQueue_.count();
+
+  foreach(i, cpuControllers_.count()) {
+    CPUController *cpuController = (CPUController*)(
+        cpuControllers_[i]);
+    count += cpuController->get_pending_count();
+  }
+
+  return count;
+}
+
+void MemoryHierarchy::skip_cycles(int cycles)
+{
+  assert(sim_cycle + cycles <= get_next_event_cycle());
+
+  foreach(i, cpuControllers_.count()) {
+    CPUController *cpuController = (CPUController*)(
+        cpuControllers_[i]);
+    cpuController->skip_cycles(cycles);
   }
 }
 
@@ -254,73 +314,20 @@ void MemoryHierarchy::print_map(ostream& os)
   os << "--End MemoryHierarchy Map\n";
 }
 
-void MemoryHierarchy::sort_event_queue(Event *event)
-{
-  // First make sure that given event is in tail of queue
-  assert(eventQueue_.tail() == event);
-
-  // No need to sort if only 1 event
-  if(eventQueue_.count() == 1)
-    return;
-
-  Event* entryEvent;
-  foreach_list_mutable(eventQueue_.list(), entryEvent, entry, preventry) {
-    if(*event < *entryEvent) {
-      eventQueue_.unlink(event);
-      eventQueue_.insert_after(event, (Event*)(entryEvent->prev));
-      return;
-    }
-  }
-
-  // Entry is already at the tail of queue, keep it there
-  return;
-}
-
-void MemoryHierarchy::sort_event_queue_tail(Event *event)
-{
-  // First make sure that given event is in tail of queue
-  assert(eventQueue_.tail() == event);
-
-  // No need to sort if only 1 event
-  if (eventQueue_.count() == 1)
-    return;
-
-  Event* entryEvent;
-  foreach_list_mutable_backwards(eventQueue_.list(), entryEvent, entry, preventry) {
-    if (entryEvent == event)
-      continue;
-
-    if (*event >= *entryEvent) {
-      eventQueue_.unlink(event);
-      eventQueue_.insert_after(event, (Event*)(entryEvent));
-      return;
-    }
-  }
-}
-
 void MemoryHierarchy::add_event(Signal *signal, int delay, void *arg)
 {
-  Event *event = eventQueue_.alloc();
-  if(eventQueue_.count() == 1)
-    assert(event == eventQueue_.head());
-  assert(event);
-  event->setup(signal, sim_cycle + delay, arg);
-
-  // If delay is 0, execute without sorting the queue
+  // If delay is 0, execute without queuing the event
   if(delay == 0) {
-    memdebug("Executing event: " << *event);
-    assert(event->execute());
-
-    eventQueue_.free(event);
-    /* memdebug("Queue after add: \n", eventQueue_); */
+    memdebug("Executing event: " << signal->get_name() << " arg:" << arg <<
+        endl);
+    execute_event(signal, arg);
     return;
   }
 
-  memdebug("Adding event:" << *event);
-
-  sort_event_queue(event);
+  memdebug("Adding event: " << signal->get_name() << " Clock:" <<
+      (sim_cycle + delay) << " arg:" << arg << endl);
 
-  return;
+  eventQueue_.schedule(signal, sim_cycle + delay, arg);
 }
 
 Message* MemoryHierarchy::get_message()
@@ -36,6 +36,7 @@
 #include <memoryRequest.h>
 #include <controller.h>
 #include <interconnect.h>
+#include <eventQueue.h>
 
 #include <statsBuilder.h>
 
@@ -56,9 +57,15 @@
 #define memdebug(...) (0)
 #endif
 
-#define ENABLE_MEM_REQUEST_HISTORY
-#ifdef ENABLE_MEM_REQUEST_HISTORY
-#define ADD_HISTORY(req, ...) req->get_history() << __VA_ARGS__
+/*
+ * Request history is recorded only when enabled at runtime with
+ * -mem-req-history, define DISABLE_MEM_REQUEST_HISTORY to compile it out
+ */
+#ifndef DISABLE_MEM_REQUEST_HISTORY
+#define ADD_HISTORY(req, ...) do { \
+  if unlikely ((req)->get_history().enabled()) { \
+    (req)->get_history() << __VA_ARGS__; \
+  } } while (0)
 #define ADD_HISTORY_ADD(req) ADD_HISTORY(req, "{+", get_name(), "} ")
 #define ADD_HISTORY_REM(req) ADD_HISTORY(req, "{-", get_name(), "} ")
 #else
@@ -86,73 +93,6 @@
 
 namespace Memory {
 
-  class Event : public FixStateListObject
-  {
-    private:
-      Signal *signal_;
-      W64    clock_;
-      void   *arg_;
-
-    public:
-      void init() {
-        signal_ = NULL;
-        clock_ = -1;
-        arg_ = NULL;
-      }
-
-      void setup(Signal *signal, W64 clock, void *arg) {
-        signal_ = signal;
-        clock_ = clock;
-        arg_ = arg;
-      }
-
-      bool execute() {
-        return signal_->emit(arg_);
-      }
-
-      W64 get_clock() {
-        return clock_;
-      }
-
-      ostream& print(ostream& os) const {
-        os << "Event< ";
-        if(signal_)
-          os << "Signal:" << signal_->get_name() << " ";
-        os << "Clock:" << clock_ << " ";
-        os << "arg:" << arg_ ;
-        os << ">" << endl, flush;
-        return os;
-      }
-
-      bool operator ==(Event &event) {
-        if(clock_ == event.clock_)
-          return true;
-        return false;
-      }
-
-      bool operator >(Event &event) {
-        if(clock_ > event.clock_)
-          return true;
-        return false;
-      }
-
-      bool operator <(Event &event) {
-        if(clock_ < event.clock_)
-          return true;
-        return false;
-      }
-
-      bool operator >=(Event &event) {
-        if (clock_ >= event.clock_)
-          return true;
-        return false;
-      }
-  };
-
-  static inline ostream& operator <<(ostream& os, const Event& event) {
-    return event.print(os);
-  }
-
   struct MemoryInterlockEntry {
     W8 ctx_id;
 
@@ -183,6 +123,10 @@ namespace Memory {
       // interface to memory hierarchy
       bool access_cache(MemoryRequest *request);
 
+      // functional warmup (-fast-fwd-warmup), updates cache lines and
+      // coherence states for request without any delay or event
+      void warmup(MemoryRequest *request);
+
       // New Core wakeup function that uses Signal of MemoryRequest
       // if Signal is not setup, it uses old wrapper functions
       void core_wakeup(MemoryRequest *request) {
@@ -202,6 +146,27 @@ namespace Memory {
 
       void clock();
 
+      // Idle cycle skipping support: first cycle in which clock() has
+      // some work to do (-1 if none), number of pending events and
+      // requests, and advance the hierarchy over cycles with no work
+      W64 get_next_event_cycle();
+      int get_pending_count();
+      void skip_cycles(int cycles);
+
+      // Relaxed synchronization (-sync-quantum) support: clock only the
+      // cpu controller of given core and run events up to sim_cycle, which
+      // is the local cycle of that core. Each core's local cycle is kept
+      // so messages that reach a core already simulated past the sender's
+      // cycle can be counted as late.
+      void clock_core(W8 coreid);
+      void set_relaxed_sync(bool flag);
+      void set_core_clock(W8 coreid, W64 cycle) {
+        coreClock_[coreid] = cycle;
+      }
+      bool is_late_message(W8 coreid) const {
+        return relaxedSync_ && coreClock_[coreid] > sim_cycle;
+      }
+
       void reset();
 
       // return the number of cycle used to flush the caches
@@ -280,14 +245,15 @@ namespace Memory {
       FixStateList<Message, 128> messageQueue_;
 
       // Event Queue
-      FixStateList<Event, 2048> eventQueue_;
-
-      void sort_event_queue(Event *event);
-      void sort_event_queue_tail(Event *event);
+      EventWheel<EVENT_WHEEL_SIZE, EVENT_QUEUE_SIZE> eventQueue_;
 
       // Temp Stats
       Stats *stats;
 
+      // Local cycle of each core in relaxed synchronization mode
+      bool relaxedSync_;
+      W64 coreClock_[NUM_SIM_CORES];
+
   };
 
 };
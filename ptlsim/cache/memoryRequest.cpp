@@ -63,8 +63,7 @@ void MemoryRequest::init(W8 coreId,
 	opType_ = opType;
 	isData_ = !isInstruction;
 
-	if(history) delete history;
-	history = new stringbuf();
+	history_.reset();
 
 	memdebug("Init ", *this, endl);
 }
@@ -82,8 +81,7 @@ void MemoryRequest::init(MemoryRequest *request)
 	opType_ = request->opType_;
 	isData_ = request->isData_;
 
-	if(history) delete history;
-	history = new stringbuf();
+	history_.reset();
 
 	memdebug("Init ", *this, endl);
 }
@@ -126,14 +124,39 @@ bool MemoryRequest::is_same(MemoryRequest *request)
 RequestPool::RequestPool()
 {
 	size_ = REQUEST_POOL_SIZE;
+	allocsSinceGC_ = 0;
+	historyBuffer_ = NULL;
+
+	/* History slots are allocated once for whole pool and only when
+	 * enabled, requests without slot skip all history updates */
+	if (config.mem_req_history) {
+		historyBuffer_ = new char[REQUEST_POOL_SIZE * MEM_REQ_HISTORY_SIZE];
+	}
+
 	foreach(i, REQUEST_POOL_SIZE) {
+		if (historyBuffer_) {
+			(*this)[i].set_history_buffer(
+					&historyBuffer_[i * MEM_REQ_HISTORY_SIZE]);
+		}
 		freeRequestList_.enqueue((selfqueuelink*)&((*this)[i]));
 	}
 }
 
+RequestPool::~RequestPool()
+{
+	if (historyBuffer_) {
+		delete[] historyBuffer_;
+		historyBuffer_ = NULL;
+	}
+}
+
 MemoryRequest* RequestPool::get_free_request()
 {
-	if (isPoolLow()){
+	/* When pool is low, collect requests with no references. Collection
+	 * walks the used list so run it only every few allocations unless
+	 * free list is fully drained. */
+	if (isEmpty() || (isPoolLow() &&
+				allocsSinceGC_ >= REQUEST_POOL_GC_INTERVAL)) {
 		garbage_collection();
         /* if asserted here please increase REQUEST_POOL_SIZE */
 		assert(!isEmpty());
@@ -141,6 +164,7 @@ MemoryRequest* RequestPool::get_free_request()
 	MemoryRequest* memoryRequest = (MemoryRequest*)freeRequestList_.peek();
 	freeRequestList_.remove((selfqueuelink*)memoryRequest);
 	usedRequestsList_.enqueue((selfqueuelink*)memoryRequest);
+	allocsSinceGC_++;
 
 	return memoryRequest;
 }
@@ -165,6 +189,7 @@ void RequestPool::garbage_collection()
 			cleaned++;
 		}
 	}
+	allocsSinceGC_ = 0;
 	memdebug("number of Request cleaned by garbageCollector is: ",
 		   cleaned,	endl);
 }
@@ -50,6 +50,84 @@ static const char* memory_op_names[NUM_MEMORY_OP] = {
 	"memory_op_evict"
 };
 
+/*
+ * RequestHistory
+ *
+ * Ring buffer trace of a memory request. Buffer slot is owned by
+ * RequestPool and is only assigned when history is enabled, so a request
+ * without buffer ignores all history writes. When the ring wraps only the
+ * most recent MEM_REQ_HISTORY_SIZE characters are kept.
+ */
+class RequestHistory
+{
+	public:
+		RequestHistory() : buf_(NULL), written_(0) {}
+
+		void set_buffer(char *buf) {
+			buf_ = buf;
+			written_ = 0;
+		}
+
+		bool enabled() const { return buf_ != NULL; }
+
+		void reset() { written_ = 0; }
+
+		void append(const char *str) {
+			if unlikely (!str) str = "<NULL>";
+			while (*str) {
+				buf_[written_ & (MEM_REQ_HISTORY_SIZE - 1)] = *str++;
+				written_++;
+			}
+		}
+
+		ostream& print(ostream& os) const {
+			if (!buf_) return os;
+
+			W32 start = 0;
+			if (written_ > MEM_REQ_HISTORY_SIZE) {
+				start = written_ - MEM_REQ_HISTORY_SIZE;
+				os << "...";
+			}
+			for (W32 i = start; i < written_; i++) {
+				os << buf_[i & (MEM_REQ_HISTORY_SIZE - 1)];
+			}
+			return os;
+		}
+
+	private:
+		char *buf_;
+		W32 written_;
+};
+
+static inline RequestHistory& operator <<(RequestHistory& history,
+		const char *v)
+{
+	history.append(v);
+	return history;
+}
+
+template <typename T>
+static inline RequestHistory& operator <<(RequestHistory& history,
+		const T& v)
+{
+	stringbuf sb;
+	sb << v;
+	history.append(sb);
+	return history;
+}
+
+template <typename T>
+static inline RequestHistory& operator ,(RequestHistory& history,
+		const T& v)
+{
+	return history << v;
+}
+
+static inline ostream& operator <<(ostream& os, const RequestHistory& history)
+{
+	return history.print(os);
+}
+
 class MemoryRequest: public selfqueuelink
 {
 	public:
@@ -65,7 +143,7 @@ class MemoryRequest: public selfqueuelink
 			refCounter_ = 0; // or maybe 1
 			opType_ = MEMORY_OP_READ;
 			isData_ = 0;
-			history = new stringbuf();
+			history_.reset();
             coreSignal_ = NULL;
 		}
 
@@ -128,7 +206,8 @@ class MemoryRequest: public selfqueuelink
 
 		W64 get_init_cycles() { return cycles_; }
 
-		stringbuf& get_history() { return *history; }
+		RequestHistory& get_history() { return history_; }
+		void set_history_buffer(char *buf) { history_.set_buffer(buf); }
 
         bool is_kernel() {
             // based on owner RIP value
@@ -160,7 +239,9 @@ class MemoryRequest: public selfqueuelink
 			os << "isData[", isData_, "] ";
 			os << "ownerUUID[", ownerUUID_, "] ";
 			os << "ownerRIP[", (void*)ownerRIP_, "] ";
-			os << "History[ " << *history << "] ";
+			if(history_.enabled()) {
+				os << "History[ " << history_ << "] ";
+			}
             if(coreSignal_) {
                 os << "Signal[ " << coreSignal_->get_name() << "] ";
             }
@@ -178,7 +259,7 @@ class MemoryRequest: public selfqueuelink
 		W64 ownerUUID_;
 		int refCounter_;
 		OP_TYPE opType_;
-		stringbuf *history;
+		RequestHistory history_;
         Signal *coreSignal_;
 
 };
@@ -192,6 +273,7 @@ class RequestPool: public array<MemoryRequest,REQUEST_POOL_SIZE>
 {
 	public:
 		RequestPool();
+		~RequestPool();
 		MemoryRequest* get_free_request();
 		void garbage_collection();
 
@@ -225,6 +307,8 @@ class RequestPool: public array<MemoryRequest,REQUEST_POOL_SIZE>
 
 	private:
 		int size_;
+		int allocsSinceGC_;
+		char *historyBuffer_;
 		StateList freeRequestList_;
 		StateList usedRequestsList_;
 
@@ -43,13 +43,22 @@
 
 #define STAT_UPDATE(expr, mode) 0
 
+/*
+ * Update counter in kernel_stats if mode is set else in user_stats. Stats
+ * are selected by indexing mode_stats so update has no branch on mode.
+ * Building with 'stats=0' (DISABLE_STATS) removes all updates, to measure
+ * overhead of stats collection. The update is still compiled, never run, so
+ * values computed only for stats don't give unused variable warnings.
+ */
+#ifdef DISABLE_STATS
+#define N_STAT_UPDATE(counter, expr, mode) { \
+    if (0) { counter(mode_stats[(mode) != 0])expr; } \
+}
+#else
 #define N_STAT_UPDATE(counter, expr, mode) { \
-    if(mode) { /* kernel mode */ \
-        counter(kernel_stats)expr; \
-    } else { \
-        counter(user_stats)expr; \
-    } \
+    counter(mode_stats[(mode) != 0])expr; \
 }
+#endif
 
 namespace Memory {
 
@@ -188,11 +197,16 @@ struct MESIStats : public BaseCacheStats {
 
     StatArray<W64,16> state_transition;
 
+    /* Coherence messages that reached this private cache after its core
+     * was simulated past the sender's cycle (-sync-quantum only) */
+    StatObj<W64> late_coherence;
+
     MESIStats(const char *name, Statable *parent=NULL)
         :BaseCacheStats(name, parent)
          ,miss_state("miss_state",this)
          ,hit_state("hit_state",this)
          ,state_transition("state_transition",this)
+         ,late_coherence("late_coherence",this)
     {}
 };
 
@@ -224,6 +238,19 @@ struct BusStats : public Statable {
         {}
     } broadcast_cycles;
 
+    struct snoop_filter : public Statable {
+        StatObj<W64> forwarded;
+        StatObj<W64> filtered;
+        StatObj<W64> back_invalidations;
+
+        snoop_filter(Statable *parent)
+            : Statable("snoop_filter", parent)
+            , forwarded("forwarded", this)
+            , filtered("filtered", this)
+            , back_invalidations("back_invalidations", this)
+        {}
+    } snoop_filter;
+
     StatObj<W64> addr_bus_cycles;
     StatObj<W64> data_bus_cycles;
     StatObj<W64> bus_not_ready;
@@ -232,12 +259,56 @@ struct BusStats : public Statable {
         : Statable(name, parent)
           , broadcasts(this)
           , broadcast_cycles(this)
+          , snoop_filter(this)
           , addr_bus_cycles("addr_bus_cycles", this)
           , data_bus_cycles("data_bus_cycles", this)
           , bus_not_ready("bus_not_ready", this)
     {}
 };
 
+struct MeshStats : public Statable {
+
+    StatObj<W64> packets;
+    StatObj<W64> flits;
+    StatObj<W64> hops;
+    StatObj<W64> latency;
+    StatObj<W64> credit_stalls;
+    StatObj<W64> inject_stalls;
+    StatObj<W64> deliver_stalls;
+
+    /* Flits sent on each link, index router * 4 + direction
+     * (north, east, south, west) */
+    StatArray<W64, MESH_LINKS> link_flits;
+
+    MeshStats(const char* name, Statable *parent)
+        : Statable(name, parent)
+          , packets("packets", this)
+          , flits("flits", this)
+          , hops("hops", this)
+          , latency("latency", this)
+          , credit_stalls("credit_stalls", this)
+          , inject_stalls("inject_stalls", this)
+          , deliver_stalls("deliver_stalls", this)
+          , link_flits("link_flits", this)
+    {}
+};
+
+struct DirectoryStats : public Statable {
+
+    StatObj<W64> accesses;
+    StatObj<W64> port_wait_cycles;
+    StatObj<W64> evictions;
+    StatObj<W64> back_invalidations;
+
+    DirectoryStats(const char* name, Statable *parent)
+        : Statable(name, parent)
+          , accesses("accesses", this)
+          , port_wait_cycles("port_wait_cycles", this)
+          , evictions("evictions", this)
+          , back_invalidations("back_invalidations", this)
+    {}
+};
+
 struct RAMStats : public Statable {
 
     StatArray<W64, MEM_BANKS> bank_access;
@@ -254,6 +325,23 @@ struct RAMStats : public Statable {
     {}
 };
 
+/* Per organisation stats of stacked DRAM model */
+struct StackedDramStats : public Statable {
+
+    StatObj<W64> row_buffer_hit;
+    StatObj<W64> row_buffer_miss;
+    StatObj<W64> total_latency;
+    StatArray<W64, STACKED_DRAM_HIST_BUCKETS> latency_hist;
+
+    StackedDramStats(const char* name, Statable *parent)
+        : Statable(name, parent)
+          , row_buffer_hit("row_buffer_hit", this)
+          , row_buffer_miss("row_buffer_miss", this)
+          , total_latency("total_latency", this)
+          , latency_hist("latency_hist", this)
+    {}
+};
+
 };
 
 #endif // MEMORY_STATS_H
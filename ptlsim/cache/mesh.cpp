@@ -0,0 +1,453 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifdef MEM_TEST
+#include <test.h>
+#else
+#include <ptlsim.h>
+#endif
+
+#include <mesh.h>
+#include <memoryHierarchy.h>
+
+#include <machine.h>
+
+using namespace Memory;
+using namespace Memory::MeshInterconnect;
+
+#define MESH_FLIT_SIZE 16
+
+/* Tile number at end of controller name, 0 if there is none */
+static int name_tile(const char *name, int &prefix_len)
+{
+    int len = strlen(name);
+    int i = len;
+
+    while (i > 0 && isdigit(name[i - 1]))
+        i--;
+
+    prefix_len = i;
+    return (i < len) ? atoi(name + i) : 0;
+}
+
+Mesh::Mesh(const char *name, MemoryHierarchy *memoryHierarchy)
+    : Interconnect(name, memoryHierarchy)
+    , clockActive_(false)
+{
+    memoryHierarchy_->add_interconnect(this);
+    new_stats = new MeshStats(name, &memoryHierarchy->get_machine());
+
+    SET_SIGNAL_CB(name, "_clock", clock_, &Mesh::clock_cb);
+
+    new_stats->set_default_stats(user_stats);
+
+    BaseMachine &machine = memoryHierarchy_->get_machine();
+
+    if (!machine.get_option(name, "width", config_.width))
+        config_.width = 0;
+    if (!machine.get_option(name, "height", config_.height))
+        config_.height = 0;
+    machine.get_option(name, "vcs", config_.vcs);
+    machine.get_option(name, "vc_buffer", config_.vc_buffer);
+    machine.get_option(name, "router_latency", config_.router_latency);
+    machine.get_option(name, "link_latency", config_.link_latency);
+
+    if (!machine.get_option(name, "flit_size", flitSize_))
+        flitSize_ = MESH_FLIT_SIZE;
+
+    assert(flitSize_ > 0);
+    dataFlits_ = 1 + ((1 << MESH_BANK_LINE_BITS) + flitSize_ - 1) /
+        flitSize_;
+
+    /* A data packet must fit in one virtual channel buffer */
+    config_.vc_buffer = max(config_.vc_buffer, dataFlits_);
+
+    setup();
+}
+
+Mesh::~Mesh()
+{
+    delete new_stats;
+}
+
+/* Controllers are added by setup() from the connection definition */
+void Mesh::register_controller(Controller *controller)
+{
+    find_controller(controller);
+}
+
+/**
+ * @brief Build the mesh from this interconnect's connection definition
+ *
+ * All controllers are created before interconnects, so controllers can be
+ * placed on tiles and bank groups found here.
+ */
+void Mesh::setup()
+{
+    /* Controllers on lower side of this interconnect */
+    dynarray<bool> lower;
+
+    BaseMachine &machine = memoryHierarchy_->get_machine();
+    foreach (i, machine.connections.count()) {
+        ConnectionDef *conn_def = machine.connections[i];
+
+        if (strcmp(conn_def->name.buf, get_name()) != 0)
+            continue;
+
+        foreach (j, conn_def->connections.count()) {
+            SingleConnection *sg = conn_def->connections[j];
+            Controller **cont = machine.controller_hash.get(sg->controller);
+            assert(cont);
+
+            MeshController mc;
+            mc.controller = *cont;
+            mc.node = 0;
+            mc.group = -1;
+            controllers_.push(mc);
+
+            lower.push(sg->type == INTERCONN_TYPE_UPPER ||
+                    sg->type == INTERCONN_TYPE_DIRECTORY);
+        }
+    }
+
+    int prefix_len;
+    int tiles = 1;
+
+    foreach (i, controllers_.count()) {
+        int tile = name_tile(controllers_[i].controller->get_name(),
+                prefix_len);
+        tiles = max(tiles, tile + 1);
+    }
+
+    if (config_.width <= 0 && config_.height <= 0) {
+        config_.width = 1;
+        while (config_.width * config_.width < tiles)
+            config_.width++;
+    }
+    if (config_.width <= 0)
+        config_.width = (tiles + config_.height - 1) / config_.height;
+    if (config_.height <= 0)
+        config_.height = (tiles + config_.width - 1) / config_.width;
+
+    int nodes = config_.width * config_.height;
+    assert(nodes <= MESH_MAX_NODES);
+
+    foreach (i, controllers_.count()) {
+        controllers_[i].node = name_tile(
+                controllers_[i].controller->get_name(), prefix_len) % nodes;
+    }
+
+    /* Group lower controllers by name prefix */
+    foreach (i, controllers_.count()) {
+        if (!lower[i] || controllers_[i].group >= 0)
+            continue;
+
+        const char *name = controllers_[i].controller->get_name();
+        name_tile(name, prefix_len);
+
+        BankGroup group;
+        group.first = bankMembers_.count();
+        group.count = 0;
+
+        for (int j = i; j < controllers_.count(); j++) {
+            const char *other = controllers_[j].controller->get_name();
+            int other_len;
+            name_tile(other, other_len);
+
+            if (!lower[j] || other_len != prefix_len ||
+                    strncmp(name, other, prefix_len) != 0)
+                continue;
+
+            controllers_[j].group = groups_.count();
+            bankMembers_.push(j);
+            group.count++;
+        }
+
+        groups_.push(group);
+    }
+
+    network_.init(config_, this);
+
+    int max_packets = network_.get_packet_count();
+    messages_.resize(max_packets);
+    freeMessages_.resize(max_packets);
+    foreach (i, max_packets) {
+        messages_[i].in_use = false;
+        freeMessages_[i] = max_packets - 1 - i;
+    }
+}
+
+int Mesh::find_controller(Controller *controller) const
+{
+    foreach (i, controllers_.count()) {
+        if (controllers_[i].controller == controller)
+            return i;
+    }
+
+    assert(0);
+    return -1;
+}
+
+/* Bank of the group that holds the request's cache line */
+int Mesh::get_bank(int group, MemoryRequest *request) const
+{
+    const BankGroup &g = groups_[group];
+    W64 line = request->get_physical_address() >> MESH_BANK_LINE_BITS;
+
+    return bankMembers_[g.first + (line % g.count)];
+}
+
+/* Controller index a message for 'dest' is delivered to */
+int Mesh::get_dest(Controller *dest, MemoryRequest *request) const
+{
+    int idx = find_controller(dest);
+    int group = controllers_[idx].group;
+
+    if (group >= 0 && groups_[group].count > 1)
+        return get_bank(group, request);
+
+    return idx;
+}
+
+bool Mesh::controller_request_cb(void *arg)
+{
+    Message *msg = (Message*)arg;
+
+    int src = find_controller((Controller*)msg->sender);
+    int dst = get_dest((Controller*)msg->dest, msg->request);
+
+    if (freeMessages_.count() == 0) {
+        N_STAT_UPDATE(new_stats->inject_stalls, ++,
+                msg->request->is_kernel());
+        return false;
+    }
+
+    int id = freeMessages_[freeMessages_.count() - 1];
+    MeshMessage &mm = messages_[id];
+
+    /* Requests and responses use different virtual channels */
+    int flits = msg->hasData ? dataFlits_ : 1;
+    int vc_class = msg->hasData ? 1 : 0;
+
+    if (!network_.inject(controllers_[src].node, controllers_[dst].node,
+                flits, vc_class, &mm, sim_cycle)) {
+        N_STAT_UPDATE(new_stats->inject_stalls, ++,
+                msg->request->is_kernel());
+        return false;
+    }
+
+    freeMessages_.pop();
+
+    mm.request  = msg->request;
+    mm.source   = (Controller*)msg->sender;
+    mm.dest     = controllers_[dst].controller;
+    mm.arg      = msg->arg;
+    mm.has_data = msg->hasData;
+    mm.shared   = msg->isShared;
+    mm.annuled  = false;
+    mm.in_use   = true;
+    mm.request->incRefCounter();
+    ADD_HISTORY_ADD(mm.request);
+
+    if (!clockActive_) {
+        marss_add_event(&clock_, 1, NULL);
+        clockActive_ = true;
+    }
+
+    return true;
+}
+
+bool Mesh::clock_cb(void *arg)
+{
+    network_.clock(sim_cycle);
+
+    if (network_.in_flight()) {
+        marss_add_event(&clock_, 1, NULL);
+    } else {
+        clockActive_ = false;
+    }
+
+    return true;
+}
+
+bool Mesh::mesh_deliver(MeshPacket &packet)
+{
+    MeshMessage &mm = *(MeshMessage*)packet.payload;
+
+    if (!mm.annuled) {
+        Message *msg = memoryHierarchy_->get_message();
+        msg->sender   = this;
+        msg->origin   = mm.source;
+        msg->dest     = mm.dest;
+        msg->request  = mm.request;
+        msg->arg      = mm.arg;
+        msg->hasData  = mm.has_data;
+        msg->isShared = mm.shared;
+
+        bool success = mm.dest->get_interconnect_signal()->emit(msg);
+
+        memoryHierarchy_->free_message(msg);
+
+        memdebug("Mesh sending message success: " << success << endl);
+
+        bool kernel = mm.request->is_kernel();
+
+        if (!success) {
+            N_STAT_UPDATE(new_stats->deliver_stalls, ++, kernel);
+            return false;
+        }
+
+        N_STAT_UPDATE(new_stats->packets, ++, kernel);
+        N_STAT_UPDATE(new_stats->flits, += packet.flits, kernel);
+        N_STAT_UPDATE(new_stats->hops, += packet.hops, kernel);
+        N_STAT_UPDATE(new_stats->latency,
+                += sim_cycle - packet.inject_cycle, kernel);
+
+        mm.request->decRefCounter();
+        ADD_HISTORY_REM(mm.request);
+    }
+
+    mm.in_use = false;
+    freeMessages_.push(&mm - &messages_[0]);
+
+    return true;
+}
+
+void Mesh::mesh_link_used(int node, int port, const MeshPacket &packet)
+{
+    MeshMessage &mm = *(MeshMessage*)packet.payload;
+    N_STAT_UPDATE(new_stats->link_flits, [node * 4 + port] += packet.flits,
+            mm.request->is_kernel());
+}
+
+void Mesh::mesh_credit_stall(const MeshPacket &packet)
+{
+    MeshMessage &mm = *(MeshMessage*)packet.payload;
+    N_STAT_UPDATE(new_stats->credit_stalls, ++, mm.request->is_kernel());
+}
+
+int Mesh::access_fast_path(Controller *controller,
+        MemoryRequest *request)
+{
+    return -1;
+}
+
+/**
+ * @brief Pass functional warmup request to the other controllers
+ *
+ * Like Switch it goes to every other controller, except that only the
+ * bank that holds the line gets it from each bank group.
+ */
+bool Mesh::warmup(Controller *controller, MemoryRequest *request)
+{
+    bool shared = false;
+
+    foreach (i, controllers_.count()) {
+        MeshController &mc = controllers_[i];
+
+        if (mc.controller == controller)
+            continue;
+
+        if (mc.group >= 0 && get_bank(mc.group, request) != i)
+            continue;
+
+        shared |= mc.controller->warmup(this, request);
+    }
+
+    return shared;
+}
+
+void Mesh::annul_request(MemoryRequest *request)
+{
+    foreach (i, messages_.count()) {
+        MeshMessage &mm = messages_[i];
+
+        if (mm.in_use && !mm.annuled && mm.request->is_same(request)) {
+            /* Packet still moves through the mesh and is dropped at its
+             * destination */
+            mm.annuled = true;
+            mm.request->decRefCounter();
+            ADD_HISTORY_REM(mm.request);
+        }
+    }
+}
+
+void Mesh::print(ostream& os) const
+{
+    os << "--Mesh-Interconnect: ", get_name(), endl;
+    os << network_;
+    os << "--End-Mesh-Interconnect\n";
+}
+
+void Mesh::print_map(ostream& os)
+{
+    os << "Mesh Interconnect: ", get_name(), " ", config_.width, "x",
+       config_.height, endl;
+    os << "\tconnected to: ", endl;
+
+    foreach (i, controllers_.count()) {
+        os << "\t\tcontroller[", i, "]: ";
+        os << controllers_[i].controller->get_name(), " tile ",
+           controllers_[i].node;
+        if (controllers_[i].group >= 0)
+            os << " bank group ", controllers_[i].group;
+        os << endl;
+    }
+}
+
+/**
+ * @brief Dump Mesh Interconnect Configuration in YAML Format
+ *
+ * @param out YAML Object
+ */
+void Mesh::dump_configuration(YAML::Emitter &out) const
+{
+    out << YAML::Key << get_name() << YAML::Value << YAML::BeginMap;
+
+    YAML_KEY_VAL(out, "type", "interconnect");
+    YAML_KEY_VAL(out, "topology", "mesh");
+    YAML_KEY_VAL(out, "width", config_.width);
+    YAML_KEY_VAL(out, "height", config_.height);
+    YAML_KEY_VAL(out, "vcs", config_.vcs);
+    YAML_KEY_VAL(out, "vc_buffer", config_.vc_buffer);
+    YAML_KEY_VAL(out, "router_latency", config_.router_latency);
+    YAML_KEY_VAL(out, "link_latency", config_.link_latency);
+    YAML_KEY_VAL(out, "flit_size", flitSize_);
+
+    out << YAML::EndMap;
+}
+
+struct MeshBuilder : public InterconnectBuilder
+{
+    MeshBuilder(const char *name) :
+        InterconnectBuilder(name)
+    { }
+
+    Interconnect* get_new_interconnect(MemoryHierarchy &mem,
+            const char *name)
+    {
+        return new Mesh(name, &mem);
+    }
+};
+
+MeshBuilder meshBuilder("mesh");
@@ -0,0 +1,140 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef MESH_INTERCONNECT_H
+#define MESH_INTERCONNECT_H
+
+#include <interconnect.h>
+#include <memoryStats.h>
+#include <meshNetwork.h>
+
+namespace Memory {
+
+namespace MeshInterconnect {
+
+    /* Message carried by a mesh packet */
+    struct MeshMessage {
+        MemoryRequest *request;
+        Controller    *source;
+        Controller    *dest;
+        void          *arg;
+        bool           has_data;
+        bool           shared;
+        bool           annuled;
+        bool           in_use;
+    };
+
+    /* Controller attached to a router */
+    struct MeshController {
+        Controller *controller;
+        int         node;
+        int         group; /* Bank group or -1 */
+    };
+
+    /* Controllers that are banks of one distributed cache/directory */
+    struct BankGroup {
+        int first; /* Index in bankMembers_ */
+        int count;
+    };
+
+    /**
+     * @brief 2D mesh network-on-chip interconnect
+     *
+     * Each controller is attached to the router of the tile given by the
+     * number at the end of its name (L2_5 and L3_5 share tile 5), so a
+     * tiled machine with a distributed L3 connects all private caches and
+     * L3 banks to one mesh:
+     *
+     *   - type: mesh
+     *     option:
+     *       width: 4
+     *     connections:
+     *       - L2_*: LOWER
+     *         L3_*: UPPER
+     *
+     * Controllers connected as UPPER or DIRECTORY with the same name
+     * prefix are banks: a message for any of them is sent to the bank
+     * selected by its cache line address.
+     *
+     * Options: width, height (default: smallest square that fits all
+     * tiles), vcs, vc_buffer (flits), router_latency, link_latency,
+     * flit_size (bytes, data messages carry a 64 byte line).
+     */
+    class Mesh : public Interconnect, public MeshClient
+    {
+        private:
+            dynarray<MeshController> controllers_;
+            dynarray<BankGroup> groups_;
+            dynarray<int> bankMembers_;
+
+            MeshConfig config_;
+            MeshNetwork network_;
+            int flitSize_;
+            int dataFlits_;
+
+            dynarray<MeshMessage> messages_;
+            dynarray<int> freeMessages_;
+
+            Signal clock_;
+            bool clockActive_;
+
+            MeshStats *new_stats;
+
+            void setup();
+            int find_controller(Controller *controller) const;
+            int get_bank(int group, MemoryRequest *request) const;
+            int get_dest(Controller *dest, MemoryRequest *request) const;
+
+        public:
+            Mesh(const char *name, MemoryHierarchy *memoryHierarchy);
+            ~Mesh();
+
+            bool controller_request_cb(void *arg);
+            void register_controller(Controller *controller);
+            int  access_fast_path(Controller *controller,
+                    MemoryRequest *request);
+            bool warmup(Controller *controller, MemoryRequest *request);
+            void annul_request(MemoryRequest *request);
+            int  get_delay() { return config_.router_latency; }
+            void dump_configuration(YAML::Emitter &out) const;
+
+            bool clock_cb(void *arg);
+
+            bool mesh_deliver(MeshPacket &packet);
+            void mesh_link_used(int node, int port, const MeshPacket &packet);
+            void mesh_credit_stall(const MeshPacket &packet);
+
+            void print(ostream& os) const;
+            void print_map(ostream& os);
+    };
+
+    static inline ostream& operator <<(ostream& os, const Mesh &mesh)
+    {
+        mesh.print(os);
+        return os;
+    }
+};
+
+};
+
+#endif // MESH_INTERCONNECT_H
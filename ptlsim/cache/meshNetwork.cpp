@@ -0,0 +1,360 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <meshNetwork.h>
+
+using namespace Memory;
+
+/* Input port a packet arrives on after leaving through 'port' */
+static inline int opposite_port(int port)
+{
+    return port ^ 2;
+}
+
+MeshNetwork::MeshNetwork()
+    : client_(NULL)
+    , nodes_(0)
+    , inFlight_(0)
+    , creditHead_(0)
+    , creditCount_(0)
+{
+}
+
+void MeshNetwork::init(const MeshConfig &config, MeshClient *client)
+{
+    assert(config.width > 0 && config.height > 0);
+    assert(config.vcs > 0);
+    assert(config.vc_buffer > 0);
+    assert(config.router_latency > 0);
+    assert(config.link_latency > 0);
+
+    config_ = config;
+    client_ = client;
+    nodes_ = config.width * config.height;
+    inFlight_ = 0;
+
+    int vcs = nodes_ * MESH_PORTS * config.vcs;
+
+    /* Every buffered packet has at least one flit */
+    int max_packets = vcs * config.vc_buffer;
+
+    packets_.resize(max_packets);
+    freePackets_.resize(max_packets);
+    foreach (i, max_packets) {
+        packets_[i].in_use = false;
+        packets_[i].payload = NULL;
+        freePackets_[i] = max_packets - 1 - i;
+    }
+
+    vcQueue_.resize(max_packets, -1);
+    vcHead_.resize(vcs, 0);
+    vcCount_.resize(vcs, 0);
+    vcFlits_.resize(vcs, 0);
+
+    credits_.resize(vcs, 0);
+    foreach (node, nodes_) {
+        foreach (port, MESH_LOCAL) {
+            if (neighbour(node, port) < 0)
+                continue;
+            foreach (vc, config.vcs) {
+                credits_[vc_index(node, port, vc)] = config.vc_buffer;
+            }
+        }
+    }
+
+    creditRing_.resize(max_packets);
+    creditHead_ = 0;
+    creditCount_ = 0;
+
+    portBusy_.resize(nodes_ * MESH_PORTS, 0);
+    routerPackets_.resize(nodes_, 0);
+    roundRobin_.resize(nodes_, 0);
+}
+
+/* Neighbour router on given port or -1 at mesh edge */
+int MeshNetwork::neighbour(int node, int port) const
+{
+    int x = node % config_.width;
+    int y = node / config_.width;
+
+    switch (port) {
+        case MESH_NORTH: return (y > 0) ? node - config_.width : -1;
+        case MESH_SOUTH: return (y < config_.height - 1) ?
+                         node + config_.width : -1;
+        case MESH_WEST:  return (x > 0) ? node - 1 : -1;
+        case MESH_EAST:  return (x < config_.width - 1) ? node + 1 : -1;
+        default:         return node;
+    }
+}
+
+/* XY routing: move along the row first, then along the column */
+int MeshNetwork::route(int node, int dst) const
+{
+    int x = node % config_.width;
+    int dst_x = dst % config_.width;
+
+    if (dst_x > x) return MESH_EAST;
+    if (dst_x < x) return MESH_WEST;
+
+    int y = node / config_.width;
+    int dst_y = dst / config_.width;
+
+    if (dst_y > y) return MESH_SOUTH;
+    if (dst_y < y) return MESH_NORTH;
+
+    return MESH_LOCAL;
+}
+
+int MeshNetwork::get_hops(int src, int dst) const
+{
+    return abs(src % config_.width - dst % config_.width) +
+        abs(src / config_.width - dst / config_.width);
+}
+
+int MeshNetwork::get_zero_load_latency(int src, int dst, int flits) const
+{
+    int hops = get_hops(src, dst);
+    return (hops + 1) * config_.router_latency +
+        hops * (config_.link_latency + flits - 1);
+}
+
+/**
+ * @brief Find a virtual channel of given class with room for a packet
+ *
+ * @param output Check credits of output port instead of buffer of input
+ * port
+ *
+ * @return Virtual channel or -1 if all of them are full
+ */
+int MeshNetwork::find_vc(int node, int port, int vc_class, int flits,
+        bool output) const
+{
+    int step = (config_.vcs > 1) ? 2 : 1;
+    int first = (config_.vcs > 1) ? (vc_class & 1) : 0;
+
+    for (int vc = first; vc < config_.vcs; vc += step) {
+        int idx = vc_index(node, port, vc);
+        if (output) {
+            if (credits_[idx] >= flits)
+                return vc;
+        } else {
+            if (vcCount_[idx] < config_.vc_buffer &&
+                    vcFlits_[idx] + flits <= config_.vc_buffer)
+                return vc;
+        }
+    }
+
+    return -1;
+}
+
+void MeshNetwork::push(int node, int port, int vc, int id)
+{
+    int idx = vc_index(node, port, vc);
+    assert(vcCount_[idx] < config_.vc_buffer);
+
+    int slot = (vcHead_[idx] + vcCount_[idx]) % config_.vc_buffer;
+    vcQueue_[idx * config_.vc_buffer + slot] = id;
+    vcCount_[idx]++;
+    vcFlits_[idx] += packets_[id].flits;
+    routerPackets_[node]++;
+}
+
+int MeshNetwork::pop(int node, int port, int vc)
+{
+    int idx = vc_index(node, port, vc);
+    assert(vcCount_[idx] > 0);
+
+    int id = vcQueue_[idx * config_.vc_buffer + vcHead_[idx]];
+    vcHead_[idx] = (vcHead_[idx] + 1) % config_.vc_buffer;
+    vcCount_[idx]--;
+    vcFlits_[idx] -= packets_[id].flits;
+    routerPackets_[node]--;
+
+    return id;
+}
+
+bool MeshNetwork::inject(int src, int dst, int flits, int vc_class,
+        void *payload, W64 cycle)
+{
+    assert(src >= 0 && src < nodes_);
+    assert(dst >= 0 && dst < nodes_);
+    assert(flits > 0 && flits <= config_.vc_buffer);
+
+    int vc = find_vc(src, MESH_LOCAL, vc_class, flits, false);
+    if (vc < 0)
+        return false;
+
+    assert(freePackets_.count() > 0);
+    int id = freePackets_.pop();
+
+    MeshPacket &packet = packets_[id];
+    packet.payload = payload;
+    packet.src = src;
+    packet.dst = dst;
+    packet.flits = flits;
+    packet.vc_class = vc_class;
+    packet.hops = 0;
+    packet.inject_cycle = cycle;
+    packet.ready_cycle = cycle + config_.router_latency;
+    packet.in_use = true;
+
+    push(src, MESH_LOCAL, vc, id);
+    inFlight_++;
+
+    return true;
+}
+
+/* Free buffer space of input (node, port, vc) in its upstream router */
+void MeshNetwork::return_credit(int node, int port, int vc, int flits,
+        W64 cycle)
+{
+    if (port == MESH_LOCAL)
+        return;
+
+    int upstream = neighbour(node, port);
+    assert(upstream >= 0);
+    assert(creditCount_ < creditRing_.count());
+
+    int slot = (creditHead_ + creditCount_) % creditRing_.count();
+    CreditReturn &credit = creditRing_[slot];
+    credit.cycle = cycle + config_.link_latency;
+    credit.index = vc_index(upstream, opposite_port(port), vc);
+    credit.flits = flits;
+    creditCount_++;
+}
+
+void MeshNetwork::clock(W64 cycle)
+{
+    while (creditCount_ > 0 && creditRing_[creditHead_].cycle <= cycle) {
+        CreditReturn &credit = creditRing_[creditHead_];
+        credits_[credit.index] += credit.flits;
+        assert(credits_[credit.index] <= config_.vc_buffer);
+        creditHead_ = (creditHead_ + 1) % creditRing_.count();
+        creditCount_--;
+    }
+
+    foreach (node, nodes_) {
+        if (routerPackets_[node])
+            clock_router(node, cycle);
+    }
+}
+
+/**
+ * @brief Switch allocation and traversal of one router
+ *
+ * Input virtual channels are checked in round robin order starting from a
+ * different one each cycle, and the first ready packet for an output port
+ * wins it.
+ */
+void MeshNetwork::clock_router(int node, W64 cycle)
+{
+    int inputs = MESH_PORTS * config_.vcs;
+    int start = roundRobin_[node];
+    W32 granted = 0;
+
+    foreach (i, inputs) {
+        int in = start + i;
+        if (in >= inputs) in -= inputs;
+
+        int in_port = in / config_.vcs;
+        int in_vc = in % config_.vcs;
+        int idx = vc_index(node, in_port, in_vc);
+
+        if (!vcCount_[idx])
+            continue;
+
+        int id = vcQueue_[idx * config_.vc_buffer + vcHead_[idx]];
+        MeshPacket &packet = packets_[id];
+
+        if (packet.ready_cycle > cycle)
+            continue;
+
+        int out = route(node, packet.dst);
+        int port_idx = node * MESH_PORTS + out;
+
+        if ((granted & (1 << out)) || portBusy_[port_idx] > cycle)
+            continue;
+
+        if (out == MESH_LOCAL) {
+            if (!client_->mesh_deliver(packet))
+                continue;
+
+            pop(node, in_port, in_vc);
+            return_credit(node, in_port, in_vc, packet.flits, cycle);
+
+            packet.in_use = false;
+            packet.payload = NULL;
+            freePackets_.push(id);
+            inFlight_--;
+        } else {
+            int out_vc = find_vc(node, out, packet.vc_class, packet.flits,
+                    true);
+            if (out_vc < 0) {
+                client_->mesh_credit_stall(packet);
+                continue;
+            }
+
+            pop(node, in_port, in_vc);
+            return_credit(node, in_port, in_vc, packet.flits, cycle);
+            credits_[vc_index(node, out, out_vc)] -= packet.flits;
+
+            client_->mesh_link_used(node, out, packet);
+
+            /* Tail flit arrives after link latency and serialization */
+            packet.hops++;
+            packet.ready_cycle = cycle + config_.link_latency +
+                packet.flits - 1 + config_.router_latency;
+            push(neighbour(node, out), opposite_port(out), out_vc, id);
+        }
+
+        granted |= (1 << out);
+        portBusy_[port_idx] = cycle + packet.flits;
+    }
+
+    if (++start >= inputs) start = 0;
+    roundRobin_[node] = start;
+}
+
+ostream& MeshNetwork::print(ostream& os) const
+{
+    os << "Mesh ", config_.width, "x", config_.height, " packets in flight: ",
+       inFlight_, endl;
+
+    foreach (node, nodes_) {
+        if (!routerPackets_[node])
+            continue;
+
+        os << "  router[", node, "]";
+        foreach (port, MESH_PORTS) {
+            foreach (vc, config_.vcs) {
+                int idx = vc_index(node, port, vc);
+                if (vcCount_[idx])
+                    os << " ", mesh_port_names[port], ".", vc, ":",
+                       vcCount_[idx], "/", vcFlits_[idx];
+            }
+        }
+        os << endl;
+    }
+
+    return os;
+}
@@ -0,0 +1,205 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef MESH_NETWORK_H
+#define MESH_NETWORK_H
+
+#include <globals.h>
+#include <superstl.h>
+
+namespace Memory {
+
+/* Router ports, first four are links to neighbour routers */
+enum MeshPort {
+    MESH_NORTH,
+    MESH_EAST,
+    MESH_SOUTH,
+    MESH_WEST,
+    MESH_LOCAL,
+    MESH_PORTS
+};
+
+static const char* mesh_port_names[MESH_PORTS] = {
+    "north",
+    "east",
+    "south",
+    "west",
+    "local",
+};
+
+struct MeshConfig {
+    int width;
+    int height;
+    int vcs;            /* Virtual channels per input port */
+    int vc_buffer;      /* Buffer size of each virtual channel in flits */
+    int router_latency; /* Router pipeline stages */
+    int link_latency;
+
+    MeshConfig()
+        : width(1), height(1), vcs(2), vc_buffer(4)
+        , router_latency(2), link_latency(1)
+    {}
+};
+
+struct MeshPacket {
+    void *payload;
+    int src;
+    int dst;
+    int flits;
+    int vc_class;
+    int hops;
+    W64 inject_cycle;
+    W64 ready_cycle; /* Cycle packet can leave its current router */
+    bool in_use;
+};
+
+/* Receives packets and link events from MeshNetwork */
+class MeshClient
+{
+    public:
+        virtual ~MeshClient() {}
+
+        /* Deliver packet at its destination node, return false to retry
+         * in next cycle */
+        virtual bool mesh_deliver(MeshPacket &packet) = 0;
+
+        /* Packet is sent on output 'port' of router 'node' */
+        virtual void mesh_link_used(int node, int port,
+                const MeshPacket &packet) {}
+
+        /* Packet at head of a virtual channel can't leave for lack of
+         * credits */
+        virtual void mesh_credit_stall(const MeshPacket &packet) {}
+};
+
+/*
+ * MeshNetwork
+ *
+ * 2D mesh of routers with dimension order (XY) routing, virtual channels
+ * and credit based flow control, moving whole packets between routers
+ * (virtual cut-through). A packet leaves a router when it has spent
+ * 'router_latency' cycles in it, its output port is free and the
+ * downstream input buffer has credits for all of its flits; the output
+ * link is then busy for one cycle per flit. Each output port grants one
+ * packet per cycle, input virtual channels are served round robin.
+ *
+ * Packets of different classes (requests and responses) use separate
+ * virtual channels when there are at least two, so responses are not
+ * blocked behind requests waiting for the same controller.
+ *
+ * All router state is kept in flat arrays indexed by router, port and
+ * virtual channel, and idle routers are skipped.
+ */
+class MeshNetwork
+{
+    public:
+        MeshNetwork();
+
+        void init(const MeshConfig &config, MeshClient *client);
+
+        /* Queue packet at local input port of 'src', returns false if
+         * there is no buffer space */
+        bool inject(int src, int dst, int flits, int vc_class,
+                void *payload, W64 cycle);
+
+        /* Move packets, call once per cycle while in_flight() */
+        void clock(W64 cycle);
+
+        int in_flight() const { return inFlight_; }
+        int get_nodes() const { return nodes_; }
+        int get_hops(int src, int dst) const;
+        const MeshConfig& get_config() const { return config_; }
+
+        /* For annulling requests */
+        int get_packet_count() const { return packets_.count(); }
+        MeshPacket& get_packet(int i) { return packets_[i]; }
+
+        /* Zero load latency from injection to delivery */
+        int get_zero_load_latency(int src, int dst, int flits) const;
+
+        ostream& print(ostream& os) const;
+
+    private:
+        MeshConfig config_;
+        MeshClient *client_;
+        int nodes_;
+        int inFlight_;
+
+        /* Packet pool */
+        dynarray<MeshPacket> packets_;
+        dynarray<int> freePackets_;
+
+        /* Input virtual channels, index (node * MESH_PORTS + port) * vcs + vc.
+         * Each one is a ring of packet ids with room for vc_buffer packets */
+        dynarray<int> vcQueue_;
+        dynarray<int> vcHead_;
+        dynarray<int> vcCount_;
+        dynarray<int> vcFlits_;
+
+        /* Free flits in downstream buffer of each output virtual channel,
+         * same index as input virtual channels */
+        dynarray<int> credits_;
+
+        /* Credits on their way back to upstream routers, they arrive
+         * link_latency cycles after a packet leaves a buffer so the ring
+         * is in arrival order */
+        struct CreditReturn {
+            W64 cycle;
+            int index;
+            int flits;
+        };
+        dynarray<CreditReturn> creditRing_;
+        int creditHead_;
+        int creditCount_;
+
+        /* Cycle output port, index node * MESH_PORTS + port, is free */
+        dynarray<W64> portBusy_;
+
+        dynarray<int> routerPackets_;
+        dynarray<int> roundRobin_;
+
+        int vc_index(int node, int port, int vc) const {
+            return (node * MESH_PORTS + port) * config_.vcs + vc;
+        }
+
+        int neighbour(int node, int port) const;
+        int route(int node, int dst) const;
+        int find_vc(int node, int port, int vc_class, int flits,
+                bool output) const;
+
+        void push(int node, int port, int vc, int id);
+        int pop(int node, int port, int vc);
+
+        void return_credit(int node, int port, int vc, int flits,
+                W64 cycle);
+        void clock_router(int node, W64 cycle);
+};
+
+static inline ostream& operator <<(ostream& os, const MeshNetwork &mesh)
+{
+    return mesh.print(os);
+}
+
+};
+
+#endif // MESH_NETWORK_H
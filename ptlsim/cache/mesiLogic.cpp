@@ -149,8 +149,17 @@ void MESILogic::handle_interconn_hit(CacheQueueEntry *queueEntry)
     N_STAT_UPDATE(hit_state.snoop, [oldState]++,
                  kernel_req);
     if(type == MEMORY_OP_EVICT) {
-        if(controller->is_lowest_private())
+        if(controller->is_lowest_private()) {
+            /*
+             * Peers only evict shared copies, a modified line is evicted
+             * when bus back-invalidates it, so write back its data
+             */
+            if(oldState == MESI_MODIFIED) {
+                controller->send_update_to_lower(queueEntry);
+                N_STAT_UPDATE(evict_writeback, ++, kernel_req);
+            }
             controller->send_evict_to_upper(queueEntry);
+        }
         UPDATE_MESI_TRANS_STATS(oldState, MESI_INVALID, kernel_req);
         queueEntry->line->state = MESI_INVALID;
         controller->clear_entry_cb(queueEntry);
@@ -448,6 +457,53 @@ void MESILogic::handle_response(CacheQueueEntry *entry, Message &msg)
 {
 }
 
+bool MESILogic::warmup_hit(CacheLine *line, bool is_write)
+{
+    switch(line->state) {
+        case MESI_INVALID:
+            return false;
+        case MESI_EXCLUSIVE:
+            /* Same as handle_local_hit(): only lowest private cache
+             * upgrades the line without asking lower level */
+            if(is_write) {
+                if(!controller->is_lowest_private())
+                    return false;
+                line->state = MESI_MODIFIED;
+            }
+            return true;
+        case MESI_SHARED:
+            return !is_write;
+        case MESI_MODIFIED:
+            return true;
+        default:
+            assert(0);
+    }
+    return false;
+}
+
+void MESILogic::warmup_fill(CacheLine *line, bool is_write, bool isShared)
+{
+    if(is_write)
+        line->state = MESI_MODIFIED;
+    else if(isShared)
+        line->state = MESI_SHARED;
+    else
+        line->state = MESI_EXCLUSIVE;
+}
+
+bool MESILogic::warmup_snoop(CacheLine *line, bool is_write)
+{
+    if(line->state == MESI_INVALID)
+        return false;
+
+    if(is_write)
+        line->state = MESI_INVALID;
+    else
+        line->state = MESI_SHARED;
+
+    return true;
+}
+
 /**
  * @brief Dump MESI Coherence Logic Configuration
  *
@@ -30,11 +30,7 @@
 #include <coherenceLogic.h>
 
 #define UPDATE_MESI_TRANS_STATS(old_state, new_state, mode) \
-    if(mode) { /* kernel mode */ \
-        state_transition(kernel_stats)[(old_state << 2) | new_state]++; \
-    } else { \
-        state_transition(user_stats)[(old_state << 2) | new_state]++; \
-    }
+    N_STAT_UPDATE(state_transition, [(old_state << 2) | new_state]++, mode)
 
 namespace Memory {
 
@@ -71,6 +67,7 @@ namespace CoherentCache {
                   , miss_state("miss_state", this)
                   , hit_state("hit_state", this)
                   , state_transition("state_transition", this)
+                  , evict_writeback("evict_writeback", this)
             {}
 
             void handle_local_hit(CacheQueueEntry *queueEntry);
@@ -85,6 +82,9 @@ namespace CoherentCache {
                     Message &message);
             bool is_line_valid(CacheLine *line);
             void invalidate_line(CacheLine *line);
+            bool warmup_hit(CacheLine *line, bool is_write);
+            void warmup_fill(CacheLine *line, bool is_write, bool isShared);
+            bool warmup_snoop(CacheLine *line, bool is_write);
 			void dump_configuration(YAML::Emitter &out) const;
 
             MESICacheLineState get_new_state(CacheQueueEntry *queueEntry, bool isShared);
@@ -110,6 +110,9 @@ namespace CoherentCache {
             } hit_state;
 
             StatArray<W64,16> state_transition;
+
+            /* Modified lines written back on eviction by interconnect */
+            StatObj<W64> evict_writeback;
     };
 };
 
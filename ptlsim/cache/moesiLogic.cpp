@@ -394,6 +394,62 @@ bool MOESILogic::is_line_valid(CacheLine *line)
     return true;
 }
 
+bool MOESILogic::warmup_hit(CacheLine *line, bool is_write)
+{
+    switch (line->state) {
+        case MOESI_INVALID:
+            return false;
+        case MOESI_EXCLUSIVE:
+            if (is_write) {
+                if (!controller->is_lowest_private())
+                    return false;
+                line->state = MOESI_MODIFIED;
+            }
+            return true;
+        case MOESI_OWNER:
+        case MOESI_SHARED:
+            /* Writes have to invalidate other copies */
+            return !is_write;
+        case MOESI_MODIFIED:
+            return true;
+        default:
+            assert(0);
+    }
+    return false;
+}
+
+void MOESILogic::warmup_fill(CacheLine *line, bool is_write, bool isShared)
+{
+    if (is_write)
+        line->state = MOESI_MODIFIED;
+    else if (isShared)
+        line->state = MOESI_SHARED;
+    else
+        line->state = MOESI_EXCLUSIVE;
+}
+
+bool MOESILogic::warmup_snoop(CacheLine *line, bool is_write)
+{
+    switch (line->state) {
+        case MOESI_INVALID:
+            return false;
+        case MOESI_MODIFIED:
+            /* Dirty line is kept as owner and supplies the data */
+            line->state = MOESI_OWNER;
+            break;
+        case MOESI_EXCLUSIVE:
+            line->state = MOESI_SHARED;
+            break;
+        default:
+            break;
+    }
+
+    if (is_write)
+        line->state = MOESI_INVALID;
+
+    return true;
+}
+
 void MOESILogic::handle_response(CacheQueueEntry *queueEntry,
         Message &message)
 {
@@ -440,7 +496,7 @@ void MOESILogic::send_to_cont(CacheQueueEntry *queueEntry,
         Interconnect *sendTo, Controller *dest)
 {
     queueEntry->dest = dest;
-    queueEntry->request->get_history() << "{MOESI} ";
+    ADD_HISTORY(queueEntry->request, "{MOESI} ");
 
     send_response(queueEntry, sendTo);
 }
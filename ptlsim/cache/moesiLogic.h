@@ -30,11 +30,8 @@
 #include <coherenceLogic.h>
 
 #define UPDATE_MOESI_TRANS_STATS(old_state, new_state, mode) \
-    if(mode) { /* kernel mode */ \
-        state_transition(kernel_stats)[MOESITransTable[old_state][new_state]]++; \
-    } else { \
-        state_transition(user_stats)[MOESITransTable[old_state][new_state]]++; \
-    }
+    N_STAT_UPDATE(state_transition, [MOESITransTable[old_state][new_state]]++, \
+            mode)
 
 namespace Memory {
 
@@ -97,6 +94,9 @@ namespace CoherentCache {
                     Message &message);
             bool is_line_valid(CacheLine *line);
             void invalidate_line(CacheLine *line);
+            bool warmup_hit(CacheLine *line, bool is_write);
+            void warmup_fill(CacheLine *line, bool is_write, bool isShared);
+            bool warmup_snoop(CacheLine *line, bool is_write);
 			void dump_configuration(YAML::Emitter &out) const;
 
             void send_response(CacheQueueEntry *queueEntry,
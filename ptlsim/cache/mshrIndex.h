@@ -0,0 +1,217 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef MSHR_INDEX_H
+#define MSHR_INDEX_H
+
+#include <globals.h>
+#include <superstl.h>
+#include <statelist.h>
+
+namespace Memory {
+
+/*
+ * MSHRIndex
+ *
+ * Hash index from cache line address to entries of a pending request
+ * queue. Each bucket keeps a doubly linked chain of entry indices in the
+ * order they were inserted, so walking the entries of one line address
+ * visits them in the same order as a scan of the queue's used list.
+ * Insert and remove are O(1), lookup only touches entries whose line
+ * address falls in the same bucket.
+ */
+template <int SIZE>
+class MSHRIndex
+{
+    private:
+        static const int BUCKETS = SIZE * 2;
+        static const W64 BUCKET_MASK = BUCKETS - 1;
+
+        int  head_[BUCKETS];
+        int  tail_[BUCKETS];
+        int  next_[SIZE];
+        int  prev_[SIZE];
+        W64  key_[SIZE];
+        bool used_[SIZE];
+        int  count_;
+
+        static int bucket_of(W64 key) {
+            return int((key ^ (key >> 11) ^ (key >> 23)) & BUCKET_MASK);
+        }
+
+    public:
+        MSHRIndex() {
+            assert((SIZE & (SIZE - 1)) == 0);
+            reset();
+        }
+
+        void reset() {
+            foreach(i, BUCKETS) {
+                head_[i] = tail_[i] = -1;
+            }
+            foreach(i, SIZE) {
+                next_[i] = prev_[i] = -1;
+                key_[i] = -1;
+                used_[i] = false;
+            }
+            count_ = 0;
+        }
+
+        void insert(int idx, W64 key) {
+            assert(idx >= 0 && idx < SIZE);
+            assert(!used_[idx]);
+
+            int b = bucket_of(key);
+            key_[idx] = key;
+            used_[idx] = true;
+            next_[idx] = -1;
+            prev_[idx] = tail_[b];
+
+            if(tail_[b] >= 0)
+                next_[tail_[b]] = idx;
+            else
+                head_[b] = idx;
+            tail_[b] = idx;
+            count_++;
+        }
+
+        /* Remove given entry, does nothing if it was not indexed */
+        void remove(int idx) {
+            if(!used_[idx])
+                return;
+
+            int b = bucket_of(key_[idx]);
+            if(prev_[idx] >= 0)
+                next_[prev_[idx]] = next_[idx];
+            else
+                head_[b] = next_[idx];
+
+            if(next_[idx] >= 0)
+                prev_[next_[idx]] = prev_[idx];
+            else
+                tail_[b] = prev_[idx];
+
+            used_[idx] = false;
+            next_[idx] = prev_[idx] = -1;
+            count_--;
+        }
+
+        bool indexed(int idx) const {
+            return used_[idx];
+        }
+
+        W64 key(int idx) const {
+            return key_[idx];
+        }
+
+        int count() const {
+            return count_;
+        }
+
+        /* Return first entry with given key or -1 */
+        int first(W64 key) const {
+            int idx = head_[bucket_of(key)];
+            while(idx >= 0 && key_[idx] != key)
+                idx = next_[idx];
+            return idx;
+        }
+
+        /* Return entry after idx with same key or -1 */
+        int next(int idx) const {
+            if(idx < 0)
+                return -1;
+            W64 key = key_[idx];
+            idx = next_[idx];
+            while(idx >= 0 && key_[idx] != key)
+                idx = next_[idx];
+            return idx;
+        }
+
+        bool contains(W64 key) const {
+            return first(key) >= 0;
+        }
+};
+
+/*
+ * IndexedStateList
+ *
+ * FixStateList of pending requests with a line address index. Entries
+ * are added to the index with index() once their request is set, and
+ * are removed from it when freed.
+ */
+template <typename T, int SIZE>
+struct IndexedStateList : public FixStateList<T, SIZE>
+{
+    typedef FixStateList<T, SIZE> base_t;
+
+    void index(T* obj, W64 key) {
+        index_.insert(obj->idx, key);
+    }
+
+    void free(T* obj) {
+        index_.remove(obj->idx);
+        base_t::free(obj);
+    }
+
+    void reset() {
+        base_t::reset();
+        index_.reset();
+    }
+
+    int first(W64 key) const {
+        return index_.first(key);
+    }
+
+    int next(int idx) const {
+        return index_.next(idx);
+    }
+
+    W64 key(T* obj) const {
+        return index_.key(obj->idx);
+    }
+
+    bool contains(W64 key) const {
+        return index_.contains(key);
+    }
+
+    private:
+        MSHRIndex<SIZE> index_;
+};
+
+/*
+ * Iterate over entries of an IndexedStateList with given line address in
+ * queue order. Like foreach_list_mutable, the current entry (obj) may be
+ * freed inside the loop.
+ */
+#define foreach_indexed_mutable(L, key, obj, i, nexti) \
+    int i; \
+    int nexti; \
+    for (i = (L).first(key), nexti = (L).next(i), \
+            obj = (i >= 0) ? &(L)[i] : NULL; \
+            i >= 0; \
+            i = nexti, nexti = (L).next(i), \
+            obj = (i >= 0) ? &(L)[i] : NULL)
+
+};
+
+#endif // MSHR_INDEX_H
@@ -127,6 +127,21 @@ int P2PInterconnect::access_fast_path(Controller *controller,
 	return receiver->access_fast_path(this, request);
 }
 
+/**
+ * @brief Pass functional warmup request to another controller
+ *
+ * @param controller Sender
+ * @param request Memory Request
+ *
+ * @return true if receiver shares the line
+ */
+bool P2PInterconnect::warmup(Controller *controller,
+		MemoryRequest *request)
+{
+	Controller *receiver = get_other_controller(controller);
+	return receiver->warmup(this, request);
+}
+
 /**
  * @brief Print connections of this instance
  *
@@ -0,0 +1,207 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifdef MEM_TEST
+#include <test.h>
+#else
+#include <ptlsim.h>
+#define PTLSIM_PUBLIC_ONLY
+#include <ptlhwdef.h>
+#endif
+
+#include <memoryHierarchy.h>
+#include <runtimeCacheLines.h>
+
+#include <machine.h>
+
+using namespace Memory;
+
+struct CacheGeometry {
+    int size;
+    int ways;
+    int line_size;
+    int latency;
+    int read_ports;
+    int write_ports;
+};
+
+/**
+ * @brief Parse cache size with optional K, M or G suffix
+ *
+ * @param str Size string like "512K"
+ *
+ * @return Size in bytes or 0 if string is not a valid positive int size
+ */
+static int parse_cache_size(const char *str)
+{
+    char *end;
+    long size = strtol(str, &end, 0);
+
+    switch(*end) {
+        case 'k': case 'K': size <<= 10; end++; break;
+        case 'm': case 'M': size <<= 20; end++; break;
+        case 'g': case 'G': size <<= 30; end++; break;
+    }
+
+    if(*end != '\0' || size <= 0 || size > INT_MAX)
+        return 0;
+
+    return size;
+}
+
+/**
+ * @brief Report invalid geometry configuration of a cache and stop
+ *
+ * Geometry comes from user options, so unlike assert this is not removed
+ * from builds with DISABLE_ASSERT.
+ *
+ * @param name Cache name
+ * @param what Option that is invalid
+ * @param value Invalid value
+ */
+static void geometry_error(const char *name, const char *what,
+        const char *value)
+{
+    stringbuf err;
+    err << "::ERROR::Invalid ", what, " for cache ", name, ": ", value, endl;
+    ptl_logfile << err;
+    cerr << err;
+    assert_fail(__STRING(0), __FILE__, __LINE__, __PRETTY_FUNCTION__);
+}
+
+static bool set_geometry_value(CacheGeometry& geom, const char *key,
+        const char *value)
+{
+    int v = parse_cache_size(value);
+
+    if(v <= 0)
+        return false;
+
+    if(!strcmp(key, "size")) geom.size = v;
+    else if(!strcmp(key, "assoc")) geom.ways = v;
+    else if(!strcmp(key, "line_size")) geom.line_size = v;
+    else if(!strcmp(key, "latency")) geom.latency = v;
+    else if(!strcmp(key, "read_ports")) geom.read_ports = v;
+    else if(!strcmp(key, "write_ports")) geom.write_ports = v;
+    else return false;
+
+    return true;
+}
+
+/**
+ * @brief Apply geometry options of a cache from machine configuration
+ *
+ * @return true if cache option 'cache_lines' selects runtime geometry
+ */
+static bool read_geometry_options(BaseMachine& machine, const char *name,
+        CacheGeometry& geom)
+{
+    const char *keys[] = {"size", "assoc", "line_size", "latency",
+        "read_ports", "write_ports"};
+
+    foreach(i, lengthof(keys)) {
+        int value;
+        stringbuf str;
+
+        if(machine.get_option(name, keys[i], value)) {
+            str << value;
+        } else if(!machine.get_option(name, keys[i], str)) {
+            continue;
+        }
+
+        if(!set_geometry_value(geom, keys[i], str.buf))
+            geometry_error(name, keys[i], str.buf);
+    }
+
+    stringbuf type;
+    if(!machine.get_option(name, "cache_lines", type))
+        return false;
+
+    if(!strcmp(type.buf, "runtime"))
+        return true;
+
+    if(strcmp(type.buf, "template"))
+        geometry_error(name, "cache_lines (runtime or template)", type.buf);
+    return false;
+}
+
+/**
+ * @brief Apply -cache-geometry entries of a cache
+ *
+ * Entries are separated with ',' and have format
+ * <cache name>:<key>=<value>[:<key>=<value>...], for example
+ * "L2_0:size=512K:assoc=16,L3_0:latency=40".
+ *
+ * @return true if there is an entry for the cache
+ */
+static bool read_geometry_override(const char *name, CacheGeometry& geom)
+{
+    if(!config.cache_geometry.buf || !config.cache_geometry.buf[0])
+        return false;
+
+    bool found = false;
+    char *spec = strdup(config.cache_geometry.buf);
+    char *entry_save, *field_save;
+
+    for(char *entry = strtok_r(spec, ",", &entry_save); entry;
+            entry = strtok_r(NULL, ",", &entry_save)) {
+        char *cache = strtok_r(entry, ":", &field_save);
+        if(!cache || strcmp(cache, name))
+            continue;
+
+        found = true;
+
+        for(char *field = strtok_r(NULL, ":", &field_save); field;
+                field = strtok_r(NULL, ":", &field_save)) {
+            char *value = strchr(field, '=');
+            if(value) *value++ = '\0';
+
+            if(!value || !set_geometry_value(geom, field, value))
+                geometry_error(name, "-cache-geometry field", field);
+        }
+    }
+
+    free(spec);
+    return found;
+}
+
+CacheLinesBase* Memory::create_cachelines(MemoryHierarchy *memoryHierarchy,
+        const char *name, int type)
+{
+    CacheLinesBase *lines = get_cachelines(type);
+
+    CacheGeometry geom;
+    geom.size = lines->get_size();
+    geom.ways = lines->get_way_count();
+    geom.line_size = lines->get_line_size();
+    geom.latency = lines->get_access_latency();
+    geom.read_ports = lines->get_read_ports();
+    geom.write_ports = lines->get_write_ports();
+
+    bool runtime = read_geometry_options(memoryHierarchy->get_machine(),
+            name, geom);
+    runtime |= read_geometry_override(name, geom);
+
+    if(!runtime)
+        return lines;
+
+    delete lines;
+
+    W64 way_bytes = W64(geom.ways) * geom.line_size;
+    int sets = geom.size / way_bytes;
+    if(sets * way_bytes != W64(geom.size) ||
+            !RuntimeCacheLines::valid_geometry(sets, geom.ways,
+                geom.line_size)) {
+        stringbuf value;
+        value << "size ", geom.size, " assoc ", geom.ways, " line_size ",
+              geom.line_size;
+        geometry_error(name, "geometry", value.buf);
+    }
+
+    return new RuntimeCacheLines(sets, geom.ways, geom.line_size,
+            geom.latency, geom.read_ports, geom.write_ports);
+}
@@ -0,0 +1,305 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef RUNTIME_CACHE_LINES_H
+#define RUNTIME_CACHE_LINES_H
+
+#include <memoryRequest.h>
+#include <cacheLines.h>
+
+namespace Memory {
+
+    class MemoryHierarchy;
+
+    /*
+     * Cache array with geometry given at run time, selected with cache
+     * option 'cache_lines: runtime' or -cache-geometry. Tags of each set
+     * are stored in one row of a flat 64 byte aligned array and compared
+     * across all ways with x86_match_tags64(). Replacement is the same
+     * mLRU policy as FullyAssociativeTags, so for same geometry both
+     * implementations hit, miss and evict identically.
+     *
+     * Limitations: sets and line size must be powers of two and a set can
+     * have at most 64 ways.
+     */
+    class RuntimeCacheLines : public CacheLinesBase
+    {
+        private:
+            int setCount_;
+            int wayCount_;
+            int lineSize_;
+            int latency_;
+            int lineBits_;
+            int setBits_;
+
+            /* Ways per tag row, rounded up to a multiple of 4 tags */
+            int wayStride_;
+            W64 wayMask_;
+
+            W64 *tags_;
+            W64 *evictMap_;
+            CacheLine *lines_;
+
+            int readPortUsed_;
+            int writePortUsed_;
+            int readPorts_;
+            int writePorts_;
+            W64 lastAccessCycle_;
+
+            static const W64 INVALID = InvalidTag<W64>::INVALID;
+
+            W64* tag_row(int set) const {
+                return &tags_[set * wayStride_];
+            }
+
+            CacheLine* line(int set, int way) const {
+                return &lines_[set * wayCount_ + way];
+            }
+
+            void use(int set, int way) {
+                evictMap_[set] |= (W64(1) << way);
+            }
+
+            bool all_used(int set) const {
+                return (evictMap_[set] & wayMask_) == wayMask_;
+            }
+
+            int lru(int set) const {
+                return all_used(set) ? 0 :
+                    lsbindex64(~evictMap_[set] & wayMask_);
+            }
+
+        public:
+            RuntimeCacheLines(int setCount, int wayCount, int lineSize,
+                    int latency, int readPorts, int writePorts);
+            ~RuntimeCacheLines();
+
+            /* Set count and line size are powers of 2, up to 64 ways */
+            static bool valid_geometry(int setCount, int wayCount,
+                    int lineSize) {
+                return setCount > 0 && (setCount & (setCount - 1)) == 0 &&
+                    lineSize > 0 && (lineSize & (lineSize - 1)) == 0 &&
+                    wayCount > 0 && wayCount <= 64;
+            }
+
+            int set_of(W64 address) const {
+                return bits(address, lineBits_, setBits_);
+            }
+
+            int match(int set, W64 tag) const;
+
+            /* Address based interface, same as AssociativeArray */
+            CacheLine* probe(W64 address);
+            CacheLine* select(W64 address, W64& oldTag);
+            int invalidate(W64 address);
+
+            void init();
+            W64 tagOf(W64 address) { return floor(address, lineSize_); }
+            int latency() const { return latency_; }
+            CacheLine* probe(MemoryRequest *request);
+            CacheLine* insert(MemoryRequest *request, W64& oldTag);
+            int invalidate(MemoryRequest *request);
+            bool get_port(MemoryRequest *request);
+            void print(ostream& os) const;
+
+            int get_size() const {
+                return setCount_ * wayCount_ * lineSize_;
+            }
+
+            int get_set_count() const { return setCount_; }
+            int get_way_count() const { return wayCount_; }
+            int get_line_size() const { return lineSize_; }
+            int get_line_bits() const { return lineBits_; }
+            int get_access_latency() const { return latency_; }
+            int get_read_ports() const { return readPorts_; }
+            int get_write_ports() const { return writePorts_; }
+    };
+
+    inline RuntimeCacheLines::RuntimeCacheLines(int setCount, int wayCount,
+            int lineSize, int latency, int readPorts, int writePorts)
+        : setCount_(setCount)
+          , wayCount_(wayCount)
+          , lineSize_(lineSize)
+          , latency_(latency)
+          , readPortUsed_(0)
+          , writePortUsed_(0)
+          , readPorts_(readPorts)
+          , writePorts_(writePorts)
+          , lastAccessCycle_(0)
+    {
+        /* Geometry can come from user options, so check it in all builds */
+        if(!valid_geometry(setCount, wayCount, lineSize)) {
+            stringbuf err;
+            err << "::ERROR::Invalid cache geometry: ", setCount, " sets, ",
+                wayCount, " ways, ", lineSize, " byte lines", endl;
+            ptl_logfile << err;
+            cerr << err;
+            assert_fail(__STRING(valid_geometry(setCount, wayCount, lineSize)),
+                    __FILE__, __LINE__, __PRETTY_FUNCTION__);
+        }
+
+        lineBits_ = lsbindex64(lineSize);
+        setBits_ = lsbindex64(setCount);
+        wayStride_ = (wayCount + 3) & ~3;
+        wayMask_ = (wayCount == 64) ? W64(-1) : ((W64(1) << wayCount) - 1);
+
+        void *mem = NULL;
+        int rc = posix_memalign(&mem, 64,
+                setCount_ * wayStride_ * sizeof(W64));
+        assert(rc == 0);
+        tags_ = (W64*)mem;
+
+        evictMap_ = new W64[setCount_];
+        lines_ = new CacheLine[setCount_ * wayCount_];
+
+        foreach(i, setCount_ * wayStride_) {
+            tags_[i] = INVALID;
+        }
+
+        foreach(i, setCount_) {
+            evictMap_[i] = 0;
+        }
+
+        foreach(i, setCount_ * wayCount_) {
+            lines_[i].reset();
+        }
+    }
+
+    inline RuntimeCacheLines::~RuntimeCacheLines()
+    {
+        free(tags_);
+        delete[] evictMap_;
+        delete[] lines_;
+    }
+
+    inline void RuntimeCacheLines::init()
+    {
+        foreach(i, setCount_ * wayCount_) {
+            lines_[i].init(-1);
+        }
+    }
+
+    /**
+     * @brief Find way of given tag in a set
+     *
+     * @param set Set index
+     * @param tag Line address to find
+     *
+     * @return Way index or -1 if tag is not present
+     */
+    inline int RuntimeCacheLines::match(int set, W64 tag) const
+    {
+        W64 hits = x86_match_tags64(tag_row(set), wayStride_, tag);
+
+        hits &= wayMask_;
+        return hits ? (int)lsbindex64(hits) : -1;
+    }
+
+    inline CacheLine* RuntimeCacheLines::probe(W64 address)
+    {
+        int set = set_of(address);
+        int way = match(set, tagOf(address));
+        if(way < 0) return NULL;
+
+        use(set, way);
+        return line(set, way);
+    }
+
+    inline CacheLine* RuntimeCacheLines::select(W64 address, W64& oldTag)
+    {
+        int set = set_of(address);
+        W64 tag = tagOf(address);
+        int way = match(set, tag);
+
+        if(way < 0) {
+            way = lru(set);
+            if(all_used(set)) evictMap_[set] = 0;
+            oldTag = tag_row(set)[way];
+            tag_row(set)[way] = tag;
+        }
+
+        use(set, way);
+        if(all_used(set)) {
+            evictMap_[set] = 0;
+            use(set, way);
+        }
+
+        return line(set, way);
+    }
+
+    inline int RuntimeCacheLines::invalidate(W64 address)
+    {
+        int set = set_of(address);
+        int way = match(set, tagOf(address));
+        if(way < 0) return -1;
+
+        tag_row(set)[way] = INVALID;
+        evictMap_[set] &= ~(W64(1) << way);
+        line(set, way)->reset();
+        return way;
+    }
+
+    inline CacheLine* RuntimeCacheLines::probe(MemoryRequest *request)
+    {
+        return probe(request->get_physical_address());
+    }
+
+    inline CacheLine* RuntimeCacheLines::insert(MemoryRequest *request,
+            W64& oldTag)
+    {
+        return select(request->get_physical_address(), oldTag);
+    }
+
+    inline int RuntimeCacheLines::invalidate(MemoryRequest *request)
+    {
+        return invalidate(request->get_physical_address());
+    }
+
+    inline bool RuntimeCacheLines::get_port(MemoryRequest *request)
+    {
+        bool rc = false;
+
+        if(lastAccessCycle_ < sim_cycle) {
+            lastAccessCycle_ = sim_cycle;
+            writePortUsed_ = 0;
+            readPortUsed_ = 0;
+        }
+
+        switch(request->get_type()) {
+            case MEMORY_OP_READ:
+                rc = (readPortUsed_ < readPorts_) ? ++readPortUsed_ : 0;
+                break;
+            case MEMORY_OP_WRITE:
+            case MEMORY_OP_UPDATE:
+            case MEMORY_OP_EVICT:
+                rc = (writePortUsed_ < writePorts_) ? ++writePortUsed_ : 0;
+                break;
+            default:
+                memdebug("Unknown type of memory request: " <<
+                        request->get_type() << endl);
+                assert(0);
+        };
+        return rc;
+    }
+
+    inline void RuntimeCacheLines::print(ostream& os) const
+    {
+        foreach(i, setCount_ * wayCount_) {
+            os << lines_[i];
+        }
+    }
+
+    /*
+     * Create cache lines of a cache controller: compile time geometry of
+     * its cache type by default, RuntimeCacheLines if selected by options
+     */
+    CacheLinesBase* create_cachelines(MemoryHierarchy *memoryHierarchy,
+            const char *name, int type);
+
+};
+
+#endif // RUNTIME_CACHE_LINES_H
@@ -0,0 +1,150 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#include <snoopFilter.h>
+
+using namespace Memory;
+
+static const W64 SNOOP_FILTER_INVALID = (W64)-1;
+
+SnoopFilter::SnoopFilter()
+    : sets_(0)
+    , assoc_(0)
+    , clock_(0)
+{
+}
+
+void SnoopFilter::init(int entries, int assoc)
+{
+    assert(entries >= 0);
+
+    if (entries == 0) {
+        sets_ = 0;
+        return;
+    }
+
+    assert(assoc > 0);
+    if (assoc > entries)
+        assoc = entries;
+
+    assoc_ = assoc;
+    sets_ = entries / assoc;
+    entries = sets_ * assoc;
+
+    tags_.resize(entries, SNOOP_FILTER_INVALID);
+    holders_.resize(entries, 0);
+    lastUse_.resize(entries, 0);
+    foreach (i, entries) {
+        tags_[i] = SNOOP_FILTER_INVALID;
+        holders_[i] = 0;
+        lastUse_[i] = 0;
+    }
+}
+
+int SnoopFilter::find(W64 line) const
+{
+    int first = get_set(line) * assoc_;
+
+    foreach (way, assoc_) {
+        if (tags_[first + way] == line)
+            return first + way;
+    }
+
+    return -1;
+}
+
+W64 SnoopFilter::lookup(W64 line) const
+{
+    if (!enabled())
+        return (W64)-1;
+
+    int idx = find(line);
+    return (idx < 0) ? 0 : holders_[idx];
+}
+
+bool SnoopFilter::add(W64 line, int holder, W64 &victim,
+        W64 &victim_holders)
+{
+    assert(enabled());
+    assert(holder >= 0 && holder < SNOOP_FILTER_MAX_CONTROLLERS);
+
+    bool replaced = false;
+    int idx = find(line);
+
+    if (idx < 0) {
+        /* Use a free way or the least recently used one */
+        int first = get_set(line) * assoc_;
+        idx = first;
+        foreach (way, assoc_) {
+            int i = first + way;
+            if (tags_[i] == SNOOP_FILTER_INVALID) {
+                idx = i;
+                break;
+            }
+            if (lastUse_[i] < lastUse_[idx])
+                idx = i;
+        }
+
+        if (tags_[idx] != SNOOP_FILTER_INVALID && holders_[idx]) {
+            victim = tags_[idx];
+            victim_holders = holders_[idx];
+            replaced = true;
+        }
+
+        tags_[idx] = line;
+        holders_[idx] = 0;
+    }
+
+    holders_[idx] |= (W64(1) << holder);
+    lastUse_[idx] = ++clock_;
+
+    return replaced;
+}
+
+void SnoopFilter::invalidate(W64 line, W64 keep)
+{
+    if (!enabled())
+        return;
+
+    int idx = find(line);
+    if (idx < 0)
+        return;
+
+    holders_[idx] &= keep;
+
+    if (!holders_[idx])
+        tags_[idx] = SNOOP_FILTER_INVALID;
+}
+
+int SnoopFilter::count() const
+{
+    int lines = 0;
+
+    foreach (i, tags_.count()) {
+        if (tags_[i] != SNOOP_FILTER_INVALID)
+            lines++;
+    }
+
+    return lines;
+}
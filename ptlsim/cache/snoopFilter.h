@@ -0,0 +1,93 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+
+#ifndef SNOOP_FILTER_H
+#define SNOOP_FILTER_H
+
+#include <globals.h>
+#include <superstl.h>
+#include <cacheConstants.h>
+
+namespace Memory {
+
+/*
+ * SnoopFilter
+ *
+ * Inclusive presence vector of the private controllers on a bus, kept in a
+ * set associative table of cache line addresses with LRU replacement. For
+ * each tracked line it has a bit for every controller that may hold the
+ * line, so a snoop is needed only by the controllers in lookup(); a line
+ * that is not in the table is in none of them.
+ *
+ * Bits are set when a controller requests a line and cleared when it is
+ * invalidated by a write or an eviction of another controller. Clean lines
+ * are replaced silently by caches, so the vector can have stale bits but
+ * never misses a holder. To stay inclusive, replacing an entry returns its
+ * line and holders, which must then be invalidated by the caller.
+ */
+class SnoopFilter
+{
+    public:
+        SnoopFilter();
+
+        /* entries == 0 disables the filter, every lookup returns all */
+        void init(int entries, int assoc);
+        bool enabled() const { return sets_ > 0; }
+
+        int get_entries() const { return tags_.count(); }
+        int get_assoc() const { return assoc_; }
+
+        /* Controllers that may hold given line */
+        W64 lookup(W64 line) const;
+
+        /**
+         * Add 'holder' to line's presence vector. Returns true if a tracked
+         * line was replaced to make room, its address and holders are set
+         * in victim and victim_holders.
+         */
+        bool add(W64 line, int holder, W64 &victim, W64 &victim_holders);
+
+        /* Remove holders of line that are not in 'keep' */
+        void invalidate(W64 line, W64 keep);
+
+        /* Number of tracked lines */
+        int count() const;
+
+    private:
+        int sets_;
+        int assoc_;
+        W64 clock_;
+
+        /* Index set * assoc + way */
+        dynarray<W64> tags_;
+        dynarray<W64> holders_;
+        dynarray<W64> lastUse_;
+
+        int find(W64 line) const;
+        int get_set(W64 line) const { return line % sets_; }
+};
+
+};
+
+#endif // SNOOP_FILTER_H
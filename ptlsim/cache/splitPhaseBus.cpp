@@ -46,6 +46,7 @@ BusInterconnect::BusInterconnect(const char *name,
     , lastAccessQueue(NULL)
     , busBusy_(false)
     , dataBusBusy_(false)
+    , privateMask_(0)
 {
     memoryHierarchy_->add_interconnect(this);
     new_stats = new BusStats(name, &memoryHierarchy->get_machine());
@@ -75,6 +76,19 @@ BusInterconnect::BusInterconnect(const char *name,
 				snoopDisabled_)) {
 		snoopDisabled_ = false;
 	}
+
+    /* Number of lines tracked by snoop filter, 0 to broadcast all snoops */
+    if(!memoryHierarchy_->get_machine().get_option(name, "snoop_filter",
+                snoopFilterSize_)) {
+        snoopFilterSize_ = 0;
+    }
+
+    if(!memoryHierarchy_->get_machine().get_option(name, "snoop_filter_assoc",
+                snoopFilterAssoc_)) {
+        snoopFilterAssoc_ = SNOOP_FILTER_ASSOC;
+    }
+
+    snoopFilter_.init(snoopFilterSize_, snoopFilterAssoc_);
 }
 
 BusInterconnect::~BusInterconnect()
@@ -98,6 +112,137 @@ void BusInterconnect::register_controller(Controller *controller)
 
     busControllerQueue->idx = controllers.count();
     controllers.push(busControllerQueue);
+
+    if(snoopFilter_.enabled()) {
+        assert(busControllerQueue->idx < SNOOP_FILTER_MAX_CONTROLLERS);
+        if(controller->is_private())
+            privateMask_ |= (W64(1) << busControllerQueue->idx);
+    }
+}
+
+/**
+ * @brief Controllers that need a snoop of given request
+ *
+ * Without snoop filter it is every controller, with it all non private
+ * controllers and the private ones that may have the line.
+ *
+ * @return Bit vector of controller indices
+ */
+W64 BusInterconnect::get_snoop_targets(MemoryRequest *request) const
+{
+    if(!snoopFilter_.enabled())
+        return (W64)-1;
+
+    W64 line = request->get_physical_address() >> SNOOP_FILTER_LINE_BITS;
+    return ~privateMask_ | snoopFilter_.lookup(line);
+}
+
+/* Controllers with a request for given line that is waiting for data */
+W64 BusInterconnect::get_pending_holders(W64 line)
+{
+    W64 holders = 0;
+    PendingQueueEntry *pendingEntry;
+
+    foreach_list_mutable(pendingRequests_.list(), pendingEntry,
+            entry, nextentry) {
+        if((pendingEntry->request->get_physical_address() >>
+                    SNOOP_FILTER_LINE_BITS) == line) {
+            holders |= (W64(1) << pendingEntry->controllerQueue->idx);
+        }
+    }
+
+    return holders;
+}
+
+/**
+ * @brief Update snoop filter after broadcast of a request
+ *
+ * Requesting controller gets the line on read and write, others lose it
+ * on write and eviction. Controllers still waiting for data of the same
+ * line keep their bit as their line will be valid when data arrives.
+ *
+ * @param source Index of controller that sent the request
+ * @param warmup Request is from functional warmup
+ */
+void BusInterconnect::update_snoop_filter(MemoryRequest *request,
+        int source, bool warmup)
+{
+    if(!snoopFilter_.enabled())
+        return;
+
+    W64 line = request->get_physical_address() >> SNOOP_FILTER_LINE_BITS;
+    W64 sourceBit = (W64(1) << source) & privateMask_;
+    W64 victim, victimHolders;
+
+    switch(request->get_type()) {
+        case MEMORY_OP_READ:
+        case MEMORY_OP_WRITE:
+            if(sourceBit && snoopFilter_.add(line, source, victim,
+                        victimHolders)) {
+                back_invalidate(victim, victimHolders, request, warmup);
+            }
+            if(request->get_type() == MEMORY_OP_WRITE) {
+                snoopFilter_.invalidate(line, sourceBit |
+                        get_pending_holders(line));
+            }
+            break;
+        case MEMORY_OP_EVICT:
+            /* Source can keep the line when it evicts other copies on write
+             * to a shared line, so don't clear its bit */
+            snoopFilter_.invalidate(line, sourceBit |
+                    get_pending_holders(line));
+            break;
+        default:
+            /* Update is a write back, holders don't change */
+            break;
+    }
+}
+
+/**
+ * @brief Evict a line that is no longer tracked by snoop filter from its
+ * holders to keep the filter inclusive
+ */
+void BusInterconnect::back_invalidate(W64 line, W64 holders,
+        MemoryRequest *cause, bool warmup)
+{
+    N_STAT_UPDATE(new_stats->snoop_filter.back_invalidations, ++,
+            cause->is_kernel());
+
+    if(warmup) {
+        MemoryRequest evict;
+        evict.init(cause);
+        evict.set_physical_address(line << SNOOP_FILTER_LINE_BITS);
+        evict.set_op_type(MEMORY_OP_EVICT);
+
+        foreach(i, controllers.count()) {
+            if(holders & (W64(1) << i))
+                controllers[i]->controller->warmup(this, &evict);
+        }
+        return;
+    }
+
+    MemoryRequest *request = memoryHierarchy_->get_free_request(
+            cause->get_coreid());
+    assert(request);
+    request->init(cause);
+    request->set_physical_address(line << SNOOP_FILTER_LINE_BITS);
+    request->set_op_type(MEMORY_OP_EVICT);
+
+    Message& message = *memoryHierarchy_->get_message();
+    message.sender = this;
+    message.request = request;
+    message.hasData = false;
+    message.origin = NULL;
+
+    foreach(i, controllers.count()) {
+        if(holders & (W64(1) << i)) {
+            bool ret = controllers[i]->controller->
+                get_interconnect_signal()->emit(&message);
+            assert(ret);
+        }
+    }
+
+    memoryHierarchy_->free_message(&message);
 }
 
 int BusInterconnect::access_fast_path(Controller *controller,
@@ -106,6 +251,28 @@ int BusInterconnect::access_fast_path(Controller *controller,
     return -1;
 }
 
+bool BusInterconnect::warmup(Controller *controller,
+        MemoryRequest *request)
+{
+    bool shared = false;
+    int source = -1;
+    W64 targets = get_snoop_targets(request);
+
+    /* Broadcast to all other controllers like a bus request */
+    foreach(i, controllers.count()) {
+        Controller *receiver = controllers[i]->controller;
+        if(receiver == controller)
+            source = i;
+        else if(is_snoop_target(targets, i))
+            shared |= receiver->warmup(this, request);
+    }
+
+    if(source >= 0)
+        update_snoop_filter(request, source, true);
+
+    return shared;
+}
+
 void BusInterconnect::annul_request(MemoryRequest *request)
 {
     foreach(i, controllers.count()) {
@@ -370,12 +537,26 @@ bool BusInterconnect::broadcast_completed_cb(void *arg)
     message.origin = NULL;
 
     Controller *controller = queueEntry->controllerQueue->controller;
+    W64 targets = get_snoop_targets(queueEntry->request);
+    bool kernel = queueEntry->request->is_kernel();
 
     foreach(i, controllers.count()) {
-        if(controller != controllers[i]->controller) {
+        if(controller != controllers[i]->controller &&
+                !is_snoop_target(targets, i)) {
+            /*
+             * Snoop filter shows that controller doesn't have the line,
+             * so it would respond with a miss
+             */
+            if(pendingEntry)
+                pendingEntry->responseReceived[i] = true;
+            N_STAT_UPDATE(new_stats->snoop_filter.filtered, ++, kernel);
+        } else if(controller != controllers[i]->controller) {
             bool ret = controllers[i]->controller->
                 get_interconnect_signal()->emit(&message);
             assert(ret);
+            if(snoopFilter_.enabled() &&
+                    controllers[i]->controller->is_private())
+                N_STAT_UPDATE(new_stats->snoop_filter.forwarded, ++, kernel);
         } else {
             /*
              * its the originating controller, mark its
@@ -386,7 +567,8 @@ bool BusInterconnect::broadcast_completed_cb(void *arg)
         }
     }
 
-    bool kernel = queueEntry->request->is_kernel();
+    update_snoop_filter(queueEntry->request,
+            queueEntry->controllerQueue->idx, false);
 
     /* Free the entry from queue */
     queueEntry->request->decRefCounter();
@@ -497,12 +679,21 @@ bool BusInterconnect::data_broadcast_completed_cb(void *arg)
     message.isShared = pendingEntry->shared;
     message.origin = NULL;
 
+    Controller *requester = pendingEntry->controllerQueue->controller;
+
     foreach(i, controllers.count()) {
         if(pendingEntry->controllerWithData == controllers[i]->controller) {
             /* Don't send the data message back to the responding controller */
             continue;
         }
 
+        /* Other private controllers ignore the data, skip them with snoop
+         * filter so its cost doesn't grow with number of cores */
+        if(snoopFilter_.enabled() && controllers[i]->controller->is_private()
+                && controllers[i]->controller != requester) {
+            continue;
+        }
+
         bool ret = controllers[i]->controller->
             get_interconnect_signal()->emit(&message);
         assert(ret);
@@ -545,6 +736,9 @@ void BusInterconnect::dump_configuration(YAML::Emitter &out) const
 	YAML_KEY_VAL(out, "type", "interconnect");
 	YAML_KEY_VAL(out, "latency", latency_);
 	YAML_KEY_VAL(out, "arbitrate_latency", arbitrate_latency_);
+	YAML_KEY_VAL(out, "snoop_filter", snoopFilterSize_);
+	if (snoopFilter_.enabled())
+		YAML_KEY_VAL(out, "snoop_filter_assoc", snoopFilter_.get_assoc());
 	if (controllers.size() > 0)
 		YAML_KEY_VAL(out, "per_cont_queue_size",
 				controllers[0]->queue.size());
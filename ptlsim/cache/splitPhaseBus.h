@@ -30,6 +30,7 @@
 
 #include <interconnect.h>
 #include <memoryStats.h>
+#include <snoopFilter.h>
 
 namespace Memory {
 
@@ -129,6 +130,15 @@ struct BusControllerQueue
 	FixStateList<BusQueueEntry, 16> dataQueue;
 };
 
+/*
+ * Split phase bus, every request is broadcast to all other controllers and
+ * its data is sent after all of them responded.
+ *
+ * With option 'snoop_filter: <lines>' (and 'snoop_filter_assoc') the bus
+ * keeps a SnoopFilter of its private controllers and sends snoops only to
+ * the ones that may have the line; the others are counted as responded
+ * with a miss.
+ */
 class BusInterconnect : public Interconnect
 {
 	private:
@@ -147,9 +157,26 @@ class BusInterconnect : public Interconnect
         int latency_;
         int arbitrate_latency_;
 
+        /* Optional snoop filter of private controllers, privateMask_ has a
+         * bit for each private controller index */
+        SnoopFilter snoopFilter_;
+        int snoopFilterSize_;
+        int snoopFilterAssoc_;
+        W64 privateMask_;
+
 		BusQueueEntry *arbitrate_round_robin();
 		bool can_broadcast(BusControllerQueue *queue);
 
+        W64 get_snoop_targets(MemoryRequest *request) const;
+        bool is_snoop_target(W64 targets, int idx) const {
+            return !snoopFilter_.enabled() || (targets & (W64(1) << idx));
+        }
+        W64 get_pending_holders(W64 line);
+        void update_snoop_filter(MemoryRequest *request, int source,
+                bool warmup);
+        void back_invalidate(W64 line, W64 holders, MemoryRequest *cause,
+                bool warmup);
+
 	public:
 		BusInterconnect(const char *name, MemoryHierarchy *memoryHierarchy);
         ~BusInterconnect();
@@ -162,6 +189,7 @@ class BusInterconnect : public Interconnect
 		void register_controller(Controller *controller);
 		int access_fast_path(Controller *controller,
 				MemoryRequest *request);
+		bool warmup(Controller *controller, MemoryRequest *request);
 		void annul_request(MemoryRequest *request);
         void set_data_bus();
 		void dump_configuration(YAML::Emitter &out) const;
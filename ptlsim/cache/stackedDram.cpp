@@ -0,0 +1,236 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#include <globals.h>
+#include <superstl.h>
+#include <ptlsim.h>
+
+#include <stackedDram.h>
+
+using namespace Memory;
+
+/**
+ * @brief Report a bad dram_* option and stop the simulator
+ *
+ * The geometry is set by the user, and a wrong one would give a nonsense
+ * address map, so this stays in builds with DISABLE_ASSERT.
+ *
+ * @param option Name of the machine option
+ * @param value Its value
+ * @param expected What the value should be
+ */
+static void dram_option_error(const char *option, int value,
+        const char *expected)
+{
+    stringbuf err;
+    err << "::ERROR::Invalid stacked DRAM option ", option, ": ", value,
+        ", ", expected, endl;
+    ptl_logfile << err;
+    cerr << err;
+    assert_fail(__STRING(0), __FILE__, __LINE__, __PRETTY_FUNCTION__);
+}
+
+static inline bool is_pow2(int v)
+{
+    return v > 0 && !(v & (v - 1));
+}
+
+StackedDram::StackedDram(StackedDramOrg org,
+        const StackedDramConfig& config)
+    : org_(org)
+    , config_(config)
+{
+    assert(org_ < NUM_STACKED_DRAM_ORGS);
+
+    if(config_.layers <= 0)
+        dram_option_error("dram_layers", config_.layers, "must be > 0");
+    if(config_.tiles <= 0)
+        dram_option_error("dram_tiles", config_.tiles, "must be > 0");
+
+    /* Row index is used to directly index rowSlot_ */
+    if(config_.row_bits <= 0 || config_.row_bits > 24)
+        dram_option_error("dram_row_bits", config_.row_bits,
+                "must be 1 to 24");
+
+    /* Geometry must be power of 2 */
+    if(!is_pow2(config_.dimms))
+        dram_option_error("dram_dimms", config_.dimms,
+                "must be a power of 2");
+    if(!is_pow2(config_.banks))
+        dram_option_error("dram_banks", config_.banks,
+                "must be a power of 2");
+
+    dimmBits_ = lsbindex64(config_.dimms);
+    bankBits_ = lsbindex64(config_.banks);
+
+    busOffsetBits_ = config_.size_bits - (dimmBits_ + config_.col_low_bits +
+            bankBits_ + config_.col_high_bits + STACKED_DRAM_RANK_BITS +
+            config_.row_bits);
+    if(busOffsetBits_ < 0)
+        dram_option_error("dram_size_bits", config_.size_bits,
+                "fewer bits than dimm, bank, rank, row and column bits");
+
+    rowShift_ = STACKED_DRAM_RANK_BITS + config_.col_high_bits + bankBits_ +
+        config_.col_low_bits + dimmBits_ + busOffsetBits_;
+
+    bankRow_.resize(config_.dimms * STACKED_DRAM_RANKS * config_.banks);
+
+    switch(org_) {
+        case STACKED_DRAM_MULTI_LAYER:
+            slotsPerLayer_ = 1;
+            break;
+        case STACKED_DRAM_VAULT:
+        case STACKED_DRAM_VAULT_TILES:
+            slotsPerLayer_ = config_.layers;
+            break;
+        default:
+            slotsPerLayer_ = 0;
+    }
+
+    if(slotsPerLayer_ && config_.buffers_per_layer > 0)
+        slotsPerLayer_ = config_.buffers_per_layer;
+
+    slots_.resize(config_.layers * slotsPerLayer_);
+    rowSlot_.resize(1 << config_.row_bits);
+    tilePos_.resize(config_.tiles);
+
+    reset();
+}
+
+void StackedDram::reset()
+{
+    foreach(i, bankRow_.count()) {
+        bankRow_[i] = -1;
+    }
+
+    foreach(i, slots_.count()) {
+        slots_[i] = -1;
+    }
+
+    foreach(i, rowSlot_.count()) {
+        rowSlot_[i] = -1;
+    }
+
+    foreach(i, tilePos_.count()) {
+        tilePos_[i] = -1;
+    }
+
+    usedSlots_ = 0;
+    nextTile_ = 0;
+}
+
+int StackedDram::access(W64 paddr, bool is_write, bool& row_hit)
+{
+    int row = get_field(paddr, rowShift_, config_.row_bits);
+
+    switch(org_) {
+        case STACKED_DRAM_SINGLE_LAYER:
+            return single_layer_access(paddr, row, is_write, row_hit);
+        case STACKED_DRAM_MULTI_LAYER:
+        case STACKED_DRAM_VAULT:
+            return buffer_access(row, 0, row_hit);
+        case STACKED_DRAM_VAULT_TILES:
+            {
+                /* Requests are spread over tiles in round robin order,
+                 * farther tiles take longer to reach the stack */
+                int tile = nextTile_;
+                nextTile_ = (nextTile_ + 1) % config_.tiles;
+                return buffer_access(row, tile, row_hit) +
+                    config_.tile_base_latency +
+                    (config_.tile_latency * tile);
+            }
+        default:
+            assert(0);
+    }
+
+    return 0;
+}
+
+int StackedDram::single_layer_access(W64 paddr, int row, bool is_write,
+        bool& row_hit)
+{
+    int dimm = get_field(paddr, busOffsetBits_, dimmBits_);
+    int bank = get_field(paddr, config_.col_low_bits + dimmBits_ +
+            busOffsetBits_, bankBits_);
+    int rank = get_field(paddr, config_.col_high_bits + bankBits_ +
+            config_.col_low_bits + dimmBits_ + busOffsetBits_,
+            STACKED_DRAM_RANK_BITS);
+
+    int &open_row = bankRow_[(dimm * STACKED_DRAM_RANKS + rank) *
+        config_.banks + bank];
+    int latency = config_.bus_latency;
+
+    if(open_row == row) {
+        row_hit = true;
+        latency += config_.row_buffer_latency;
+    } else {
+        row_hit = false;
+        latency += config_.row_read_latency;
+        open_row = row;
+    }
+
+    if(is_write)
+        latency += config_.row_write_latency;
+
+    return latency;
+}
+
+int StackedDram::buffer_access(int row, int tile, bool& row_hit)
+{
+    int slot = rowSlot_[row];
+
+    if(slot >= 0) {
+        /* Row buffers of upper layers are farther from logic layer */
+        row_hit = true;
+        int layer = slot / slotsPerLayer_;
+        return config_.bus_latency +
+            (config_.layer_latency * (layer + 1));
+    }
+
+    row_hit = false;
+
+    /* Fill empty buffers in order, then replace in round robin order
+     * starting from last slot replaced by this tile */
+    if(usedSlots_ < slots_.count()) {
+        slot = usedSlots_++;
+    } else {
+        slot = (tilePos_[tile] + 1) % slots_.count();
+        rowSlot_[slots_[slot]] = -1;
+    }
+
+    tilePos_[tile] = slot;
+    slots_[slot] = row;
+    rowSlot_[row] = slot;
+
+    return config_.row_read_latency;
+}
+
+ostream& StackedDram::print(ostream& os) const
+{
+    os << "StackedDram< org:", stacked_dram_org_names[org_];
+    os << " layers:", config_.layers, " tiles:", config_.tiles;
+    os << " row_bits:", config_.row_bits, " buffers:", slots_.count();
+    os << " used_buffers:", usedSlots_;
+    os << " >", endl;
+    return os;
+}
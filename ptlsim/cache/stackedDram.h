@@ -0,0 +1,183 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ */
+
+#ifndef STACKED_DRAM_H
+#define STACKED_DRAM_H
+
+#include <globals.h>
+#include <superstl.h>
+
+namespace Memory {
+
+/*
+ * Organisation of the 3D-stacked DRAM model
+ *
+ * single_layer : one open row per bank (classic open-page DRAM)
+ * multi_layer  : one row buffer per stacked layer
+ * vault        : layers x layers grid of row buffers (vault organisation)
+ * vault_tiles  : vault organisation accessed from multiple tiles, each tile
+ *                keeps its own replacement position and adds link latency
+ */
+enum StackedDramOrg {
+    STACKED_DRAM_SINGLE_LAYER,
+    STACKED_DRAM_MULTI_LAYER,
+    STACKED_DRAM_VAULT,
+    STACKED_DRAM_VAULT_TILES,
+    NUM_STACKED_DRAM_ORGS
+};
+
+static const char* stacked_dram_org_names[NUM_STACKED_DRAM_ORGS] = {
+    "single_layer",
+    "multi_layer",
+    "vault",
+    "vault_tiles",
+};
+
+/* Return organisation with given name or -1 if name is not valid */
+static inline int get_stacked_dram_org(const char *name)
+{
+    foreach(i, NUM_STACKED_DRAM_ORGS) {
+        if(strequal(name, stacked_dram_org_names[i]))
+            return i;
+    }
+    return -1;
+}
+
+const int STACKED_DRAM_RANKS = 2; /* each side of DIMM is one rank */
+const int STACKED_DRAM_RANK_BITS = 1;
+
+/*
+ * Geometry and latency table of the model, set from memory controller
+ * options in machine configuration. Latencies are in CPU cycles.
+ */
+struct StackedDramConfig {
+    int layers;
+    int tiles;
+    int buffers_per_layer; /* 0: 1 for multi_layer, layers for vault */
+
+    int size_bits;
+    int dimms;
+    int banks;
+    int row_bits;
+    int col_high_bits;
+    int col_low_bits;
+
+    int bus_latency;
+    int row_read_latency;
+    int row_write_latency;
+    int row_buffer_latency;
+    int layer_latency;
+    int tile_base_latency;
+    int tile_latency;
+
+    StackedDramConfig() {
+        layers = 8;
+        tiles = 4;
+        buffers_per_layer = 0;
+
+        size_bits = 32;
+        dimms = 2;
+        banks = 8;
+        row_bits = 4;
+        col_high_bits = 2;
+        col_low_bits = 2;
+
+        bus_latency = 45;
+        row_read_latency = 90;
+        row_write_latency = 90;
+        row_buffer_latency = 45;
+        layer_latency = 2;
+        tile_base_latency = 4;
+        tile_latency = 2;
+    }
+};
+
+/*
+ * StackedDram
+ *
+ * Row buffer model of 3D-stacked DRAM used by MemoryController to compute
+ * the access latency of each request that reaches memory. All state is
+ * owned by the instance, so each memory controller has its own buffers.
+ *
+ * Physical address to DRAM mapping (MSB-LSB):
+ * | row | rank | col_high | bank | col_low | dimm | bus_offset |
+ */
+class StackedDram
+{
+    public:
+        StackedDram(StackedDramOrg org, const StackedDramConfig& config);
+
+        /* Return access latency of given address and update buffers,
+         * row_hit is set if the row was found in a row buffer */
+        int access(W64 paddr, bool is_write, bool& row_hit);
+
+        void reset();
+
+        StackedDramOrg get_org() const { return org_; }
+        int get_layers() const { return config_.layers; }
+        int get_tiles() const { return config_.tiles; }
+        int get_buffer_count() const { return slots_.count(); }
+
+        ostream& print(ostream& os) const;
+
+    private:
+        StackedDramOrg org_;
+        StackedDramConfig config_;
+
+        /* Address mapping */
+        int dimmBits_;
+        int bankBits_;
+        int busOffsetBits_;
+        int rowShift_;
+
+        /* Last opened row of each bank for single_layer */
+        dynarray<int> bankRow_;
+
+        /* Row buffers, stored layer major, and reverse index from row id
+         * to buffer slot so lookup does not scan the buffers */
+        dynarray<int> slots_;
+        dynarray<int> rowSlot_;
+        int slotsPerLayer_;
+        int usedSlots_;
+
+        /* Last replaced slot, one per tile */
+        dynarray<int> tilePos_;
+        int nextTile_;
+
+        int get_field(W64 paddr, int shift, int bits) const {
+            return int((paddr >> shift) & ((W64(1) << bits) - 1));
+        }
+
+        int single_layer_access(W64 paddr, int row, bool is_write,
+                bool& row_hit);
+        int buffer_access(int row, int tile, bool& row_hit);
+};
+
+static inline ostream& operator <<(ostream& os, const StackedDram& dram)
+{
+    return dram.print(os);
+}
+
+};
+
+#endif // STACKED_DRAM_H
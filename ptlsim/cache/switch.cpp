@@ -46,6 +46,25 @@ int Switch::access_fast_path(Controller *controller,
     return -1;
 }
 
+/**
+ * @brief Pass functional warmup request to all other controllers
+ *
+ * Caches connected to a Global Directory send warmup requests to the
+ * directory instead, so switch only sees them without a directory.
+ */
+bool Switch::warmup(Controller *controller, MemoryRequest *request)
+{
+    bool shared = false;
+
+    foreach (i, controllers.count()) {
+        Controller *receiver = controllers[i]->controller;
+        if (receiver != controller)
+            shared |= receiver->warmup(this, request);
+    }
+
+    return shared;
+}
+
 void Switch::annul_request(MemoryRequest *request)
 {
     foreach (i, controllers.count()) {
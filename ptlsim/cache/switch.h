@@ -141,6 +141,7 @@ namespace SwitchInterconnect {
             void register_controller(Controller *controller);
             int  access_fast_path(Controller *controller,
                     MemoryRequest *request);
+            bool warmup(Controller *controller, MemoryRequest *request);
             void annul_request(MemoryRequest *request);
             int  get_delay() { return latency_; }
 			void dump_configuration(YAML::Emitter &out) const;
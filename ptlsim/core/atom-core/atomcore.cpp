@@ -1993,12 +1993,14 @@ bool AtomThread::fetch_check_current_bb()
     // We need to fetch new basic block from the buffer.
     fetchrip.update(ctx);
 
+    BasicBlock *prev = current_bb;
+
     if(current_bb) {
         current_bb->release();
         current_bb = NULL;
     }
 
-    BasicBlock *bb = bbcache[ctx.cpu_index](fetchrip);
+    BasicBlock *bb = bbcache[ctx.cpu_index].lookup(ctx, fetchrip, prev);
 
     if likely (bb) {
         current_bb = bb;
@@ -3141,11 +3143,7 @@ bool AtomCore::runcycle(void* none)
     running_thread->handle_interrupt_at_next_eom =
         running_thread->ctx.check_events();
 
-    if(running_thread->ctx.kernel_mode) {
-        running_thread->set_default_stats(kernel_stats);
-    } else {
-        running_thread->set_default_stats(user_stats);
-    }
+    running_thread->set_default_stats(running_thread->ctx.stats);
 
     exit_requested = writeback();
 
@@ -3283,6 +3281,62 @@ void AtomCore::flush_tlb_virt(Context& ctx, Waddr virtaddr)
     }
 }
 
+/**
+ * @brief Functional warmup of TLB and caches (-fast-fwd-warmup)
+ *
+ * @param ctx Context that accessed memory
+ * @param virtaddr Virtual address of access
+ * @param physaddr Physical address of access
+ * @param is_icache Flag indicating instruction fetch
+ * @param is_write Flag indicating store
+ *
+ * @return false if ctx is not simulated by this core
+ */
+bool AtomCore::warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+        bool is_icache, bool is_write)
+{
+    foreach(i, threadcount) {
+        if(threads[i]->ctx.cpu_index == ctx.cpu_index) {
+            if(is_icache)
+                itlb.insert(virtaddr, i);
+            else
+                dtlb.insert(virtaddr, i);
+
+            warmup_caches(i, physaddr, is_icache, is_write);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Functional warmup of branch predictor (-fast-fwd-warmup)
+ *
+ * @param ctx Context that executed a conditional branch
+ * @param ripafter RIP of instruction after the branch
+ * @param riptaken Target RIP if branch is taken
+ * @param target RIP of next executed instruction
+ *
+ * @return false if ctx is not simulated by this core
+ */
+bool AtomCore::warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+        W64 target)
+{
+    foreach(i, threadcount) {
+        if(threads[i]->ctx.cpu_index == ctx.cpu_index) {
+            BranchPredictorUpdateInfo predinfo;
+            predinfo.ctxid = ctx.cpu_index;
+            threads[i]->branchpred.predict(predinfo, BRANCH_HINT_COND,
+                    ripafter, riptaken);
+            threads[i]->branchpred.update(predinfo, ripafter, target);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void AtomCore::dump_state(ostream& os)
 {
     os << *this;
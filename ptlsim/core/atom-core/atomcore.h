@@ -1041,9 +1041,14 @@ namespace ATOM_CORE_MODEL {
         
         void reset();
         bool runcycle(void*);
+        Signal* get_cycle_signal() { return &run_cycle; }
         void check_ctx_changes();
         void flush_tlb(Context& ctx);
         void flush_tlb_virt(Context& ctx, Waddr virtaddr);
+        bool warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+                bool is_icache, bool is_write);
+        bool warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+                W64 target);
         void dump_state(ostream& os);
         void update_stats();
         void flush_pipeline();
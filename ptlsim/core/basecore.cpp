@@ -19,14 +19,40 @@ BaseCore::BaseCore(BaseMachine& machine, const char* name)
       , machine(machine)
 {
     coreid = machine.get_next_coreid();
+    in_parallel_phase = false;
 }
 
 void BaseCore::update_memory_hierarchy_ptr() {
     memoryHierarchy = machine.memoryHierarchyPtr;
 }
 
+void BaseCore::warmup_caches(W8 threadid, W64 physaddr, bool is_icache,
+        bool is_write)
+{
+    Memory::MemoryRequest request;
+
+    request.init(coreid, threadid, physaddr, 0, sim_cycle, is_icache, 0, 0,
+            is_write ? Memory::MEMORY_OP_WRITE : Memory::MEMORY_OP_READ);
+    memoryHierarchy->warmup(&request);
+}
+
 extern "C" void ptl_flush_bbcache(int8_t context_id) {
     if(in_simulation) {
+      /*
+       * With -lazy-bbcache-flush a TLB flush of one context keeps all
+       * basic blocks, they are revalidated when used again
+       */
+      if(config.lazy_bbcache_flush && context_id >= 0) {
+        bbcache_flush_epoch++;
+
+        PTLsimMachine* machine = PTLsimMachine::getcurrent();
+        if(machine) {
+            machine->flush_tlb(machine->contextof(context_id));
+        }
+        return;
+      }
+
+      flush_shared_bbcache(context_id);
       foreach(i, NUM_SIM_CORES) {
         bbcache[i].flush(context_id);
         // Get the current ptlsim machine and call its flush tlb
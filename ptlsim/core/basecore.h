@@ -35,6 +35,66 @@ namespace Core {
             virtual void flush_pipeline() = 0;
 		    virtual void dump_configuration(YAML::Emitter &out) const = 0;
 
+            /*
+             * Idle cycle skipping (-skip-idle-cycles):
+             * is_idle() returns true if the last cycle changed nothing in
+             * the core except its stats counters, so the following cycles
+             * will repeat it until the memory hierarchy or an IO event
+             * wakes the core up. get_idle_limit() returns maximum number of
+             * such cycles that can be skipped and skip_idle_cycles() must
+             * update all state that changes in an idle cycle, except stats.
+             * By default cores are never idle.
+             */
+            virtual bool is_idle() const { return false; }
+            virtual W64 get_idle_limit() const { return 0; }
+            virtual void skip_idle_cycles(W64 cycles) {}
+
+            /*
+             * Parallel core clocking (-parallel-cores):
+             * Cores that support it split each cycle in three phases.
+             * runcycle_begin() and runcycle_end() are called for all
+             * cores in core id order from the simulation thread and may
+             * access memory hierarchy, QEMU and other shared state.
+             * runcycle_private() is called for all cores in between, on
+             * worker threads, and must only touch state owned by the
+             * core. runcycle_end() returns true if simulation should stop.
+             */
+            virtual bool supports_parallel_cycle() const { return false; }
+            virtual void runcycle_begin() {}
+            virtual void runcycle_private() {}
+            virtual bool runcycle_end() { return false; }
+
+            /*
+             * Per-cycle signal of the core, used when machine clocks the
+             * cores itself (-parallel-cores and -sync-quantum)
+             */
+            virtual Signal* get_cycle_signal() { return NULL; }
+
+            /* Set while runcycle_private() runs on a worker thread */
+            bool in_parallel_phase;
+
+            /*
+             * Functional warmup (-fast-fwd-warmup):
+             * Instruction fetches, memory accesses and conditional
+             * branches emulated by QEMU in the last instructions of
+             * fast-forward update the TLBs, caches and branch predictor
+             * of the thread that simulates 'ctx', without timing, events
+             * or stats. Both return false if 'ctx' is not simulated by
+             * this core.
+             */
+            virtual bool warmup_access(Context& ctx, W64 virtaddr,
+                    W64 physaddr, bool is_icache, bool is_write) {
+                return false;
+            }
+            virtual bool warmup_branch(Context& ctx, W64 ripafter,
+                    W64 riptaken, W64 target) {
+                return false;
+            }
+
+            /* Warmup cache hierarchy with one access of given thread */
+            void warmup_caches(W8 threadid, W64 physaddr, bool is_icache,
+                    bool is_write);
+
             void update_memory_hierarchy_ptr();
 
             BaseMachine& machine;
@@ -104,6 +104,26 @@
 #define OOO_ALULAT 1 /* ALU latency, assuming fast bypass */
 #endif
 
+/*
+ * Memory dependence prediction: 0 uses the 8 entry load/store alias
+ * table, 1 uses store sets with SSIT and LFST of the given sizes
+ */
+#ifndef OOO_STORE_SETS
+#define OOO_STORE_SETS 0
+#endif
+
+#ifndef OOO_SSIT_SIZE
+#define OOO_SSIT_SIZE 4096
+#endif
+
+#ifndef OOO_LFST_SIZE
+#define OOO_LFST_SIZE 128
+#endif
+
+#ifndef OOO_STORE_SETS_CLEAR_INTERVAL
+#define OOO_STORE_SETS_CLEAR_INTERVAL 1000000 /* cycles, 0 to never clear */
+#endif
+
 /* max resources - Non configurable */
 #define OOO_MAX_FU_COUNT 16
 
@@ -185,6 +205,18 @@ namespace OOO_CORE_MODEL {
     const int LDQ_SIZE = OOO_LOAD_Q_SIZE;
     const int STQ_SIZE = OOO_STORE_Q_SIZE;
 
+    /* Buckets in each per-thread load and store address filter */
+    const int LSQ_FILTER_SIZE = 64;
+
+    /*
+     * Memory dependence prediction
+     */
+
+    const bool USE_STORE_SETS = OOO_STORE_SETS;
+    const int SSIT_SIZE = OOO_SSIT_SIZE;
+    const int LFST_SIZE = OOO_LFST_SIZE;
+    const W64 STORE_SETS_CLEAR_INTERVAL = OOO_STORE_SETS_CLEAR_INTERVAL;
+
     /*
      * Fetch
      */
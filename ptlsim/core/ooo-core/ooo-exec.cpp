@@ -1059,6 +1059,7 @@ int ReorderBufferEntry::issuestore(LoadStoreQueueEntry& state, Waddr& origaddr,
     thread.thread_stats.dcache.store.size[sizeshift]++;
 
     state.physaddr = (annul) ? INVALID_PHYSADDR : (physaddr >> 3);
+    thread.lsq_filter_update(state);
 
 /*
  *     The STQ is then searched for the most recent prior store S to same 64-bit block. If found, U's
@@ -1080,7 +1081,8 @@ int ReorderBufferEntry::issuestore(LoadStoreQueueEntry& state, Waddr& origaddr,
  */
     LoadStoreQueueEntry* sfra = NULL;
 
-    foreach_backward_before(LSQ, lsq, i) {
+    /* Only a store or fence with unresolved address can become sfra */
+    if unlikely (thread.unresolved_stores > 0) foreach_backward_before(LSQ, lsq, i) {
         LoadStoreQueueEntry& stbuf = LSQ[i];
 
         /* Skip over loads (we only care about the store queue subset): */
@@ -1199,7 +1201,10 @@ int ReorderBufferEntry::issuestore(LoadStoreQueueEntry& state, Waddr& origaddr,
      * itself and the load after it in program order at commit time.
      */
 
-    foreach_forward_after (LSQ, lsq, i) {
+    bool may_alias = thread.load_filter.probe_adjacent(state.physaddr);
+    thread.thread_stats.dcache.store.dependency.filtered += (!may_alias);
+
+    if unlikely (may_alias) foreach_forward_after (LSQ, lsq, i) {
         LoadStoreQueueEntry& ldbuf = LSQ[i];
 
          /*
@@ -1240,8 +1245,12 @@ int ReorderBufferEntry::issuestore(LoadStoreQueueEntry& state, Waddr& origaddr,
             state.data = EXCEPTION_LoadStoreAliasing;
             state.datavalid = 1;
 
-            /* Add the rip to the load to the load/store alias predictor: */
-            lsap.select(ldbuf.rob->uop.rip);
+            /* Add the rip to the load to the memory dependence predictor: */
+            if (USE_STORE_SETS)
+                thread.storesets.violation(ldbuf.rob->uop.rip, uop.rip);
+            else
+                lsap.select(ldbuf.rob->uop.rip);
+            thread.thread_stats.dcache.memdep.missed_violations++;
 
             /*
              * The load as dependent on this store. Add a new dependency
@@ -1476,6 +1485,24 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
     thread.thread_stats.dcache.load.size[sizeshift]++;
 
     state.physaddr = (annul) ? INVALID_PHYSADDR : (physaddr >> 3);
+    thread.lsq_filter_update(state);
+
+    /*
+     * Load was replayed to wait for a store it was predicted to alias.
+     * Once that store has its address, check if the wait was needed.
+     */
+    if unlikely (state.memdep_waited) {
+        LoadStoreQueueEntry* memdep = thread.get_memdep_store(state);
+        if (!memdep || memdep->addrvalid) {
+            if (memdep) {
+                int x = (memdep->physaddr - state.physaddr);
+                bool alias = (-1 <= x && x <= 1);
+                thread.thread_stats.dcache.memdep.replays_avoided += alias;
+                thread.thread_stats.dcache.memdep.false_dependencies += (!alias);
+            }
+            state.memdep_waited = 0;
+        }
+    }
 
     W64 data;
 
@@ -1483,7 +1510,7 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
 
 #define SMT_ENABLE_LOAD_HOISTING
 #ifdef SMT_ENABLE_LOAD_HOISTING
-    bool load_is_known_to_alias_with_store = (lsap(uop.rip) >= 0);
+    bool load_is_known_to_alias_with_store = (!USE_STORE_SETS) && (lsap(uop.rip) >= 0);
 #else
     /* For processors that cannot speculatively issue loads before unresolved stores: */
     bool load_is_known_to_alias_with_store = 1;
@@ -1504,8 +1531,20 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
 
     int sfra_addr_diff;
     bool all_sfra_datavalid = true;
+    bool predicted_wait = false;
 
-    foreach_backward_before(LSQ, lsq, i) {
+    /*
+     * Only stores within one 8-byte chunk of the load, or unresolved
+     * stores the load must wait for, can stop the scan. The address
+     * filter shows when there are none and the scan can be skipped.
+     */
+    bool may_depend = thread.store_filter.probe_adjacent(state.physaddr) |
+        ((thread.unresolved_stores > 0) &
+         (state.mmio | (thread.unresolved_lfences > 0) | load_is_known_to_alias_with_store));
+
+    thread.thread_stats.dcache.load.dependency.filtered += (!may_depend);
+
+    if likely (may_depend) foreach_backward_before(LSQ, lsq, i) {
         LoadStoreQueueEntry& stbuf = LSQ[i];
 
         /* Skip over loads (we only care about the store queue subset): */
@@ -1549,11 +1588,24 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
             if unlikely (load_is_known_to_alias_with_store) {
                 thread.thread_stats.dcache.load.dependency.predicted_alias_unresolved++;
                 sfra = &stbuf;
+                predicted_wait = true;
                 break;
             }
         }
     }
 
+    /*
+     * With store sets the load waits only for the last store of its store
+     * set renamed before it, unless a later store already blocks it.
+     */
+    LoadStoreQueueEntry* memdep = (USE_STORE_SETS) ? thread.get_memdep_store(state) : NULL;
+    if unlikely (memdep && !memdep->addrvalid &&
+            (!sfra || memdep->rob->uop.uuid > sfra->rob->uop.uuid)) {
+        thread.thread_stats.dcache.load.dependency.predicted_alias_unresolved++;
+        sfra = memdep;
+        predicted_wait = true;
+    }
+
     thread.thread_stats.dcache.load.dependency.independent += (sfra == NULL);
 
 
@@ -1616,6 +1668,13 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
         }
 
 #endif
+        if unlikely (predicted_wait && sfra) {
+            state.memdep_idx = sfra->index();
+            state.memdep_uuid = sfra->rob->uop.uuid;
+            state.memdep_waited = 1;
+            thread.thread_stats.dcache.memdep.predicted_waits++;
+        }
+
         replay();
         load_store_second_phase = 1;
         return ISSUE_NEEDS_REPLAY;
@@ -1683,6 +1742,7 @@ int ReorderBufferEntry::issueload(LoadStoreQueueEntry& state, Waddr& origaddr, W
     }
 
     state.addrvalid = 1;
+    thread.lsq_filter_update(state);
     generated_addr = addr;
     original_addr = origaddr;
     annul_flag = annul;
@@ -1890,6 +1950,7 @@ bool ReorderBufferEntry::probetlb(LoadStoreQueueEntry& state, Waddr& origaddr, W
 #endif
 
     addrgen(state, origaddr, virtpage, ra, rb, rc, pteupdate, addr, exception, pfec, annul);
+    thread.lsq_filter_update(state);
 
 #ifndef DISABLE_TLB
     /* First check if its a TLB hit or miss */
@@ -2067,6 +2128,7 @@ rob_cont:
     request->set_coreSignal(&core.dcache_signal);
 
     lsq->physaddr = pteaddr >> 3;
+    thread.lsq_filter_update(*lsq);
 
     bool L1_hit = core.memoryHierarchy->access_cache(request);
 
@@ -2126,6 +2188,24 @@ LoadStoreQueueEntry* ReorderBufferEntry::find_nearest_memory_fence() {
     return NULL;
 }
 
+/**
+ * @brief Find the store a load was predicted to depend on
+ *
+ * @param lsq Load queue entry
+ *
+ * @return Store entry if it is still in flight, NULL otherwise
+ */
+LoadStoreQueueEntry* ThreadContext::get_memdep_store(LoadStoreQueueEntry& lsq) {
+    if likely (lsq.memdep_idx < 0) return NULL;
+
+    LoadStoreQueueEntry& stbuf = LSQ[lsq.memdep_idx];
+    if (stbuf.entry_valid && stbuf.store && stbuf.rob &&
+            stbuf.rob->uop.uuid == lsq.memdep_uuid)
+        return &stbuf;
+
+    return NULL;
+}
+
 /**
  * @brief Issue a memory fence instruction
  *
@@ -2166,6 +2246,7 @@ int ReorderBufferEntry::issuefence(LoadStoreQueueEntry& state) {
     state.datavalid = 0;
     state.addrvalid = 0;
     state.physaddr = bitmask(48-3);
+    thread.lsq_filter_update(state);
 
     changestate(thread.rob_memory_fence_list);
 
@@ -2388,6 +2469,7 @@ void ReorderBufferEntry::fencewakeup() {
     physreg->complete();
     lsq->datavalid = 1;
     lsq->addrvalid = 1;
+    thread.lsq_filter_update(*lsq);
 
     cycles_left = 0;
     lfrqslot = -1;
@@ -2802,6 +2884,8 @@ W64 ReorderBufferEntry::annul(bool keep_misspec_uop, bool return_first_annulled_
             if (annulrob.release_mem_lock(true)) thread.flush_mem_lock_release_list(queued_locks_before);
             loads_in_flight -= (annulrob.lsq->store == 0);
             stores_in_flight -= (annulrob.lsq->store == 1);
+            thread.lsq_filter_remove(*annulrob.lsq);
+            thread.storesets.resolve_store(annulrob.lsq->store_set, annulrob.uop.uuid);
             annulrob.lsq->reset();
             LSQ.annul(annulrob.lsq);
 
@@ -2932,6 +3016,7 @@ void ReorderBufferEntry::redispatch(const bitvec<MAX_OPERANDS>& dependent_operan
         lsq->data = 0;
         lsq->invalid = 0;
         lsq->time_stamp = -1;
+        thread.lsq_filter_update(*lsq);
 
         if (operands[RS]->nonnull()) {
             operands[RS]->unref(*this, thread.threadid);
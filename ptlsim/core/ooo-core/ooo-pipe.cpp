@@ -282,6 +282,10 @@ void ThreadContext::flush_pipeline() {
     }
     loads_in_flight = 0;
     stores_in_flight = 0;
+    load_filter.reset();
+    store_filter.reset();
+    unresolved_stores = 0;
+    unresolved_lfences = 0;
     foreach_issueq(reset(core.get_coreid(), threadid, &core));
 
     dispatch_deadlock_countdown = DISPATCH_DEADLOCK_COUNTDOWN_CYCLES;
@@ -760,13 +764,15 @@ bool ThreadContext::fetch() {
  */
 BasicBlock* ThreadContext::fetch_or_translate_basic_block(const RIPVirtPhys& rvp) {
 
+    BasicBlock* prev = current_basic_block;
+
     if likely (current_basic_block) {
         /* Release our ref to the old basic block being fetched */
         current_basic_block->release();
         current_basic_block = NULL;
     }
 
-    BasicBlock* bb = bbcache[ctx.cpu_index](rvp);
+    BasicBlock* bb = bbcache[ctx.cpu_index].lookup(ctx, rvp, prev);
 
     if likely (bb) {
         current_basic_block = bb;
@@ -801,6 +807,14 @@ void ThreadContext::rename() {
 
     int prepcount = 0;
 
+    /* Store sets are cleared periodically to remove stale dependencies */
+    if unlikely (USE_STORE_SETS && STORE_SETS_CLEAR_INTERVAL &&
+            (sim_cycle >= storesets_clear_cycle)) {
+        storesets.clear();
+        storesets_clear_cycle = sim_cycle + STORE_SETS_CLEAR_INTERVAL;
+        thread_stats.dcache.memdep.clears++;
+    }
+
     while (prepcount < FRONTEND_WIDTH) {
         if unlikely (fetchq.empty()) {
             thread_stats.frontend.status.fetchq_empty++;
@@ -871,6 +885,20 @@ void ThreadContext::rename() {
             lsq.datavalid = 0;
             lsq.addrvalid = 0;
             lsq.invalid = 0;
+            lsq_filter_update(lsq);
+            lsq.store_set = -1;
+            lsq.memdep_idx = -1;
+            lsq.memdep_waited = 0;
+            if (USE_STORE_SETS) {
+                if (!st) {
+                    int idx;
+                    if (storesets.rename_load(transop.rip, lsq.memdep_uuid, idx))
+                        lsq.memdep_idx = idx;
+                } else if (!(lsq.lfence | lsq.sfence)) {
+                    lsq.store_set = storesets.rename_store(transop.rip,
+                            transop.uuid, lsq.index());
+                }
+            }
             loads_in_flight += (st == 0);
             stores_in_flight += (st == 1);
         }
@@ -1396,7 +1424,12 @@ int ThreadContext::dispatch() {
     } else if unlikely (!rob_ready_to_dispatch_list.empty()) {
         dispatch_deadlock_countdown--;
         if (!dispatch_deadlock_countdown) {
-            redispatch_deadlock_recovery();
+            /* Recovery flushes memory requests, so it is done in serial
+             * part of the cycle when core is clocked in parallel */
+            if (core.in_parallel_phase)
+                dispatch_deadlock_pending = 1;
+            else
+                redispatch_deadlock_recovery();
             dispatch_deadlock_countdown = DISPATCH_DEADLOCK_COUNTDOWN_CYCLES;
             return -1;
         }
@@ -2210,6 +2243,8 @@ int ReorderBufferEntry::commit() {
         assert(lsq->data == physreg->data);
         thread.loads_in_flight -= (lsq->store == 0);
         thread.stores_in_flight -= (lsq->store == 1);
+        thread.lsq_filter_remove(*lsq);
+        thread.storesets.resolve_store(lsq->store_set, uop.uuid);
         lsq->reset();
         thread.LSQ.commit(lsq);
         core.set_unaligned_hint(uop.rip, uop.ld_st_truly_unaligned);
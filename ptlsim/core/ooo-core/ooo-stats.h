@@ -432,6 +432,7 @@ namespace OOO_CORE_MODEL {
                     StatObj<W64> stq_address_not_ready;
                     StatObj<W64> fence;
                     StatObj<W64> mmio;
+                    StatObj<W64> filtered;
 
                         dependency(Statable *parent)
                             : Statable("dependency", parent)
@@ -441,6 +442,7 @@ namespace OOO_CORE_MODEL {
                               , stq_address_not_ready("stq_address_not_ready", this)
                               , fence("fence", this)
                               , mmio("mmio", this)
+                              , filtered("filtered", this)
                     {}
                 } dependency;
 
@@ -490,6 +492,24 @@ namespace OOO_CORE_MODEL {
                 {}
             } fence;
 
+            struct memdep : public Statable
+            {
+                StatObj<W64> predicted_waits;
+                StatObj<W64> false_dependencies;
+                StatObj<W64> replays_avoided;
+                StatObj<W64> missed_violations;
+                StatObj<W64> clears;
+
+                memdep(Statable *parent)
+                    : Statable("memdep", parent)
+                      , predicted_waits("predicted_waits", this)
+                      , false_dependencies("false_dependencies", this)
+                      , replays_avoided("replays_avoided", this)
+                      , missed_violations("missed_violations", this)
+                      , clears("clears", this)
+                {}
+            } memdep;
+
             struct tlb_stat : public Statable
             {
                 StatObj<W64> hits;
@@ -513,6 +533,7 @@ namespace OOO_CORE_MODEL {
                   , load("load", this)
                   , store("store", this)
                   , fence(this)
+                  , memdep(this)
                   , dtlb("dtlb", this)
                   , itlb("itlb", this)
                   , dtlb_latency("dtlb_latency", this)
@@ -153,6 +153,12 @@ void ThreadContext::reset() {
     current_icache_block = 0;
     loads_in_flight = 0;
     stores_in_flight = 0;
+    load_filter.reset();
+    store_filter.reset();
+    unresolved_stores = 0;
+    unresolved_lfences = 0;
+    storesets.reset();
+    storesets_clear_cycle = sim_cycle + STORE_SETS_CLEAR_INTERVAL;
     prev_interrupts_pending = false;
     handle_interrupt_at_next_eom = false;
     stop_at_next_eom = false;
@@ -170,6 +176,7 @@ void ThreadContext::reset() {
     total_uops_committed = 0;
     total_insns_committed = 0;
     dispatch_deadlock_countdown = 0;
+    dispatch_deadlock_pending = 0;
 #ifdef MULTI_IQ
     foreach(i, 4){
         issueq_count[i] = 0;
@@ -292,6 +299,7 @@ OooCore::OooCore(BaseMachine& machine_, W8 num_threads,
  */
 void OooCore::reset() {
     round_robin_tid = 0;
+    idle = false;
     round_robin_reg_file_offset = 0;
 
     setzero(robs_on_fu);
@@ -521,7 +529,18 @@ int ThreadContext::get_priority() const {
  * @return true if the core should stop simulating after this cycle
  */
 bool OooCore::runcycle(void* none) {
-    bool exiting = 0;
+    runcycle_begin();
+    runcycle_private();
+    return runcycle_end();
+}
+
+/**
+ * @brief First part of the cycle: commit, writeback, transfer, TLB walk and
+ * issue. These stages access the memory hierarchy and guest memory.
+ */
+void OooCore::runcycle_begin() {
+    if unlikely (config.skip_idle_cycles)
+        get_idle_signature(idle_signature);
 
      /*
       * Detect edge triggered transition from 0->1 for
@@ -536,11 +555,8 @@ bool OooCore::runcycle(void* none) {
         thread->handle_interrupt_at_next_eom = current_interrupts_pending;
         thread->prev_interrupts_pending = current_interrupts_pending;
 
-        if(thread->ctx.kernel_mode) {
-            thread->thread_stats.set_default_stats(kernel_stats);
-        } else {
-            thread->thread_stats.set_default_stats(user_stats);
-        }
+        /* Only changes stats pointers after a mode switch */
+        thread->thread_stats.set_default_stats(thread->ctx.stats);
     }
 
      /*
@@ -618,7 +634,6 @@ bool OooCore::runcycle(void* none) {
     /*
      *  Backend and issue pipe stages run with round robin priority
      */
-    int commitrc[threadcount];
     commitcount = 0;
     writecount = 0;
 
@@ -634,19 +649,19 @@ bool OooCore::runcycle(void* none) {
         if (thread->pause_counter > 0) {
             thread->pause_counter--;
             if(thread->handle_interrupt_at_next_eom) {
-                commitrc[tid] = COMMIT_RESULT_INTERRUPT;
+                thread->cycle_commitrc = COMMIT_RESULT_INTERRUPT;
                 if(thread->ctx.is_int_pending()) {
                     thread->thread_stats.cycles_in_pause -=
                         thread->pause_counter;
                     thread->pause_counter = 0;
                 }
             } else {
-                commitrc[tid] = COMMIT_RESULT_OK;
+                thread->cycle_commitrc = COMMIT_RESULT_OK;
             }
             continue;
         }
 
-        commitrc[tid] = thread->commit();
+        thread->cycle_commitrc = thread->commit();
         for_each_cluster(j) thread->writeback(j);
         for_each_cluster(j) thread->transfer(j);
     }
@@ -680,7 +695,14 @@ bool OooCore::runcycle(void* none) {
     }
 
     for_each_cluster(i) { issue(i); }
+}
 
+/**
+ * @brief Middle part of the cycle: complete, dispatch, frontend and rename,
+ * and fetch priorities. These stages only use state owned by this core, so
+ * cores can run this part in parallel.
+ */
+void OooCore::runcycle_private() {
     /*
      * Most of the frontend (except fetch!) also works with round robin priority
      */
@@ -689,7 +711,6 @@ bool OooCore::runcycle(void* none) {
         ptl_logfile << "OooCore::run():dispatch\n";
     }
 
-    int dispatchrc[threadcount];
     dispatchcount = 0;
     foreach (permute, threadcount) {
         int tid = add_index_modulo(round_robin_tid, +permute, threadcount);
@@ -698,9 +719,9 @@ bool OooCore::runcycle(void* none) {
 
         for_each_cluster(j) { thread->complete(j); }
 
-        dispatchrc[tid] = thread->dispatch();
+        thread->cycle_dispatchrc = thread->dispatch();
 
-        if likely (dispatchrc[tid] >= 0) {
+        if likely (thread->cycle_dispatchrc >= 0) {
             thread->frontend();
             thread->rename();
         }
@@ -713,25 +734,45 @@ bool OooCore::runcycle(void* none) {
      *  (if any) given the lowest priority.
      */
 
-    if (logable(9)) {
-        ptl_logfile << "OooCore::run():fetch\n";
-    }
-
     int priority_value[threadcount];
-    int priority_index[threadcount];
 
     if likely (threadcount == 1) {
         priority_value[0] = 0;
-        priority_index[0] = 0;
+        fetch_priority[0] = 0;
     } else {
         foreach (i, threadcount) {
-            priority_index[i] = i;
+            fetch_priority[i] = i;
             ThreadContext* thread = threads[i];
             priority_value[i] = thread->get_priority();
             if unlikely (!thread->ctx.running) priority_value[i] = limits<int>::max;
         }
 
-        sort(priority_index, threadcount, SortPrecomputedIndexListComparator<int, false>(priority_value));
+        sort(fetch_priority, threadcount, SortPrecomputedIndexListComparator<int, false>(priority_value));
+    }
+}
+
+/**
+ * @brief Last part of the cycle: fetch and handling of commit results.
+ *
+ * @return true if the core should stop simulating after this cycle
+ */
+bool OooCore::runcycle_end() {
+    bool exiting = 0;
+
+    /*
+     * Deadlock recovery found by dispatch while clocked in parallel
+     */
+
+    foreach (i, threadcount) {
+        ThreadContext* thread = threads[i];
+        if unlikely (thread->dispatch_deadlock_pending) {
+            thread->dispatch_deadlock_pending = 0;
+            thread->redispatch_deadlock_recovery();
+        }
+    }
+
+    if (logable(9)) {
+        ptl_logfile << "OooCore::run():fetch\n";
     }
 
     /*
@@ -743,18 +784,17 @@ bool OooCore::runcycle(void* none) {
      *  fetch from multiple threads every cycle.
      */
 
-    bool fetch_exception[threadcount];
     foreach (j, threadcount) {
-        int i = priority_index[j];
+        int i = fetch_priority[j];
         ThreadContext* thread = threads[i];
         assert(thread);
-        fetch_exception[i] = true;
+        thread->cycle_fetch_exception = true;
         if unlikely (!thread->ctx.running) {
             continue;
         }
 
-        if likely (dispatchrc[i] >= 0) {
-            fetch_exception[i] = thread->fetch();
+        if likely (thread->cycle_dispatchrc >= 0) {
+            thread->cycle_fetch_exception = thread->fetch();
         }
     }
 
@@ -780,14 +820,14 @@ bool OooCore::runcycle(void* none) {
     foreach (i, threadcount) {
         ThreadContext* thread = threads[i];
         if unlikely (!thread->ctx.running) continue;
-        int rc = commitrc[i];
+        int rc = thread->cycle_commitrc;
         if (logable(9)) {
             ptl_logfile << "OooCore::run():result check thread[",
             i, "] rc[", rc, "]\n";
         }
 
         if likely ((rc == COMMIT_RESULT_OK) | (rc == COMMIT_RESULT_NONE)) {
-            if(fetch_exception[i])
+            if(thread->cycle_fetch_exception)
                 continue;
 
             /* Its a instruction page fault */
@@ -933,9 +973,183 @@ bool OooCore::runcycle(void* none) {
 
     core_stats.cycles++;
 
+    if unlikely (config.skip_idle_cycles)
+        idle = !exiting && check_idle_cycle();
+
     return exiting;
 }
 
+/**
+ * @brief Collect all core state that changes when the core does any work in
+ * a cycle. Counters that change in every idle cycle (round robin thread,
+ * pause and dispatch deadlock counters) are left out and updated by
+ * skip_idle_cycles().
+ *
+ * @param sig Array to fill with signature values
+ */
+void OooCore::get_idle_signature(dynarray<W64>& sig)
+{
+    sig.clear();
+
+    foreach (i, physreg_states.count) {
+        sig.push(physreg_states[i]->count);
+    }
+
+#ifdef MULTI_IQ
+    sig.push(issueq_int0.count);
+    sig.push(issueq_int1.count);
+    sig.push(issueq_ld.count);
+    sig.push(issueq_fp.count);
+#else
+    sig.push(issueq_all.count);
+#endif
+
+    foreach (i, threadcount) {
+        ThreadContext* thread = threads[i];
+
+        foreach (j, thread->rob_states.count) {
+            sig.push(thread->rob_states[j]->count);
+        }
+        foreach (j, thread->lsq_states.count) {
+            sig.push(thread->lsq_states[j]->count);
+        }
+
+        sig.push(thread->ROB.head);
+        sig.push(thread->ROB.tail);
+        sig.push(thread->LSQ.head);
+        sig.push(thread->LSQ.tail);
+        sig.push(thread->fetchq.head);
+        sig.push(thread->fetchq.tail);
+        sig.push(thread->fetchq.count);
+
+        sig.push(thread->fetchrip.rip);
+        sig.push((W64)thread->current_basic_block);
+        sig.push(thread->current_basic_block_transop_index);
+        sig.push(thread->current_icache_block);
+        sig.push(thread->fetch_uuid);
+        sig.push(thread->stall_frontend);
+        sig.push(thread->waiting_for_icache_fill);
+        sig.push(thread->itlb_walk_level);
+        sig.push(thread->in_tlb_walk);
+        sig.push(thread->loads_in_flight);
+        sig.push(thread->stores_in_flight);
+        sig.push(thread->pause_counter > 0);
+        sig.push(thread->handle_interrupt_at_next_eom);
+        sig.push(thread->stop_at_next_eom);
+        sig.push(thread->smc_invalidate_pending);
+        sig.push(thread->queued_mem_lock_release_count);
+        sig.push(thread->last_commit_at_cycle);
+        sig.push(thread->total_uops_committed);
+        sig.push(thread->ctx.running);
+        sig.push(thread->ctx.kernel_mode);
+    }
+}
+
+/**
+ * @brief Check if the cycle that just finished was idle: no pipeline stage
+ * had anything to do and no state changed, only some stall counters.
+ *
+ * @return true if following cycles will repeat the last one
+ */
+bool OooCore::check_idle_cycle()
+{
+    if (commitcount || dispatchcount || writecount)
+        return false;
+
+#ifdef MULTI_IQ
+    if (issueq_int0.allready.nonzero() || issueq_int1.allready.nonzero() ||
+            issueq_ld.allready.nonzero() || issueq_fp.allready.nonzero())
+        return false;
+#else
+    if (issueq_all.allready.nonzero())
+        return false;
+#endif
+
+    foreach (i, threadcount) {
+        ThreadContext* thread = threads[i];
+
+        if (!thread->rob_frontend_list.empty() ||
+                !thread->rob_tlb_miss_list.empty() ||
+                !thread->rob_memory_fence_list.empty())
+            return false;
+
+        for_each_cluster(j) {
+            if (!thread->rob_ready_to_issue_list[j].empty() ||
+                    !thread->rob_ready_to_store_list[j].empty() ||
+                    !thread->rob_ready_to_load_list[j].empty() ||
+                    !thread->rob_issued_list[j].empty() ||
+                    !thread->rob_completed_list[j].empty() ||
+                    !thread->rob_ready_to_writeback_list[j].empty())
+                return false;
+        }
+    }
+
+    get_idle_signature(idle_signature_end);
+
+    if (idle_signature.count() != idle_signature_end.count())
+        return false;
+
+    foreach (i, idle_signature.count()) {
+        if (idle_signature[i] != idle_signature_end[i])
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Get number of idle cycles that can be skipped before a thread
+ * leaves pause, reaches dispatch deadlock recovery or the pipeline
+ * deadlock check.
+ */
+W64 OooCore::get_idle_limit() const
+{
+    W64 limit = (W64)1024*1024*threadcount;
+
+    foreach (i, threadcount) {
+        ThreadContext* thread = threads[i];
+        if unlikely (!thread->ctx.running) continue;
+
+        W64 since_commit = sim_cycle - thread->last_commit_at_cycle;
+        if (since_commit >= (W64)1024*1024*threadcount)
+            return 0;
+        limit = min(limit, (W64)1024*1024*threadcount - since_commit);
+
+        if (thread->pause_counter > 0)
+            limit = min(limit, thread->pause_counter - 1);
+
+        if (!thread->rob_ready_to_dispatch_list.empty()) {
+            if (thread->dispatch_deadlock_countdown <= 1)
+                return 0;
+            limit = min(limit, (W64)thread->dispatch_deadlock_countdown - 1);
+        }
+    }
+
+    return limit;
+}
+
+/**
+ * @brief Update the counters that change in every idle cycle as if given
+ * number of idle cycles were simulated.
+ *
+ * @param cycles Number of cycles skipped
+ */
+void OooCore::skip_idle_cycles(W64 cycles)
+{
+    foreach (i, threadcount) {
+        ThreadContext* thread = threads[i];
+        if unlikely (!thread->ctx.running) continue;
+
+        if (thread->pause_counter > 0)
+            thread->pause_counter -= cycles;
+
+        if (!thread->rob_ready_to_dispatch_list.empty())
+            thread->dispatch_deadlock_countdown -= cycles;
+    }
+
+    round_robin_tid = (round_robin_tid + cycles) % threadcount;
+}
+
 /*
  * ReorderBufferEntry
  */
@@ -1572,6 +1786,44 @@ void OooCore::flush_tlb_virt(Context& ctx, Waddr virtaddr) {
     /* FIXME AVADH DEFCORE */
 }
 
+bool OooCore::warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+        bool is_icache, bool is_write) {
+    foreach(i, threadcount) {
+        ThreadContext* thread = threads[i];
+        if(thread->ctx.cpu_index != ctx.cpu_index)
+            continue;
+
+        if(is_icache)
+            thread->itlb.insert(virtaddr, thread->threadid);
+        else
+            thread->dtlb.insert(virtaddr, thread->threadid);
+
+        warmup_caches(thread->threadid, physaddr, is_icache, is_write);
+        return true;
+    }
+
+    return false;
+}
+
+bool OooCore::warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+        W64 target) {
+    foreach(i, threadcount) {
+        ThreadContext* thread = threads[i];
+        if(thread->ctx.cpu_index != ctx.cpu_index)
+            continue;
+
+        /* Same predict and update calls as fetch and commit */
+        PredictorUpdate predinfo;
+        predinfo.ctxid = 0;
+        thread->branchpred.predict(predinfo, BRANCH_HINT_COND, ripafter,
+                riptaken);
+        thread->branchpred.update(predinfo, ripafter, target);
+        return true;
+    }
+
+    return false;
+}
+
 void OooCore::check_ctx_changes()
 {
     foreach(i, threadcount) {
@@ -16,6 +16,7 @@
 #include <ptlsim.h>
 #include <basecore.h>
 #include <branchpred.h>
+#include <storesets.h>
 #include <statelist.h>
 #include <statsBuilder.h>
 #include <decode.h>
@@ -600,6 +601,14 @@ namespace OOO_CORE_MODEL {
     /* Define this to allow speculative issue of loads before unresolved stores */
     /* #define SMT_ENABLE_LOAD_HOISTING */
 
+    /* What an LSQ entry is counted as in its thread's address filters */
+    enum {
+        LSQ_FILTER_LOAD         = (1 << 0), /* load with valid address */
+        LSQ_FILTER_STORE        = (1 << 1), /* store with valid address */
+        LSQ_FILTER_UNRESOLVED   = (1 << 2), /* store or fence without address */
+        LSQ_FILTER_LFENCE       = (1 << 3), /* load fence not yet completed */
+    };
+
     /**
      * @brief  LSQ structure used to track memory operations to insure update
      * memory in order
@@ -615,6 +624,12 @@ namespace OOO_CORE_MODEL {
         W32 time_stamp;
         W64 sfr_data;
         W8 sfr_bytemask;
+        W8 filter_flags; /* LSQ_FILTER_* this entry was counted as */
+        W32 filter_key;  /* physaddr it was counted with */
+        W16s store_set;    /* stores: store set it was renamed in or -1 */
+        W16s memdep_idx;   /* loads: LSQ index of predicted store or -1 */
+        W8 memdep_waited;  /* loads: replayed waiting for memdep store */
+        W64 memdep_uuid;   /* loads: uuid of predicted store */
         LoadStoreQueueEntry() { }
 
         int index() const { return idx; }
@@ -634,6 +649,7 @@ namespace OOO_CORE_MODEL {
 
         void init(int idx) {
             this->idx = idx;
+            filter_flags = 0;
             reset();
         }
 
@@ -865,6 +881,7 @@ namespace OOO_CORE_MODEL {
     extern bool globals_initialized;
 
     struct LoadStoreAliasPredictor: public FullyAssociativeTags<W64, 8> { };
+    typedef Core::StoreSetPredictor<SSIT_SIZE, LFST_SIZE> StoreSetPredictor;
 
     enum {
         ROB_STATE_READY = (1 << 0),
@@ -992,6 +1009,52 @@ namespace OOO_CORE_MODEL {
         Queue<ReorderBufferEntry, ROB_SIZE> ROB;
 
         Queue<LoadStoreQueueEntry, LSQ_SIZE> LSQ;
+
+        /*
+         * Address filters over the LSQ: the load and store scans in
+         * issueload() and issuestore() are skipped when these show that
+         * no entry can match. Entries must call lsq_filter_update() after
+         * any change to store, fence, addrvalid or physaddr and
+         * lsq_filter_remove() before they are freed.
+         */
+        CountingAddressFilter<LSQ_FILTER_SIZE> load_filter;
+        CountingAddressFilter<LSQ_FILTER_SIZE> store_filter;
+        int unresolved_stores;
+        int unresolved_lfences;
+
+        void lsq_filter_remove(LoadStoreQueueEntry& lsq) {
+            if (lsq.filter_flags & LSQ_FILTER_LOAD)
+                load_filter.remove(lsq.filter_key);
+            if (lsq.filter_flags & LSQ_FILTER_STORE)
+                store_filter.remove(lsq.filter_key);
+            unresolved_stores -= ((lsq.filter_flags & LSQ_FILTER_UNRESOLVED) != 0);
+            unresolved_lfences -= ((lsq.filter_flags & LSQ_FILTER_LFENCE) != 0);
+            lsq.filter_flags = 0;
+        }
+
+        void lsq_filter_update(LoadStoreQueueEntry& lsq) {
+            lsq_filter_remove(lsq);
+
+            W8 flags = 0;
+            if (!lsq.store) {
+                flags = (lsq.addrvalid) ? LSQ_FILTER_LOAD : 0;
+            } else if (!lsq.addrvalid) {
+                flags = LSQ_FILTER_UNRESOLVED | ((lsq.lfence) ? LSQ_FILTER_LFENCE : 0);
+            } else if (!(lsq.lfence | lsq.sfence)) {
+                flags = LSQ_FILTER_STORE;
+            }
+
+            /* Scans compare the low 32 bits of the physaddr difference */
+            lsq.filter_key = W32(lsq.physaddr);
+            lsq.filter_flags = flags;
+            if (flags & LSQ_FILTER_LOAD)
+                load_filter.add(lsq.filter_key);
+            if (flags & LSQ_FILTER_STORE)
+                store_filter.add(lsq.filter_key);
+            unresolved_stores += ((flags & LSQ_FILTER_UNRESOLVED) != 0);
+            unresolved_lfences += ((flags & LSQ_FILTER_LFENCE) != 0);
+        }
+
         RegisterRenameTable specrrt;
         RegisterRenameTable commitrrt;
 
@@ -1028,6 +1091,9 @@ namespace OOO_CORE_MODEL {
 
         TransOpBuffer unaligned_ldst_buf;
         LoadStoreAliasPredictor lsap;
+        StoreSetPredictor storesets;
+        W64 storesets_clear_cycle;
+        LoadStoreQueueEntry* get_memdep_store(LoadStoreQueueEntry& lsq);
         int loads_in_this_cycle;
         W64 load_to_store_parallel_forwarding_buffer[LOAD_FU_COUNT];
 
@@ -1038,6 +1104,12 @@ namespace OOO_CORE_MODEL {
         W64 total_uops_committed;
         W64 total_insns_committed;
         int dispatch_deadlock_countdown;
+        bool dispatch_deadlock_pending;
+
+        /* Pipeline stage results of current cycle */
+        int cycle_commitrc;
+        int cycle_dispatchrc;
+        bool cycle_fetch_exception;
 #ifdef MULTI_IQ
         int issueq_count[4]; // number of occupied issuequeue entries
 #else
@@ -1256,6 +1328,15 @@ namespace OOO_CORE_MODEL {
 
 		/* Pipeline Stages */
         bool runcycle(void*);
+        bool supports_parallel_cycle() const { return true; }
+        void runcycle_begin();
+        void runcycle_private();
+        bool runcycle_end();
+        Signal* get_cycle_signal() { return &run_cycle; }
+
+        /* Fetch order of threads in current cycle */
+        int fetch_priority[1 << MAX_THREADS_BIT];
+
         void flush_pipeline();
         bool fetch();
         void rename();
@@ -1270,6 +1351,11 @@ namespace OOO_CORE_MODEL {
         void flush_tlb(Context& ctx);
         void flush_tlb_virt(Context& ctx, Waddr virtaddr);
 
+        bool warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+                bool is_icache, bool is_write);
+        bool warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+                W64 target);
+
 		/* Cache Signals and Callbacks */
         Signal dcache_signal;
         Signal icache_signal;
@@ -1292,6 +1378,17 @@ namespace OOO_CORE_MODEL {
         void check_ctx_changes();
 
 		void dump_configuration(YAML::Emitter &out) const;
+
+		/* Idle cycle skipping */
+        bool idle;
+        dynarray<W64> idle_signature;
+        dynarray<W64> idle_signature_end;
+
+        void get_idle_signature(dynarray<W64>& sig);
+        bool check_idle_cycle();
+        bool is_idle() const { return idle; }
+        W64 get_idle_limit() const;
+        void skip_idle_cycles(W64 cycles);
     };
 
     /**
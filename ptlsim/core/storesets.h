@@ -0,0 +1,136 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef STORE_SETS_H
+#define STORE_SETS_H
+
+#include <globals.h>
+#include <superstl.h>
+
+namespace Core {
+
+    /**
+     * @brief Store set memory dependence predictor
+     *
+     * Based on G. Chrysos and J. Emer, "Memory Dependence Prediction using
+     * Store Sets", ISCA 1998. The Store Set ID Table (SSIT), indexed by
+     * instruction address, maps loads and stores that once caused a memory
+     * ordering violation to a common store set. The Last Fetched Store
+     * Table (LFST) holds for each store set the last renamed store. A load
+     * in a store set waits only for that store instead of for every older
+     * store with an unresolved address.
+     *
+     * Stores are identified by their uuid and a tag chosen by the core
+     * (the LSQ index), so the core can check that the store is still in
+     * flight before waiting on it.
+     */
+    template <int SSIT_SIZE, int LFST_SIZE>
+    struct StoreSetPredictor {
+
+        static const W16 INVALID_SSID = 0xffff;
+
+        struct LastFetchedStore {
+            W64 uuid;
+            int tag;
+            bool valid;
+        };
+
+        W16 ssit[SSIT_SIZE];
+        LastFetchedStore lfst[LFST_SIZE];
+        int next_ssid;
+
+        StoreSetPredictor() {
+            reset();
+        }
+
+        void reset() {
+            clear();
+            next_ssid = 0;
+        }
+
+        /* Forget all store sets, done periodically to drop stale ones */
+        void clear() {
+            foreach (i, SSIT_SIZE) {
+                ssit[i] = INVALID_SSID;
+            }
+            foreach (i, LFST_SIZE) {
+                lfst[i].valid = false;
+            }
+        }
+
+        static int index(W64 rip) {
+            return (rip ^ (rip >> 10) ^ (rip >> 20)) % SSIT_SIZE;
+        }
+
+        /* Returns store set of instruction at rip or -1 */
+        int get_ssid(W64 rip) const {
+            W16 ssid = ssit[index(rip)];
+            return (ssid == INVALID_SSID) ? -1 : ssid;
+        }
+
+        /*
+         * Load is renamed: returns true and sets uuid and tag of the
+         * store it is predicted to depend on
+         */
+        bool rename_load(W64 rip, W64& uuid, int& tag) const {
+            int ssid = get_ssid(rip);
+            if likely (ssid < 0 || !lfst[ssid].valid)
+                return false;
+            uuid = lfst[ssid].uuid;
+            tag = lfst[ssid].tag;
+            return true;
+        }
+
+        /*
+         * Store is renamed: it becomes the last fetched store of its store
+         * set. Returns the store set, which is passed to resolve_store().
+         */
+        int rename_store(W64 rip, W64 uuid, int tag) {
+            int ssid = get_ssid(rip);
+            if likely (ssid < 0)
+                return -1;
+            lfst[ssid].uuid = uuid;
+            lfst[ssid].tag = tag;
+            lfst[ssid].valid = true;
+            return ssid;
+        }
+
+        /* Store has committed or was annulled */
+        void resolve_store(int ssid, W64 uuid) {
+            if (ssid < 0)
+                return;
+            if (lfst[ssid].valid && lfst[ssid].uuid == uuid)
+                lfst[ssid].valid = false;
+        }
+
+        /*
+         * Load at load_rip was issued before the store at store_rip it
+         * depends on: put both in one store set. Two existing sets are
+         * merged into the one with the smaller id.
+         */
+        void violation(W64 load_rip, W64 store_rip) {
+            W16& load_ssid = ssit[index(load_rip)];
+            W16& store_ssid = ssit[index(store_rip)];
+
+            if (load_ssid == INVALID_SSID && store_ssid == INVALID_SSID) {
+                W16 ssid = next_ssid;
+                next_ssid = (next_ssid + 1) % LFST_SIZE;
+                lfst[ssid].valid = false;
+                load_ssid = store_ssid = ssid;
+            } else if (load_ssid == INVALID_SSID) {
+                load_ssid = store_ssid;
+            } else if (store_ssid == INVALID_SSID) {
+                store_ssid = load_ssid;
+            } else {
+                load_ssid = store_ssid = min(load_ssid, store_ssid);
+            }
+        }
+    };
+
+};
+
+#endif // STORE_SETS_H
@@ -11,6 +11,14 @@
 #include <globals.h>
 #include <superstl.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
 inline vec16b x86_sse_ldvbu(const vec16b* m) { vec16b rd; asm("movdqu %[m],%[rd]" : [rd] "=x" (rd) : [m] "xm" (*m)); return rd; }
 inline void x86_sse_stvbu(vec16b* m, const vec16b ra) { asm("movdqu %[ra],%[m]" : [m] "=xm" (*m) : [ra] "x" (ra) : "memory"); }
 inline vec8w x86_sse_ldvwu(const vec8w* m) {
@@ -342,6 +350,58 @@ ostream& operator <<(ostream& os, HistoryBuffer<T, size>& history) {
   return os;
 }
 
+//
+// Counting filter over 32-bit keys hashed into <size> buckets. A zero
+// bucket proves no key mapping to it was added, so a queue search for
+// a key can be skipped; a non-zero bucket may be a hash collision.
+// Every add() must be matched with a remove() of the same key.
+//
+template <int size>
+struct CountingAddressFilter {
+  W16 counts[size];
+  int total;
+
+  CountingAddressFilter() {
+    reset();
+  }
+
+  void reset() {
+    setzero(counts);
+    total = 0;
+  }
+
+  static int bucket(W32 key) {
+    return (key ^ (key >> 16)) % size;
+  }
+
+  void add(W32 key) {
+    counts[bucket(key)]++;
+    total++;
+  }
+
+  void remove(W32 key) {
+    int b = bucket(key);
+    assert(counts[b] > 0);
+    counts[b]--;
+    total--;
+  }
+
+  bool probe(W32 key) const {
+    return (counts[bucket(key)] != 0);
+  }
+
+  //
+  // True if key or one of its neighbours (key - 1, key + 1 with
+  // 32-bit wraparound) may have been added
+  //
+  bool probe_adjacent(W32 key) const {
+    if likely (!total) return false;
+    return probe(key - 1) | probe(key) | probe(key + 1);
+  }
+
+  int count() const { return total; }
+};
+
 //
 // Fully Associative Arrays
 //
@@ -352,6 +412,107 @@ template <> struct InvalidTag<W32> { static const W32 INVALID = 0xffffffff; };
 template <> struct InvalidTag<W16> { static const W16 INVALID = 0xffff; };
 template <> struct InvalidTag<W8> { static const W8 INVALID = 0xff; };
 
+//
+// Match 64-bit tags with SIMD compares: returns a bitmap of all entries
+// of tags[0..count-1] that are equal to target. <count> must be a
+// multiple of 4 and at most 64. Uses AVX-512, AVX2, SSE4.1 or SSE2,
+// whichever the build targets. Loads are unaligned.
+//
+
+static inline W64 x86_match_tags64(const W64* tags, int count, W64 target) {
+  W64 hits = 0;
+  int i = 0;
+
+#if defined(__AVX512F__)
+  __m512i t8 = _mm512_set1_epi64(target);
+  for (; i + 8 <= count; i += 8) {
+    __m512i v = _mm512_loadu_si512((const void*)&tags[i]);
+    hits |= W64(_mm512_cmpeq_epi64_mask(v, t8)) << i;
+  }
+#endif
+
+#if defined(__AVX2__)
+  __m256i t = _mm256_set1_epi64x(target);
+  for (; i < count; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)&tags[i]);
+    W64 m = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, t)));
+    hits |= m << i;
+  }
+#elif defined(__SSE4_1__)
+  __m128i t = _mm_set1_epi64x(target);
+  for (; i < count; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&tags[i]);
+    W64 m = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, t)));
+    hits |= m << i;
+  }
+#else
+  // SSE2 has no 64-bit compare: both 32-bit halves must match
+  __m128i t = _mm_set1_epi64x(target);
+  for (; i < count; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)&tags[i]);
+    W32 m = _mm_movemask_epi8(_mm_cmpeq_epi32(v, t));
+    W64 lanes = ((m & 0xff) == 0xff) | (((m >> 8) == 0xff) << 1);
+    hits |= lanes << i;
+  }
+#endif
+
+  return hits;
+}
+
+//
+// This is a clever way of doing branch-free matching
+// with conditional moves and addition. It relies on
+// having at most one matching entry in the array;
+// otherwise the algorithm breaks:
+//
+template <typename T, int ways>
+static inline int scalar_match_tags(const T* tags, T target) {
+  int way = 0;
+  foreach (i, ways) {
+    way += (tags[i] == target) ? (i + 1) : 0;
+  }
+
+  return way - 1;
+}
+
+//
+// Way matching used by FullyAssociativeTags. W64 tags with a multiple
+// of 4 ways (4, 8, 16 and 32 way caches, directory, BTB) use one SIMD
+// compare per 4 ways instead of a compare-and-add per way.
+//
+
+template <typename T, int ways>
+struct FullyAssociativeTagMatch {
+  static const bool vectorized = false;
+
+  static int match(const T* tags, T target) {
+    return scalar_match_tags<T, ways>(tags, target);
+  }
+};
+
+//
+// Plain SSE2 builds keep the scalar match for sets: emulating 64-bit
+// compares with 32-bit ones is slower than scalar above 8 ways.
+//
+#ifdef __SSE4_1__
+#define VECTOR_TAG_MATCH64 1
+#else
+#define VECTOR_TAG_MATCH64 0
+#endif
+
+template <int ways>
+struct FullyAssociativeTagMatch<W64, ways> {
+  static const bool vectorized = VECTOR_TAG_MATCH64 &&
+    ((ways % 4) == 0) && (ways <= 64);
+
+  static int match(const W64* tags, W64 target) {
+    if (!vectorized) return scalar_match_tags<W64, ways>(tags, target);
+
+    W64 hits = x86_match_tags64(tags, ways, target);
+    return (hits) ? (int)lsbindex64(hits) : -1;
+  }
+};
+
 //
 // The replacement policy is pseudo-LRU using a most recently used
 // bit vector (mLRU), as described in the paper "Performance Evaluation
@@ -388,19 +549,8 @@ struct FullyAssociativeTags {
     // if (evictmap.allset()) evictmap = 0;
   }
 
-  //
-  // This is a clever way of doing branch-free matching
-  // with conditional moves and addition. It relies on
-  // having at most one matching entry in the array;
-  // otherwise the algorithm breaks:
-  //
   int match(T target) {
-    int way = 0;
-    foreach (i, ways) {
-      way += (tags[i] == target) ? (i + 1) : 0;
-    }
-
-    return way - 1;
+    return FullyAssociativeTagMatch<T, ways>::match(tags, target);
   }
 
   int probe(T target) {
@@ -931,19 +1081,8 @@ struct LockableFullyAssociativeTags {
     // if (evictmap.allset()) evictmap = 0;
   }
 
-  //
-  // This is a clever way of doing branch-free matching
-  // with conditional moves and addition. It relies on
-  // having at most one matching entry in the array;
-  // otherwise the algorithm breaks:
-  //
   int match(T target) {
-    int way = 0;
-    foreach (i, ways) {
-      way += (tags[i] == target) ? (i + 1) : 0;
-    }
-
-    return way - 1;
+    return FullyAssociativeTagMatch<T, ways>::match(tags, target);
   }
 
   int probe(T target) {
@@ -0,0 +1,340 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#include <shmsync.h>
+
+#include <sched.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/* Number of polls before a waiter goes to sleep */
+#define SHMSYNC_SPIN_LIMIT (1 << 14)
+
+/* Number of polls between yields, in case host has fewer cpus than
+ * processes */
+#define SHMSYNC_YIELD_SPINS (1 << 10)
+
+#define COUNT_ARRIVED(c) W32(c)
+#define COUNT_PARTICIPANTS(c) W32((c) >> 32)
+#define MAKE_COUNT(participants, arrived) \
+    ((W64(participants) << 32) | W64(arrived))
+
+/**
+ * @brief Map a shared memory segment, creating it if required
+ *
+ * New segments are zero filled. Segment is grown if it is smaller than
+ * 'size'.
+ *
+ * @return Mapped segment or NULL on error
+ */
+static void* shm_map(const char *name, size_t size)
+{
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0666);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 ||
+            (st.st_size < (off_t)size && ftruncate(fd, size) < 0)) {
+        ::close(fd);
+        return NULL;
+    }
+
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    return (mem == MAP_FAILED) ? NULL : mem;
+}
+
+/* Spinning only helps if every waiter has its own host cpu */
+static int spin_limit(int participants)
+{
+    static int host_cpus = 0;
+
+    if unlikely (!host_cpus)
+        host_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (participants <= host_cpus) ? SHMSYNC_SPIN_LIMIT : 0;
+}
+
+static int futex(W32 *addr, int op, W32 val)
+{
+    /* Not FUTEX_PRIVATE_FLAG, waiters are in other processes */
+    return syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+ShmBarrier::ShmBarrier()
+    : state(NULL)
+{
+}
+
+ShmBarrier::~ShmBarrier()
+{
+    close();
+}
+
+bool ShmBarrier::open(const char *name)
+{
+    close();
+    state = (State*)shm_map(name, sizeof(State));
+    return state != NULL;
+}
+
+void ShmBarrier::close()
+{
+    if (state) {
+        munmap(state, sizeof(State));
+        state = NULL;
+    }
+}
+
+bool ShmBarrier::unlink(const char *name)
+{
+    return shm_unlink(name) == 0;
+}
+
+void ShmBarrier::join()
+{
+    assert(state);
+    xadd(state->count, MAKE_COUNT(1, 0));
+}
+
+/**
+ * @brief Stop taking part in barriers
+ *
+ * If all other participants are already waiting, they are released.
+ */
+void ShmBarrier::leave()
+{
+    assert(state);
+
+    W64 old, next;
+    bool last;
+    do {
+        old = state->count;
+        W32 participants = COUNT_PARTICIPANTS(old) - 1;
+        W32 arrived = COUNT_ARRIVED(old);
+        last = (arrived && arrived >= participants);
+        next = MAKE_COUNT(participants, last ? 0 : arrived);
+    } while (cmpxchg(state->count, next, old) != old);
+
+    if (last)
+        release();
+}
+
+/* Start next generation and wake up sleeping waiters */
+void ShmBarrier::release()
+{
+    /* Locked add orders the new generation before sleepers is read */
+    xadd(state->generation, W32(1));
+
+    if (state->sleepers)
+        futex(&state->generation, FUTEX_WAKE, INT_MAX);
+}
+
+bool ShmBarrier::wait()
+{
+    assert(state);
+
+    W32 gen = state->generation;
+    barrier();
+
+    if unlikely (state->stopped)
+        return false;
+
+    W64 old, next;
+    W32 participants;
+    bool last;
+    do {
+        old = state->count;
+        participants = COUNT_PARTICIPANTS(old);
+        W32 arrived = COUNT_ARRIVED(old) + 1;
+        last = (arrived >= participants);
+        next = MAKE_COUNT(participants, last ? 0 : arrived);
+    } while (cmpxchg(state->count, next, old) != old);
+
+    if (last) {
+        release();
+        return !state->stopped;
+    }
+
+    foreach (i, spin_limit(participants)) {
+        barrier();
+        if (state->generation != gen)
+            return !state->stopped;
+        if unlikely ((i % SHMSYNC_YIELD_SPINS) == SHMSYNC_YIELD_SPINS - 1)
+            sched_yield();
+        cpu_pause();
+    }
+
+    xadd(state->sleepers, W32(1));
+    for (;;) {
+        barrier();
+        if (state->generation != gen)
+            break;
+        /* Returns immediately if generation has already changed */
+        futex(&state->generation, FUTEX_WAIT, gen);
+    }
+    xadd(state->sleepers, W32(-1));
+
+    return !state->stopped;
+}
+
+void ShmBarrier::kill()
+{
+    assert(state);
+
+    state->stopped = 1;
+    xadd(state->generation, W32(1));
+    futex(&state->generation, FUTEX_WAKE, INT_MAX);
+}
+
+bool ShmBarrier::killed() const
+{
+    assert(state);
+    return state->stopped;
+}
+
+int ShmBarrier::get_participants() const
+{
+    return COUNT_PARTICIPANTS(state->count);
+}
+
+int ShmBarrier::get_arrived() const
+{
+    return COUNT_ARRIVED(state->count);
+}
+
+int ShmBarrier::get_sleepers() const
+{
+    return state->sleepers;
+}
+
+W32 ShmBarrier::get_generation() const
+{
+    return state->generation;
+}
+
+/**
+ * @brief Change number of participants
+ *
+ * Used to recover from instances that exited without leave(). If the
+ * processes still waiting are now all participants they are released.
+ */
+void ShmBarrier::set_participants(int count)
+{
+    assert(state);
+
+    W64 old, next;
+    bool last;
+    do {
+        old = state->count;
+        W32 arrived = COUNT_ARRIVED(old);
+        last = (arrived && arrived >= W32(count));
+        next = MAKE_COUNT(count, last ? 0 : arrived);
+    } while (cmpxchg(state->count, next, old) != old);
+
+    if (last)
+        release();
+}
+
+ShmRing::ShmRing()
+    : ring(NULL), packets(NULL), slots(0), slot_size(0), size(0)
+{
+}
+
+ShmRing::~ShmRing()
+{
+    close();
+}
+
+bool ShmRing::open(const char *name, int slots_, int max_size)
+{
+    assert(slots_ > 0);
+    assert(max_size >= 0);
+
+    close();
+
+    slots = slots_;
+    slot_size = ceil(sizeof(ShmPacket) + max_size, sizeof(W64));
+    size = sizeof(Ring) + size_t(slots) * slot_size;
+
+    ring = (Ring*)shm_map(name, size);
+    if (!ring)
+        return false;
+
+    packets = (byte*)(ring + 1);
+    return true;
+}
+
+void ShmRing::close()
+{
+    if (ring) {
+        munmap(ring, size);
+        ring = NULL;
+        packets = NULL;
+    }
+}
+
+bool ShmRing::push(W64 timestamp, W32 src, const void *data, int len)
+{
+    assert(ring);
+
+    if unlikely (sizeof(ShmPacket) + len > size_t(slot_size))
+        return false;
+
+    W64 head = ring->head;
+    barrier();
+    if (head - ring->tail >= W64(slots))
+        return false;
+
+    ShmPacket *packet = slot(head);
+    packet->timestamp = timestamp;
+    packet->src = src;
+    packet->size = len;
+    memcpy(packet + 1, data, len);
+
+    /* Packet must be written before consumer can see it */
+    barrier();
+    ring->head = head + 1;
+
+    return true;
+}
+
+const ShmPacket* ShmRing::front() const
+{
+    assert(ring);
+
+    W64 tail = ring->tail;
+    barrier();
+    if (tail == ring->head)
+        return NULL;
+
+    barrier();
+    return slot(tail);
+}
+
+void ShmRing::pop()
+{
+    assert(ring);
+    assert(ring->tail != ring->head);
+
+    /* Packet must be read before producer can reuse the slot */
+    barrier();
+    ring->tail++;
+}
+
+int ShmRing::count() const
+{
+    barrier();
+    return ring->head - ring->tail;
+}
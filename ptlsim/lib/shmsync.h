@@ -0,0 +1,138 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef SHMSYNC_H
+#define SHMSYNC_H
+
+#include <globals.h>
+
+/*
+ * ShmBarrier
+ *
+ * Sense reversing barrier between processes in a POSIX shared memory
+ * segment, used by -sync to keep several simulation instances in lock
+ * step. A zero filled segment is a valid empty barrier, so any number of
+ * processes can open the same name in any order without setup.
+ *
+ * Processes that join() take part in every wait() until they leave().
+ * Waiters poll the barrier generation for a short time (only if the host
+ * has a cpu for each participant) and then sleep on it with futex(2); the
+ * last process to arrive starts the next generation and wakes the
+ * sleepers only if there are any, so with small sync intervals a barrier
+ * costs a few cache line transfers and no system calls.
+ *
+ * kill() stops the barrier: current and future wait() calls return false.
+ */
+class ShmBarrier
+{
+    public:
+        ShmBarrier();
+        ~ShmBarrier();
+
+        bool open(const char *name);
+        void close();
+        bool is_open() const { return state != NULL; }
+
+        void join();
+        void leave();
+
+        /* Wait for all joined processes, returns false if killed */
+        bool wait();
+
+        void kill();
+        bool killed() const;
+
+        /* For sync_helper */
+        int get_participants() const;
+        int get_arrived() const;
+        int get_sleepers() const;
+        W32 get_generation() const;
+        void set_participants(int count);
+
+        static bool unlink(const char *name);
+
+    private:
+        struct State {
+            /* Arrived processes in low half, participants in high half,
+             * changed together so join/leave can complete a barrier */
+            W64 count;
+            W32 generation;
+            W32 sleepers;
+            W32 stopped;
+        };
+
+        State *state;
+
+        void release();
+};
+
+/* Header of a packet in ShmRing */
+struct ShmPacket {
+    W64 timestamp;
+    W32 src;
+    W32 size;
+
+    const byte* data() const { return (const byte*)(this + 1); }
+};
+
+/*
+ * ShmRing
+ *
+ * Lock free single producer, single consumer ring of packets in a POSIX
+ * shared memory segment, used to send timestamped messages between
+ * simulation instances (for example a network link between simulated
+ * nodes; use one ring per direction). Both sides must open the ring with
+ * the same 'slots' and 'max_size'. Like ShmBarrier a zero filled segment
+ * is an empty ring.
+ *
+ * Receiver looks at front() to check the timestamp before it takes the
+ * packet with pop(), so packets can be delivered at the simulated cycle
+ * they are sent for.
+ */
+class ShmRing
+{
+    public:
+        ShmRing();
+        ~ShmRing();
+
+        bool open(const char *name, int slots, int max_size);
+        void close();
+        bool is_open() const { return ring != NULL; }
+
+        /* Returns false if ring is full or packet is too large */
+        bool push(W64 timestamp, W32 src, const void *data, int size);
+
+        /* Next packet or NULL if ring is empty */
+        const ShmPacket* front() const;
+        void pop();
+
+        int count() const;
+        int get_slots() const { return slots; }
+
+        static bool unlink(const char *name) { return ShmBarrier::unlink(name); }
+
+    private:
+        /* head and tail in separate cache lines, each written by one side */
+        struct Ring {
+            W64 head;
+            W64 pad0[7];
+            W64 tail;
+            W64 pad1[7];
+        };
+
+        Ring *ring;
+        byte *packets;
+        int slots;
+        int slot_size;
+        size_t size;
+
+        ShmPacket* slot(W64 index) const {
+            return (ShmPacket*)(packets + (index % slots) * slot_size);
+        }
+};
+
+#endif // SHMSYNC_H
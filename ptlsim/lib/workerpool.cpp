@@ -0,0 +1,161 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#include <workerpool.h>
+
+#include <sched.h>
+
+/* Number of polls before an idle worker goes to sleep */
+#define WORKER_SPIN_LIMIT (1 << 16)
+
+/* Number of polls between yields, in case host has fewer cpus than
+ * threads */
+#define WORKER_YIELD_SPINS (1 << 10)
+
+WorkerPool::WorkerPool(int threads)
+{
+    assert(threads > 0);
+
+    thread_count = threads;
+    job_fn = NULL;
+    job_arg = NULL;
+    job_count = 0;
+    generation = 0;
+    remaining = 0;
+    sleepers = 0;
+    stopping = false;
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&wakeup, NULL);
+
+    workers = new Worker[thread_count];
+
+    /* Worker 0 is the calling thread */
+    for (int i = 1; i < threads; i++) {
+        workers[i].pool = this;
+        workers[i].id = i;
+
+        if (pthread_create(&workers[i].thread, NULL, worker_main,
+                    &workers[i])) {
+            cerr << "WorkerPool: Unable to create worker thread, ",
+                 "using ", i, " threads", endl;
+            thread_count = i;
+            break;
+        }
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    xadd(generation, W64(1));
+    pthread_cond_broadcast(&wakeup);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 1; i < thread_count; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    delete[] workers;
+
+    pthread_cond_destroy(&wakeup);
+    pthread_mutex_destroy(&lock);
+}
+
+void WorkerPool::run(worker_job_t job, void *arg, int count)
+{
+    if (thread_count == 1 || count <= 1) {
+        foreach (i, count) {
+            job(arg, i);
+        }
+        return;
+    }
+
+    job_fn = job;
+    job_arg = arg;
+    job_count = count;
+    remaining = thread_count - 1;
+
+    /* Locked add orders the batch setup before the new generation is
+     * visible and before sleepers is read */
+    xadd(generation, W64(1));
+
+    if (sleepers) {
+        pthread_mutex_lock(&lock);
+        pthread_cond_broadcast(&wakeup);
+        pthread_mutex_unlock(&lock);
+    }
+
+    run_jobs(0);
+
+    int spins = 0;
+    while (remaining) {
+        if unlikely (++spins == WORKER_YIELD_SPINS) {
+            sched_yield();
+            spins = 0;
+        }
+        cpu_pause();
+        barrier();
+    }
+
+    barrier();
+}
+
+void WorkerPool::run_jobs(int worker)
+{
+    for (int i = worker; i < job_count; i += thread_count) {
+        job_fn(job_arg, i);
+    }
+}
+
+/**
+ * @brief Wait until a new batch is started or pool is stopped
+ *
+ * @param seen Generation of the last batch this worker has run
+ *
+ * @return false if the pool is stopping
+ */
+bool WorkerPool::wait_for_batch(W64 seen)
+{
+    foreach (i, WORKER_SPIN_LIMIT) {
+        barrier();
+        if (generation != seen)
+            return !stopping;
+        if unlikely ((i % WORKER_YIELD_SPINS) == WORKER_YIELD_SPINS - 1)
+            sched_yield();
+        cpu_pause();
+    }
+
+    pthread_mutex_lock(&lock);
+    xadd(sleepers, 1);
+    while (generation == seen) {
+        pthread_cond_wait(&wakeup, &lock);
+    }
+    xadd(sleepers, -1);
+    pthread_mutex_unlock(&lock);
+
+    return !stopping;
+}
+
+void* WorkerPool::worker_main(void *arg)
+{
+    Worker *self = (Worker*)arg;
+    WorkerPool *pool = self->pool;
+    W64 seen = 0;
+
+    for (;;) {
+        if (!pool->wait_for_batch(seen))
+            break;
+
+        seen = pool->generation;
+        pool->run_jobs(self->id);
+        xadd(pool->remaining, -1);
+    }
+
+    return NULL;
+}
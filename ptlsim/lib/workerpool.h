@@ -0,0 +1,72 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <globals.h>
+#include <superstl.h>
+
+#include <pthread.h>
+
+/* Job function, called once for each job index of WorkerPool::run() */
+typedef void (*worker_job_t)(void *arg, int job);
+
+/*
+ * WorkerPool
+ *
+ * Fixed set of host threads that run a batch of jobs and wait for all of
+ * them to finish, used to clock independent parts of the simulated machine
+ * in parallel within one cycle. Jobs are statically assigned to threads
+ * (job i runs on thread i % threads) and the calling thread works as
+ * thread 0, so the same job always runs on the same host thread.
+ *
+ * Between batches workers spin for a short time and then sleep, so an idle
+ * pool does not take host cpu time while QEMU is emulating.
+ */
+class WorkerPool
+{
+    public:
+        WorkerPool(int threads);
+        ~WorkerPool();
+
+        /* Run job(arg, i) for i in [0, count) and return when all are
+         * done. Must only be called from the thread that created the pool */
+        void run(worker_job_t job, void *arg, int count);
+
+        int get_thread_count() const { return thread_count; }
+
+    private:
+        struct Worker {
+            WorkerPool *pool;
+            int id;
+            pthread_t thread;
+        };
+
+        int thread_count;
+        Worker *workers;
+
+        /* Current batch */
+        worker_job_t job_fn;
+        void *job_arg;
+        int job_count;
+
+        /* Incremented to start a batch, workers count down when done */
+        W64 generation;
+        int remaining;
+        int sleepers;
+        bool stopping;
+
+        pthread_mutex_t lock;
+        pthread_cond_t wakeup;
+
+        static void* worker_main(void *arg);
+        bool wait_for_batch(W64 seen);
+        void run_jobs(int worker);
+};
+
+#endif // WORKERPOOL_H
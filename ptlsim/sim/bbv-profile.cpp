@@ -0,0 +1,500 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#include <globals.h>
+#include <ptlhwdef.h>
+
+extern "C" {
+#include <exec-all.h>
+}
+
+#include <ptl-qemu.h>
+#include <ptlsim.h>
+#include <bbv-profile.h>
+
+#include <math.h>
+
+/* Number of k-means runs with different initial centers for each k */
+#define SIMPOINT_KMEANS_SEEDS       5
+#define SIMPOINT_KMEANS_ITERATIONS  100
+
+static inline W64 mix64(W64 x)
+{
+    x ^= x >> 31;
+    x *= 0x7fb5d329728ea185ULL;
+    x ^= x >> 27;
+    x *= 0x81dadef4bc2dd44dULL;
+    x ^= x >> 33;
+    return x;
+}
+
+SimpointClustering::SimpointClustering(int dims, int max_k, W64 seed)
+    : dims(dims)
+      , max_k(max_k)
+      , seed(seed)
+      , k(0)
+{
+    assert(dims > 0);
+    assert(max_k > 0);
+}
+
+/**
+ * @brief Random projection matrix entry in [-1, 1] for a block id
+ *
+ * Computed from the id so the matrix never has to be stored.
+ */
+double SimpointClustering::projection(W32 id, int dim) const
+{
+    W64 h = mix64((W64(id) << 8) ^ dim ^ (seed * 0x9e3779b97f4a7c15ULL));
+    return (double(h >> 11) / double(1ULL << 53)) * 2.0 - 1.0;
+}
+
+double SimpointClustering::distance(const double *a, const double *b) const
+{
+    double d = 0;
+    foreach (i, dims) {
+        double t = a[i] - b[i];
+        d += t * t;
+    }
+    return d;
+}
+
+/**
+ * @brief Add basic block vector of next interval
+ */
+void SimpointClustering::add_interval(const BBVector& bbv)
+{
+    double total = 0;
+    foreach (i, bbv.size()) {
+        total += bbv[i].count;
+    }
+
+    int base = points.size();
+    foreach (d, dims) {
+        points.push(0.0);
+    }
+
+    if (total == 0)
+        return;
+
+    foreach (i, bbv.size()) {
+        double frac = bbv[i].count / total;
+        foreach (d, dims) {
+            points[base + d] += frac * projection(bbv[i].id, d);
+        }
+    }
+}
+
+/**
+ * @brief Run k-means from random initial centers
+ *
+ * @return Sum of squared distances of intervals to their center
+ */
+double SimpointClustering::kmeans(int k, W64 seed, dynarray<int>& assign,
+        dynarray<double>& centers) const
+{
+    int n = interval_count();
+    dynarray<int> count;
+
+    assign.resize(n);
+    centers.resize(k * dims);
+    count.resize(k);
+
+    /* Initial centers are k different intervals */
+    W64 rnd = seed;
+    foreach (c, k) {
+        int pick;
+        bool used;
+        do {
+            rnd = mix64(rnd + 0x9e3779b97f4a7c15ULL);
+            pick = rnd % n;
+            used = false;
+            foreach (j, c) {
+                if (assign[j] == pick) used = true;
+            }
+        } while (used);
+
+        assign[c] = pick;
+        foreach (d, dims) {
+            centers[c * dims + d] = point(pick)[d];
+        }
+    }
+
+    foreach (i, n) {
+        assign[i] = -1;
+    }
+
+    double distortion = 0;
+
+    foreach (iter, SIMPOINT_KMEANS_ITERATIONS) {
+        bool changed = false;
+        distortion = 0;
+
+        foreach (i, n) {
+            int best = 0;
+            double best_dist = distance(point(i), centers.data);
+
+            for (int c = 1; c < k; c++) {
+                double dist = distance(point(i), centers.data + c * dims);
+                if (dist < best_dist) {
+                    best = c;
+                    best_dist = dist;
+                }
+            }
+
+            if (assign[i] != best) {
+                assign[i] = best;
+                changed = true;
+            }
+            distortion += best_dist;
+        }
+
+        if (!changed)
+            break;
+
+        /* Move centers to mean of their intervals, empty clusters keep
+         * their old center */
+        foreach (c, k) {
+            count[c] = 0;
+        }
+        foreach (i, n) {
+            if (!count[assign[i]]) {
+                foreach (d, dims) {
+                    centers[assign[i] * dims + d] = 0;
+                }
+            }
+            count[assign[i]]++;
+            foreach (d, dims) {
+                centers[assign[i] * dims + d] += point(i)[d];
+            }
+        }
+        foreach (c, k) {
+            if (!count[c]) continue;
+            foreach (d, dims) {
+                centers[c * dims + d] /= count[c];
+            }
+        }
+    }
+
+    return distortion;
+}
+
+/**
+ * @brief Bayesian Information Criterion of a clustering
+ *
+ * Log-likelihood of the intervals under a mixture of spherical Gaussians
+ * with common variance, less a penalty for the number of parameters.
+ */
+double SimpointClustering::bic(int k, const dynarray<int>& assign,
+        const dynarray<double>& centers) const
+{
+    int n = interval_count();
+    dynarray<int> count;
+    double distortion = 0;
+
+    count.resize(k);
+    foreach (c, k) {
+        count[c] = 0;
+    }
+
+    foreach (i, n) {
+        count[assign[i]]++;
+        distortion += distance(point(i), centers.data + assign[i] * dims);
+    }
+
+    double variance = distortion / (double(dims) * max(n - k, 1));
+    if (variance < 1e-12) variance = 1e-12;
+
+    double loglike = -(double(n) * dims / 2.0) * log(2.0 * M_PI * variance)
+        - (double(dims) * max(n - k, 1)) / 2.0;
+
+    foreach (c, k) {
+        if (count[c])
+            loglike += count[c] * log(double(count[c]) / n);
+    }
+
+    double params = (k - 1) + (double(dims) * k) + 1;
+
+    return loglike - (params / 2.0) * log(double(n));
+}
+
+/**
+ * @brief Cluster all intervals and select simulation points
+ *
+ * @param bic_threshold Fraction of BIC range the selected clustering must
+ * reach
+ *
+ * @return Number of clusters
+ */
+int SimpointClustering::cluster(double bic_threshold)
+{
+    int n = interval_count();
+    int kmax = min(max_k, n);
+
+    k = 0;
+    if (n == 0)
+        return 0;
+
+    dynarray< dynarray<int>* > assigns;
+    dynarray< dynarray<double>* > centers;
+    dynarray<double> scores;
+
+    for (int kk = 1; kk <= kmax; kk++) {
+        dynarray<int> *best_assign = NULL;
+        dynarray<double> *best_centers = NULL;
+        double best = 0;
+
+        foreach (s, SIMPOINT_KMEANS_SEEDS) {
+            dynarray<int> *a = new dynarray<int>();
+            dynarray<double> *c = new dynarray<double>();
+            double distortion = kmeans(kk, mix64(seed + kk * 1000 + s), *a, *c);
+
+            if (!best_assign || distortion < best) {
+                delete best_assign;
+                delete best_centers;
+                best = distortion;
+                best_assign = a;
+                best_centers = c;
+            } else {
+                delete a;
+                delete c;
+            }
+        }
+
+        assigns.push(best_assign);
+        centers.push(best_centers);
+        scores.push(bic(kk, *best_assign, *best_centers));
+    }
+
+    double lo = scores[0];
+    double hi = scores[0];
+    foreach (i, scores.size()) {
+        lo = min(lo, scores[i]);
+        hi = max(hi, scores[i]);
+    }
+
+    int pick = 0;
+    foreach (i, scores.size()) {
+        if (scores[i] >= lo + bic_threshold * (hi - lo)) {
+            pick = i;
+            break;
+        }
+    }
+
+    k = pick + 1;
+    assign.resize(n);
+    foreach (i, n) {
+        assign[i] = (*assigns[pick])[i];
+    }
+
+    /* Simulation point of each cluster is interval closest to center */
+    dynarray<double>& center = *centers[pick];
+    dynarray<double> closest;
+
+    simpoint.resize(k);
+    size.resize(k);
+    closest.resize(k);
+    foreach (c, k) {
+        simpoint[c] = -1;
+        size[c] = 0;
+    }
+
+    foreach (i, n) {
+        int c = assign[i];
+        double dist = distance(point(i), center.data + c * dims);
+
+        size[c]++;
+        if (simpoint[c] < 0 || dist < closest[c]) {
+            simpoint[c] = i;
+            closest[c] = dist;
+        }
+    }
+
+    foreach (i, assigns.size()) {
+        delete assigns[i];
+        delete centers[i];
+    }
+
+    return k;
+}
+
+double SimpointClustering::get_weight(int cluster) const
+{
+    return double(size[cluster]) / interval_count();
+}
+
+/**
+ * @brief Write simpoints and weights in SimPoint format, in interval order
+ */
+void SimpointClustering::write(ostream& simpoints, ostream& weights) const
+{
+    dynarray<int> order;
+
+    foreach (c, k) {
+        if (size[c]) order.push(c);
+    }
+
+    foreach (i, order.size()) {
+        for (int j = i + 1; j < order.size(); j++) {
+            if (simpoint[order[j]] < simpoint[order[i]]) {
+                int t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+            }
+        }
+    }
+
+    foreach (i, order.size()) {
+        simpoints << simpoint[order[i]] << " " << i << endl;
+        weights << get_weight(order[i]) << " " << i << endl;
+    }
+}
+
+/* Profiling of emulated code */
+
+struct BBVBlock {
+    W64 pc;
+    W64 count;
+    BBVBlock *next;
+    W32 id;
+};
+
+#define BBV_HASH_BITS 16
+
+static BBVBlock *bbv_hash[1 << BBV_HASH_BITS];
+static dynarray<BBVBlock*> bbv_blocks;
+static ofstream bbv_file;
+static SimpointClustering *bbv_clustering = NULL;
+static W64 bbv_intervals = 0;
+
+extern "C" {
+uint8_t ptl_bbv_enabled = 0;
+int64_t ptl_bbv_insns_left = 0;
+}
+
+static inline int bbv_hash_of(W64 pc)
+{
+    return lowbits(pc ^ (pc >> BBV_HASH_BITS) ^ (pc >> 32), BBV_HASH_BITS);
+}
+
+/**
+ * @brief Counter of block at pc, called when QEMU translates the block
+ */
+extern "C" uint64_t* ptl_bbv_counter(uint64_t pc)
+{
+    BBVBlock **head = &bbv_hash[bbv_hash_of(pc)];
+
+    for (BBVBlock *b = *head; b; b = b->next) {
+        if (b->pc == pc) return (uint64_t*)&b->count;
+    }
+
+    BBVBlock *b = new BBVBlock();
+    b->pc = pc;
+    b->count = 0;
+    b->next = *head;
+    /* Block ids in '.bb' files start from 1 */
+    b->id = bbv_blocks.size() + 1;
+    *head = b;
+    bbv_blocks.push(b);
+
+    return (uint64_t*)&b->count;
+}
+
+/**
+ * @brief Write current interval as one 'T:id:count :id:count ...' line
+ */
+extern "C" void ptl_bbv_interval_end(void)
+{
+    BBVector bbv;
+
+    bbv_file << "T";
+    foreach (i, bbv_blocks.size()) {
+        BBVBlock *b = bbv_blocks[i];
+        if (!b->count) continue;
+
+        bbv_file << ":" << b->id << ":" << b->count << " ";
+
+        if (bbv_clustering) {
+            BBVEntry e = {b->id, b->count};
+            bbv.push(e);
+        }
+        b->count = 0;
+    }
+    bbv_file << endl;
+
+    if (bbv_clustering)
+        bbv_clustering->add_interval(bbv);
+
+    bbv_intervals++;
+    ptl_bbv_insns_left += config.bbv_interval;
+}
+
+void bbv_profile_start()
+{
+    if (ptl_bbv_enabled || !config.bbv_profile.set())
+        return;
+
+    if (NUM_SIM_CORES != 1) {
+        cerr << "ERROR: Marss doesnt support basic block vector profiling " <<
+            "with more than one CPU Context.  Please simulate with only one CPU.\n";
+        ptl_quit();
+        return;
+    }
+
+    bbv_file.open(config.bbv_profile.buf);
+    if (!bbv_file) {
+        cerr << "Error: Unable to write basic block vector file: " <<
+            config.bbv_profile << endl;
+        ptl_quit();
+        return;
+    }
+
+    if (config.bbv_simpoints.set())
+        bbv_clustering = new SimpointClustering(15, config.bbv_max_k);
+
+    ptl_logfile << "Writing basic block vectors of " << config.bbv_interval <<
+        " instructions to " << config.bbv_profile << endl;
+
+    ptl_bbv_insns_left = config.bbv_interval;
+    ptl_bbv_enabled = 1;
+
+    /* Retranslate so all blocks update their counters */
+    tb_flush(&contextof(0));
+
+    /* Profile ends when QEMU exits, with or without simulation */
+    atexit(bbv_profile_finish);
+}
+
+void bbv_profile_finish()
+{
+    if (!ptl_bbv_enabled)
+        return;
+
+    ptl_bbv_enabled = 0;
+
+    /* Last partial interval is left out, same as simpoints that can only
+     * start at full intervals */
+    bbv_file.close();
+
+    if (!bbv_clustering)
+        return;
+
+    int k = bbv_clustering->cluster();
+
+    stringbuf weights_name;
+    weights_name << config.bbv_simpoints, ".weights";
+
+    ofstream simpoints(config.bbv_simpoints.buf);
+    ofstream weights(weights_name.buf);
+    bbv_clustering->write(simpoints, weights);
+
+    ptl_logfile << "Selected " << k << " simpoints from " << bbv_intervals <<
+        " intervals, written to " << config.bbv_simpoints << endl;
+
+    delete bbv_clustering;
+    bbv_clustering = NULL;
+}
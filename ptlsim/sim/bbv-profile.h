@@ -0,0 +1,91 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef BBV_PROFILE_H
+#define BBV_PROFILE_H
+
+#include <globals.h>
+#include <superstl.h>
+
+/* Instructions executed in one basic block during an interval */
+struct BBVEntry {
+    W32 id;
+    W64 count;
+};
+
+typedef dynarray<BBVEntry> BBVector;
+
+/*
+ * SimpointClustering
+ *
+ * Picks simulation points from basic block vectors the same way as the
+ * SimPoint tool: each interval's vector is normalized and randomly
+ * projected to a few dimensions, k-means is run for k = 1..max_k and the
+ * smallest k whose BIC score is within 'bic_threshold' of the best score
+ * range is used. Simulation point of a cluster is the interval closest to
+ * its centroid and its weight is the fraction of intervals in the
+ * cluster.
+ *
+ * Output files use the SimPoint format read by -simpoint:
+ *   simpoints : "<interval> <cluster>" per line
+ *   weights   : "<weight> <cluster>" per line
+ */
+class SimpointClustering
+{
+    public:
+        SimpointClustering(int dims = 15, int max_k = 30, W64 seed = 1);
+
+        void add_interval(const BBVector& bbv);
+        int interval_count() const { return points.size() / dims; }
+
+        /* Run clustering, returns selected number of clusters */
+        int cluster(double bic_threshold = 0.9);
+
+        int get_cluster_count() const { return k; }
+        int get_cluster(int interval) const { return assign[interval]; }
+        int get_simpoint(int cluster) const { return simpoint[cluster]; }
+        double get_weight(int cluster) const;
+
+        void write(ostream& simpoints, ostream& weights) const;
+
+    private:
+        int dims;
+        int max_k;
+        W64 seed;
+
+        /* Projected intervals, interval_count() x dims */
+        dynarray<double> points;
+
+        /* Result of cluster() */
+        int k;
+        dynarray<int> assign;
+        dynarray<int> simpoint;
+        dynarray<int> size;
+
+        const double* point(int i) const { return points.data + i * dims; }
+        double projection(W32 id, int dim) const;
+        double distance(const double *a, const double *b) const;
+        double kmeans(int k, W64 seed, dynarray<int>& assign,
+                dynarray<double>& centers) const;
+        double bic(int k, const dynarray<int>& assign,
+                const dynarray<double>& centers) const;
+};
+
+/*
+ * Basic block vector profile (-bbv-profile, -bbv-interval)
+ *
+ * Emulated code counts instructions of each translated block into a
+ * counter of its start address (see gen_bbv_count() in QEMU's
+ * translate.c). At the end of each interval the counters are written as
+ * one line of a SimPoint '.bb' file and cleared. With -bbv-simpoints the
+ * vectors are also clustered at exit and the simpoint and weights files
+ * are written, ready for -simpoint.
+ */
+void bbv_profile_start();
+void bbv_profile_finish();
+
+#endif // BBV_PROFILE_H
@@ -15,8 +15,11 @@
 #include <basecore.h>
 #include <statsBuilder.h>
 #include <memoryHierarchy.h>
+#include <workerpool.h>
+#include <timeStatsWriter.h>
 
 #include <cstdarg>
+#include <unistd.h>
 
 using namespace Core;
 using namespace Memory;
@@ -37,6 +40,11 @@ BaseMachine::BaseMachine(const char *name)
 
     context_used = 0;
     coreid_counter = 0;
+
+    idle_probe = false;
+    idle_cycles_skipped = 0;
+
+    core_pool = NULL;
 }
 
 BaseMachine::~BaseMachine()
@@ -90,6 +98,11 @@ void BaseMachine::shutdown()
 		delete memoryHierarchyPtr;
 		memoryHierarchyPtr = NULL;
 	}
+
+	if (core_pool) {
+		delete core_pool;
+		core_pool = NULL;
+	}
 }
 
 /**
@@ -225,6 +238,10 @@ int BaseMachine::run(PTLsimConfig& config)
         cores[cur_core]->check_ctx_changes();
     }
     first_run = 0;
+    idle_probe = false;
+
+    bool quantum_sync = setup_sync_quantum(config);
+    bool parallel_clock = !quantum_sync && setup_parallel_cores(config);
 
     // Run each core
     bool exiting = false;
@@ -249,24 +266,47 @@ int BaseMachine::run(PTLsimConfig& config)
             StatsBuilder::get().dump_periodic(*time_stats_file, sim_cycle);
         }
 
+        if unlikely (time_stats_writer && sim_cycle > 0 &&
+                sim_cycle % config.time_stats_period == 0) {
+            time_stats_writer->snapshot(sim_cycle, user_stats, kernel_stats);
+        }
+
 
         // limit the ptl_logfile size
         if unlikely (ptl_logfile.is_open() &&
                 ((W64)ptl_logfile.tellp() > config.log_file_size))
             backup_and_reopen_logfile();
 
-        memoryHierarchyPtr->clock();
-        clock_qemu_io_events();
-
-		foreach (i, coremodel.per_cycle_signals.size()) {
-			if (logable(4))
-				ptl_logfile << "Per-Cycle-Signal : " <<
-					coremodel.per_cycle_signals[i]->get_name() << endl;
-			exiting |= coremodel.per_cycle_signals[i]->emit(NULL);
-		}
-
-        sim_cycle++;
-        iterations++;
+        if (quantum_sync) {
+            exiting |= run_sync_quantum(config);
+        } else {
+            memoryHierarchyPtr->clock();
+            clock_qemu_io_events();
+
+            /* Private phases run on this thread while logging to keep log
+             * in order, cycle steps stay same so timing does not change */
+            if (parallel_clock) {
+                exiting |= clock_cores_parallel(
+                        logenable && config.loglevel > 0);
+
+                foreach (i, serial_cycle_signals.size()) {
+                    exiting |= serial_cycle_signals[i]->emit(NULL);
+                }
+            } else {
+                foreach (i, coremodel.per_cycle_signals.size()) {
+                    if (logable(4))
+                        ptl_logfile << "Per-Cycle-Signal : " <<
+                            coremodel.per_cycle_signals[i]->get_name() << endl;
+                    exiting |= coremodel.per_cycle_signals[i]->emit(NULL);
+                }
+            }
+
+            sim_cycle++;
+            iterations++;
+
+            if unlikely (config.skip_idle_cycles && !exiting)
+                skip_idle_cycles(config);
+        }
 
         if unlikely (config.stop_at_insns <= total_insns_committed ||
                 config.stop_at_cycle <= sim_cycle) {
@@ -284,11 +324,367 @@ int BaseMachine::run(PTLsimConfig& config)
     if(logable(1))
         ptl_logfile << "Exiting out-of-order core at ", total_insns_committed, " commits, ", total_uops_committed, " uops and ", iterations, " iterations (cycles)", endl;
 
+    if(config.skip_idle_cycles)
+        ptl_logfile << "Skipped ", idle_cycles_skipped, " idle cycles", endl;
+
     config.dump_state_now = 0;
 
     return exiting;
 }
 
+/* Number of cycles from 'cycle' to next multiple of 'period' */
+static inline W64 cycles_to_next_multiple(W64 cycle, W64 period)
+{
+    W64 rem = cycle % period;
+    return (rem) ? (period - rem) : 0;
+}
+
+/**
+ * @brief Check if cores can be clocked in parallel and start worker threads
+ *
+ * @param config Simulation configuration
+ *
+ * @return true if cores are clocked with clock_cores_parallel()
+ */
+bool BaseMachine::setup_parallel_cores(PTLsimConfig& config)
+{
+    int threads = min((int)config.parallel_cores, cores.count());
+
+    /* No gain from more threads than host cpus */
+    int host_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (host_cpus > 0)
+        threads = min(threads, host_cpus);
+
+    if (threads <= 1)
+        return false;
+
+    foreach (i, cores.count()) {
+        if (!cores[i]->supports_parallel_cycle()) {
+            if (logable(1))
+                ptl_logfile << "Core ", i, " can't be clocked in parallel, ",
+                            "clocking all cores serially", endl;
+            return false;
+        }
+    }
+
+    if (core_pool && core_pool->get_thread_count() != threads) {
+        delete core_pool;
+        core_pool = NULL;
+    }
+
+    if (!core_pool) {
+        core_pool = new WorkerPool(threads);
+        ptl_logfile << "Clocking ", cores.count(), " cores on ",
+                    core_pool->get_thread_count(), " host threads", endl;
+    }
+
+    find_serial_cycle_signals();
+
+    return true;
+}
+
+/**
+ * @brief Collect per-cycle signals other than core cycle signals, these are
+ * emitted once per cycle when cores are not clocked by their signals
+ */
+void BaseMachine::find_serial_cycle_signals()
+{
+    serial_cycle_signals.clear();
+    foreach (i, coremodel.per_cycle_signals.size()) {
+        Signal *signal = coremodel.per_cycle_signals[i];
+        bool core_signal = false;
+
+        foreach (j, cores.count()) {
+            if (cores[j]->get_cycle_signal() == signal) {
+                core_signal = true;
+                break;
+            }
+        }
+
+        if (!core_signal)
+            serial_cycle_signals.push(signal);
+    }
+}
+
+/**
+ * @brief Check if relaxed synchronization (-sync-quantum) can be used
+ *
+ * @param config Simulation configuration
+ *
+ * @return true if cores are clocked with run_sync_quantum()
+ */
+bool BaseMachine::setup_sync_quantum(PTLsimConfig& config)
+{
+    bool enable = (config.sync_quantum > 1 && cores.count() > 1);
+
+    foreach (i, cores.count()) {
+        if (enable && !cores[i]->get_cycle_signal()) {
+            if (logable(1))
+                ptl_logfile << "Core ", i, " has no cycle signal, ",
+                            "using strict synchronization", endl;
+            enable = false;
+        }
+    }
+
+    memoryHierarchyPtr->set_relaxed_sync(enable);
+
+    if (!enable)
+        return false;
+
+    if (config.parallel_cores > 1 && logable(1))
+        ptl_logfile << "Ignoring -parallel-cores with -sync-quantum", endl;
+
+    find_serial_cycle_signals();
+
+    return true;
+}
+
+/**
+ * @brief Number of cycles in next quantum, a quantum ends before next
+ * cycle at which the simulation loop has periodic work or must stop
+ */
+W64 BaseMachine::get_sync_quantum_length(PTLsimConfig& config)
+{
+    W64 length = min(config.sync_quantum, config.stop_at_cycle - sim_cycle);
+
+    length = min(length, cycles_to_next_multiple(sim_cycle + 1, 1000) + 1);
+
+    if (time_stats_file || time_stats_writer)
+        length = min(length, cycles_to_next_multiple(sim_cycle + 1,
+                    config.time_stats_period) + 1);
+
+    if (!logenable && !config.log_user_only &&
+            config.start_log_at_iteration > iterations)
+        length = min(length, config.start_log_at_iteration - iterations);
+
+    return max(length, W64(1));
+}
+
+/**
+ * @brief Simulate one quantum with relaxed synchronization
+ *
+ * @param config Simulation configuration
+ *
+ * Each core is clocked over all cycles of the quantum before the next
+ * core runs, along with its cpu controller and the memory hierarchy events
+ * up to its local cycle. A core thus sees messages from cores clocked
+ * after it only at the next quantum (late coherence messages, counted by
+ * the caches) and messages from cores clocked before it ahead of time.
+ * If a core stops the simulation, following cores are clocked only up to
+ * the same cycle.
+ *
+ * @return true if any core wants to stop simulation
+ */
+bool BaseMachine::run_sync_quantum(PTLsimConfig& config)
+{
+    W64 start = sim_cycle;
+    W64 end = start + get_sync_quantum_length(config);
+    bool exiting = false;
+
+    foreach (i, cores.count()) {
+        Signal *cycle_signal = cores[i]->get_cycle_signal();
+
+        for (sim_cycle = start; sim_cycle < end; sim_cycle++) {
+            memoryHierarchyPtr->set_core_clock(i, sim_cycle);
+            memoryHierarchyPtr->clock_core(i);
+
+            /* IO and other per-cycle events run with first core */
+            if (i == 0) {
+                clock_qemu_io_events();
+
+                foreach (j, serial_cycle_signals.size()) {
+                    exiting |= serial_cycle_signals[j]->emit(NULL);
+                }
+            }
+
+            if unlikely (cycle_signal->emit(NULL)) {
+                exiting = true;
+                end = sim_cycle + 1;
+            }
+        }
+    }
+
+    iterations += end - start;
+    sim_cycle = end;
+
+    return exiting;
+}
+
+static void run_core_private_phase(void *arg, int idx)
+{
+    BaseCore *core = ((BaseMachine*)arg)->cores[idx];
+
+    core->in_parallel_phase = true;
+    core->runcycle_private();
+    core->in_parallel_phase = false;
+}
+
+/**
+ * @brief Clock all cores for one cycle, running private part of the cycle
+ * of all cores in parallel. Parts that access shared state are run in core
+ * id order, so simulation result does not depend on thread scheduling.
+ *
+ * @param serial Run private parts on calling thread in core id order
+ *
+ * @return true if any core wants to stop simulation
+ */
+bool BaseMachine::clock_cores_parallel(bool serial)
+{
+    bool exiting = false;
+
+    foreach (i, cores.count()) {
+        cores[i]->runcycle_begin();
+    }
+
+    if (serial) {
+        foreach (i, cores.count()) {
+            run_core_private_phase(this, i);
+        }
+    } else {
+        core_pool->run(run_core_private_phase, this, cores.count());
+    }
+
+    foreach (i, cores.count()) {
+        exiting |= cores[i]->runcycle_end();
+    }
+
+    return exiting;
+}
+
+/* Don't spend a cycle on measuring stats if only few cycles can be skipped */
+#define IDLE_SKIP_MIN_CYCLES 8
+
+bool BaseMachine::all_cores_idle()
+{
+    foreach(i, cores.count()) {
+        if(!cores[i]->is_idle())
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Get number of cycles, starting from sim_cycle, that can be skipped
+ *
+ * @param config Simulation configuration
+ *
+ * @return Number of cycles in which no memory or IO event is due and the
+ * simulation loop does not dump stats, update progress or stop
+ */
+W64 BaseMachine::get_idle_skip_limit(PTLsimConfig& config)
+{
+    W64 next_cycle = min(memoryHierarchyPtr->get_next_event_cycle(),
+            get_next_qemu_io_event_cycle());
+
+    if(next_cycle <= sim_cycle || config.stop_at_cycle <= sim_cycle)
+        return 0;
+
+    W64 limit = min(next_cycle, config.stop_at_cycle) - sim_cycle;
+
+    limit = min(limit, cycles_to_next_multiple(sim_cycle, 1000));
+
+    if(time_stats_file || time_stats_writer)
+        limit = min(limit, cycles_to_next_multiple(sim_cycle,
+                    config.time_stats_period));
+
+    if(!logenable && !config.log_user_only &&
+            config.start_log_at_iteration > iterations)
+        limit = min(limit, config.start_log_at_iteration - iterations);
+
+    foreach(i, cores.count()) {
+        limit = min(limit, cores[i]->get_idle_limit());
+    }
+
+    return limit;
+}
+
+void BaseMachine::snapshot_idle_stats()
+{
+    Stats* stats[3] = {user_stats, kernel_stats, global_stats};
+    /* All counters are W64 and at start of Stats */
+    int words = StatsBuilder::get().get_counter_size() / sizeof(W64);
+
+    idle_stats_snapshot.resize(words * 3);
+    foreach(i, 3) {
+        memcpy(&idle_stats_snapshot[words * i], (W64*)stats[i]->base(),
+                words * sizeof(W64));
+    }
+}
+
+/**
+ * @brief Fast forward over cycles in which all cores are idle
+ *
+ * @param config Simulation configuration
+ *
+ * Called at the end of each simulated cycle. Once all cores report an idle
+ * cycle, Stats are saved and next cycle is simulated as usual to find the
+ * counters updated by one idle cycle. If that cycle was idle as well and
+ * left the memory hierarchy untouched, following cycles up to the next
+ * event will do exactly the same, so its counter updates are added once per
+ * skipped cycle and sim_cycle jumps over them. All stats and periodic dumps
+ * stay same as simulating each cycle.
+ */
+void BaseMachine::skip_idle_cycles(PTLsimConfig& config)
+{
+    if likely (!all_cores_idle()) {
+        idle_probe = false;
+        return;
+    }
+
+    W64 limit = get_idle_skip_limit(config);
+
+    if(!idle_probe) {
+        if(limit > IDLE_SKIP_MIN_CYCLES) {
+            snapshot_idle_stats();
+            idle_mem_pending = memoryHierarchyPtr->get_pending_count();
+            idle_mem_next_event = memoryHierarchyPtr->get_next_event_cycle();
+            idle_probe = true;
+        }
+        return;
+    }
+
+    idle_probe = false;
+
+    if(limit == 0 ||
+            idle_mem_pending != memoryHierarchyPtr->get_pending_count() ||
+            idle_mem_next_event != memoryHierarchyPtr->get_next_event_cycle())
+        return;
+
+    /* Find the counters updated in probe cycle, stored as (index, delta) */
+    Stats* stats[3] = {user_stats, kernel_stats, global_stats};
+    int words = idle_stats_snapshot.count() / 3;
+
+    idle_stats_delta.clear();
+    foreach(i, 3) {
+        W64 *mem = (W64*)stats[i]->base();
+        W64 *saved = &idle_stats_snapshot[words * i];
+        foreach(j, words) {
+            if(mem[j] != saved[j]) {
+                idle_stats_delta.push(words * i + j);
+                idle_stats_delta.push(mem[j] - saved[j]);
+            }
+        }
+    }
+
+    for(int i = 0; i < idle_stats_delta.count(); i += 2) {
+        W64 idx = idle_stats_delta[i];
+        W64 *mem = (W64*)stats[idx / words]->base();
+        mem[idx % words] += idle_stats_delta[i + 1] * limit;
+    }
+
+    foreach(i, cores.count()) {
+        cores[i]->skip_idle_cycles(limit);
+    }
+    memoryHierarchyPtr->skip_cycles(limit);
+
+    if(logable(4))
+        ptl_logfile << "Skipping ", limit, " idle cycles at ", sim_cycle, endl;
+
+    sim_cycle += limit;
+    iterations += limit;
+    idle_cycles_skipped += limit;
+}
+
 void BaseMachine::flush_tlb(Context& ctx)
 {
     foreach(i, cores.count()) {
@@ -305,6 +701,41 @@ void BaseMachine::flush_tlb_virt(Context& ctx, Waddr virtaddr)
     }
 }
 
+/**
+ * @brief Prepare machine for functional warmup
+ *
+ * Cores are reset here instead of at the start of first run, which would
+ * clear the warmed up branch predictors.
+ */
+void BaseMachine::warmup_start()
+{
+    if (first_run) {
+        foreach (i, cores.count()) {
+            cores[i]->reset();
+        }
+        first_run = 0;
+    }
+}
+
+void BaseMachine::warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+        bool is_icache, bool is_write)
+{
+    foreach (i, cores.count()) {
+        if (cores[i]->warmup_access(ctx, virtaddr, physaddr, is_icache,
+                    is_write))
+            return;
+    }
+}
+
+void BaseMachine::warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+        W64 target)
+{
+    foreach (i, cores.count()) {
+        if (cores[i]->warmup_branch(ctx, ripafter, riptaken, target))
+            return;
+    }
+}
+
 void BaseMachine::dump_state(ostream& os)
 {
     foreach(i, cores.count()) {
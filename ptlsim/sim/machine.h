@@ -22,6 +22,8 @@ namespace Core {
     struct BaseCore;
 };
 
+class WorkerPool;
+
 namespace Memory {
     struct Controller;
     struct Interconnect;
@@ -104,6 +106,39 @@ struct BaseMachine: public PTLsimMachine {
     bool get_option(const char* name, const char* opt_name, bool& value);
     bool get_option(const char* name, const char* opt_name, int& value);
     bool get_option(const char* name, const char* opt_name, stringbuf& value);
+
+    // Idle cycle skipping support
+    bool idle_probe;
+    int idle_mem_pending;
+    W64 idle_mem_next_event;
+    W64 idle_cycles_skipped;
+    dynarray<W64> idle_stats_snapshot;
+    dynarray<W64> idle_stats_delta;
+
+    bool all_cores_idle();
+    W64 get_idle_skip_limit(PTLsimConfig& config);
+    void snapshot_idle_stats();
+    void skip_idle_cycles(PTLsimConfig& config);
+
+    // Parallel core clocking support
+    WorkerPool* core_pool;
+    dynarray<Signal*> serial_cycle_signals;
+
+    bool setup_parallel_cores(PTLsimConfig& config);
+    bool clock_cores_parallel(bool serial);
+    void find_serial_cycle_signals();
+
+    // Relaxed synchronization support
+    bool setup_sync_quantum(PTLsimConfig& config);
+    W64 get_sync_quantum_length(PTLsimConfig& config);
+    bool run_sync_quantum(PTLsimConfig& config);
+
+    // Functional warmup (-fast-fwd-warmup) support
+    void warmup_start();
+    void warmup_access(Context& ctx, W64 virtaddr, W64 physaddr,
+            bool is_icache, bool is_write);
+    void warmup_branch(Context& ctx, W64 ripafter, W64 riptaken,
+            W64 target);
 };
 
 typedef void (*machine_gen)(BaseMachine& machine);
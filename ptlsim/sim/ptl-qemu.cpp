@@ -42,6 +42,8 @@ extern "C" {
 
 #include <ptl-qemu.h>
 #include <ptlsim.h>
+#include <machine.h>
+#include <bbv-profile.h>
 
 #include <cacheConstants.h>
 
@@ -470,9 +472,30 @@ RIPVirtPhys& RIPVirtPhys::update(Context& ctx, int bytes) {
     mfnlo = 0;
     mfnhi = 0;
 
+    /* Shared basic block cache is tagged with physical code pages */
+    if unlikely (config.shared_bbcache) {
+        mfnlo = ctx.code_mfn(rip);
+        mfnhi = ctx.code_mfn(rip + bytes - 1);
+    }
+
     return *this;
 }
 
+Waddr Context::code_mfn(Waddr virtaddr) {
+    int exception = 0;
+    int mmio = 0;
+    PageFaultErrorCode pfec;
+
+    /* Only look up the TLB, page tables are walked when code is fetched */
+    Waddr paddr = check_and_translate(virtaddr, 0, false, false, exception,
+            mmio, pfec, true);
+
+    if (exception || mmio)
+        return RIPVirtPhys::INVALID;
+
+    return lowbits(paddr >> 12, 28);
+}
+
 # define PHYS_ADDR_MASK 0xfffffff000LL
 
 W64 Context::virt_to_pte_phys_addr(W64 rawvirt, byte& level) {
@@ -737,6 +760,7 @@ void Context::update_mode_count() {
 
 void Context::update_mode(bool is_kernel) {
     kernel_mode = is_kernel;
+    stats = mode_stats[kernel_mode];
     if(config.log_user_only) {
         if(kernel_mode)
             logenable = 0;
@@ -1458,6 +1482,95 @@ uint8_t ptl_fast_fwd_enabled = 0;
 
 uint8_t sim_update_clock_offset = 1;
 
+/**
+ * @brief Flag to indicate if emulated code calls warmup functions
+ */
+uint8_t ptl_warmup_enabled = 0;
+
+/* Last fast-forward instructions of each CPU that are emulated with
+ * functional warmup, they are given to CPU when its simpoint_decr reaches
+ * zero */
+static W64 warmup_insns[NUM_SIM_CORES];
+static bool warmup_active[NUM_SIM_CORES];
+static BaseMachine* warmup_machine = NULL;
+
+/**
+ * @brief Start functional warmup of a CPU that has fast-forwarded all its
+ * instructions except warmup instructions
+ *
+ * @param ctx CPU Context
+ *
+ * @return true if CPU continues emulation in warmup
+ *
+ * Simulated machine is created here so emulated instruction fetches,
+ * memory accesses and conditional branches can update its caches, TLBs
+ * and branch predictors. Code is translated again with calls to warmup
+ * functions, which ignore CPUs not in warmup.
+ */
+static bool start_cpu_warmup(Context& ctx)
+{
+    W64 insns = warmup_insns[ctx.cpu_index];
+
+    if (!insns)
+        return false;
+
+    warmup_insns[ctx.cpu_index] = 0;
+
+    if (!warmup_machine) {
+        PTLsimMachine* machine = PTLsimMachine::getmachine(config.core_name);
+
+        if (!machine || !ptl_create_machine(machine)) {
+            ptl_logfile << "WARNING: Can't create machine for warmup, " <<
+                "switching to simulation without warmup\n";
+            return false;
+        }
+
+        warmup_machine = (BaseMachine*)machine;
+        warmup_machine->warmup_start();
+    }
+
+    ptl_logfile << "Cpu " << int(ctx.cpu_index) << " will emulate last " <<
+        insns << " instructions with functional warmup\n";
+
+    ctx.simpoint_decr = insns;
+    warmup_active[ctx.cpu_index] = true;
+    ptl_warmup_enabled = 1;
+    tb_flush(&ctx);
+
+    return true;
+}
+
+static void stop_warmup()
+{
+    ptl_warmup_enabled = 0;
+    warmup_machine = NULL;
+
+    foreach (i, NUM_SIM_CORES) {
+        warmup_insns[i] = 0;
+        warmup_active[i] = false;
+    }
+}
+
+void ptl_warmup_access(int cpuid, uint64_t virtaddr, uint64_t physaddr,
+        int is_icache, int is_write)
+{
+    if unlikely (!warmup_active[cpuid])
+        return;
+
+    warmup_machine->warmup_access(contextof(cpuid), virtaddr, physaddr,
+            is_icache, is_write);
+}
+
+void ptl_warmup_branch(int cpuid, uint64_t ripafter, uint64_t riptaken,
+        uint64_t target)
+{
+    if unlikely (!warmup_active[cpuid])
+        return;
+
+    warmup_machine->warmup_branch(contextof(cpuid), ripafter, riptaken,
+            target);
+}
+
 /**
  * @brief Set CPU's simpoint_decr count to fast-forward simulation mode
  */
@@ -1482,9 +1595,29 @@ void set_cpu_fast_fwd()
     ptl_logfile << "All CPU context will be fast-forwared to " <<
         per_cpu_fast_fwd << " instructions.\n";
 
+    /* Warm state is not saved in checkpoints so don't warmup if we
+     * create a checkpoint after fast-forward */
+    W64 per_cpu_warmup = 0;
+
+    if (config.fast_fwd_warmup > 0 && config.fast_fwd_checkpoint.size() == 0) {
+        per_cpu_warmup = min(config.fast_fwd_warmup / NUM_SIM_CORES,
+                per_cpu_fast_fwd);
+
+        ptl_logfile << "Last " << per_cpu_warmup << " instructions of " <<
+            "each CPU will warmup caches and branch predictors.\n";
+    }
+
+    stop_warmup();
+
     foreach (i, NUM_SIM_CORES) {
         Context& ctx = contextof(i);
-        ctx.simpoint_decr = per_cpu_fast_fwd;
+        ctx.simpoint_decr = per_cpu_fast_fwd - per_cpu_warmup;
+        warmup_insns[i] = per_cpu_warmup;
+
+        /* All instructions of this CPU are warmup instructions */
+        if (ctx.simpoint_decr == 0 && !start_cpu_warmup(ctx))
+            ctx.simpoint_decr = per_cpu_warmup;
+
         tb_flush(&ctx);
     }
 }
@@ -1544,6 +1677,10 @@ static void cpu_fast_fwded(Context& ctx)
     bool others_halted = false;
     W64 insns_remaining = 0;
 
+    /* Emulate last instructions of this CPU with warmup */
+    if (start_cpu_warmup(ctx))
+        return;
+
     /* Stop this CPU and check if all CPU are stopped or not */
     ctx.stopped = 1;
 
@@ -1599,6 +1736,7 @@ static void cpu_fast_fwded(Context& ctx)
         }
 
         ptl_fast_fwd_enabled = 0;
+        stop_warmup();
 
         foreach (i, NUM_SIM_CORES) {
             contextof(i).stopped = 0;
@@ -1661,6 +1799,8 @@ void ptl_qemu_initialized(void)
 
     set_cpu_fast_fwd();
 
+    bbv_profile_start();
+
     if (config.run) {
         /* If we are going to run simulations immediately then we set
          * simulation clock offset before QEMU updates offset with
@@ -248,12 +248,66 @@ void set_next_simpoint(CPUX86State* ctx);
  */
 extern uint8_t ptl_fast_fwd_enabled;
 
+/**
+ * @brief Set when basic block vector profiling (-bbv-profile) is enabled
+ */
+extern uint8_t ptl_bbv_enabled;
+
+/**
+ * @brief Instructions left in current basic block vector interval
+ */
+extern int64_t ptl_bbv_insns_left;
+
+/**
+ * @brief Get instruction counter of the basic block starting at pc
+ *
+ * @param pc Linear address of the block
+ *
+ * @return Pointer to counter that generated code adds block size to
+ */
+uint64_t* ptl_bbv_counter(uint64_t pc);
+
+/**
+ * @brief Current basic block vector interval is complete
+ */
+void ptl_bbv_interval_end(void);
+
 /**
  * @brief Set each CPU Context to fast forward N instructions before
  * switching to simulation mode
  */
 void set_cpu_fast_fwd(void);
 
+/**
+ * @brief Set while emulated code updates simulated caches, TLBs and
+ * branch predictors in last instructions of fast-forward
+ * (-fast-fwd-warmup)
+ */
+extern uint8_t ptl_warmup_enabled;
+
+/**
+ * @brief Warmup with an instruction fetch or memory access
+ *
+ * @param cpuid CPU Context id that accessed memory
+ * @param virtaddr Linear address of the access
+ * @param physaddr Physical address of the access
+ * @param is_icache Set for instruction fetch
+ * @param is_write Set for store
+ */
+void ptl_warmup_access(int cpuid, uint64_t virtaddr, uint64_t physaddr,
+        int is_icache, int is_write);
+
+/**
+ * @brief Warmup with outcome of a conditional branch
+ *
+ * @param cpuid CPU Context id that executed the branch
+ * @param ripafter Linear address of next instruction after the branch
+ * @param riptaken Linear address of branch target
+ * @param target Linear address of next executed instruction
+ */
+void ptl_warmup_branch(int cpuid, uint64_t ripafter, uint64_t riptaken,
+        uint64_t target);
+
 /**
  * @brief Initialize simulator structures after QEMU's initialization
  *
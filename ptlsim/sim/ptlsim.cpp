@@ -17,14 +17,15 @@
 #include <netinet/in.h>
 #include <errno.h>
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/sem.h>
 
 #include <bson/bson.h>
 #include <bson/mongo.h>
 #include <machine.h>
 #include <statelist.h>
 #include <decode.h>
+#include <timeStatsWriter.h>
+#include <bbv-profile.h>
+#include <shmsync.h>
 
 #include <fstream>
 #include <syscalls.h>
@@ -73,8 +74,10 @@ const char *snapshot_names[] = {"user", "kernel", "global"};
 Stats *user_stats;
 Stats *kernel_stats;
 Stats *global_stats;
+Stats *mode_stats[2];
 
 ofstream *time_stats_file;
+TimeStatsWriter *time_stats_writer;
 
 #endif
 
@@ -171,6 +174,7 @@ void ConfigurationParser<PTLsimConfig>::reset() {
   dump_config_filename = "";
 
   dump_state_now = 0;
+  mem_req_history = 0;
 
   verify_cache = 0;
   stats_filename.reset();
@@ -180,11 +184,13 @@ void ConfigurationParser<PTLsimConfig>::reset() {
   snapshot_now.reset();
   time_stats_logfile = "";
   time_stats_period = 10000;
+  time_stats_format = "csv";
 
   start_at_rip = INVALIDRIP;
   fast_fwd_insns = 0;
   fast_fwd_user_insns = 0;
   fast_fwd_checkpoint = "";
+  fast_fwd_warmup = 0;
 
   // memory model
   use_memory_model = 0;
@@ -210,8 +216,15 @@ void ConfigurationParser<PTLsimConfig>::reset() {
   dumpcode_filename = "test.dat";
   dump_at_end = 0;
   bbcache_dump_filename.reset();
+  shared_bbcache = 0;
+  lazy_bbcache_flush = 0;
+  bbcache_file.reset();
 
   machine_config = "";
+  skip_idle_cycles = 0;
+  parallel_cores = 0;
+  sync_quantum = 0;
+  cache_geometry = "";
 
   ///
   /// memory hierarchy implementation
@@ -240,6 +253,10 @@ void ConfigurationParser<PTLsimConfig>::reset() {
   simpoint_file = "";
   simpoint_interval = 10e6;
   simpoint_chk_name = "simpoint";
+  bbv_profile = "";
+  bbv_interval = 10e6;
+  bbv_simpoints = "";
+  bbv_max_k = 30;
 }
 
 template <>
@@ -268,6 +285,7 @@ void ConfigurationParser<PTLsimConfig>::setup() {
   add(log_user_only,                "log-user-only",        "Only log the user mode activities");
   add(dump_config_filename,			    "dump-config-file",		  "Dump Simulated Machine Configuration into Specified file instead of log file");
   add(logMemory,                    "logMemory",            "Log the Memory system");
+  add(mem_req_history,              "mem-req-history",      "Record controllers visited by each memory request (for debugging)");
 
   section("Statistics Database");
   add(stats_filename,               "stats",                "Statistics data store hierarchy root");
@@ -277,11 +295,13 @@ void ConfigurationParser<PTLsimConfig>::setup() {
   add(snapshot_now,                 "snapshot-now",         "Take statistical snapshot immediately, using specified name");
   add(time_stats_logfile,           "time-stats-logfile",   "File to write time-series statistics (new)");
   add(time_stats_period,            "time-stats-period",    "Frequency of capturing time-stats (in cycles)");
+  add(time_stats_format,            "time-stats-format",    "Time-stats file format: csv or binary (only counters with periodic dump, written in background)");
   section("Trace Start/Stop Point");
   add(start_at_rip,                 "startrip",             "Start at rip <startrip>");
   add(fast_fwd_insns,               "fast-fwd-insns",       "Fast Fwd each CPU by <N> instructions");
   add(fast_fwd_user_insns,          "fast-fwd-user-insns",  "Fast Fwd each CPU by <N> user level instructions");
   add(fast_fwd_checkpoint,          "fast-fwd-checkpoint",  "Create a checkpoint <chk-name> after fast-forwarding");
+  add(fast_fwd_warmup,              "fast-fwd-warmup",      "Warmup caches, TLBs and branch predictors in last <N> fast-forwarded instructions");
   add(stop_at_insns,                "stopinsns",            "Stop after executing <stopinsns> user instructions");
   add(stop_at_cycle,                "stopcycle",            "Stop after <stop> cycles");
   add(stop_at_iteration,            "stopiter",             "Stop after <stop> iterations (does not apply to cycle-accurate cores)");
@@ -311,11 +331,18 @@ void ConfigurationParser<PTLsimConfig>::setup() {
   add(dumpcode_filename,            "dumpcode",             "Save page of user code at final rip to file <dumpcode>");
   add(dump_at_end,                  "dump-at-end",          "Set breakpoint and dump core before first instruction executed on return to native mode");
   add(bbcache_dump_filename,        "bbdump",               "Basic block cache dump filename");
+  add(shared_bbcache,               "shared-bbcache",       "Share decoded basic blocks between all cores, tagged by physical code page");
+  add(lazy_bbcache_flush,           "lazy-bbcache-flush",   "Keep basic blocks on guest TLB flush and revalidate their code bytes on next use");
+  add(bbcache_file,                 "bbcache-file",         "Load decoded basic blocks from this file and save new ones to it at exit");
 
   add(verify_cache,                 "verify-cache",         "run simulation with storing actual data in cache");
 
   section("Core Configuration");
   add(machine_config, "machine", "Name of machine configuration to simulate");
+  add(skip_idle_cycles,             "skip-idle-cycles",     "Fast forward cycles in which all cores are idle waiting for memory");
+  add(parallel_cores,               "parallel-cores",       "Number of host threads used to clock simulated cores (0 or 1: serial)");
+  add(sync_quantum,                 "sync-quantum",         "Clock each core this many cycles ahead before the next core (0 or 1: strict cycle by cycle)");
+  add(cache_geometry,               "cache-geometry",       "Run time cache geometry, e.g. 'L2_0:size=512K:assoc=16,L3_0:latency=40'");
 
   ///
   /// following are for the new memory hierarchy implementation:
@@ -347,6 +374,10 @@ void ConfigurationParser<PTLsimConfig>::setup() {
   add(simpoint_file, "simpoint", "Create simpoint based checkpoints from given 'simpoint' file");
   add(simpoint_interval, "simpoint-interval", "Number of instructions in each interval");
   add(simpoint_chk_name, "simpoint-chk-name", "Checkpoint name prefix");
+  add(bbv_profile, "bbv-profile", "Write basic block vectors of emulated code to given SimPoint '.bb' file");
+  add(bbv_interval, "bbv-interval", "Number of instructions in each basic block vector");
+  add(bbv_simpoints, "bbv-simpoints", "Cluster basic block vectors at exit and write simpoints to given file (weights to <file>.weights)");
+  add(bbv_max_k, "bbv-maxk", "Maximum number of clusters for -bbv-simpoints");
 };
 
 #ifndef CONFIG_ONLY
@@ -518,6 +549,10 @@ static void flush_stats()
     time_stats_file->close();
   }
 
+  if(time_stats_writer) {
+    time_stats_writer->close();
+  }
+
   ptl_logfile << "Stats Summary:\n";
   (StatsBuilder::get()).dump_summary(ptl_logfile);
 }
@@ -617,6 +652,10 @@ bool handle_config_change(PTLsimConfig& config) {
     set_cpu_fast_fwd();
   }
 
+  if (config.bbv_profile.set() && qemu_initialized) {
+    bbv_profile_start();
+  }
+
   if (config.run && (config.fast_fwd_insns > 0 || config.fast_fwd_user_insns > 0)) {
     /* Disable run untill cpus are fast-forwarded */
     config.run = 0;
@@ -674,78 +713,35 @@ bool handle_config_change(PTLsimConfig& config) {
   return true;
 }
 
-/* Synchronization Support using SystemV Semaphores */
-const int SEM_ID = 3764;
-static int sem_id = -1;
-
-static void sync_op(W16 op)
-{
-  int rc;
-  sembuf sem_op;
-
-  sem_op.sem_num = 0;
-  sem_op.sem_op = op;
-  sem_op.sem_flg = 0;
-
-  while ((rc = semop(sem_id, &sem_op, 1)) == -1) {
-    if (errno != EINTR && errno != EIDRM) {
-      ptl_logfile << "Error in op " << op << " is: ";
-      switch (errno) {
-        case EACCES: ptl_logfile << "Access\n"; break;
-        case EEXIST: ptl_logfile << "Exists\n"; break;
-        case EINVAL: ptl_logfile << "Invalid\n"; break;
-        case ENOENT: ptl_logfile << "NoEnt\n"; break;
-        case ENOMEM: ptl_logfile << "NoMem\n"; break;
-        case ENOSPC: ptl_logfile << "NoSPC\n"; break;
-      }
-      ptl_logfile << flush;
-    }
-    if (errno == EIDRM) {
-      /* Semaphore is removed, so kill simulation */
-      flush_stats();
-      kill_simulation();
-    }
-  }
-}
-
-static void sync_set_sem()
-{
-  sync_op(1);
-}
+/* Synchronization Support using a shared memory barrier */
+const int SYNC_ID = 3764;
+static ShmBarrier sync_barrier;
+static char sync_name[64];
 
 static void sync_setup()
 {
-  /* First we will try to create a new semaphore if it fails
-   * then some other simulation process has already setup the
-   * semaphore and it will act as Master */
+  /* All instances with same MARSS_SEM_ID open the same barrier, the first
+   * one creates it */
 
-  int env_sem_id = -1;
-  char *env_sem_id_p;
+  int env_sync_id = -1;
+  char *env_sync_id_p;
 
-  env_sem_id_p = getenv("MARSS_SEM_ID");
+  env_sync_id_p = getenv("MARSS_SEM_ID");
 
-  if (env_sem_id_p)
-    env_sem_id = atoi(env_sem_id_p);
+  if (env_sync_id_p)
+    env_sync_id = atoi(env_sync_id_p);
   else
-    env_sem_id = SEM_ID;
-
-  sem_id = semget(env_sem_id, 1, IPC_CREAT | 0666);
-
-  if (sem_id == -1) {
-    ptl_logfile << "Sempahore setup error: ";
-    switch (errno) {
-      case EACCES: ptl_logfile << "Access\n"; break;
-      case EEXIST: ptl_logfile << "Exists\n"; break;
-      case EINVAL: ptl_logfile << "Invalid\n"; break;
-      case ENOENT: ptl_logfile << "NoEnt\n"; break;
-      case ENOMEM: ptl_logfile << "NoMem\n"; break;
-      case ENOSPC: ptl_logfile << "NoSPC\n"; break;
-    }
-    ptl_logfile << flush;
+    env_sync_id = SYNC_ID;
+
+  snprintf(sync_name, sizeof(sync_name), "/marss-sync-%d", env_sync_id);
+
+  if (!sync_barrier.open(sync_name)) {
+    ptl_logfile << "Sync barrier " << sync_name << " setup error: "
+                << strerror(errno) << endl << flush;
     kill_simulation();
   }
 
-  sync_set_sem();
+  sync_barrier.join();
 }
 
 static void sync_wait()
@@ -757,21 +753,23 @@ static void sync_wait()
 
   last_sync_cycle = sim_cycle;
 
-  /* Decrement semaphore */
-  sync_op(-1);
-
-  /* Now wait for all prcoesses to reach to semaphore */
-  sync_op(0);
-
-  sync_set_sem();
+  /* Wait for all processes to reach the barrier */
+  if (!sync_barrier.wait()) {
+    /* Barrier is removed, so kill simulation */
+    flush_stats();
+    kill_simulation();
+  }
 }
 
 static void sync_remove()
 {
-  /* We allow any simulation instance to remove the semaphore
+  /* We allow any simulation instance to remove the barrier
    * so that other instances will kill themselves */
-  if (sem_id != -1)
-    semctl(sem_id, 0, IPC_RMID);
+  if (sync_barrier.is_open()) {
+    sync_barrier.kill();
+    sync_barrier.close();
+    ShmBarrier::unlink(sync_name);
+  }
 }
 
 Hashtable<const char*, PTLsimMachine*, 1>* machinetable = NULL;
@@ -831,7 +829,7 @@ void ptl_reconfigure(const char* config_str) {
 
   ptl_logfile << "Configuration changed: " << config << endl;
 
-  if (config.sync_interval && sem_id == -1) {
+  if (config.sync_interval && !sync_barrier.is_open()) {
     sync_setup();
   }
 
@@ -885,14 +883,25 @@ extern "C" void ptl_machine_configure(const char* config_str_) {
     user_stats = builder.get_new_stats();
     kernel_stats = builder.get_new_stats();
     global_stats = builder.get_new_stats();
+    mode_stats[0] = user_stats;
+    mode_stats[1] = kernel_stats;
 
     // time based stats
+    time_stats_file = NULL;
+    time_stats_writer = NULL;
+
     if (config.time_stats_logfile.length > 0)
     {
-      time_stats_file = new ofstream(config.time_stats_logfile.buf);
-      builder.init_timer_stats();
-    } else {
-      time_stats_file = NULL;
+      if (config.time_stats_format == "binary") {
+        time_stats_writer = new TimeStatsWriter(config.time_stats_logfile.buf,
+            config.time_stats_period, config.core_freq_hz);
+      } else {
+        if (config.time_stats_format != "csv")
+          ptl_logfile << "Unknown time-stats format: " << config.time_stats_format <<
+            " writing in default CSV format." << endl;
+        time_stats_file = new ofstream(config.time_stats_logfile.buf);
+        builder.init_timer_stats();
+      }
     }
   }
 
@@ -1254,6 +1263,26 @@ static void dump_machine_configuration(PTLsimMachine *machine)
   }
 }
 
+/*
+ * Create cores, caches and interconnects of the machine. This is done at
+ * start of the first simulation run, or earlier if functional warmup
+ * (-fast-fwd-warmup) has to update them during fast-forward.
+ */
+bool ptl_create_machine(PTLsimMachine* machine) {
+  if (machine->created)
+    return true;
+
+  ptl_logfile << "Initializing core '" << machine->machine_name << "'" << endl;
+  if (!machine->init(config)) {
+    ptl_logfile << "Cannot initialize simulation machine; check the configuration!" << endl;
+    return false;
+  }
+
+  machine->created = 1;
+  machine->first_run = 1;
+  return true;
+}
+
 extern "C" uint8_t ptl_simulate() {
   PTLsimMachine* machine = NULL;
   char* machinename = config.core_name;
@@ -1275,14 +1304,11 @@ extern "C" uint8_t ptl_simulate() {
   }
 
   if (!machine->initialized) {
-    ptl_logfile << "Initializing core '" << machinename << "'" << endl;
-    if (!machine->init(config)) {
-      ptl_logfile << "Cannot initialize simulation machine; check the configuration!" << endl;
+    if (!ptl_create_machine(machine)) {
       config.run = 0;
       return 0;
     }
     machine->initialized = 1;
-    machine->first_run = 1;
 
     if(logable(1)) {
       ptl_logfile << "Switching to simulation core '" << machinename << "'..." << endl << flush;
@@ -1541,6 +1567,17 @@ void clock_qemu_io_events()
   }
 }
 
+/* Return cycle of earliest pending IO event or -1 if there is none */
+W64 get_next_qemu_io_event_cycle()
+{
+  W64 next_cycle = W64(-1);
+  QemuIOSignal *signal;
+  foreach_list_mutable(qemuIOEvents->list(), signal, entry, prev) {
+    next_cycle = min(next_cycle, signal->cycle);
+  }
+  return next_cycle;
+}
+
 extern "C" void add_qemu_io_event(QemuIOCB fn, void *arg, int delay)
 {
   QemuIOSignal* signal = qemuIOEvents->alloc();
@@ -36,9 +36,15 @@ struct PTLsimStats;
 extern Stats *user_stats;
 extern Stats *kernel_stats;
 extern Stats *global_stats;
+
+/* user_stats and kernel_stats indexed by kernel mode */
+extern Stats *mode_stats[2];
 extern Stats *time_stats;
 extern ofstream *time_stats_file;
 
+class TimeStatsWriter;
+extern TimeStatsWriter *time_stats_writer;
+
 struct PTLsimCore{
   virtual PTLsimCore& getcore() const{ return (*((PTLsimCore*)NULL));}
 };
@@ -47,11 +53,12 @@ extern Context* ptl_contexts[MAX_CONTEXTS];
 
 struct PTLsimMachine : public Statable {
   bool initialized;
+  bool created;
   bool stopped;
   bool first_run;
   Context* ret_qemu_env;
   PTLsimMachine() : Statable("machine") {
-    initialized = 0; stopped = 0;
+    initialized = 0; created = 0; stopped = 0;
     handle_cpuid = NULL;
   }
 
@@ -85,6 +92,7 @@ struct PTLsimMachine : public Statable {
 void setup_qemu_switch_all_ctx(Context& last_ctx);
 void setup_qemu_switch_except_ctx(const Context& const_ctx);
 void setup_ptlsim_switch_all_ctx(Context& const_ctx);
+bool ptl_create_machine(PTLsimMachine* machine);
 
 inline Context& contextof(W8 i) {
   return *ptl_contexts[i];
@@ -196,6 +204,7 @@ struct PTLsimConfig {
   W64 fast_fwd_insns;
   W64 fast_fwd_user_insns;
   stringbuf fast_fwd_checkpoint;
+  W64 fast_fwd_warmup;
 
   // Logging
   bool quiet;
@@ -211,6 +220,7 @@ struct PTLsimConfig {
   stringbuf dump_config_filename;
 
   bool logMemory;
+  bool mem_req_history;
 
   bool dump_state_now;
   bool abort_at_end;
@@ -224,6 +234,7 @@ struct PTLsimConfig {
   stringbuf snapshot_now;
   stringbuf time_stats_logfile;
   W64 time_stats_period;
+  stringbuf time_stats_format;
   stringbuf stats_format;
 
   // memory model:
@@ -256,9 +267,16 @@ struct PTLsimConfig {
   stringbuf dumpcode_filename;
   bool dump_at_end;
   stringbuf bbcache_dump_filename;
+  bool shared_bbcache;
+  bool lazy_bbcache_flush;
+  stringbuf bbcache_file;
 
   // Machine configurations
   stringbuf machine_config;
+  bool skip_idle_cycles;
+  W64 parallel_cores;
+  W64 sync_quantum;
+  stringbuf cache_geometry;
 
   ///
   /// for memory hierarchy implementaion
@@ -288,6 +306,10 @@ struct PTLsimConfig {
   stringbuf simpoint_file;
   W64 simpoint_interval;
   stringbuf simpoint_chk_name;
+  stringbuf bbv_profile;
+  W64 bbv_interval;
+  stringbuf bbv_simpoints;
+  W64 bbv_max_k;
 
   void reset();
 
@@ -317,6 +339,7 @@ void force_logging_enabled();
 
 void init_qemu_io_events();
 void clock_qemu_io_events();
+W64 get_next_qemu_io_event_cycle();
 
 /**
  * @brief Convert nano-seconds to Simulation Cycles
@@ -12,6 +12,12 @@
 
 #include <ptlsim.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
 static Stats *periodic_stats = NULL;
 static Stats *temp_stats  = NULL;
 static Stats *temp2_stats  = NULL;
@@ -133,6 +139,19 @@ ostream& Statable::dump_header(ostream &os) const
     return os;
 }
 
+void Statable::get_periodic_columns(PeriodicColumns& cols) const
+{
+    if(dump_disabled || !periodic_enabled) return;
+
+    foreach(i, leafs.count()) {
+        leafs[i]->get_periodic_columns(cols);
+    }
+
+    foreach(i, childNodes.count()) {
+        childNodes[i]->get_periodic_columns(cols);
+    }
+}
+
 ostream& Statable::dump_periodic(ostream &os, Stats *stats) const
 {
     if(dump_disabled || !periodic_enabled) return os;
@@ -236,29 +255,34 @@ bson_buffer* Statable::dump(bson_buffer *bb, Stats *stats)
     return bb;
 }
 
-void Statable::add_stats(Stats& dest_stats, Stats& src_stats)
+/**
+ * @param counters If false, skip W64 counters as they are added in bulk
+ */
+void Statable::add_stats(Stats& dest_stats, Stats& src_stats, bool counters)
 {
     // First add all the leafs
     foreach(i, leafs.count()) {
-        leafs[i]->add_stats(dest_stats, src_stats);
+        if(counters || !leafs[i]->is_counter())
+            leafs[i]->add_stats(dest_stats, src_stats);
     }
 
     // Now add all the child nodes
     foreach(i, childNodes.count()) {
-        childNodes[i]->add_stats(dest_stats, src_stats);
+        childNodes[i]->add_stats(dest_stats, src_stats, counters);
     }
 }
 
-void Statable::sub_stats(Stats& dest_stats, Stats& src_stats)
+void Statable::sub_stats(Stats& dest_stats, Stats& src_stats, bool counters)
 {
     // First add all the leafs
     foreach(i, leafs.count()) {
-        leafs[i]->sub_stats(dest_stats, src_stats);
+        if(counters || !leafs[i]->is_counter())
+            leafs[i]->sub_stats(dest_stats, src_stats);
     }
 
     // Now add all the child nodes
     foreach(i, childNodes.count()) {
-        childNodes[i]->sub_stats(dest_stats, src_stats);
+        childNodes[i]->sub_stats(dest_stats, src_stats, counters);
     }
 }
 
@@ -350,10 +374,87 @@ Stats* StatsBuilder::get_new_stats()
 
 void StatsBuilder::destroy_stats(Stats *stats)
 {
-    delete stats->mem;
     delete stats;
 }
 
+static void add_counters(W64 *dest, const W64 *src, W64 count)
+{
+    W64 i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)&dest[i]);
+        __m256i s = _mm256_loadu_si256((const __m256i*)&src[i]);
+        _mm256_storeu_si256((__m256i*)&dest[i], _mm256_add_epi64(d, s));
+    }
+#endif
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i d = _mm_loadu_si128((const __m128i*)&dest[i]);
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_si128((__m128i*)&dest[i], _mm_add_epi64(d, s));
+    }
+
+    for (; i < count; i++) {
+        dest[i] += src[i];
+    }
+}
+
+static void sub_counters(W64 *dest, const W64 *src, W64 count)
+{
+    W64 i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 4 <= count; i += 4) {
+        __m256i d = _mm256_loadu_si256((const __m256i*)&dest[i]);
+        __m256i s = _mm256_loadu_si256((const __m256i*)&src[i]);
+        _mm256_storeu_si256((__m256i*)&dest[i], _mm256_sub_epi64(d, s));
+    }
+#endif
+
+    for (; i + 2 <= count; i += 2) {
+        __m128i d = _mm_loadu_si128((const __m128i*)&dest[i]);
+        __m128i s = _mm_loadu_si128((const __m128i*)&src[i]);
+        _mm_storeu_si128((__m128i*)&dest[i], _mm_sub_epi64(d, s));
+    }
+
+    for (; i < count; i++) {
+        dest[i] -= src[i];
+    }
+}
+
+/**
+ * @brief Add all stats of src_stats to dest_stats
+ *
+ * W64 counters are added as one array, other objects one by one.
+ */
+void StatsBuilder::add_stats(Stats& dest_stats, Stats& src_stats) const
+{
+    add_counters((W64*)dest_stats.base(), (W64*)src_stats.base(),
+            counter_offset / sizeof(W64));
+    rootNode->add_stats(dest_stats, src_stats, false);
+}
+
+void StatsBuilder::sub_stats(Stats& dest_stats, Stats& src_stats) const
+{
+    sub_counters((W64*)dest_stats.base(), (W64*)src_stats.base(),
+            counter_offset / sizeof(W64));
+    rootNode->sub_stats(dest_stats, src_stats, false);
+}
+
+void StatsBuilder::copy_stats(Stats& dest_stats, Stats& src_stats) const
+{
+    memcpy(dest_stats.mem, src_stats.mem, counter_offset);
+    memcpy(dest_stats.mem + other_offset, src_stats.mem + other_offset,
+            STATS_SIZE - other_offset);
+}
+
+void StatsBuilder::clear_stats(Stats& stats) const
+{
+    memset(stats.mem, 0, counter_max);
+    memset(stats.mem + other_min, 0, STATS_SIZE - other_min);
+}
+
 ostream& StatsBuilder::dump_header(ostream &os) const
 {
     if (rootNode->is_dump_periodic())
@@ -17,6 +17,8 @@
 #include <yaml/yaml.h>
 #include <bson/bson.h>
 
+#include <sys/mman.h>
+
 #ifdef ENABLE_TESTS
 #  define STATS_SIZE 1024*1024*10
 #else
@@ -26,6 +28,28 @@
 class StatObjBase;
 class Stats;
 
+/**
+ * @brief One counter of time-series stats
+ *
+ * Columns are collected from all StatObjBase objects that have periodic
+ * dump enabled so TimeStatsWriter can read just those counters instead
+ * of copying whole Stats.
+ */
+struct PeriodicColumn {
+    StatObjBase *obj;
+    W64 offset;
+    bool is_float;
+    bool is_equation;
+
+    /* Read/write value at offset, float values as IEEE double bits */
+    W64 (*get)(Stats *stats, W64 offset);
+    void (*set)(Stats *stats, W64 offset, W64 value);
+
+    stringbuf *name;
+};
+
+typedef dynarray<PeriodicColumn> PeriodicColumns;
+
 inline static YAML::Emitter& operator << (YAML::Emitter& out, const W64 value)
 {
     stringbuf buf;
@@ -234,8 +258,10 @@ class Statable {
          */
         bson_buffer* dump(bson_buffer *bb, Stats *stats);
 
-        void add_stats(Stats& dest_stats, Stats& src_stats);
-        void sub_stats(Stats& dest_stats, Stats& src_stats);
+        void add_stats(Stats& dest_stats, Stats& src_stats,
+                bool counters=true);
+        void sub_stats(Stats& dest_stats, Stats& src_stats,
+                bool counters=true);
 
         void add_periodic_stats(Stats& dest_stats, Stats& src_stats);
         void sub_periodic_stats(Stats& dest_stats, Stats& src_stats);
@@ -244,6 +270,8 @@ class Statable {
 
         ostream& dump_header(ostream &os) const;
 
+        void get_periodic_columns(PeriodicColumns& cols) const;
+
         stringbuf *get_full_stat_string() const;
 
 		StatObjBase* get_stat_obj(dynarray<stringbuf*> &names, int idx);
@@ -255,18 +283,34 @@ class Statable {
  * This class provides interface to build a Stats object and also provides and
  * interface to map StatObjBase objects to Stats memory.
  *
+ * W64 counters are packed from the start of Stats memory in order of
+ * creation, so counters of one core share cache lines and bulk operations
+ * work on one array of W64. All other objects (strings, equation results)
+ * are placed from the end of Stats memory. Only these two regions are
+ * touched by reset, copy, add and sub.
+ *
  * This is a 'singleton' class, so get the object using 'get()' function.
  */
 class StatsBuilder {
     private:
         static StatsBuilder *_builder;
         Statable *rootNode;
-        W64 stat_offset;
+
+        /* Counters grow up from 0, other objects down from STATS_SIZE */
+        W64 counter_offset;
+        W64 other_offset;
+
+        /* Largest regions ever used, cleared by reset after delete_nodes */
+        W64 counter_max;
+        W64 other_min;
 
         StatsBuilder()
         {
             rootNode = new Statable("", true);
-            stat_offset = 0;
+            counter_offset = 0;
+            other_offset = STATS_SIZE;
+            counter_max = 0;
+            other_min = STATS_SIZE;
         }
 
         ~StatsBuilder()
@@ -304,17 +348,48 @@ class StatsBuilder {
          * @brief Get the offset for given StatObjBase class
          *
          * @param size Size of the memory to be allocted
+         * @param counter Memory is an array of W64 counters
          *
          * @return Offset value
          */
-        W64 get_offset(int size)
+        W64 get_offset(int size, bool counter=false)
         {
-            W64 ret_val = stat_offset;
-            stat_offset += size;
-            assert(stat_offset < STATS_SIZE);
+            W64 ret_val;
+
+            if (counter) {
+                ret_val = counter_offset;
+                counter_offset += size;
+                counter_max = max(counter_max, counter_offset);
+            } else {
+                other_offset = floor(other_offset - size, sizeof(W64));
+                ret_val = other_offset;
+                other_min = min(other_min, other_offset);
+            }
+
+            assert(counter_offset <= other_offset);
             return ret_val;
         }
 
+        /**
+         * @brief Get number of bytes of Stats memory used by all StatObjBase
+         *
+         * @return Size of used memory
+         */
+        W64 get_used_size() const
+        {
+            return counter_offset + (STATS_SIZE - other_offset);
+        }
+
+        /**
+         * @brief Get number of bytes used by W64 counters
+         *
+         * @return Size of counter array, starting from Stats base
+         */
+        W64 get_counter_size() const
+        {
+            return counter_offset;
+        }
+
         /**
          * @brief Get a new Stats object
          *
@@ -362,15 +437,10 @@ class StatsBuilder {
 
         void init_timer_stats();
 
-        void add_stats(Stats& dest_stats, Stats& src_stats) const
-        {
-            rootNode->add_stats(dest_stats, src_stats);
-        }
-
-        void sub_stats(Stats& dest_stats, Stats& src_stats) const
-        {
-            rootNode->sub_stats(dest_stats, src_stats);
-        }
+        void add_stats(Stats& dest_stats, Stats& src_stats) const;
+        void sub_stats(Stats& dest_stats, Stats& src_stats) const;
+        void copy_stats(Stats& dest_stats, Stats& src_stats) const;
+        void clear_stats(Stats& stats) const;
 
         void add_periodic_stats(Stats& dest_stats, Stats& src_stats) const
         {
@@ -385,6 +455,17 @@ class StatsBuilder {
         }
 
         bool is_dump_periodic() { return rootNode->is_dump_periodic(); }
+
+        /**
+         * @brief Get all counters with periodic dump enabled
+         *
+         * @param cols Columns are added in same order as in dump_header()
+         */
+        void get_periodic_columns(PeriodicColumns& cols) const
+        {
+            rootNode->get_periodic_columns(cols);
+        }
+
         ostream& dump_header(ostream &os) const;
         ostream& dump_periodic(ostream &os, W64 cycle) const;
         ostream& dump_summary(ostream &os) const;
@@ -394,7 +475,8 @@ class StatsBuilder {
             delete rootNode;
 
             rootNode = new Statable("", true);
-            stat_offset = 0;
+            counter_offset = 0;
+            other_offset = STATS_SIZE;
         }
 
 		StatObjBase* get_stat_obj(stringbuf &name);
@@ -408,6 +490,9 @@ class StatsBuilder {
  * classes to store their variables. Users are not allowed to directly create
  * an object of Stats, they must used StatsBuilder::get_new_stats() function
  * to get one.
+ *
+ * Memory is reserved as zero pages, so only pages of the regions that
+ * StatsBuilder has handed out are ever backed by host memory.
  */
 class Stats {
     private:
@@ -415,8 +500,14 @@ class Stats {
 
         Stats()
         {
-            mem = new W8[STATS_SIZE];
-            reset();
+            mem = (W8*)mmap(NULL, STATS_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            assert(mem != MAP_FAILED);
+        }
+
+        ~Stats()
+        {
+            munmap(mem, STATS_SIZE);
         }
 
     public:
@@ -429,7 +520,7 @@ class Stats {
 
         void reset()
         {
-            memset(mem, 0, sizeof(W8) * STATS_SIZE);
+            (StatsBuilder::get()).clear_stats(*this);
         }
 
         Stats& operator+=(Stats& rhs_stats)
@@ -440,11 +531,76 @@ class Stats {
 
         Stats& operator=(Stats& rhs_stats)
         {
-            memcpy(mem, rhs_stats.mem, sizeof(W8) * STATS_SIZE);
+            (StatsBuilder::get()).copy_stats(*this, rhs_stats);
             return *this;
         }
 };
 
+/* Types stored in the counter region of Stats */
+template<typename T>
+struct StatCounter {
+    static const bool value = false;
+};
+
+template<>
+struct StatCounter<W64> {
+    static const bool value = true;
+};
+
+template<typename T>
+struct PeriodicValue {
+    static W64 get(Stats *stats, W64 offset)
+    {
+        return W64(*(T*)(stats->base() + offset));
+    }
+
+    static void set(Stats *stats, W64 offset, W64 value)
+    {
+        *(T*)(stats->base() + offset) = T(value);
+    }
+
+    static const bool is_float = false;
+};
+
+template<>
+struct PeriodicValue<double> {
+    static W64 get(Stats *stats, W64 offset)
+    {
+        W64 value;
+        memcpy(&value, (void*)(stats->base() + offset), sizeof(double));
+        return value;
+    }
+
+    static void set(Stats *stats, W64 offset, W64 value)
+    {
+        memcpy((void*)(stats->base() + offset), &value, sizeof(double));
+    }
+
+    static const bool is_float = true;
+};
+
+/**
+ * @brief Create a time-series column for a counter of type T
+ *
+ * @param obj Stats object that owns the counter
+ * @param offset Offset of counter in Stats
+ * @param name Full name of the column, owned by the column
+ */
+template<typename T>
+static inline PeriodicColumn periodic_column(StatObjBase *obj, W64 offset,
+        stringbuf *name)
+{
+    PeriodicColumn col;
+    col.obj = obj;
+    col.offset = offset;
+    col.is_float = PeriodicValue<T>::is_float;
+    col.is_equation = false;
+    col.get = PeriodicValue<T>::get;
+    col.set = PeriodicValue<T>::set;
+    col.name = name;
+    return col;
+}
+
 /**
  * @brief Base class for all Statistics container classes
  */
@@ -457,12 +613,16 @@ class StatObjBase {
         bool dump_disabled;
         bool periodic_enabled;
 
+        /* Stored in the W64 counter region of Stats */
+        bool counter;
+
     public:
         StatObjBase(const char *name, Statable *parent)
             : parent(parent)
               , summarize(false)
               , dump_disabled(false)
               , periodic_enabled(false)
+              , counter(false)
         {
             this->name = name;
             default_stats = parent->get_default_stats();
@@ -540,6 +700,16 @@ class StatObjBase {
             return os;
         }
 
+        /**
+         * @brief Add a column for each counter with periodic dump enabled
+         */
+        virtual void get_periodic_columns(PeriodicColumns& cols) { }
+
+        /**
+         * @brief Update derived value in given Stats, see StatEquation
+         */
+        virtual void compute(Stats *stats) const { }
+
         virtual ostream& dump_summary(ostream& os, Stats* stats, const char* pfx) const = 0;
 
         virtual void add_stats(Stats& dest_stats, Stats& src_stats) = 0;
@@ -551,6 +721,8 @@ class StatObjBase {
         void disable_dump() { dump_disabled = true; }
         void enable_dump() { dump_disabled = false; }
         bool is_dump_disabled() const { return dump_disabled; }
+
+        bool is_counter() const { return counter; }
 };
 
 /**
@@ -559,6 +731,10 @@ class StatObjBase {
  * This class povides an easy interface to create basic statistics counters for
  * the simulator. It also provides easy way to generate YAML and BSON
  * representation of the the object for final Stats dump.
+ *
+ * When built with DISABLE_STATS ('scons stats=0') updates through the default
+ * Stats (++, --, +=, -= and StatArray []) do nothing, to measure cost of
+ * stats collection.
  */
 template<typename T>
 class StatObj : public StatObjBase {
@@ -588,7 +764,8 @@ class StatObj : public StatObjBase {
         {
             StatsBuilder &builder = StatsBuilder::get();
 
-            offset = builder.get_offset(sizeof(T));
+            counter = StatCounter<T>::value;
+            offset = builder.get_offset(sizeof(T), counter);
 
             set_default_var_ptr();
         }
@@ -616,9 +793,13 @@ class StatObj : public StatObjBase {
          */
         inline T operator++(int dummy)
         {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             T ret = (*default_var)++;
             return ret;
+#endif
         }
 
         /**
@@ -628,9 +809,13 @@ class StatObj : public StatObjBase {
          */
         inline T operator++()
         {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             (*default_var)++;
             return (*default_var);
+#endif
         }
 
         /**
@@ -641,9 +826,13 @@ class StatObj : public StatObjBase {
          * @return object of type T with update value
          */
         inline T operator--(int dummy) {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             T ret = (*default_var)--;
             return ret;
+#endif
         }
 
         /**
@@ -652,9 +841,13 @@ class StatObj : public StatObjBase {
          * @return object of type T with update value
          */
         inline T operator--() {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             (*default_var)--;
             return (*default_var);
+#endif
         }
 
         /**
@@ -665,8 +858,12 @@ class StatObj : public StatObjBase {
          * @return T& with updated value
          */
         inline T& operator -= (T& val) {
+#ifdef DISABLE_STATS
+            return val;
+#else
             (*default_var) -= val;
             return (*default_var);
+#endif
         }
 
         inline T& operator=(T& val) {
@@ -710,9 +907,13 @@ class StatObj : public StatObjBase {
          * @return object of type T with new value
          */
         inline T operator +=(const T &b) const {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             *default_var += b;
             return *default_var;;
+#endif
         }
 
         /**
@@ -723,10 +924,14 @@ class StatObj : public StatObjBase {
          * @return object of type T with new value
          */
         inline T operator +=(const StatObj<T> &statObj) const {
+#ifdef DISABLE_STATS
+            return T();
+#else
             assert(default_var);
             assert(statObj.default_var);
             *default_var += (*statObj.default_var);
             return  *default_var;
+#endif
         }
 
         /**
@@ -927,6 +1132,14 @@ class StatObj : public StatObjBase {
             return os;
         }
 
+        void get_periodic_columns(PeriodicColumns& cols)
+        {
+            if (is_dump_periodic()) {
+                cols.push(periodic_column<T>(this, offset,
+                            get_full_stat_string()));
+            }
+        }
+
         ostream &dump_summary(ostream &os, Stats *stats, const char* pfx) const
         {
             if (is_summarize_enabled()) {
@@ -979,7 +1192,8 @@ class StatArray : public StatObjBase {
         {
             StatsBuilder &builder = StatsBuilder::get();
 
-            offset = builder.get_offset(sizeof(T) * size);
+            counter = StatCounter<T>::value;
+            offset = builder.get_offset(sizeof(T) * size, counter);
 
             set_default_var_ptr();
         }
@@ -1008,11 +1222,17 @@ class StatArray : public StatObjBase {
          */
         inline T& operator[](const int index)
         {
+#ifdef DISABLE_STATS
+            /* Per thread so -parallel-cores threads don't race on it */
+            static thread_local T discard;
+            return discard;
+#else
             assert(index < size);
             assert(default_var);
 
             BaseArr& arr = *(BaseArr*)(default_var);
             return arr[index];
+#endif
         }
 
         /**
@@ -1208,6 +1428,26 @@ class StatArray : public StatObjBase {
             return os;
         }
 
+        void get_periodic_columns(PeriodicColumns& cols)
+        {
+            if (!is_dump_periodic()) return;
+
+            foreach(i, size) {
+                if(periodic_flag[i]) {
+                    stringbuf *name = get_full_stat_string();
+
+                    if(labels) {
+                        *name << "." << labels[i];
+                    } else {
+                        *name << "." << i;
+                    }
+
+                    cols.push(periodic_column<T>(this,
+                                offset + i * sizeof(T), name));
+                }
+            }
+        }
+
         ostream &dump_periodic(ostream &os, Stats *stats) const
         {
             if (!is_dump_periodic()) return os;
@@ -1702,6 +1942,19 @@ class StatEquation : public StatObj<K> {
             base_t::dump_periodic(os, stats);
             return os;
         }
+
+        /**
+         * @brief Add column of this equation, its value is computed from
+         * the periodic values of its elements
+         */
+        void get_periodic_columns(PeriodicColumns& cols)
+        {
+            int first = cols.count();
+            base_t::get_periodic_columns(cols);
+
+            if (cols.count() > first)
+                cols[first].is_equation = true;
+        }
 };
 
 #endif // STATS_BUILDER_H
@@ -0,0 +1,320 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#include <timeStatsWriter.h>
+
+#include <ptlsim.h>
+
+static inline double bits_to_double(W64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static inline W64 double_to_bits(double value)
+{
+    W64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline void put_varint(byte*& p, W64 value)
+{
+    while (value >= 0x80) {
+        *p++ = byte(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = byte(value);
+}
+
+static inline W64 zigzag(W64 value)
+{
+    return (value << 1) ^ W64(W64s(value) >> 63);
+}
+
+TimeStatsWriter::TimeStatsWriter(const char *filename, W64 period,
+        W64 freq_hz)
+    : out(filename, std::ios::binary)
+      , period(period)
+      , freq_hz(freq_hz)
+      , column_count(0)
+      , started(false)
+      , last_total(NULL)
+      , equation_stats(NULL)
+      , produced(0)
+      , consumed(0)
+      , stopping(false)
+      , last_cycle(0)
+      , last_value(NULL)
+      , encode_buf(NULL)
+{
+    foreach (i, TIME_STATS_BLOCKS) {
+        blocks[i].values = NULL;
+        blocks[i].rows = 0;
+    }
+
+    pthread_mutex_init(&lock, NULL);
+    pthread_cond_init(&filled, NULL);
+    pthread_cond_init(&drained, NULL);
+}
+
+TimeStatsWriter::~TimeStatsWriter()
+{
+    close();
+
+    pthread_cond_destroy(&drained);
+    pthread_cond_destroy(&filled);
+    pthread_mutex_destroy(&lock);
+}
+
+/**
+ * @brief Collect columns and start writer thread
+ *
+ * Done on first snapshot so all Statable objects of the machine are
+ * created and have enabled their periodic counters.
+ */
+void TimeStatsWriter::start()
+{
+    started = true;
+
+    StatsBuilder::get().get_periodic_columns(columns);
+    column_count = columns.count();
+
+    last_total = new W64[column_count];
+    last_value = new W64[column_count];
+
+    foreach (i, column_count) {
+        last_total[i] = 0;
+        last_value[i] = 0;
+
+        if (columns[i].is_equation && !equation_stats)
+            equation_stats = StatsBuilder::get().get_new_stats();
+    }
+
+    foreach (i, TIME_STATS_BLOCKS) {
+        blocks[i].values = new W64[TIME_STATS_BLOCK_ROWS * (column_count + 1)];
+    }
+
+    /* Worst case is 10 bytes per varint */
+    encode_buf = new byte[10 * (TIME_STATS_BLOCK_ROWS * (column_count + 1) + 1)];
+
+    write_header();
+
+    /* Snapshots would wait forever for a writer, so stop in all builds */
+    int rc = pthread_create(&thread, NULL, writer_main, this);
+    if (rc) {
+        stringbuf err;
+        err << "::ERROR::Unable to start time stats writer thread: ",
+            strerror(rc), endl;
+        ptl_logfile << err;
+        cerr << err;
+        assert_fail(__STRING(rc == 0), __FILE__, __LINE__,
+                __PRETTY_FUNCTION__);
+    }
+}
+
+void TimeStatsWriter::write_header()
+{
+    W64 magic = TIME_STATS_MAGIC;
+    W32 version = TIME_STATS_VERSION;
+    W32 count = column_count;
+
+    out.write((const char*)&magic, sizeof(magic));
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)&count, sizeof(count));
+    out.write((const char*)&period, sizeof(period));
+    out.write((const char*)&freq_hz, sizeof(freq_hz));
+
+    foreach (i, column_count) {
+        W8 type = columns[i].is_float;
+        W16 len = columns[i].name->size();
+
+        out.write((const char*)&type, sizeof(type));
+        out.write((const char*)&len, sizeof(len));
+        out.write(columns[i].name->buf, len);
+    }
+}
+
+/**
+ * @brief Record one row of time-series stats
+ *
+ * @param cycle Simulation cycle of this row
+ * @param user User Stats
+ * @param kernel Kernel Stats
+ *
+ * Each column gets change of user + kernel value since last snapshot.
+ * Equations are computed from these changes, same as CSV time stats.
+ */
+void TimeStatsWriter::snapshot(W64 cycle, Stats *user, Stats *kernel)
+{
+    if unlikely (!started) start();
+
+    Block& block = blocks[produced % TIME_STATS_BLOCKS];
+    W64 *row = block.values + block.rows * (column_count + 1);
+
+    row[0] = cycle;
+
+    foreach (i, column_count) {
+        PeriodicColumn& col = columns[i];
+        if (col.is_equation) continue;
+
+        W64 u = col.get(user, col.offset);
+        W64 k = col.get(kernel, col.offset);
+        W64 total, value;
+
+        if (col.is_float) {
+            double t = bits_to_double(u) + bits_to_double(k);
+            total = double_to_bits(t);
+            value = double_to_bits(t - bits_to_double(last_total[i]));
+        } else {
+            total = u + k;
+            value = total - last_total[i];
+        }
+
+        last_total[i] = total;
+        row[i + 1] = value;
+
+        if (equation_stats)
+            col.set(equation_stats, col.offset, value);
+    }
+
+    if (equation_stats) {
+        foreach (i, column_count) {
+            PeriodicColumn& col = columns[i];
+            if (!col.is_equation) continue;
+
+            col.obj->compute(equation_stats);
+            row[i + 1] = col.get(equation_stats, col.offset);
+        }
+    }
+
+    if (++block.rows == TIME_STATS_BLOCK_ROWS)
+        publish_block();
+}
+
+/**
+ * @brief Hand current block to writer thread, waits if writer is
+ * TIME_STATS_BLOCKS blocks behind
+ */
+void TimeStatsWriter::publish_block()
+{
+    pthread_mutex_lock(&lock);
+
+    produced++;
+    pthread_cond_signal(&filled);
+
+    while (produced - consumed >= TIME_STATS_BLOCKS) {
+        pthread_cond_wait(&drained, &lock);
+    }
+
+    pthread_mutex_unlock(&lock);
+
+    blocks[produced % TIME_STATS_BLOCKS].rows = 0;
+}
+
+void TimeStatsWriter::encode_block(const Block& block)
+{
+    byte *p = encode_buf;
+    int stride = column_count + 1;
+
+    put_varint(p, block.rows);
+
+    foreach (r, block.rows) {
+        W64 cycle = block.values[r * stride];
+        put_varint(p, cycle - last_cycle);
+        last_cycle = cycle;
+    }
+
+    foreach (i, column_count) {
+        const W64 *values = block.values + i + 1;
+
+        if (columns[i].is_float) {
+            foreach (r, block.rows) {
+                memcpy(p, &values[r * stride], sizeof(W64));
+                p += sizeof(W64);
+            }
+            continue;
+        }
+
+        foreach (r, block.rows) {
+            W64 value = values[r * stride];
+            put_varint(p, zigzag(value - last_value[i]));
+            last_value[i] = value;
+        }
+    }
+
+    out.write((const char*)encode_buf, p - encode_buf);
+}
+
+void* TimeStatsWriter::writer_main(void *arg)
+{
+    TimeStatsWriter *writer = (TimeStatsWriter*)arg;
+
+    pthread_mutex_lock(&writer->lock);
+
+    for (;;) {
+        while (writer->consumed == writer->produced && !writer->stopping) {
+            pthread_cond_wait(&writer->filled, &writer->lock);
+        }
+
+        if (writer->consumed == writer->produced)
+            break;
+
+        Block& block = writer->blocks[writer->consumed % TIME_STATS_BLOCKS];
+
+        pthread_mutex_unlock(&writer->lock);
+        writer->encode_block(block);
+        pthread_mutex_lock(&writer->lock);
+
+        writer->consumed++;
+        pthread_cond_signal(&writer->drained);
+    }
+
+    pthread_mutex_unlock(&writer->lock);
+
+    return NULL;
+}
+
+void TimeStatsWriter::close()
+{
+    if (!out.is_open())
+        return;
+
+    /* File without any snapshot still has a valid header */
+    if (!started)
+        start();
+
+    if (blocks[produced % TIME_STATS_BLOCKS].rows)
+        publish_block();
+
+    pthread_mutex_lock(&lock);
+    stopping = true;
+    pthread_cond_signal(&filled);
+    pthread_mutex_unlock(&lock);
+
+    pthread_join(thread, NULL);
+
+    out.close();
+
+    foreach (i, column_count) {
+        delete columns[i].name;
+    }
+    columns.clear();
+
+    foreach (i, TIME_STATS_BLOCKS) {
+        delete[] blocks[i].values;
+        blocks[i].values = NULL;
+    }
+
+    delete[] last_total;
+    delete[] last_value;
+    delete[] encode_buf;
+
+    if (equation_stats)
+        StatsBuilder::get().destroy_stats(equation_stats);
+}
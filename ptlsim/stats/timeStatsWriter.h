@@ -0,0 +1,105 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+#ifndef TIME_STATS_WRITER_H
+#define TIME_STATS_WRITER_H
+
+#include <globals.h>
+#include <superstl.h>
+#include <statsBuilder.h>
+
+#include <pthread.h>
+
+#define TIME_STATS_MAGIC        0x315354535352414dULL // "MARSSTS1"
+#define TIME_STATS_VERSION      1
+
+/* Rows per block and blocks buffered between simulator and writer */
+#define TIME_STATS_BLOCK_ROWS   256
+#define TIME_STATS_BLOCKS       4
+
+/*
+ * TimeStatsWriter
+ *
+ * Binary time-series stats, selected with -time-stats-format binary.
+ * Each snapshot reads only the counters that have periodic dump enabled
+ * from user and kernel stats and stores the change since last snapshot,
+ * same values as CSV time stats. Snapshots are collected in blocks of
+ * rows that a background thread encodes and writes to the file.
+ *
+ * File format, all fixed size fields little endian:
+ *
+ *   header  : W64 magic, W32 version, W32 column count, W64 period,
+ *             W64 core frequency in Hz
+ *   columns : W8 type (0 integer, 1 double), W16 name length, name
+ *   blocks  : varint row count, then one column after other:
+ *             sim_cycle of each row as varint difference to previous row,
+ *             then for each column the value of each row, as zigzag varint
+ *             difference to previous row for integers and raw 8 bytes for
+ *             doubles
+ *
+ * Difference to previous row continues across blocks. util/mstats.py
+ * reads these files and converts them to CSV (mstats_plugins/time_stats.py).
+ */
+class TimeStatsWriter
+{
+    public:
+        TimeStatsWriter(const char *filename, W64 period, W64 freq_hz);
+        ~TimeStatsWriter();
+
+        /* Record stats change since last snapshot at given cycle */
+        void snapshot(W64 cycle, Stats *user, Stats *kernel);
+
+        /* Write all pending snapshots and close the file */
+        void close();
+
+        bool is_open() const { return out.is_open(); }
+
+    private:
+        struct Block {
+            /* rows x (1 + column count) values, row major */
+            W64 *values;
+            int rows;
+        };
+
+        ofstream out;
+        W64 period;
+        W64 freq_hz;
+
+        PeriodicColumns columns;
+        int column_count;
+        bool started;
+
+        /* Last cumulative value of each column */
+        W64 *last_total;
+
+        /* Periodic values are stored here to compute equations */
+        Stats *equation_stats;
+
+        Block blocks[TIME_STATS_BLOCKS];
+        W64 produced;
+        W64 consumed;
+        bool stopping;
+
+        pthread_t thread;
+        pthread_mutex_t lock;
+        pthread_cond_t filled;
+        pthread_cond_t drained;
+
+        /* Writer thread state */
+        W64 last_cycle;
+        W64 *last_value;
+        byte *encode_buf;
+
+        void start();
+        void write_header();
+        void publish_block();
+        void encode_block(const Block& block);
+
+        static void* writer_main(void *arg);
+};
+
+#endif // TIME_STATS_WRITER_H
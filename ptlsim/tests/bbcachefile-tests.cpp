@@ -0,0 +1,233 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <ptlsim.h>
+#include <decode.h>
+
+#include <link.h>
+#include <unistd.h>
+
+namespace {
+
+    /* add rax, [rbx]; mov [rbx+8], rax; cmp rax, rcx; jne -16 */
+    static const byte test_code[] = {
+        0x48, 0x03, 0x03,
+        0x48, 0x89, 0x43, 0x08,
+        0x48, 0x39, 0xc8,
+        0x75, 0xf0,
+    };
+
+    /* Decoder updates stats of the core, tests run before cores exist */
+    static void setup_decoder_stats()
+    {
+        if (!decoder_stats[0])
+            set_decoder_stats(new Statable("bbcache_file_test", true), 0);
+    }
+
+    /* Use a new empty basic block file */
+    static void set_bbcache_file(stringbuf& path)
+    {
+        char name[] = "/tmp/bbcache-test-XXXXXX";
+        int fd = mkstemp(name);
+        close(fd);
+        unlink(name);
+
+        path.reset();
+        path << name;
+        config.bbcache_file.reset();
+        config.bbcache_file << name;
+    }
+
+    /*
+     * Code bytes at rip and mode of a 64-bit user context, as fillbuf()
+     * gives them to the decoder
+     */
+    static void fill_decoder(TraceDecoder& trans, byte* insnbuf,
+            const byte* code, int bytes)
+    {
+        trans.use32 = 1;
+        trans.ss32 = 0;
+        trans.pe = 1;
+        trans.vm86 = 0;
+        trans.hflags = 0;
+
+        memset(insnbuf, 0, MAX_BB_BYTES);
+        memcpy(insnbuf, code, min(bytes, MAX_BB_BYTES));
+        trans.insnbytes = insnbuf;
+        trans.insnbytes_bufsize = MAX_BB_BYTES;
+        trans.valid_byte_count = min(bytes, MAX_BB_BYTES);
+    }
+
+    /* Same steps as BasicBlockCache::translate() for a block not in file */
+    static BasicBlock* decode_and_store(const RIPVirtPhys& rvp,
+            const byte* code, int bytes)
+    {
+        byte insnbuf[MAX_BB_BYTES];
+        TraceDecoder trans(rvp);
+        fill_decoder(trans, insnbuf, code, bytes);
+
+        for (;;) {
+            if (!trans.translate()) break;
+        }
+
+        trans.bb.code_crc = CRC32().update(insnbuf,
+                min((int)trans.bb.bytes, MAX_BB_BYTES));
+        BasicBlock* bb = trans.bb.clone();
+        bbcache_file_store(trans, bb);
+        return bb;
+    }
+
+    static BasicBlock* lookup(const RIPVirtPhys& rvp, const byte* code,
+            int bytes)
+    {
+        byte insnbuf[MAX_BB_BYTES];
+        TraceDecoder trans(rvp);
+        fill_decoder(trans, insnbuf, code, bytes);
+        return bbcache_file_lookup(trans, insnbuf);
+    }
+
+    static bool same_translation(const BasicBlock* a, const BasicBlock* b)
+    {
+        return a->bytes == b->bytes && a->count == b->count &&
+            a->rip_taken == b->rip_taken &&
+            a->rip_not_taken == b->rip_not_taken &&
+            !memcmp(a->transops, b->transops, a->count * sizeof(TransOp));
+    }
+
+    TEST(BBCacheFile, LookupMatchesCodeAndMode)
+    {
+        stringbuf path;
+        setup_decoder_stats();
+        set_bbcache_file(path);
+
+        RIPVirtPhys rvp;
+        setzero(rvp);
+        rvp.rip = 0x7f0000401000ULL;
+        rvp.use64 = 1;
+
+        ASSERT_TRUE(lookup(rvp, test_code, sizeof(test_code)) == NULL);
+
+        BasicBlock* bb = decode_and_store(rvp, test_code, sizeof(test_code));
+        ASSERT_EQ((int)sizeof(test_code), (int)bb->bytes);
+
+        BasicBlock* hit = lookup(rvp, test_code, sizeof(test_code));
+        ASSERT_TRUE(hit != NULL);
+        ASSERT_TRUE(same_translation(bb, hit));
+        ASSERT_EQ(rvp.rip, hit->rip.rip);
+        hit->free();
+
+        /* Changed code at same rip */
+        byte changed[sizeof(test_code)];
+        memcpy(changed, test_code, sizeof(test_code));
+        changed[sizeof(test_code) - 1] = 0xe0;
+        ASSERT_TRUE(lookup(rvp, changed, sizeof(changed)) == NULL);
+
+        /* Fewer valid bytes than the block was decoded from */
+        ASSERT_TRUE(lookup(rvp, test_code, sizeof(test_code) - 2) == NULL);
+
+        /* Same code in another decoder mode or at another rip */
+        RIPVirtPhys kernel_rvp = rvp;
+        kernel_rvp.kernel = 1;
+        ASSERT_TRUE(lookup(kernel_rvp, test_code, sizeof(test_code)) == NULL);
+
+        RIPVirtPhys other_rvp = rvp;
+        other_rvp.rip += 0x1000;
+        ASSERT_TRUE(lookup(other_rvp, test_code, sizeof(test_code)) == NULL);
+
+        bbcache_file_save();
+        ASSERT_EQ(0, access(path.buf, R_OK));
+
+        bb->free();
+        unlink(path.buf);
+        config.bbcache_file.reset();
+    }
+
+    struct CodeSegment {
+        const byte* start;
+        W64 size;
+    };
+
+    /* First executable segment of this binary */
+    static int find_text(struct dl_phdr_info *info, size_t size, void *data)
+    {
+        CodeSegment& text = *(CodeSegment*)data;
+
+        foreach (i, info->dlpi_phnum) {
+            const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+            if (ph.p_type == PT_LOAD && (ph.p_flags & PF_X)) {
+                text.start = (const byte*)(info->dlpi_addr + ph.p_vaddr);
+                text.size = ph.p_filesz;
+                return 1;
+            }
+        }
+
+        return 0;
+    }
+
+    /*
+     * Cost of BasicBlockCache::translate() for a block that is decoded
+     * compared to one found in the basic block file, over the machine
+     * code of this binary. Not run by default, run with
+     * GTEST_ALSO_RUN_DISABLED_TESTS=1
+     * GTEST_FILTER=BBCacheFile.DISABLED_DecodeBenchmark
+     */
+    TEST(BBCacheFile, DISABLED_DecodeBenchmark)
+    {
+        stringbuf path;
+        setup_decoder_stats();
+        set_bbcache_file(path);
+
+        CodeSegment text = {NULL, 0};
+        dl_iterate_phdr(find_text, &text);
+        ASSERT_TRUE(text.start != NULL);
+
+        const W64 code_bytes = min(text.size, W64(256 * 1024));
+        dynarray<W64> rips;
+
+        CycleTimer decode_timer("decode");
+        CycleTimer file_timer("file");
+
+        RIPVirtPhys rvp;
+        setzero(rvp);
+        rvp.use64 = 1;
+
+        for (W64 offset = 0; offset < code_bytes - MAX_BB_BYTES; ) {
+            rvp.rip = (Waddr)(text.start + offset);
+
+            decode_timer.start();
+            BasicBlock* bb = decode_and_store(rvp, text.start + offset,
+                    text.size - offset);
+            decode_timer.stop();
+
+            rips.push(offset);
+            offset += max((int)bb->bytes, 1);
+            bb->free();
+        }
+
+        int file_hits = 0;
+        foreach (i, rips.count()) {
+            rvp.rip = (Waddr)(text.start + rips[i]);
+
+            file_timer.start();
+            BasicBlock* bb = lookup(rvp, text.start + rips[i],
+                    text.size - rips[i]);
+            file_timer.stop();
+
+            if (bb) {
+                file_hits++;
+                bb->free();
+            }
+        }
+
+        ASSERT_EQ(rips.count(), file_hits);
+
+        std::cout << "[ BENCH    ] " << rips.count() << " blocks: decode " <<
+            (double)decode_timer.cycles() / rips.count() << " file " <<
+            (double)file_timer.cycles() / rips.count() <<
+            " cycles/bb" << std::endl;
+
+        config.bbcache_file.reset();
+    }
+};
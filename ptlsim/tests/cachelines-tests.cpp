@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <ptlsim.h>
+#include <memoryHierarchy.h>
+#include <runtimeCacheLines.h>
+
+using namespace Memory;
+
+namespace {
+
+    typedef CacheLines<64, 8, 64, 2> TestTemplateLines;
+    typedef CacheLines<16, 20, 32, 2> TestOddWayLines;
+
+    /* Address stream with enough reuse to give both hits and evictions */
+    static W64 stream_addr(W64 i, int line_size, int lines)
+    {
+        W64 h = (i + 1) * 0x9e3779b97f4a7c15ULL;
+        W64 line = (h >> 20) % lines;
+        return (line * line_size) + ((h >> 8) % line_size);
+    }
+
+    /*
+     * Run same probe, insert and invalidate sequence through template and
+     * run time cache arrays of same geometry and compare every result
+     */
+    template <typename T>
+    static void compare_stream(T& fixed, RuntimeCacheLines& runtime,
+            int line_size, int lines, int count)
+    {
+        fixed.init();
+        runtime.init();
+
+        foreach(i, count) {
+            W64 addr = stream_addr(i, line_size, lines);
+            int op = (i * 7) % 10;
+
+            if(op < 6) {
+                CacheLine *f = fixed.T::base_t::probe(addr);
+                CacheLine *r = runtime.probe(addr);
+                ASSERT_EQ(f == NULL, r == NULL) << "probe " << i;
+                if(!f) {
+                    W64 f_old = -1, r_old = -1;
+                    f = fixed.T::base_t::select(addr, f_old);
+                    r = runtime.select(addr, r_old);
+                    ASSERT_EQ(f_old, r_old) << "evicted tag " << i;
+                    f->init(fixed.tagOf(addr));
+                    r->init(runtime.tagOf(addr));
+                }
+                ASSERT_EQ(f->tag, r->tag);
+            } else if(op < 9) {
+                W64 f_old = 0, r_old = 0;
+                CacheLine *f = fixed.T::base_t::select(addr, f_old);
+                CacheLine *r = runtime.select(addr, r_old);
+                ASSERT_EQ(f_old, r_old) << "select " << i;
+                f->init(fixed.tagOf(addr));
+                r->init(runtime.tagOf(addr));
+            } else {
+                ASSERT_EQ(fixed.T::base_t::invalidate(addr),
+                        runtime.invalidate(addr)) << "invalidate " << i;
+            }
+        }
+    }
+
+    TEST(RuntimeCacheLines, Geometry)
+    {
+        RuntimeCacheLines lines(64, 8, 64, 2, 2, 1);
+
+        ASSERT_EQ(64 * 8 * 64, lines.get_size());
+        ASSERT_EQ(64, lines.get_set_count());
+        ASSERT_EQ(8, lines.get_way_count());
+        ASSERT_EQ(6, lines.get_line_bits());
+        ASSERT_EQ(2, lines.get_access_latency());
+        ASSERT_EQ(2, lines.get_read_ports());
+        ASSERT_EQ(1, lines.get_write_ports());
+        ASSERT_EQ(0x1000, lines.tagOf(0x103f));
+        ASSERT_EQ(1, lines.set_of(0x1040));
+    }
+
+    TEST(RuntimeCacheLines, MatchesTemplate)
+    {
+        TestTemplateLines *fixed = new TestTemplateLines(2, 1);
+        RuntimeCacheLines runtime(64, 8, 64, 2, 2, 1);
+
+        compare_stream(*fixed, runtime, 64, 64 * 8 * 3, 200000);
+
+        delete fixed;
+    }
+
+    /* Way count that is not a multiple of SIMD width */
+    TEST(RuntimeCacheLines, MatchesTemplateOddWays)
+    {
+        TestOddWayLines *fixed = new TestOddWayLines(2, 1);
+        RuntimeCacheLines runtime(16, 20, 32, 2, 2, 1);
+
+        compare_stream(*fixed, runtime, 32, 16 * 20 * 2, 200000);
+
+        delete fixed;
+    }
+
+    TEST(RuntimeCacheLines, InvalidateAndReinsert)
+    {
+        RuntimeCacheLines lines(1, 4, 64, 2, 1, 1);
+        W64 old_tag = 0;
+
+        lines.init();
+        foreach(i, 4) {
+            CacheLine *line = lines.select(i * 64, old_tag);
+            line->init(lines.tagOf(i * 64));
+        }
+
+        ASSERT_TRUE(lines.probe(128) != NULL);
+        ASSERT_EQ(2, lines.invalidate(128));
+        ASSERT_TRUE(lines.probe(128) == NULL);
+        ASSERT_EQ(-1, lines.invalidate(128));
+
+        /* Victim is the lowest way without its MRU bit set, which is
+         * way 0 and not the invalidated way 2 */
+        old_tag = -1;
+        lines.select(4 * 64, old_tag);
+        ASSERT_EQ(0, old_tag);
+        ASSERT_EQ(0, lines.match(0, 4 * 64));
+        ASSERT_TRUE(lines.probe(W64(0)) == NULL);
+    }
+
+    /* Invalid geometry stops simulator also when asserts are disabled */
+    TEST(RuntimeCacheLines, InvalidGeometryIsFatal)
+    {
+        ASSERT_TRUE(RuntimeCacheLines::valid_geometry(16, 20, 32));
+        ASSERT_FALSE(RuntimeCacheLines::valid_geometry(48, 8, 64));
+        ASSERT_FALSE(RuntimeCacheLines::valid_geometry(64, 8, 48));
+        ASSERT_FALSE(RuntimeCacheLines::valid_geometry(64, 65, 64));
+        ASSERT_FALSE(RuntimeCacheLines::valid_geometry(0, 8, 64));
+
+        ASSERT_DEATH(RuntimeCacheLines(48, 8, 64, 2, 1, 1),
+                "Invalid cache geometry: 48 sets");
+    }
+};
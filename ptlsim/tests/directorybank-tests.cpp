@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <directoryBank.h>
+
+using namespace Memory;
+
+namespace {
+
+    static W64 line(W64 n)
+    {
+        return n * DIR_LINE_SIZE;
+    }
+
+    TEST(DirectoryBank, Interleave)
+    {
+        Directory b0(16, 2, 10, 0);
+        Directory b1(16, 2, 10, 0);
+        Directory b2(16, 2, 10, 0);
+
+        Directory::add_bank(&b0);
+        Directory::add_bank(&b1);
+        Directory::add_bank(&b2);
+        ASSERT_EQ(3, Directory::get_bank_count());
+
+        ASSERT_EQ(&b0, &Directory::get_bank(line(0)));
+        ASSERT_EQ(&b1, &Directory::get_bank(line(1)));
+        ASSERT_EQ(&b2, &Directory::get_bank(line(2)));
+        ASSERT_EQ(&b0, &Directory::get_bank(line(3) + 8));
+
+        /* Consecutive lines of a bank use all of its sets */
+        W64 old_tag;
+        foreach (i, 32) {
+            DirectoryEntry *e = b0.insert(line(i * 3), old_tag);
+            ASSERT_EQ((W64)-1, old_tag);
+            e->init(Directory::tag_of(line(i * 3)));
+        }
+        foreach (i, 32) {
+            ASSERT_TRUE(b0.probe(line(i * 3) + 4) != NULL);
+        }
+    }
+
+    TEST(DirectoryBank, Sizes)
+    {
+        Directory bank(4, 2, 10, 0);
+        Directory::add_bank(&bank);
+        W64 old_tag;
+
+        /* 8 entries hold 8 lines, the next one replaces one of them */
+        foreach (i, 8) {
+            bank.insert(line(i), old_tag)->init(line(i));
+            ASSERT_EQ((W64)-1, old_tag);
+        }
+        bank.insert(line(8), old_tag)->init(line(8));
+        ASSERT_EQ(line(0), old_tag);
+        ASSERT_TRUE(bank.probe(line(0)) == NULL);
+        ASSERT_TRUE(bank.probe(line(4)) != NULL);
+
+        ASSERT_EQ(4, bank.get_sets());
+        ASSERT_EQ(2, bank.get_ways());
+    }
+
+    TEST(DirectoryBank, SparseReplacement)
+    {
+        Directory bank(1, 4, 10, 0);
+        Directory::add_bank(&bank);
+        W64 old_tag;
+
+        DirectoryEntry *dirty0 = bank.insert(line(0), old_tag);
+        dirty0->init(line(0));
+        dirty0->present.set(0);
+        dirty0->dirty = 1;
+
+        DirectoryEntry *dirty1 = bank.insert(line(1), old_tag);
+        dirty1->init(line(1));
+        dirty1->present.set(0);
+        dirty1->dirty = 1;
+
+        DirectoryEntry *clean = bank.insert(line(2), old_tag);
+        clean->init(line(2));
+        clean->present.set(0);
+
+        /* No sharers left, replaced first even if recently used */
+        DirectoryEntry *unused = bank.insert(line(3), old_tag);
+        unused->init(line(3));
+
+        ASSERT_EQ(unused, bank.insert(line(4), old_tag));
+        ASSERT_EQ(line(3), old_tag);
+        unused->init(line(4));
+        unused->present.set(0);
+        unused->locked = 1;
+
+        /* Clean line needs no write back, replaced before dirty ones */
+        ASSERT_EQ(clean, bank.insert(line(5), old_tag));
+        ASSERT_EQ(line(2), old_tag);
+        clean->init(line(5));
+        clean->present.set(0);
+        clean->dirty = 1;
+
+        /* Same cost, least recently used goes first, locked stays */
+        bank.probe(line(0));
+        ASSERT_EQ(dirty1, bank.insert(line(6), old_tag));
+        ASSERT_EQ(line(1), old_tag);
+        dirty1->init(line(6));
+        dirty1->present.set(0);
+
+        /* Locked entries are replaced only when all ways are locked */
+        dirty0->locked = dirty1->locked = clean->locked = 1;
+        ASSERT_TRUE(bank.insert(line(7), old_tag) != NULL);
+        ASSERT_NE((W64)-1, old_tag);
+    }
+
+    TEST(DirectoryBank, LockedWithoutSharers)
+    {
+        Directory bank(1, 2, 10, 0);
+        Directory::add_bank(&bank);
+        W64 old_tag;
+
+        /* Locked in the middle of a transaction, no sharers yet */
+        DirectoryEntry *locked = bank.insert(line(0), old_tag);
+        locked->init(line(0));
+        locked->locked = 1;
+
+        DirectoryEntry *dirty = bank.insert(line(1), old_tag);
+        dirty->init(line(1));
+        dirty->present.set(0);
+        dirty->dirty = 1;
+
+        bank.probe(line(1));
+        ASSERT_EQ(dirty, bank.insert(line(2), old_tag));
+        ASSERT_EQ(line(1), old_tag);
+    }
+
+    TEST(DirectoryBank, Ports)
+    {
+        Directory unlimited(4, 2, 10, 0);
+        Directory ported(4, 2, 10, 2);
+        int wait;
+
+        foreach (i, 8) {
+            ASSERT_EQ(10, unlimited.access(100, wait));
+            ASSERT_EQ(0, wait);
+        }
+
+        /* Two accesses start each cycle, others queue */
+        ASSERT_EQ(10, ported.access(100, wait));
+        ASSERT_EQ(10, ported.access(100, wait));
+        ASSERT_EQ(11, ported.access(100, wait));
+        ASSERT_EQ(1, wait);
+        ASSERT_EQ(11, ported.access(100, wait));
+        ASSERT_EQ(12, ported.access(100, wait));
+        ASSERT_EQ(2, wait);
+
+        /* Queue drains when accesses are spread out */
+        ASSERT_EQ(10, ported.access(110, wait));
+        ASSERT_EQ(0, wait);
+    }
+};
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <eventQueue.h>
+
+using namespace Memory;
+
+namespace {
+
+    /*
+     * Synthetic memory hierarchy event stream. Most events are short
+     * cache hops, some are memory accesses and a few are far enough in
+     * future to go through EventWheel overflow heap.
+     */
+    struct StreamEntry {
+        W64 cycle;
+        int delay;
+        W64 id;
+    };
+
+    static int stream_delay(W64 id)
+    {
+        W64 h = id * 0x9e3779b97f4a7c15ULL;
+        int kind = (h >> 32) % 100;
+        int jitter = (h >> 16) & 0xffff;
+
+        if(kind < 60) return 1 + jitter % 8;
+        if(kind < 85) return 10 + jitter % 30;
+        if(kind < 97) return 100 + jitter % 200;
+        return 600 + jitter % 900;
+    }
+
+    static void build_stream(dynarray<StreamEntry>& stream, W64 cycles,
+            int per_cycle)
+    {
+        W64 id = 1;
+        stream.reserve(cycles * per_cycle);
+        foreach(c, cycles) {
+            foreach(i, per_cycle) {
+                StreamEntry e;
+                e.cycle = c;
+                e.delay = stream_delay(id);
+                e.id = id++;
+                stream.push(e);
+            }
+        }
+    }
+
+    /*
+     * Replays a stream into given queue type. Every third executed event
+     * schedules a follow-up event, like a cache forwarding a response to
+     * next level, so part of the stream is generated from signal handlers.
+     */
+    template <typename Q>
+    struct StreamReplay {
+        Q queue;
+        Signal signal;
+        W64 now;
+        dynarray<W64> executed;
+
+        StreamReplay() : signal("replay"), now(0) {
+            signal.connect(signal_mem_ptr(*this, &StreamReplay<Q>::handle));
+        }
+
+        bool handle(void *arg) {
+            W64 id = (W64)arg;
+            executed.push(id);
+            if((id % 3) == 0 && id < (W64(1) << 40)) {
+                W64 next = id | (W64(1) << 40);
+                queue.schedule(&signal, now + stream_delay(next),
+                        (void*)next);
+            }
+            return true;
+        }
+
+        void run(dynarray<StreamEntry>& stream, W64 drain_cycles) {
+            int idx = 0;
+            executed.reserve(stream.count() * 2);
+            W64 last = stream[stream.count() - 1].cycle + drain_cycles;
+            for(now = 0; now <= last; now++) {
+                queue.run_until(now);
+                while(idx < stream.count() && stream[idx].cycle == now) {
+                    queue.schedule(&signal, now + stream[idx].delay,
+                            (void*)stream[idx].id);
+                    idx++;
+                }
+            }
+        }
+    };
+
+    typedef ListEventQueue<4096> TestListQueue;
+    typedef EventWheel<512, 4096> TestEventWheel;
+
+    TEST(EventQueue, WheelMatchesListOrder)
+    {
+        dynarray<StreamEntry> stream;
+        build_stream(stream, 20000, 2);
+
+        StreamReplay<TestListQueue> *list = new StreamReplay<TestListQueue>();
+        StreamReplay<TestEventWheel> *wheel =
+            new StreamReplay<TestEventWheel>();
+
+        list->run(stream, 4000);
+        wheel->run(stream, 4000);
+
+        ASSERT_TRUE(list->queue.empty());
+        ASSERT_TRUE(wheel->queue.empty());
+        ASSERT_EQ(list->executed.count(), wheel->executed.count());
+        foreach(i, list->executed.count()) {
+            ASSERT_EQ(list->executed[i], wheel->executed[i]) <<
+                "Execution order differs at event " << i;
+        }
+
+        delete list;
+        delete wheel;
+    }
+
+    TEST(EventQueue, WheelSameCycleFIFO)
+    {
+        StreamReplay<TestEventWheel> *wheel =
+            new StreamReplay<TestEventWheel>();
+
+        /* Same clock scheduled from far (heap) and near (wheel) range */
+        wheel->queue.schedule(&wheel->signal, 1000, (void*)1);
+        wheel->queue.schedule(&wheel->signal, 1000, (void*)2);
+        wheel->queue.run_until(700);
+        wheel->queue.schedule(&wheel->signal, 1000, (void*)4);
+        ASSERT_EQ(1000, wheel->queue.next_event_clock());
+        wheel->queue.run_until(999);
+        ASSERT_EQ(0, wheel->executed.count());
+        wheel->queue.run_until(1000);
+
+        ASSERT_EQ(3, wheel->executed.count());
+        ASSERT_EQ(1, wheel->executed[0]);
+        ASSERT_EQ(2, wheel->executed[1]);
+        ASSERT_EQ(4, wheel->executed[2]);
+        ASSERT_EQ(W64(-1), wheel->queue.next_event_clock());
+
+        delete wheel;
+    }
+
+    /*
+     * Events scheduled behind the wheel, as done by cores that run behind
+     * in -sync-quantum mode, run once run_until reaches their own clock
+     */
+    TEST(EventQueue, WheelPastDueLocalTime)
+    {
+        StreamReplay<TestEventWheel> *wheel =
+            new StreamReplay<TestEventWheel>();
+
+        wheel->queue.run_until(100);
+        wheel->queue.schedule(&wheel->signal, 95, (void*)1);
+        wheel->queue.schedule(&wheel->signal, 98, (void*)2);
+        wheel->queue.schedule(&wheel->signal, 100, (void*)4);
+        wheel->queue.schedule(&wheel->signal, 97, (void*)5);
+        ASSERT_EQ(4, wheel->queue.count());
+
+        wheel->queue.run_until(96);
+        ASSERT_EQ(1, wheel->executed.count());
+        ASSERT_EQ(1, wheel->executed[0]);
+
+        wheel->queue.run_until(97);
+        ASSERT_EQ(2, wheel->executed.count());
+        ASSERT_EQ(5, wheel->executed[1]);
+
+        wheel->queue.run_until(99);
+        ASSERT_EQ(3, wheel->executed.count());
+        ASSERT_EQ(2, wheel->executed[2]);
+
+        wheel->queue.run_until(100);
+        ASSERT_EQ(4, wheel->executed.count());
+        ASSERT_EQ(4, wheel->executed[3]);
+        ASSERT_TRUE(wheel->queue.empty());
+
+        delete wheel;
+    }
+
+    /*
+     * Replay same recorded stream through both schedulers and report
+     * time taken by each. Not run by default, run with
+     * GTEST_ALSO_RUN_DISABLED_TESTS=1 GTEST_FILTER=EventQueue.DISABLED_Benchmark
+     */
+    TEST(EventQueue, DISABLED_Benchmark)
+    {
+        dynarray<StreamEntry> stream;
+        build_stream(stream, 50000, 8);
+
+        StreamReplay<TestListQueue> *list = new StreamReplay<TestListQueue>();
+        StreamReplay<TestEventWheel> *wheel =
+            new StreamReplay<TestEventWheel>();
+
+        CycleTimer list_timer("list");
+        CycleTimer wheel_timer("wheel");
+
+        list_timer.start();
+        list->run(stream, 4000);
+        list_timer.stop();
+
+        wheel_timer.start();
+        wheel->run(stream, 4000);
+        wheel_timer.stop();
+
+        ASSERT_EQ(list->executed.count(), wheel->executed.count());
+
+        std::cout << "[ BENCH    ] events: " << wheel->executed.count() <<
+            " list: " << list_timer.cycles() << " cycles, wheel: " <<
+            wheel_timer.cycles() << " cycles" << std::endl;
+
+        delete list;
+        delete wheel;
+    }
+};
@@ -61,4 +61,166 @@ namespace {
         W64 invalid = InvalidTag<W64>::INVALID;
         ASSERT_EQ(-1, invalid);
     }
+
+    /* Fill a set with distinct tags, leaving the last way invalid */
+    template <int ways>
+    static void fill_tags(FullyAssociativeTags<W64, ways>& tags, W64 seed)
+    {
+        tags.reset();
+        foreach(i, ways - 1) {
+            tags.select((seed + i * 0x1040) << 6);
+        }
+    }
+
+    template <int ways>
+    static void check_vector_match()
+    {
+        FullyAssociativeTags<W64, ways> tags;
+
+        foreach(seed, 64) {
+            fill_tags(tags, seed);
+
+            foreach(i, ways + 4) {
+                W64 target = (seed + i * 0x1040) << 6;
+                int expected = scalar_match_tags<W64, ways>(tags.tags,
+                        target);
+                ASSERT_EQ(expected, tags.match(target)) << ways <<
+                    " ways, tag " << i;
+                ASSERT_EQ((i < ways - 1) ? i : -1, tags.match(target));
+
+                W64 hits = x86_match_tags64(tags.tags, ways, target);
+                ASSERT_EQ((i < ways - 1) ? (W64(1) << i) : 0, hits);
+            }
+
+            /* Tag that differs from a valid tag only in upper half */
+            W64 target = ((seed << 6) | (W64(1) << 40));
+            ASSERT_EQ(-1, tags.match(target));
+        }
+    }
+
+    /* SIMD W64 way match gives same result as scalar match */
+    TEST(Logic, AssocTagsVectorMatch)
+    {
+        check_vector_match<4>();
+        check_vector_match<8>();
+        check_vector_match<16>();
+        check_vector_match<32>();
+
+        ASSERT_FALSE((FullyAssociativeTagMatch<W64, 6>::vectorized));
+        ASSERT_FALSE((FullyAssociativeTagMatch<W16, 16>::vectorized));
+    }
+
+    template <int ways>
+    static void bench_tag_probe()
+    {
+        const int sets = 1024;
+        const int probes = 1 << 22;
+        FullyAssociativeTags<W64, ways> *tags =
+            new FullyAssociativeTags<W64, ways>[sets];
+
+        foreach(i, sets) {
+            fill_tags(tags[i], i);
+        }
+
+        CycleTimer scalar_timer("scalar");
+        CycleTimer vector_timer("vector");
+        ASSERT_EQ(bool(VECTOR_TAG_MATCH64),
+                bool(FullyAssociativeTagMatch<W64, ways>::vectorized));
+        W64 scalar_hits = 0;
+        W64 vector_hits = 0;
+
+        /* Half of probes hit, hits are spread over all ways */
+        scalar_timer.start();
+        foreach(i, probes) {
+            int set = (i * 7) & (sets - 1);
+            W64 target = (set + ((i >> 1) % ways) * 0x1040) << 6;
+            scalar_hits += (scalar_match_tags<W64, ways>(tags[set].tags,
+                        target) >= 0);
+        }
+        scalar_timer.stop();
+
+        vector_timer.start();
+        foreach(i, probes) {
+            int set = (i * 7) & (sets - 1);
+            W64 target = (set + ((i >> 1) % ways) * 0x1040) << 6;
+            vector_hits += (tags[set].match(target) >= 0);
+        }
+        vector_timer.stop();
+
+        ASSERT_EQ(scalar_hits, vector_hits);
+
+        std::cout << "[ BENCH    ] " << ways << " ways: scalar " <<
+            (double)scalar_timer.cycles() / probes << " vector " <<
+            (double)vector_timer.cycles() / probes <<
+            " cycles/probe" << std::endl;
+
+        delete[] tags;
+    }
+
+    /*
+     * Probe throughput of W64 tags at each associativity. Not run by
+     * default, run with --gtest_also_run_disabled_tests
+     * --gtest_filter=Logic.DISABLED_AssocTagsProbeBenchmark
+     */
+    TEST(Logic, DISABLED_AssocTagsProbeBenchmark)
+    {
+        bench_tag_probe<4>();
+        bench_tag_probe<8>();
+        bench_tag_probe<16>();
+        bench_tag_probe<32>();
+    }
+    /* Address filter never misses a key within +-1 of an added key */
+    TEST(Logic, CountingAddressFilter)
+    {
+        CountingAddressFilter<64> filter;
+        ASSERT_FALSE(filter.probe_adjacent(0));
+
+        filter.add(100);
+        filter.add(100);
+        ASSERT_EQ(2, filter.count());
+        ASSERT_TRUE(filter.probe_adjacent(99));
+        ASSERT_TRUE(filter.probe_adjacent(100));
+        ASSERT_TRUE(filter.probe_adjacent(101));
+
+        filter.remove(100);
+        ASSERT_TRUE(filter.probe(100));
+        filter.remove(100);
+        ASSERT_FALSE(filter.probe_adjacent(100));
+        ASSERT_EQ(0, filter.count());
+
+        /* Wraps around like the signed 32-bit LSQ address compare */
+        filter.add(0);
+        ASSERT_TRUE(filter.probe_adjacent(0xffffffff));
+        filter.remove(0);
+
+        /* Random queue contents: any key the scan would find is found */
+        dynarray<W32> keys;
+        srand(7);
+        int skipped = 0;
+        foreach (i, 100000) {
+            if ((keys.count() < 32) && (rand() & 1)) {
+                W32 key = rand() % 4096;
+                keys.push(key);
+                filter.add(key);
+            } else if (keys.count()) {
+                int n = rand() % keys.count();
+                filter.remove(keys[n]);
+                keys[n] = keys[keys.count() - 1];
+                keys.pop();
+            }
+
+            W32 probe = rand() % 4096;
+            bool match = false;
+            foreach (j, keys.count()) {
+                int x = keys[j] - probe;
+                match |= (-1 <= x && x <= 1);
+            }
+            if (match) {
+                ASSERT_TRUE(filter.probe_adjacent(probe));
+            }
+            skipped += !filter.probe_adjacent(probe);
+        }
+        ASSERT_EQ(keys.count(), filter.count());
+        ASSERT_GT(skipped, 10000);
+    }
 };
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <meshNetwork.h>
+
+using namespace Memory;
+
+namespace {
+
+    /* Records deliveries and link usage, refuses delivery while blocked */
+    struct TestClient : public MeshClient {
+        W64 cycle;
+        bool blocked;
+        int delivered;
+        int credit_stalls;
+        W64 last_delivery;
+        int last_hops;
+        dynarray<int> order;
+        dynarray<int> link_flits;
+
+        TestClient(int nodes)
+            : cycle(0), blocked(false), delivered(0), credit_stalls(0)
+            , last_delivery(0), last_hops(0)
+        {
+            link_flits.resize(nodes * 4, 0);
+        }
+
+        bool mesh_deliver(MeshPacket &packet) {
+            if (blocked)
+                return false;
+            delivered++;
+            last_delivery = cycle - packet.inject_cycle;
+            last_hops = packet.hops;
+            order.push((int)(long)packet.payload);
+            return true;
+        }
+
+        void mesh_link_used(int node, int port, const MeshPacket &packet) {
+            link_flits[node * 4 + port] += packet.flits;
+        }
+
+        void mesh_credit_stall(const MeshPacket &packet) {
+            credit_stalls++;
+        }
+    };
+
+    static MeshConfig make_config(int width, int height)
+    {
+        MeshConfig config;
+        config.width = width;
+        config.height = height;
+        return config;
+    }
+
+    /* Clock network until it is empty or 'limit' cycles have passed */
+    static void run(MeshNetwork &mesh, TestClient &client, W64 limit)
+    {
+        W64 end = client.cycle + limit;
+        while (mesh.in_flight() && client.cycle < end) {
+            client.cycle++;
+            mesh.clock(client.cycle);
+        }
+    }
+
+    TEST(Mesh, ZeroLoadLatency)
+    {
+        MeshConfig config = make_config(4, 4);
+        MeshNetwork mesh;
+        TestClient client(16);
+        mesh.init(config, &client);
+
+        int pairs[][2] = { {0, 0}, {0, 1}, {0, 15}, {15, 0}, {5, 10},
+            {3, 12} };
+
+        foreach (i, 6) {
+            foreach (flits, 3) {
+                int src = pairs[i][0];
+                int dst = pairs[i][1];
+                ASSERT_TRUE(mesh.inject(src, dst, flits + 1, 0, NULL,
+                            client.cycle));
+                run(mesh, client, 100);
+                ASSERT_EQ(0, mesh.in_flight());
+                ASSERT_EQ(mesh.get_zero_load_latency(src, dst, flits + 1),
+                        (int)client.last_delivery);
+                ASSERT_EQ(mesh.get_hops(src, dst), client.last_hops);
+            }
+        }
+    }
+
+    TEST(Mesh, XYRouting)
+    {
+        MeshConfig config = make_config(4, 4);
+        MeshNetwork mesh;
+        TestClient client(16);
+        mesh.init(config, &client);
+
+        /* 0 -> 14: east twice along row 0, then south three times */
+        ASSERT_TRUE(mesh.inject(0, 14, 2, 0, NULL, client.cycle));
+        run(mesh, client, 100);
+        ASSERT_EQ(1, client.delivered);
+        ASSERT_EQ(5, client.last_hops);
+
+        ASSERT_EQ(2, client.link_flits[0 * 4 + MESH_EAST]);
+        ASSERT_EQ(2, client.link_flits[1 * 4 + MESH_EAST]);
+        ASSERT_EQ(2, client.link_flits[2 * 4 + MESH_SOUTH]);
+        ASSERT_EQ(2, client.link_flits[6 * 4 + MESH_SOUTH]);
+        ASSERT_EQ(2, client.link_flits[10 * 4 + MESH_SOUTH]);
+
+        int total = 0;
+        foreach (i, client.link_flits.count()) {
+            total += client.link_flits[i];
+        }
+        ASSERT_EQ(10, total);
+
+        /* Reverse path goes west first */
+        ASSERT_TRUE(mesh.inject(14, 0, 1, 0, NULL, client.cycle));
+        run(mesh, client, 100);
+        ASSERT_EQ(1, client.link_flits[14 * 4 + MESH_WEST]);
+        ASSERT_EQ(1, client.link_flits[13 * 4 + MESH_WEST]);
+        ASSERT_EQ(1, client.link_flits[12 * 4 + MESH_NORTH]);
+        ASSERT_EQ(1, client.link_flits[4 * 4 + MESH_NORTH]);
+    }
+
+    TEST(Mesh, CreditBackpressure)
+    {
+        MeshConfig config = make_config(2, 1);
+        config.vcs = 1;
+        config.vc_buffer = 4;
+        MeshNetwork mesh;
+        TestClient client(2);
+        mesh.init(config, &client);
+
+        client.blocked = true;
+
+        /* Destination buffer holds 4 flits and source buffer another 4,
+         * the rest can't be injected until destination accepts packets */
+        int injected = 0;
+        dynarray<int> ids;
+        foreach (i, 16) {
+            if (mesh.inject(0, 1, 2, 0, (void*)(long)i, client.cycle)) {
+                injected++;
+                ids.push(i);
+            }
+            client.cycle++;
+            mesh.clock(client.cycle);
+        }
+
+        ASSERT_EQ(4, injected);
+        ASSERT_EQ(4, mesh.in_flight());
+        ASSERT_EQ(0, client.delivered);
+        ASSERT_GT(client.credit_stalls, 0);
+        ASSERT_EQ(4, client.link_flits[0 * 4 + MESH_EAST]);
+
+        client.blocked = false;
+        run(mesh, client, 100);
+
+        ASSERT_EQ(0, mesh.in_flight());
+        ASSERT_EQ(4, client.delivered);
+        ASSERT_EQ(8, client.link_flits[0 * 4 + MESH_EAST]);
+
+        /* Packets of one virtual channel stay in order */
+        foreach (i, 4) {
+            ASSERT_EQ(ids[i], client.order[i]);
+        }
+    }
+
+    TEST(Mesh, VirtualChannelClasses)
+    {
+        MeshConfig config = make_config(2, 1);
+        config.vcs = 2;
+        config.vc_buffer = 2;
+        MeshNetwork mesh;
+        TestClient client(2);
+        mesh.init(config, &client);
+
+        client.blocked = true;
+
+        /* Fill class 0 channels with requests */
+        int requests = 0;
+        foreach (i, 8) {
+            if (mesh.inject(0, 1, 2, 0, (void*)(long)i, client.cycle))
+                requests++;
+            client.cycle++;
+            mesh.clock(client.cycle);
+        }
+        ASSERT_EQ(2, requests);
+        ASSERT_FALSE(mesh.inject(0, 1, 2, 0, NULL, client.cycle));
+
+        /* Responses still get in on class 1 */
+        ASSERT_TRUE(mesh.inject(0, 1, 2, 1, (void*)100L, client.cycle));
+
+        client.blocked = false;
+        run(mesh, client, 100);
+        ASSERT_EQ(3, client.delivered);
+        ASSERT_EQ(0, mesh.in_flight());
+    }
+
+    TEST(Mesh, PortContention)
+    {
+        MeshConfig config = make_config(3, 1);
+        MeshNetwork mesh;
+        TestClient client(3);
+        mesh.init(config, &client);
+
+        /* Two packets from same router to same output serialize on link */
+        ASSERT_TRUE(mesh.inject(0, 2, 1, 0, NULL, client.cycle));
+        ASSERT_TRUE(mesh.inject(0, 2, 1, 1, NULL, client.cycle));
+        run(mesh, client, 100);
+
+        ASSERT_EQ(2, client.delivered);
+        ASSERT_EQ(mesh.get_zero_load_latency(0, 2, 1) + 1,
+                (int)client.last_delivery);
+    }
+};
@@ -250,6 +250,7 @@ namespace {
         ASSERT_EQ(st, in);
         ASSERT_TRUE(cont->clear_entry);
         ASSERT_TRUE(cont->evict_upper);
+        ASSERT_TRUE(cont->update_lower);
         r();
     }
 
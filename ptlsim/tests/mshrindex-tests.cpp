@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <mshrIndex.h>
+
+using namespace Memory;
+
+namespace {
+
+    struct TestEntry : public FixStateListObject
+    {
+        W64 line;
+        int depends;
+        bool annuled;
+
+        void init() {
+            line = -1;
+            depends = -1;
+            annuled = false;
+        }
+    };
+
+    typedef IndexedStateList<TestEntry, 64> TestList;
+
+    /* Reference lookups that scan the used list, as done by the cache
+     * controllers before the index was added */
+    static TestEntry* scan_first(TestList& list, W64 line, TestEntry *skip)
+    {
+        TestEntry *entry;
+        foreach_list_mutable(list.list(), entry, e, ne) {
+            if(entry == skip || entry->annuled)
+                continue;
+            if(entry->line == line)
+                return entry;
+        }
+        return NULL;
+    }
+
+    static TestEntry* index_first(TestList& list, W64 line, TestEntry *skip)
+    {
+        TestEntry *entry;
+        foreach_indexed_mutable(list, line, entry, i, next_i) {
+            if(entry == skip || entry->annuled)
+                continue;
+            return entry;
+        }
+        return NULL;
+    }
+
+    static bool scan_contains(TestList& list, W64 line)
+    {
+        TestEntry *entry;
+        foreach_list_mutable(list.list(), entry, e, ne) {
+            if(entry->line == line)
+                return true;
+        }
+        return false;
+    }
+
+    static W64 next_rand(W64& state)
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    }
+
+    TEST(MSHRIndex, InsertOrder)
+    {
+        MSHRIndex<16> index;
+
+        index.insert(3, 100);
+        index.insert(7, 200);
+        index.insert(1, 100);
+        index.insert(9, 100);
+
+        ASSERT_EQ(3, index.first(100));
+        ASSERT_EQ(1, index.next(3));
+        ASSERT_EQ(9, index.next(1));
+        ASSERT_EQ(-1, index.next(9));
+        ASSERT_EQ(7, index.first(200));
+        ASSERT_EQ(-1, index.first(300));
+
+        index.remove(1);
+        ASSERT_EQ(9, index.next(3));
+        index.remove(3);
+        ASSERT_EQ(9, index.first(100));
+        index.remove(9);
+        ASSERT_FALSE(index.contains(100));
+        ASSERT_TRUE(index.contains(200));
+        ASSERT_EQ(1, index.count());
+
+        /* Removing an entry twice has no effect */
+        index.remove(9);
+        ASSERT_EQ(1, index.count());
+    }
+
+    /*
+     * Random alloc, free and annul of entries over a small set of lines,
+     * every lookup must return same entry as the list scan
+     */
+    TEST(MSHRIndex, MatchesListScan)
+    {
+        TestList *list = new TestList();
+        W64 state = 12345;
+
+        foreach(iter, 200000) {
+            int op = next_rand(state) % 8;
+            W64 line = next_rand(state) % 24;
+
+            if(op < 4) {
+                TestEntry *entry = list->alloc();
+                if(!entry)
+                    continue;
+                entry->line = line;
+                list->index(entry, line);
+
+                /* Chain new entry like CacheController::find_dependency */
+                TestEntry *dep = index_first(*list, line, entry);
+                ASSERT_EQ(scan_first(*list, line, entry), dep);
+                if(dep) {
+                    while(dep->depends >= 0)
+                        dep = &(*list)[dep->depends];
+                    dep->depends = entry->idx;
+                }
+            } else if(op < 7) {
+                TestEntry *entry = index_first(*list, line, NULL);
+                ASSERT_EQ(scan_first(*list, line, NULL), entry);
+                if(!entry)
+                    continue;
+
+                TestEntry *tmp;
+                foreach_indexed_mutable(*list, line, tmp, i, next_i) {
+                    if(tmp->depends == entry->idx)
+                        tmp->depends = entry->depends;
+                }
+                if(op == 6) {
+                    entry->annuled = true;
+                } else {
+                    list->free(entry);
+                }
+            } else {
+                /* Free all annuled entries of this line */
+                TestEntry *tmp;
+                foreach_indexed_mutable(*list, line, tmp, i, next_i) {
+                    if(tmp->annuled)
+                        list->free(tmp);
+                }
+            }
+
+            W64 probe = next_rand(state) % 24;
+            ASSERT_EQ(scan_contains(*list, probe), list->contains(probe));
+            ASSERT_EQ(scan_first(*list, probe, NULL),
+                    index_first(*list, probe, NULL));
+        }
+
+        /* Index must visit all entries of a line in list order */
+        foreach(line, 24) {
+            dynarray<int> scanned;
+            dynarray<int> indexed;
+            TestEntry *entry;
+            foreach_list_mutable(list->list(), entry, e, ne) {
+                if(entry->line == W64(line))
+                    scanned.push(entry->idx);
+            }
+            foreach_indexed_mutable(*list, line, entry, i, next_i) {
+                indexed.push(entry->idx);
+            }
+            ASSERT_EQ(scanned.count(), indexed.count());
+            foreach(j, scanned.count()) {
+                ASSERT_EQ(scanned[j], indexed[j]);
+            }
+        }
+
+        delete list;
+    }
+};
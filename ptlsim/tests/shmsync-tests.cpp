@@ -0,0 +1,341 @@
+
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <shmsync.h>
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sched.h>
+#include <time.h>
+
+namespace {
+
+    /* Unique segment name for each test process */
+    static const char* shm_name(const char *base)
+    {
+        static char name[64];
+        snprintf(name, sizeof(name), "/marss-test-%s-%d", base, getpid());
+        return name;
+    }
+
+    /* Run fn(i) in 'count' child processes, returns number of children
+     * that failed */
+    template <typename F>
+    static int run_processes(int count, F fn)
+    {
+        pid_t pids[16];
+        int failed = 0;
+
+        assert(count <= 16);
+
+        foreach (i, count) {
+            pids[i] = fork();
+            if (pids[i] == 0) {
+                _exit(fn(i) ? 0 : 1);
+            }
+        }
+
+        foreach (i, count) {
+            int status;
+            waitpid(pids[i], &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                failed++;
+        }
+
+        return failed;
+    }
+
+    static W64 now_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return W64(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+    TEST(ShmSync, BarrierLockStep)
+    {
+        const int procs = 4;
+        const int iterations = 2000;
+        const char *name = shm_name("barrier");
+
+        /* Per process progress, visible to all children */
+        volatile W64 *progress = (volatile W64*)mmap(NULL, 4096,
+                PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        ASSERT_NE(MAP_FAILED, (void*)progress);
+        memset((void*)progress, 0, 4096);
+
+        ShmBarrier barrier;
+        ASSERT_TRUE(barrier.open(name));
+        barrier.set_participants(procs);
+
+        int failed = run_processes(procs, [&](int id) {
+            ShmBarrier b;
+            if (!b.open(name))
+                return false;
+
+            foreach (i, iterations) {
+                progress[id] = i + 1;
+                if (!b.wait())
+                    return false;
+
+                /* No process can be a full barrier ahead or behind */
+                foreach (j, procs) {
+                    W64 p = progress[j];
+                    if (p < W64(i + 1) || p > W64(i + 2))
+                        return false;
+                }
+
+                if (!b.wait())
+                    return false;
+            }
+            return true;
+        });
+
+        ASSERT_EQ(0, failed);
+        ASSERT_EQ(0, barrier.get_arrived());
+        ASSERT_EQ(W32(iterations * 2), barrier.get_generation());
+
+        munmap((void*)progress, 4096);
+        ShmBarrier::unlink(name);
+    }
+
+    TEST(ShmSync, BarrierWakeSleepers)
+    {
+        const char *name = shm_name("wake");
+
+        ShmBarrier barrier;
+        ASSERT_TRUE(barrier.open(name));
+        barrier.set_participants(2);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            ShmBarrier b;
+            bool ok = b.open(name) && b.wait() && b.wait();
+            _exit(ok ? 0 : 1);
+        }
+
+        /* Give the child time to stop spinning and sleep */
+        usleep(200000);
+        ASSERT_EQ(1, barrier.get_sleepers());
+        ASSERT_TRUE(barrier.wait());
+
+        usleep(200000);
+        ASSERT_TRUE(barrier.wait());
+
+        int status;
+        waitpid(pid, &status, 0);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(0, WEXITSTATUS(status));
+
+        ShmBarrier::unlink(name);
+    }
+
+    TEST(ShmSync, BarrierLeaveReleases)
+    {
+        const char *name = shm_name("leave");
+
+        ShmBarrier barrier;
+        ASSERT_TRUE(barrier.open(name));
+        barrier.set_participants(2);
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            ShmBarrier b;
+            bool ok = b.open(name) && b.wait();
+            _exit(ok ? 0 : 1);
+        }
+
+        usleep(100000);
+        ASSERT_EQ(1, barrier.get_arrived());
+
+        /* Waiting child is the only participant left */
+        barrier.leave();
+
+        int status;
+        waitpid(pid, &status, 0);
+        ASSERT_TRUE(WIFEXITED(status));
+        ASSERT_EQ(0, WEXITSTATUS(status));
+        ASSERT_EQ(1, barrier.get_participants());
+        ASSERT_EQ(0, barrier.get_arrived());
+
+        ShmBarrier::unlink(name);
+    }
+
+    TEST(ShmSync, BarrierKill)
+    {
+        const char *name = shm_name("kill");
+
+        ShmBarrier barrier;
+        ASSERT_TRUE(barrier.open(name));
+        barrier.set_participants(3);
+
+        pid_t pids[2];
+        foreach (i, 2) {
+            pids[i] = fork();
+            if (pids[i] == 0) {
+                /* Barrier never completes, wait() must return false */
+                ShmBarrier b;
+                bool ok = b.open(name) && !b.wait() && !b.wait();
+                _exit(ok ? 0 : 1);
+            }
+        }
+
+        usleep(100000);
+        barrier.kill();
+        ASSERT_TRUE(barrier.killed());
+        ASSERT_FALSE(barrier.wait());
+
+        foreach (i, 2) {
+            int status;
+            waitpid(pids[i], &status, 0);
+            ASSERT_TRUE(WIFEXITED(status));
+            ASSERT_EQ(0, WEXITSTATUS(status));
+        }
+
+        ShmBarrier::unlink(name);
+    }
+
+    TEST(ShmSync, RingOrder)
+    {
+        const char *name = shm_name("ring");
+        const int count = 100000;
+
+        ShmRing ring;
+        ASSERT_TRUE(ring.open(name, 64, 16));
+        ASSERT_EQ(0, ring.count());
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            ShmRing r;
+            if (!r.open(name, 64, 16))
+                _exit(1);
+            foreach (i, count) {
+                W64 payload[2] = {W64(i), W64(i) * 3};
+                while (!r.push(i * 10, 7, payload, (i % 2) ? 16 : 8))
+                    sched_yield();
+            }
+            _exit(0);
+        }
+
+        foreach (i, count) {
+            const ShmPacket *p;
+            while ((p = ring.front()) == NULL)
+                sched_yield();
+
+            ASSERT_EQ(W64(i * 10), p->timestamp);
+            ASSERT_EQ(7, p->src);
+            ASSERT_EQ(W32((i % 2) ? 16 : 8), p->size);
+
+            const W64 *payload = (const W64*)p->data();
+            ASSERT_EQ(W64(i), payload[0]);
+            if (i % 2) {
+                ASSERT_EQ(W64(i) * 3, payload[1]);
+            }
+
+            ring.pop();
+        }
+
+        int status;
+        waitpid(pid, &status, 0);
+        ASSERT_EQ(0, WEXITSTATUS(status));
+        ASSERT_EQ(0, ring.count());
+        ASSERT_TRUE(ring.front() == NULL);
+
+        ShmRing::unlink(name);
+    }
+
+    TEST(ShmSync, RingFull)
+    {
+        const char *name = shm_name("full");
+        W64 data = 0;
+
+        ShmRing ring;
+        ASSERT_TRUE(ring.open(name, 4, 8));
+
+        foreach (i, 4) {
+            ASSERT_TRUE(ring.push(i, 0, &data, 8));
+        }
+        ASSERT_FALSE(ring.push(4, 0, &data, 8));
+        ASSERT_EQ(4, ring.count());
+
+        /* Too large for a slot */
+        ring.pop();
+        ASSERT_FALSE(ring.push(4, 0, &data, 64));
+        ASSERT_TRUE(ring.push(4, 0, &data, 8));
+
+        foreach (i, 4) {
+            ASSERT_EQ(W64(i + 1), ring.front()->timestamp);
+            ring.pop();
+        }
+
+        ShmRing::unlink(name);
+    }
+
+    /*
+     * Barrier latency of -sync with 'procs' instances for different sync
+     * intervals. One simulated cycle is modeled as a fixed amount of work.
+     * Not run by default, run with
+     * --gtest_also_run_disabled_tests --gtest_filter=ShmSync.DISABLED_Benchmark
+     */
+    TEST(ShmSync, DISABLED_Benchmark) {
+        const int procs = 4;
+        const W64 cycles = 1000000;
+        const int intervals[] = {1, 10, 100, 1000, 10000};
+        const char *name = shm_name("bench");
+
+        W64 *result = (W64*)mmap(NULL, 4096, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        ASSERT_NE(MAP_FAILED, (void*)result);
+
+        printf("%d processes, %lld cycles\n", procs, (long long)cycles);
+        printf("  interval  barriers    ns/barrier  total ms\n");
+
+        foreach (n, lengthof(intervals)) {
+            ShmBarrier::unlink(name);
+            ShmBarrier barrier;
+            ASSERT_TRUE(barrier.open(name));
+            barrier.set_participants(procs);
+
+            int interval = intervals[n];
+            int failed = run_processes(procs, [&](int id) {
+                ShmBarrier b;
+                if (!b.open(name))
+                    return false;
+
+                volatile W64 v = id;
+                W64 start = now_ns();
+                for (W64 c = 0; c < cycles; c++) {
+                    v = v * 6364136223846793005ULL + 1;
+                    if ((c + 1) % interval == 0 && !b.wait())
+                        return false;
+                }
+                if (id == 0)
+                    result[0] = now_ns() - start;
+                return true;
+            });
+            ASSERT_EQ(0, failed);
+
+            /* Same work without barriers */
+            volatile W64 v = 0;
+            W64 start = now_ns();
+            for (W64 c = 0; c < cycles; c++) {
+                v = v * 6364136223846793005ULL + 1;
+            }
+            W64 base = now_ns() - start;
+
+            W64 barriers = cycles / interval;
+            W64 total = result[0];
+            W64 overhead = (total > base) ? total - base : 0;
+            printf("  %8d  %8lld  %12.1f  %8.1f\n", interval,
+                    (long long)barriers, double(overhead) / barriers,
+                    double(total) / 1e6);
+        }
+
+        munmap(result, 4096);
+        ShmBarrier::unlink(name);
+    }
+};
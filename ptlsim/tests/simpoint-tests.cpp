@@ -0,0 +1,111 @@
+
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <bbv-profile.h>
+
+#include <sstream>
+
+namespace {
+
+    /* Interval of a program phase: blocks 'phase * 10 + 1' to
+     * 'phase * 10 + 10' with small per interval noise */
+    static void phase_interval(BBVector& bbv, int phase, int interval)
+    {
+        bbv.clear();
+        foreach (i, 10) {
+            BBVEntry e;
+            e.id = phase * 10 + i + 1;
+            e.count = 1000 * (i + 1) + ((interval * 7 + i * 13) % 50);
+            bbv.push(e);
+        }
+    }
+
+    TEST(Simpoint, FindsPhases)
+    {
+        SimpointClustering clustering(15, 10);
+        BBVector bbv;
+        int phase_of[60];
+
+        /* Phases 0, 1, 2 repeat in runs of 5 intervals */
+        foreach (i, 60) {
+            phase_of[i] = (i / 5) % 3;
+            phase_interval(bbv, phase_of[i], i);
+            clustering.add_interval(bbv);
+        }
+
+        ASSERT_EQ(60, clustering.interval_count());
+        ASSERT_EQ(3, clustering.cluster());
+
+        /* Intervals are in same cluster only if they are in same phase */
+        foreach (i, 60) {
+            foreach (j, 60) {
+                ASSERT_EQ(phase_of[i] == phase_of[j],
+                        clustering.get_cluster(i) == clustering.get_cluster(j));
+            }
+        }
+
+        double total = 0;
+        foreach (c, 3) {
+            int sp = clustering.get_simpoint(c);
+            ASSERT_EQ(c, clustering.get_cluster(sp));
+            ASSERT_DOUBLE_EQ(1.0 / 3, clustering.get_weight(c));
+            total += clustering.get_weight(c);
+        }
+        ASSERT_DOUBLE_EQ(1.0, total);
+    }
+
+    TEST(Simpoint, SinglePhase)
+    {
+        SimpointClustering clustering(15, 10);
+        BBVector bbv;
+
+        /* Every interval runs the same code */
+        foreach (i, 20) {
+            phase_interval(bbv, 4, 0);
+            clustering.add_interval(bbv);
+        }
+
+        ASSERT_EQ(1, clustering.cluster());
+        ASSERT_DOUBLE_EQ(1.0, clustering.get_weight(0));
+    }
+
+    TEST(Simpoint, WriteFormat)
+    {
+        SimpointClustering clustering(15, 4);
+        BBVector bbv;
+
+        /* Phase 1 first so clusters are written in interval order */
+        foreach (i, 8) {
+            phase_interval(bbv, (i < 6) ? 1 : 2, i);
+            clustering.add_interval(bbv);
+        }
+
+        ASSERT_EQ(2, clustering.cluster());
+
+        std::stringstream simpoints;
+        std::stringstream weights;
+        clustering.write(simpoints, weights);
+
+        int interval, id;
+        double weight;
+
+        simpoints >> interval >> id;
+        ASSERT_LT(interval, 6);
+        ASSERT_EQ(0, id);
+        simpoints >> interval >> id;
+        ASSERT_GE(interval, 6);
+        ASSERT_EQ(1, id);
+
+        weights >> weight >> id;
+        ASSERT_DOUBLE_EQ(0.75, weight);
+        ASSERT_EQ(0, id);
+        weights >> weight >> id;
+        ASSERT_DOUBLE_EQ(0.25, weight);
+        ASSERT_EQ(1, id);
+    }
+
+};
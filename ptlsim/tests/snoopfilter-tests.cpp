@@ -0,0 +1,609 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <snoopFilter.h>
+
+#include <memoryHierarchy.h>
+#include <coherentCache.h>
+#include <mesiLogic.h>
+#include <splitPhaseBus.h>
+#include <machine.h>
+
+using namespace Memory;
+using namespace Memory::CoherentCache;
+using namespace Memory::SplitPhaseBus;
+
+namespace {
+
+    TEST(SnoopFilter, Disabled)
+    {
+        SnoopFilter filter;
+        filter.init(0, 4);
+
+        ASSERT_FALSE(filter.enabled());
+        ASSERT_EQ((W64)-1, filter.lookup(0x1234));
+    }
+
+    TEST(SnoopFilter, AddInvalidate)
+    {
+        SnoopFilter filter;
+        filter.init(64, 4);
+        W64 victim, holders;
+
+        ASSERT_TRUE(filter.enabled());
+        ASSERT_EQ(0, filter.lookup(10));
+
+        ASSERT_FALSE(filter.add(10, 0, victim, holders));
+        ASSERT_FALSE(filter.add(10, 3, victim, holders));
+        ASSERT_EQ(W64(0x9), filter.lookup(10));
+        ASSERT_EQ(0, filter.lookup(11));
+        ASSERT_EQ(1, filter.count());
+
+        /* Write from 3 invalidates 0 */
+        filter.invalidate(10, W64(1) << 3);
+        ASSERT_EQ(W64(0x8), filter.lookup(10));
+
+        /* Entry is freed when last holder is removed */
+        filter.invalidate(10, 0);
+        ASSERT_EQ(0, filter.lookup(10));
+        ASSERT_EQ(0, filter.count());
+    }
+
+    TEST(SnoopFilter, ReplacementReturnsHolders)
+    {
+        SnoopFilter filter;
+        filter.init(8, 2);
+        W64 victim, holders;
+
+        /* 4 sets, lines 0, 4 and 8 map to set 0 */
+        ASSERT_FALSE(filter.add(0, 1, victim, holders));
+        ASSERT_FALSE(filter.add(4, 2, victim, holders));
+
+        /* Touch line 0 so line 4 is least recently used */
+        ASSERT_FALSE(filter.add(0, 5, victim, holders));
+
+        ASSERT_TRUE(filter.add(8, 0, victim, holders));
+        ASSERT_EQ(W64(4), victim);
+        ASSERT_EQ(W64(1) << 2, holders);
+
+        ASSERT_EQ(0, filter.lookup(4));
+        ASSERT_EQ(W64(0x22), filter.lookup(0));
+        ASSERT_EQ(W64(0x1), filter.lookup(8));
+
+        /* Freed entry is reused without replacement */
+        filter.invalidate(8, 0);
+        ASSERT_FALSE(filter.add(12, 3, victim, holders));
+    }
+
+    /*
+     * Functional MESI model of private caches on a bus, with the
+     * transitions tested in mesi.cpp: read snoop moves M and E to S, write
+     * snoop and evict invalidate, shared write hit evicts other copies and
+     * clean lines are replaced silently. The same trace is run with full
+     * broadcast and with snoop filter.
+     */
+    enum { I, S, E, M };
+
+    const int CACHES = 8;
+    const int LINES = 256;
+
+    struct BusModel {
+        SnoopFilter filter;
+        int state[CACHES][LINES];
+        int snoops;
+        int back_invalidations;
+
+        BusModel(int entries, int assoc)
+            : snoops(0), back_invalidations(0)
+        {
+            filter.init(entries, assoc);
+            memset(state, 0, sizeof(state));
+        }
+
+        bool target(int cache, int line) const {
+            return (filter.lookup(line) >> cache) & 1;
+        }
+
+        void add(int cache, int line) {
+            W64 victim, holders;
+            if (!filter.enabled())
+                return;
+            if (filter.add(line, cache, victim, holders)) {
+                back_invalidations++;
+                foreach (c, CACHES) {
+                    if ((holders >> c) & 1)
+                        state[c][victim] = I;
+                }
+            }
+        }
+
+        void read(int cache, int line) {
+            if (state[cache][line] != I)
+                return;
+
+            bool shared = false;
+            foreach (c, CACHES) {
+                if (c == cache || !target(c, line))
+                    continue;
+                snoops++;
+                if (state[c][line] != I) {
+                    state[c][line] = S;
+                    shared = true;
+                }
+            }
+            add(cache, line);
+            state[cache][line] = shared ? S : E;
+        }
+
+        void write(int cache, int line) {
+            int old = state[cache][line];
+            if (old == M || old == E) {
+                state[cache][line] = M;
+                return;
+            }
+
+            /* Shared write hit sends evict, miss sends write */
+            foreach (c, CACHES) {
+                if (c == cache || !target(c, line))
+                    continue;
+                snoops++;
+                state[c][line] = I;
+            }
+            if (old == I)
+                add(cache, line);
+            filter.invalidate(line, W64(1) << cache);
+            state[cache][line] = M;
+        }
+
+        /* Replacement: modified lines are written back, others dropped */
+        void replace(int cache, int line) {
+            state[cache][line] = I;
+        }
+    };
+
+    static void run_trace(BusModel &model, int ops, int seed)
+    {
+        srand(seed);
+        foreach (i, ops) {
+            int cache = rand() % CACHES;
+            /* Skew lines so some of them are shared */
+            int line = (rand() % 4) ? rand() % 16 : rand() % LINES;
+            switch (rand() % 8) {
+                case 0: case 1: case 2: case 3:
+                    model.read(cache, line);
+                    break;
+                case 4: case 5: case 6:
+                    model.write(cache, line);
+                    break;
+                default:
+                    model.replace(cache, line);
+            }
+        }
+    }
+
+    /* Every valid line must be in snoop filter */
+    static bool is_inclusive(BusModel &model)
+    {
+        foreach (c, CACHES) {
+            foreach (line, LINES) {
+                if (model.state[c][line] != I && !model.target(c, line))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    TEST(SnoopFilter, SameCoherenceOutcome)
+    {
+        BusModel broadcast(0, 0);
+        BusModel filtered(CACHES * LINES, SNOOP_FILTER_ASSOC);
+
+        run_trace(broadcast, 20000, 42);
+        run_trace(filtered, 20000, 42);
+
+        ASSERT_EQ(0, filtered.back_invalidations);
+        foreach (c, CACHES) {
+            foreach (line, LINES) {
+                ASSERT_EQ(broadcast.state[c][line], filtered.state[c][line]);
+            }
+        }
+
+        ASSERT_TRUE(is_inclusive(filtered));
+        ASSERT_LT(filtered.snoops, broadcast.snoops / 2);
+    }
+
+    TEST(SnoopFilter, InclusiveWithReplacement)
+    {
+        BusModel filtered(32, 4);
+
+        foreach (i, 50) {
+            run_trace(filtered, 200, i);
+            ASSERT_TRUE(is_inclusive(filtered));
+        }
+
+        ASSERT_GT(filtered.back_invalidations, 0);
+        ASSERT_LE(filtered.filter.count(), 32);
+    }
+
+    /*
+     * Private MESI caches on a BusInterconnect, with a memory that answers
+     * all misses. Caches are CacheControllers with the real MESILogic, so
+     * snoops, back-invalidations and write backs go through the bus.
+     */
+    const int BUS_CACHES = 4;
+    const int BUS_LINES = 16;
+    const int MEMORY_DELAY = 20;
+
+    static W64 line_addr(int line)
+    {
+        return W64(line) << SNOOP_FILTER_LINE_BITS;
+    }
+
+    /* Keeps line of each completed request to read its state */
+    class TraceMESILogic : public MESILogic
+    {
+        public:
+            TraceMESILogic(CacheController *cont, MemoryHierarchy *mem)
+                : MESILogic(cont, cont->get_stats(), mem)
+            {
+                memset(lines, 0, sizeof(lines));
+                memset(tags, 0, sizeof(tags));
+            }
+
+            void complete_request(CacheQueueEntry *queueEntry,
+                    Message &message)
+            {
+                MESILogic::complete_request(queueEntry, message);
+
+                int line = queueEntry->request->get_physical_address() >>
+                    SNOOP_FILTER_LINE_BITS;
+                lines[line] = queueEntry->line;
+                tags[line] = queueEntry->line->tag;
+            }
+
+            /* Line replaced by another address is invalid */
+            int state(int line) const {
+                if (!lines[line] || lines[line]->tag != tags[line])
+                    return MESI_INVALID;
+                return lines[line]->state;
+            }
+
+        private:
+            CacheLine *lines[BUS_LINES];
+            W64 tags[BUS_LINES];
+    };
+
+    /* Memory that answers reads and writes, and counts write backs */
+    class TestMemory : public Controller
+    {
+        public:
+            Interconnect *bus;
+            int writebacks[BUS_LINES];
+
+            TestMemory(MemoryHierarchy *mem)
+                : Controller(0, "snoop_test_memory", mem)
+                , bus(NULL)
+                , respond_("snoop_test_memory_respond")
+            {
+                respond_.connect(signal_mem_ptr(*this,
+                            &TestMemory::respond_cb));
+                memset(writebacks, 0, sizeof(writebacks));
+            }
+
+            bool handle_interconnect_cb(void *arg)
+            {
+                Message *message = (Message*)arg;
+                MemoryRequest *request = message->request;
+
+                switch (request->get_type()) {
+                    case MEMORY_OP_UPDATE:
+                        writebacks[request->get_physical_address() >>
+                            SNOOP_FILTER_LINE_BITS]++;
+                        break;
+                    case MEMORY_OP_READ:
+                    case MEMORY_OP_WRITE:
+                        /* Data broadcast of a completed request */
+                        if (message->hasData)
+                            break;
+                        request->incRefCounter();
+                        marss_add_event(&respond_, MEMORY_DELAY, request);
+                        break;
+                    default:
+                        break;
+                }
+                return true;
+            }
+
+            /* Request stays referenced until its response event */
+            void annul_request(MemoryRequest *request)
+            {
+                annuled_.push(request);
+            }
+
+            bool respond_cb(void *arg)
+            {
+                MemoryRequest *request = (MemoryRequest*)arg;
+
+                foreach (i, annuled_.count()) {
+                    if (annuled_[i] == request) {
+                        annuled_.remove(request);
+                        request->decRefCounter();
+                        return true;
+                    }
+                }
+
+                Message& message = *memoryHierarchy_->get_message();
+                message.sender = this;
+                message.request = request;
+                message.hasData = true;
+                message.isShared = false;
+                message.origin = NULL;
+                message.dest = NULL;
+                message.arg = NULL;
+                bus->get_controller_request_signal()->emit(&message);
+                memoryHierarchy_->free_message(&message);
+
+                request->decRefCounter();
+                return true;
+            }
+
+            void register_interconnect(Interconnect *interconnect,
+                    int type) {}
+            void print_map(ostream& os) {}
+            void print(ostream& os) const {}
+            bool is_full(bool fromInterconnect = false) const {
+                return false;
+            }
+            void dump_configuration(YAML::Emitter &out) const {}
+
+        private:
+            Signal respond_;
+            dynarray<MemoryRequest*> annuled_;
+    };
+
+    /* Upper interconnect of a cache, marks its request done on response */
+    class TestPort : public Interconnect
+    {
+        public:
+            MemoryRequest *request;
+            bool done;
+
+            TestPort(MemoryHierarchy *mem)
+                : Interconnect("snoop_test_port", mem)
+                , request(NULL)
+                , done(false)
+            {}
+
+            bool controller_request_cb(void *arg)
+            {
+                Message *message = (Message*)arg;
+                if (message->request == request)
+                    done = true;
+                return true;
+            }
+
+            void register_controller(Controller *controller) {}
+            int access_fast_path(Controller *controller,
+                    MemoryRequest *request) {
+                return -1;
+            }
+            void print_map(ostream& os) {}
+            void print(ostream& os) const {}
+            int get_delay() { return 0; }
+            void annul_request(MemoryRequest *request) {}
+            void dump_configuration(YAML::Emitter &out) const {}
+    };
+
+    struct BusSystem {
+        BaseMachine *machine;
+        MemoryHierarchy *mem;
+        MemoryHierarchy *saved_mem;
+        BusInterconnect *bus;
+        TestMemory *memory;
+        CacheController *caches[BUS_CACHES];
+        TraceMESILogic *logic[BUS_CACHES];
+        TestPort *ports[BUS_CACHES];
+
+        BusSystem(int filter_lines, int filter_assoc)
+        {
+            machine = (BaseMachine*)PTLsimMachine::getmachine("base");
+            machine->add_option("snoop_test_bus", "snoop_filter",
+                    filter_lines);
+            machine->add_option("snoop_test_bus", "snoop_filter_assoc",
+                    filter_assoc);
+
+            /* Events are added to memory hierarchy of the machine */
+            mem = new MemoryHierarchy(*machine);
+            saved_mem = machine->memoryHierarchyPtr;
+            machine->memoryHierarchyPtr = mem;
+
+            bus = new BusInterconnect("snoop_test_bus", mem);
+
+            foreach (i, BUS_CACHES) {
+                CacheController *cache = new CacheController(0,
+                        "snoop_test_cache", mem, CacheType(0));
+                cache->set_lowest_private(true);
+                cache->set_private(true);
+
+                logic[i] = new TraceMESILogic(cache, mem);
+                cache->set_coherence_logic(logic[i]);
+
+                ports[i] = new TestPort(mem);
+                cache->register_interconnect(ports[i], INTERCONN_TYPE_UPPER);
+                cache->register_interconnect(bus, INTERCONN_TYPE_LOWER);
+                bus->register_controller(cache);
+                caches[i] = cache;
+            }
+
+            memory = new TestMemory(mem);
+            memory->bus = bus;
+            bus->register_controller(memory);
+
+            mem->setup_full_flags();
+        }
+
+        ~BusSystem()
+        {
+            machine->memoryHierarchyPtr = saved_mem;
+        }
+
+        void run(int cycles)
+        {
+            foreach (i, cycles) {
+                sim_cycle++;
+                mem->clock();
+            }
+        }
+
+        /*
+         * Access line from cache and run until it completes and following
+         * write backs and evictions are done. Requests of each cache have
+         * their own rob id so bus and caches don't annul them as same.
+         */
+        bool access(int cache, int line, OP_TYPE type)
+        {
+            MemoryRequest *request = mem->get_free_request(0);
+            request->init(0, 0, line_addr(line), cache, sim_cycle, false,
+                    0, 0, type);
+            request->incRefCounter();
+
+            TestPort *port = ports[cache];
+            port->request = request;
+            port->done = false;
+
+            Message& message = *mem->get_message();
+            message.sender = port;
+            message.request = request;
+            message.hasData = false;
+            message.origin = NULL;
+            message.dest = NULL;
+            message.arg = NULL;
+            bool sent = caches[cache]->get_interconnect_signal()->
+                emit(&message);
+            mem->free_message(&message);
+
+            for (int i = 0; sent && !port->done && i < 1000; i++)
+                run(1);
+            run(200);
+
+            port->request = NULL;
+            request->decRefCounter();
+            return sent && port->done;
+        }
+
+        int state(int cache, int line) const {
+            return logic[cache]->state(line);
+        }
+    };
+
+    struct BusAccess {
+        int cache;
+        int line;
+        OP_TYPE type;
+    };
+
+    /* Transitions tested in mesi.cpp, driven through the bus */
+    static const BusAccess mesi_trace[] = {
+        /* Read miss gives E, read snoop moves E to S */
+        {0, 0, MEMORY_OP_READ},
+        {1, 0, MEMORY_OP_READ},
+        /* Write hit on S evicts other copies */
+        {1, 0, MEMORY_OP_WRITE},
+        /* Read snoop moves M to S and writes it back */
+        {2, 0, MEMORY_OP_READ},
+        /* Write miss snoops M and S copies */
+        {3, 0, MEMORY_OP_WRITE},
+        /* Write hit on E gives M, write snoop invalidates M */
+        {0, 1, MEMORY_OP_READ},
+        {0, 1, MEMORY_OP_WRITE},
+        {2, 1, MEMORY_OP_WRITE},
+        /* Dirty and shared lines in several caches */
+        {1, 2, MEMORY_OP_WRITE},
+        {2, 3, MEMORY_OP_WRITE},
+        {3, 4, MEMORY_OP_READ},
+        {0, 4, MEMORY_OP_READ},
+        {1, 5, MEMORY_OP_WRITE},
+        {2, 5, MEMORY_OP_READ},
+        {3, 6, MEMORY_OP_WRITE},
+        {0, 7, MEMORY_OP_READ},
+    };
+
+    static void run_bus_trace(BusSystem &sys)
+    {
+        foreach (i, sizeof(mesi_trace) / sizeof(mesi_trace[0])) {
+            const BusAccess &a = mesi_trace[i];
+            ASSERT_TRUE(sys.access(a.cache, a.line, a.type));
+        }
+    }
+
+    TEST(SnoopFilter, BusSameCoherenceOutcome)
+    {
+        BusSystem broadcast(0, SNOOP_FILTER_ASSOC);
+        run_bus_trace(broadcast);
+
+        ASSERT_EQ(MESI_MODIFIED, broadcast.state(3, 0));
+        ASSERT_EQ(MESI_INVALID, broadcast.state(0, 0));
+        ASSERT_EQ(MESI_INVALID, broadcast.state(1, 0));
+        ASSERT_EQ(MESI_MODIFIED, broadcast.state(2, 1));
+        ASSERT_EQ(MESI_INVALID, broadcast.state(0, 1));
+        ASSERT_EQ(MESI_SHARED, broadcast.state(0, 4));
+        ASSERT_EQ(MESI_SHARED, broadcast.state(3, 4));
+        ASSERT_EQ(MESI_SHARED, broadcast.state(1, 5));
+        ASSERT_EQ(MESI_SHARED, broadcast.state(2, 5));
+        ASSERT_EQ(MESI_EXCLUSIVE, broadcast.state(0, 7));
+
+        /* Snoop hits on M lines */
+        ASSERT_EQ(1, broadcast.memory->writebacks[0]);
+        ASSERT_EQ(1, broadcast.memory->writebacks[1]);
+        ASSERT_EQ(1, broadcast.memory->writebacks[5]);
+
+        BusSystem filtered(BUS_CACHES * BUS_LINES, SNOOP_FILTER_ASSOC);
+        run_bus_trace(filtered);
+
+        foreach (line, BUS_LINES) {
+            foreach (c, BUS_CACHES) {
+                ASSERT_EQ(broadcast.state(c, line), filtered.state(c, line));
+            }
+            ASSERT_EQ(broadcast.memory->writebacks[line],
+                    filtered.memory->writebacks[line]);
+        }
+    }
+
+    /* One set of 4 lines, line 8 written by cache 0 is replaced by line 12 */
+    static void run_back_invalidate_trace(BusSystem &sys)
+    {
+        ASSERT_TRUE(sys.access(0, 8, MEMORY_OP_WRITE));
+        ASSERT_TRUE(sys.access(0, 9, MEMORY_OP_WRITE));
+        for (int line = 10; line <= 12; line++) {
+            ASSERT_TRUE(sys.access(1, line, MEMORY_OP_READ));
+        }
+    }
+
+    TEST(SnoopFilter, BusBackInvalidateWritesBack)
+    {
+        /* Events go to the last created system, so run each in turn */
+        BusSystem broadcast(0, SNOOP_FILTER_ASSOC);
+        run_back_invalidate_trace(broadcast);
+
+        BusSystem filtered(4, 4);
+        run_back_invalidate_trace(filtered);
+
+        ASSERT_EQ(MESI_MODIFIED, broadcast.state(0, 8));
+        ASSERT_EQ(0, broadcast.memory->writebacks[8]);
+
+        /* Dirty data is written back, not lost */
+        ASSERT_EQ(MESI_INVALID, filtered.state(0, 8));
+        ASSERT_EQ(1, filtered.memory->writebacks[8]);
+
+        for (int line = 9; line <= 12; line++) {
+            foreach (c, BUS_CACHES) {
+                ASSERT_EQ(broadcast.state(c, line), filtered.state(c, line));
+            }
+            ASSERT_EQ(broadcast.memory->writebacks[line],
+                    filtered.memory->writebacks[line]);
+        }
+    }
+};
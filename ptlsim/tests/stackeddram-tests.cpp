@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <stackedDram.h>
+
+using namespace Memory;
+
+namespace {
+
+    /* Address of given row with default geometry, row is top 4 bits of
+     * 32 bit address */
+    static W64 row_addr(int row)
+    {
+        return W64(row) << 28;
+    }
+
+    TEST(StackedDram, SingleLayerOpenRow)
+    {
+        StackedDramConfig config;
+        StackedDram dram(STACKED_DRAM_SINGLE_LAYER, config);
+        bool hit;
+
+        ASSERT_EQ(45 + 90, dram.access(row_addr(1), false, hit));
+        ASSERT_FALSE(hit);
+        ASSERT_EQ(45 + 45, dram.access(row_addr(1) + 64, false, hit));
+        ASSERT_TRUE(hit);
+        ASSERT_EQ(45 + 45 + 90, dram.access(row_addr(1), true, hit));
+        ASSERT_TRUE(hit);
+        ASSERT_EQ(45 + 90 + 90, dram.access(row_addr(2), true, hit));
+        ASSERT_FALSE(hit);
+    }
+
+    TEST(StackedDram, MultiLayerReplacement)
+    {
+        StackedDramConfig config;
+        config.layers = 4;
+        StackedDram dram(STACKED_DRAM_MULTI_LAYER, config);
+        bool hit;
+
+        /* Rows fill layers in order and hit latency grows with layer */
+        foreach(i, 4) {
+            ASSERT_EQ(90, dram.access(row_addr(i), false, hit));
+            ASSERT_FALSE(hit);
+        }
+        foreach(i, 4) {
+            ASSERT_EQ(45 + 2 * (i + 1), dram.access(row_addr(i), false, hit));
+            ASSERT_TRUE(hit);
+        }
+
+        /* New rows replace layers in round robin order */
+        dram.access(row_addr(8), false, hit);
+        dram.access(row_addr(9), false, hit);
+        dram.access(row_addr(0), false, hit);
+        ASSERT_FALSE(hit);
+        dram.access(row_addr(3), false, hit);
+        ASSERT_TRUE(hit);
+        ASSERT_EQ(45 + 4, dram.access(row_addr(9), false, hit));
+    }
+
+    TEST(StackedDram, VaultTilesLatency)
+    {
+        StackedDramConfig config;
+        StackedDram dram(STACKED_DRAM_VAULT_TILES, config);
+        bool hit;
+
+        ASSERT_EQ(64, dram.get_buffer_count());
+
+        /* Tiles are used in round robin order */
+        ASSERT_EQ(90 + 4, dram.access(row_addr(5), false, hit));
+        ASSERT_EQ(45 + 2 + 4 + 2, dram.access(row_addr(5), false, hit));
+        ASSERT_TRUE(hit);
+        ASSERT_EQ(90 + 4 + 4, dram.access(row_addr(6), false, hit));
+        ASSERT_EQ(45 + 2 + 4 + 6, dram.access(row_addr(6), false, hit));
+
+        dram.reset();
+        ASSERT_EQ(90 + 4, dram.access(row_addr(5), false, hit));
+        ASSERT_FALSE(hit);
+    }
+
+    TEST(StackedDram, InvalidGeometryIsFatal)
+    {
+        StackedDramConfig config;
+        config.banks = 6;
+        ASSERT_DEATH(StackedDram(STACKED_DRAM_SINGLE_LAYER, config),
+                "Invalid stacked DRAM option dram_banks: 6");
+
+        config = StackedDramConfig();
+        config.size_bits = 10;
+        ASSERT_DEATH(StackedDram(STACKED_DRAM_SINGLE_LAYER, config),
+                "Invalid stacked DRAM option dram_size_bits: 10");
+    }
+
+    TEST(StackedDram, OrgNames)
+    {
+        foreach(i, NUM_STACKED_DRAM_ORGS) {
+            ASSERT_EQ(i, get_stacked_dram_org(stacked_dram_org_names[i]));
+        }
+        ASSERT_EQ(-1, get_stacked_dram_org("compare_all"));
+    }
+};
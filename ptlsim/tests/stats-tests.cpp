@@ -5,8 +5,13 @@
 #define DISABLE_ASSERT
 #include <ptlsim.h>
 #include <statsBuilder.h>
+#include <timeStatsWriter.h>
 
 #include <sstream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <unistd.h>
 #define reset_stream(os) { os.str(""); }
         using std::ostringstream;
 
@@ -318,4 +323,248 @@ namespace {
 
 		ASSERT_EQ(ct1_val, 10);
 	}
+
+    /* Decoder of TimeStatsWriter files, same as mstats time_stats plugin */
+    struct TimeStatsFile {
+        std::vector<std::string> names;
+        std::vector<int> types;
+        std::vector<W64> cycles;
+        std::vector<std::vector<W64> > rows;
+        W64 period;
+    };
+
+    static W64 get_varint(std::istream& is)
+    {
+        W64 value = 0;
+        int shift = 0;
+        int c;
+
+        do {
+            c = is.get();
+            value |= W64(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+
+        return value;
+    }
+
+    static bool read_time_stats(const char *filename, TimeStatsFile& f)
+    {
+        std::ifstream is(filename, std::ios::binary);
+        W64 magic, freq;
+        W32 version, count;
+
+        is.read((char*)&magic, 8);
+        is.read((char*)&version, 4);
+        is.read((char*)&count, 4);
+        is.read((char*)&f.period, 8);
+        is.read((char*)&freq, 8);
+
+        if (!is || magic != TIME_STATS_MAGIC || version != TIME_STATS_VERSION)
+            return false;
+
+        foreach (i, count) {
+            W8 type;
+            W16 len;
+            is.read((char*)&type, 1);
+            is.read((char*)&len, 2);
+            std::string name(len, ' ');
+            is.read(&name[0], len);
+            f.names.push_back(name);
+            f.types.push_back(type);
+        }
+
+        W64 cycle = 0;
+        std::vector<W64> last(count, 0);
+
+        while (is.peek() != EOF) {
+            int rows = get_varint(is);
+            int first = f.rows.size();
+
+            foreach (r, rows) {
+                cycle += get_varint(is);
+                f.cycles.push_back(cycle);
+                f.rows.push_back(std::vector<W64>(count));
+            }
+
+            foreach (i, count) {
+                foreach (r, rows) {
+                    W64 value;
+                    if (f.types[i]) {
+                        is.read((char*)&value, 8);
+                    } else {
+                        W64 z = get_varint(is);
+                        value = last[i] + ((z >> 1) ^ -(z & 1));
+                        last[i] = value;
+                    }
+                    f.rows[first + r][i] = value;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST(Stats, TimeStatsBinary) {
+        StatsBuilder &builder = StatsBuilder::get();
+        builder.delete_nodes();
+        user_stats->reset();
+        kernel_stats->reset();
+
+        TestStat st;
+
+        st.ct1.set_default_stats(kernel_stats);
+        st.ct2.set_default_stats(user_stats);
+        st.ct3.set_default_stats(user_stats);
+        st.time_arr.set_default_stats(user_stats);
+        st.ct3.enable_periodic_dump();
+        st.sum.enable_periodic_dump();
+        st.div.enable_periodic_dump();
+        st.time_arr.enable_periodic_dump(1);
+
+        char filename[] = "/tmp/time-stats-XXXXXX";
+        int fd = mkstemp(filename);
+        ASSERT_TRUE(fd >= 0);
+        close(fd);
+
+        /* More rows than one block, with decreasing counters */
+        const int rows = TIME_STATS_BLOCK_ROWS * 2 + 17;
+        TimeStatsWriter *writer = new TimeStatsWriter(filename, 100, 1000000000);
+
+        foreach (i, rows) {
+            st.ct1 += i % 7;
+            st.ct2 += 3;
+            if (i % 3) st.ct3++; else st.ct3--;
+            st.time_arr[1] += i * 1000;
+            writer->snapshot((i + 1) * 100, user_stats, kernel_stats);
+        }
+
+        delete writer;
+
+        TimeStatsFile f;
+        ASSERT_TRUE(read_time_stats(filename, f));
+        unlink(filename);
+
+        ASSERT_EQ(100, f.period);
+        ASSERT_EQ(6, f.names.size());
+        ASSERT_STREQ("test.ct1", f.names[0].c_str());
+        ASSERT_STREQ("test.ct2", f.names[1].c_str());
+        ASSERT_STREQ("test.ct3", f.names[2].c_str());
+        ASSERT_STREQ("test.sum", f.names[3].c_str());
+        ASSERT_STREQ("test.div", f.names[4].c_str());
+        ASSERT_STREQ("test.time_arr.1", f.names[5].c_str());
+        ASSERT_EQ(1, f.types[4]);
+        ASSERT_EQ(rows, f.rows.size());
+
+        foreach (i, rows) {
+            std::vector<W64>& row = f.rows[i];
+            double div;
+            memcpy(&div, &row[4], sizeof(div));
+
+            ASSERT_EQ((i + 1) * 100, f.cycles[i]);
+            ASSERT_EQ(i % 7, row[0]);
+            ASSERT_EQ(3, row[1]);
+            ASSERT_EQ((i % 3) ? 1 : W64(-1), row[2]);
+            ASSERT_EQ((i % 7) + 3, row[3]);
+            ASSERT_EQ(double(i % 7) / 3.0, div);
+            ASSERT_EQ(i * 1000, row[5]);
+        }
+    }
+
+    TEST(Stats, BulkOperations) {
+        StatsBuilder &builder = StatsBuilder::get();
+        builder.delete_nodes();
+
+        TestStat st;
+        Stats *a = builder.get_new_stats();
+        Stats *b = builder.get_new_stats();
+
+        /* Counters and other objects are in separate regions */
+        ASSERT_TRUE(st.ct1.is_counter());
+        ASSERT_TRUE(st.arr1.is_counter());
+        ASSERT_FALSE(st.st1.is_counter());
+        ASSERT_FALSE(st.div.is_counter());
+        ASSERT_EQ((10 + 3 + 3 + 1) * sizeof(W64), builder.get_counter_size());
+
+        st.set_default_stats(a);
+        st.ct1 += 5;
+        st.arr1[9] += 7;
+        st.time_arr[2] += 3;
+        st.st1 = "copied";
+
+        *b = *a;
+        ASSERT_EQ(5, st.ct1(b));
+        ASSERT_EQ(7, st.arr1(b)[9]);
+        ASSERT_EQ(3, st.time_arr(b)[2]);
+        ASSERT_STREQ("copied", st.st1(b));
+
+        *b += *a;
+        ASSERT_EQ(10, st.ct1(b));
+        ASSERT_EQ(14, st.arr1(b)[9]);
+        ASSERT_EQ(6, st.time_arr(b)[2]);
+
+        builder.sub_stats(*b, *a);
+        ASSERT_EQ(5, st.ct1(b));
+        ASSERT_EQ(7, st.arr1(b)[9]);
+
+        b->reset();
+        ASSERT_EQ(0, st.ct1(b));
+        ASSERT_EQ(0, st.time_arr(b)[2]);
+        ASSERT_STREQ("", st.st1(b));
+
+        st.set_default_stats(user_stats);
+        builder.destroy_stats(a);
+        builder.destroy_stats(b);
+    }
+
+    /*
+     * Time bulk Stats operations with about as many counters as a four
+     * core machine. Not run by default, run with
+     * --gtest_also_run_disabled_tests --gtest_filter=Stats.DISABLED_Benchmark
+     */
+    TEST(Stats, DISABLED_Benchmark) {
+        StatsBuilder &builder = StatsBuilder::get();
+        builder.delete_nodes();
+
+        Statable root("bench");
+        dynarray<StatArray<W64, 256>*> arrays;
+        dynarray<StatString*> strings;
+
+        foreach (i, 48) {
+            arrays.push(new StatArray<W64, 256>("arr", &root));
+            strings.push(new StatString("str", &root));
+        }
+
+        arrays[0]->enable_periodic_dump();
+        builder.init_timer_stats();
+
+        Stats *a = builder.get_new_stats();
+        Stats *b = builder.get_new_stats();
+        CycleTimer t_reset, t_copy, t_add, t_periodic;
+        std::ostringstream os;
+        const int iterations = 1000;
+
+        foreach (i, iterations) {
+            t_reset.start(); a->reset(); t_reset.stop();
+            t_copy.start(); *b = *a; t_copy.stop();
+            t_add.start(); *a += *b; t_add.stop();
+            t_periodic.start(); builder.dump_periodic(os, i); t_periodic.stop();
+            reset_stream(os);
+        }
+
+        printf("Stats used %lld bytes, cycles per operation:\n",
+                (long long)builder.get_used_size());
+        printf("  reset          %10lld\n", (long long)(t_reset.cycles() / iterations));
+        printf("  copy           %10lld\n", (long long)(t_copy.cycles() / iterations));
+        printf("  add            %10lld\n", (long long)(t_add.cycles() / iterations));
+        printf("  periodic dump  %10lld\n", (long long)(t_periodic.cycles() / iterations));
+
+        builder.destroy_stats(a);
+        builder.destroy_stats(b);
+
+        foreach (i, arrays.count()) {
+            delete arrays[i];
+            delete strings[i];
+        }
+    }
 };
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <storesets.h>
+
+using namespace Core;
+
+namespace {
+
+    typedef StoreSetPredictor<1024, 64> Predictor;
+
+    TEST(StoreSets, NoPrediction)
+    {
+        Predictor pred;
+        W64 uuid;
+        int tag;
+
+        ASSERT_EQ(-1, pred.get_ssid(0x400000));
+        ASSERT_EQ(-1, pred.rename_store(0x400010, 1, 0));
+        ASSERT_FALSE(pred.rename_load(0x400000, uuid, tag));
+    }
+
+    TEST(StoreSets, ViolationCreatesDependency)
+    {
+        Predictor pred;
+        W64 load = 0x400000, store = 0x400010;
+        W64 uuid;
+        int tag;
+
+        pred.violation(load, store);
+        ASSERT_NE(-1, pred.get_ssid(load));
+        ASSERT_EQ(pred.get_ssid(load), pred.get_ssid(store));
+
+        /* Load renamed after the store waits for it */
+        int ssid = pred.rename_store(store, 100, 5);
+        ASSERT_EQ(pred.get_ssid(store), ssid);
+        ASSERT_TRUE(pred.rename_load(load, uuid, tag));
+        ASSERT_EQ(W64(100), uuid);
+        ASSERT_EQ(5, tag);
+
+        /* Only the last renamed store of the set is removed */
+        pred.rename_store(store, 101, 6);
+        pred.resolve_store(ssid, 100);
+        ASSERT_TRUE(pred.rename_load(load, uuid, tag));
+        ASSERT_EQ(W64(101), uuid);
+
+        pred.resolve_store(ssid, 101);
+        ASSERT_FALSE(pred.rename_load(load, uuid, tag));
+
+        /* Unrelated load is not delayed */
+        pred.rename_store(store, 102, 7);
+        ASSERT_FALSE(pred.rename_load(0x400020, uuid, tag));
+    }
+
+    TEST(StoreSets, MergeSets)
+    {
+        Predictor pred;
+        W64 load1 = 0x1000, store1 = 0x1010;
+        W64 load2 = 0x2000, store2 = 0x2010;
+
+        pred.violation(load1, store1);
+        pred.violation(load2, store2);
+        ASSERT_NE(pred.get_ssid(load1), pred.get_ssid(load2));
+
+        /* Store without a set joins the set of the load */
+        pred.violation(load1, 0x3010);
+        ASSERT_EQ(pred.get_ssid(load1), pred.get_ssid(0x3010));
+
+        /* Two sets merge into the smaller one */
+        int smaller = min(pred.get_ssid(load1), pred.get_ssid(store2));
+        pred.violation(load1, store2);
+        ASSERT_EQ(smaller, pred.get_ssid(load1));
+        ASSERT_EQ(smaller, pred.get_ssid(store2));
+    }
+
+    TEST(StoreSets, Clear)
+    {
+        Predictor pred;
+        W64 uuid;
+        int tag;
+
+        pred.violation(0x1000, 0x1010);
+        pred.rename_store(0x1010, 1, 0);
+        pred.clear();
+
+        ASSERT_EQ(-1, pred.get_ssid(0x1000));
+        ASSERT_FALSE(pred.rename_load(0x1000, uuid, tag));
+    }
+
+    /* More aliasing loads than the 8 entry alias table holds */
+    TEST(StoreSets, ManyAliasingLoads)
+    {
+        Predictor pred;
+        const int pairs = 32;
+        W64 uuid;
+        int tag;
+
+        foreach (i, pairs) {
+            pred.violation(0x400000 + i * 0x20, 0x400010 + i * 0x20);
+        }
+
+        foreach (i, pairs) {
+            pred.rename_store(0x400010 + i * 0x20, 1000 + i, i);
+        }
+        foreach (i, pairs) {
+            ASSERT_TRUE(pred.rename_load(0x400000 + i * 0x20, uuid, tag));
+            ASSERT_EQ(W64(1000 + i), uuid);
+            ASSERT_EQ(i, tag);
+        }
+    }
+};
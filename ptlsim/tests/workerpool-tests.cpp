@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#define DISABLE_ASSERT
+
+#include <globals.h>
+#include <superstl.h>
+#include <workerpool.h>
+
+namespace {
+
+    struct JobState {
+        int runs[64];
+        pthread_t thread[64];
+        W64 result[64];
+    };
+
+    static void count_job(void *arg, int job)
+    {
+        JobState *state = (JobState*)arg;
+        state->runs[job]++;
+        state->thread[job] = pthread_self();
+
+        /* Some work that depends only on the job index */
+        W64 v = job + 1;
+        foreach (i, 1000) {
+            v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        state->result[job] = v;
+    }
+
+    TEST(WorkerPool, RunsEachJobOnce)
+    {
+        WorkerPool pool(4);
+        JobState state;
+        memset(&state, 0, sizeof(state));
+
+        foreach (iter, 1000) {
+            pool.run(count_job, &state, 10);
+        }
+
+        foreach (i, 10) {
+            ASSERT_EQ(1000, state.runs[i]);
+        }
+        foreach (i, 54) {
+            ASSERT_EQ(0, state.runs[10 + i]);
+        }
+    }
+
+    TEST(WorkerPool, DeterministicAssignment)
+    {
+        WorkerPool pool(3);
+        JobState first;
+        JobState state;
+        memset(&first, 0, sizeof(first));
+
+        pool.run(count_job, &first, 9);
+
+        /* Caller runs jobs of thread 0 */
+        ASSERT_TRUE(pthread_equal(pthread_self(), first.thread[0]));
+        ASSERT_TRUE(pthread_equal(pthread_self(), first.thread[3]));
+
+        foreach (iter, 100) {
+            memset(&state, 0, sizeof(state));
+            pool.run(count_job, &state, 9);
+
+            foreach (i, 9) {
+                ASSERT_EQ(first.result[i], state.result[i]);
+                ASSERT_TRUE(pthread_equal(first.thread[i], state.thread[i]));
+                ASSERT_TRUE(pthread_equal(state.thread[i % 3],
+                            state.thread[i]));
+            }
+        }
+    }
+
+    TEST(WorkerPool, WakeUpAfterSleep)
+    {
+        WorkerPool pool(2);
+        JobState state;
+        memset(&state, 0, sizeof(state));
+
+        pool.run(count_job, &state, 2);
+
+        /* Give the worker time to stop spinning and sleep */
+        usleep(200000);
+
+        pool.run(count_job, &state, 2);
+        ASSERT_EQ(2, state.runs[0]);
+        ASSERT_EQ(2, state.runs[1]);
+    }
+};
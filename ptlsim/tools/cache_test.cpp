@@ -9,6 +9,7 @@
 
 #include <memoryRequest.h>
 #include <memoryHierarchy.h>
+#include <runtimeCacheLines.h>
 #include <test.h>
 
 using namespace Memory;
@@ -339,6 +340,106 @@ void test_strip()
 	}
 }
 
+/*
+ * Compare probe and insert throughput of compile time CacheLines and
+ * RuntimeCacheLines with same geometry (32K 8-way L1 and 2M 16-way L3),
+ * on an address stream with roughly 80% hits
+ */
+template <typename T>
+static W64 bench_template_lines(T& lines, W64 *addrs, int count, int rounds)
+{
+	W64 hits = 0;
+	W64 old_tag;
+
+	lines.init();
+	foreach(r, rounds) {
+		foreach(i, count) {
+			if(lines.T::base_t::probe(addrs[i]))
+				hits++;
+			else
+				lines.T::base_t::select(addrs[i], old_tag);
+		}
+	}
+
+	return hits;
+}
+
+static W64 bench_runtime_lines(RuntimeCacheLines& lines, W64 *addrs,
+		int count, int rounds)
+{
+	W64 hits = 0;
+	W64 old_tag;
+
+	lines.init();
+	foreach(r, rounds) {
+		foreach(i, count) {
+			if(lines.probe(addrs[i]))
+				hits++;
+			else
+				lines.select(addrs[i], old_tag);
+		}
+	}
+
+	return hits;
+}
+
+template <typename T>
+static void bench_cachelines(const char *name, int size, int ways,
+		int line_size)
+{
+	const int count = 1 << 20;
+	const int rounds = 8;
+	int lines_in_cache = size / line_size;
+	W64 *addrs = new W64[count];
+
+	foreach(i, count) {
+		W64 h = (i + 1) * 0x9e3779b97f4a7c15ULL;
+		/* 4 of 5 accesses go to a footprint that fits in cache */
+		W64 range = ((h >> 60) < 13) ? (lines_in_cache / 2) :
+			(lines_in_cache * 16);
+		addrs[i] = ((h >> 16) % range) * line_size;
+	}
+
+	T *fixed = new T(2, 1);
+	RuntimeCacheLines *runtime = new RuntimeCacheLines(
+			size / (ways * line_size), ways, line_size, 2, 2, 1);
+
+	CycleTimer fixed_timer("template");
+	CycleTimer runtime_timer("runtime");
+
+	fixed_timer.start();
+	W64 fixed_hits = bench_template_lines(*fixed, addrs, count, rounds);
+	fixed_timer.stop();
+
+	runtime_timer.start();
+	W64 runtime_hits = bench_runtime_lines(*runtime, addrs, count, rounds);
+	runtime_timer.stop();
+
+	assert(fixed_hits == runtime_hits);
+
+	W64 accesses = W64(count) * rounds;
+	cout << name, ": ", accesses, " accesses, ", fixed_hits, " hits", endl;
+	cout << "  template: ", (double)fixed_timer.cycles() / accesses,
+		 " cycles/access", endl;
+	cout << "  runtime : ", (double)runtime_timer.cycles() / accesses,
+		 " cycles/access", endl;
+
+	delete fixed;
+	delete runtime;
+	delete[] addrs;
+}
+
+void test_cachelines_throughput()
+{
+	cout << "Testing CacheLines throughput", endl;
+
+	bench_cachelines<CacheLines<64, 8, 64, 2> >("32K 8-way", 32*1024, 8, 64);
+	bench_cachelines<CacheLines<2048, 16, 64, 2> >("2M 16-way",
+			2*1024*1024, 16, 64);
+
+	cout << "Done..", endl;
+}
+
 int main(int argc, char *argv[])
 {
 
@@ -358,6 +459,11 @@ int main(int argc, char *argv[])
 
 	memory->print_map(ptl_logfile);
 
+	if(argc == 2 && !strcmp(argv[1], "--cachelines")) {
+		test_cachelines_throughput();
+		return 0;
+	}
+
 	if(argc == 2) {
 		test_trace(memory, argv[1]);
 		memory->dump_info(ptl_logfile);
@@ -394,7 +394,9 @@ def write_option_logic(st, of, name, opt, val):
     of.write(st % (name, opt, val))
 
 def get_cache_cfg(config, name):
-    for cache in config["caches"]:
+    # Memory controllers can also have an instance per core, for example
+    # banks of a distributed directory
+    for cache in config["caches"] + config.get("memory", []):
         if cache["name_prefix"] == name:
             return cache
     return None
@@ -434,6 +436,13 @@ def write_cont_logic(config, m_conf, of, n1, n2):
             of.write(machine_for_each_num_loop_i %
                     int(cache["insts"]))
 
+        # Memory controller params are runtime options shared by all
+        # instances of this type, per instance options override them
+        if n2 == "memory" and cache_cfg.has_key("params"):
+            for key,val in cache_cfg["params"].items():
+                write_option_logic(machine_option_add_i, of, name_pfx,
+                        key, val)
+
         # Check if there are any options to add
         if cache.has_key("option"):
             for key,val in cache["option"].items():
@@ -2,119 +2,94 @@
  * sync_helper.cpp : A small helper tool for Marss's -sync option
  *
  * This small tool is aimed to help Marss users in -sync option by
- * providing options to manipulate semaphore used for syncing between
- * simulation instances.  Available options are:
+ * providing options to manipulate the shared memory barrier used for
+ * syncing between simulation instances.  Available options are:
  *
- *    delete   :  Delete the semaphore
- *    set N    :  Set semaphore value to N
+ *    delete   :  Delete the barrier, waiting instances will exit
+ *    set N    :  Set number of instances taking part in the barrier to N
  *
  * To compile:
- *    $ g++ sync_helper.cpp -o sync_helper
+ *    $ g++ -DNUM_SIM_CORES=1 -DDISABLE_ASSERT -I../sim -I../lib \
+ *          sync_helper.cpp ../lib/shmsync.cpp -o sync_helper -lrt
  */
 
 
-#include <iostream>
-
-#include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/sem.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <errno.h>
 
-using namespace std;
+#include <shmsync.h>
 
-#define SEM_NUM 3764
+#define SYNC_ID 3764
 
-void info(int sem_id)
+void info(ShmBarrier& barrier)
 {
-    int rc;
-
-    rc = semctl(sem_id, 0, GETVAL);
-    cout << "Semaphore value: " << rc << endl;
-
-    rc = semctl(sem_id, 0, GETZCNT);
-    cout << "Processes waiting for zero: " << rc << endl;
+    printf("Instances: %d\n", barrier.get_participants());
+    printf("Instances waiting: %d\n", barrier.get_arrived());
+    printf("Instances sleeping: %d\n", barrier.get_sleepers());
+    printf("Generation: %u\n", barrier.get_generation());
+    if (barrier.killed())
+        printf("Barrier is deleted\n");
 }
 
-void remove(int sem_id)
+void remove(ShmBarrier& barrier, const char* name)
 {
-    int rc;
-
-    rc = semctl(sem_id, 0, IPC_RMID);
+    barrier.kill();
 
-    if (rc != 0) {
-        cout << "Unable to delete semaphore: ";
-        perror("sem_id");
+    if (!ShmBarrier::unlink(name)) {
+        printf("Unable to delete barrier: ");
+        perror(name);
         return;
     }
 
-    cout << "Semaphore removed." << endl;
+    printf("Barrier removed.\n");
 }
 
-void set(int sem_id, int val)
+void set(ShmBarrier& barrier, int val)
 {
-    int rc;
-
-    rc = semctl(sem_id, 0, SETVAL, val);
-
-    if (rc != 0) {
-        cout << "Unable to set semaphore value: ";
-        perror("sem_id");
-        return;
-    }
-
-    cout << "Semaphore value set to " << val << endl;
+    barrier.set_participants(val);
+    printf("Instances set to %d\n", val);
 }
 
 int main(int argc, char** argv)
 {
-    char *env_sem_id_p;
-    int sem_num;
-    int sem_id;
+    char *env_sync_id_p;
+    int sync_id;
+    char name[64];
+    ShmBarrier barrier;
     int val;
-    int rc;
-
-    /* First check if semaphore exists or not */
 
-    env_sem_id_p = getenv("MARSS_SEM_ID");
+    env_sync_id_p = getenv("MARSS_SEM_ID");
 
-    if (env_sem_id_p)
-        sem_num = atoi(env_sem_id_p);
+    if (env_sync_id_p)
+        sync_id = atoi(env_sync_id_p);
     else
-        sem_num = SEM_NUM;
+        sync_id = SYNC_ID;
 
-    sem_id = semget(sem_num, 1, IPC_CREAT|IPC_EXCL|0666);
+    snprintf(name, sizeof(name), "/marss-sync-%d", sync_id);
 
-    if (sem_id == -1) {
-        if (errno == EEXIST) {
-            sem_id = semget(sem_num, 1, IPC_CREAT|0666);
-        }
-
-        if (sem_id == -1) {
-            cout << "Unable to access semaphore.\n";
-            perror("sem_id");
-            exit(0);
-        }
+    if (!barrier.open(name)) {
+        printf("Unable to access barrier.\n");
+        perror(name);
+        exit(0);
     }
 
-    info(sem_id);
+    info(barrier);
 
     if (argc < 2)
         return 0;
 
     if (strcmp("delete", argv[1]) == 0) {
-        remove(sem_id);
+        remove(barrier, name);
     } else if (strcmp("set", argv[1]) == 0) {
 
         if (argc < 3) {
-            cout << "Please specify the value to set.\n";
+            printf("Please specify the value to set.\n");
             return -1;
         }
 
         val = atoi(argv[2]);
-        set(sem_id, val);
+        set(barrier, val);
     }
 
     return 0;
@@ -0,0 +1,301 @@
+/*
+ * MARSSx86 : A Full System Computer-Architecture Simulator
+ *
+ * This code is released under GPL.
+ *
+ */
+
+//
+// Persistent file of decoded basic blocks (-bbcache-file).
+//
+// Translations are appended to an in memory index as they are decoded
+// and written to the file when simulation is shut down. The file is
+// memory mapped on first use in the next run, so runs from the same
+// checkpoint skip decoding of code they have already seen.
+//
+// A record is found by rip and decoder mode and is used only if the
+// code bytes fetched for the new translation have the same CRC32 as
+// the code it was decoded from, so records of code that changed or of
+// another program at same address are never used.
+//
+// File layout is the raw BasicBlock image of this build, so header
+// checks sizes of BasicBlockBase and TransOp and files written by a
+// different build are ignored.
+//
+
+#include <globals.h>
+#include <ptlsim.h>
+#include <decode.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const W64 BBCACHE_FILE_MAGIC = 0x434242535352414dULL; // "MARSSBBC"
+static const W32 BBCACHE_FILE_VERSION = 1;
+
+struct BBCacheFileHeader {
+    W64 magic;
+    W32 version;
+    W32 base_size;
+    W32 transop_size;
+    W32 count;
+    W64 pad;
+};
+
+struct BBCacheRecord {
+    W64 rip;
+    W32 mode;
+    W32 code_crc;
+    W16 bytes;
+    W16 transops;
+    // Size of record including this header, multiple of 16 bytes
+    W32 size;
+    W64 pad;
+
+    BasicBlock* image() const {
+        return (BasicBlock*)(this + 1);
+    }
+};
+
+static const BBCacheRecord** records = NULL;
+static W32* chain = NULL;
+static int record_count = 0;
+static int record_capacity = 0;
+
+static W32* buckets = NULL;
+static int bucket_count = 0;
+
+static int loaded_count = 0;
+static void* file_map = NULL;
+static size_t file_map_size = 0;
+static bool file_loaded = false;
+
+static const W32 NO_RECORD = 0xffffffff;
+
+//
+// Decoder state that, besides code bytes, changes the translation
+//
+static W32 decoder_mode(const TraceDecoder& trans) {
+    return (trans.use64 << 0) | (trans.use32 << 1) | (trans.ss32 << 2) |
+        (trans.kernel << 3) | (trans.dirflag << 4) | (trans.pe << 5) |
+        (trans.vm86 << 6) | (((trans.hflags & HF_SVMI_MASK) != 0) << 7) |
+        (((trans.hflags & HF_SVME_MASK) != 0) << 8);
+}
+
+static inline int bucket_of(W64 rip) {
+    return lowbits(rip ^ (rip >> 13) ^ (rip >> 29), lsbindex64(bucket_count));
+}
+
+static void rehash(int new_bucket_count) {
+    delete[] buckets;
+    bucket_count = new_bucket_count;
+    buckets = new W32[bucket_count];
+
+    foreach (i, bucket_count) buckets[i] = NO_RECORD;
+
+    foreach (i, record_count) {
+        int b = bucket_of(records[i]->rip);
+        chain[i] = buckets[b];
+        buckets[b] = i;
+    }
+}
+
+static void index_record(const BBCacheRecord* rec) {
+    if unlikely (record_count == record_capacity) {
+        int capacity = max(record_capacity * 2, 4096);
+        const BBCacheRecord** new_records = new const BBCacheRecord*[capacity];
+        W32* new_chain = new W32[capacity];
+
+        foreach (i, record_count) {
+            new_records[i] = records[i];
+            new_chain[i] = chain[i];
+        }
+
+        delete[] records;
+        delete[] chain;
+        records = new_records;
+        chain = new_chain;
+        record_capacity = capacity;
+    }
+
+    records[record_count++] = rec;
+
+    if unlikely (record_count > bucket_count) {
+        rehash(max(bucket_count * 2, 8192));
+    } else {
+        int b = bucket_of(rec->rip);
+        chain[record_count - 1] = buckets[b];
+        buckets[b] = record_count - 1;
+    }
+}
+
+static void load_file() {
+    file_loaded = true;
+
+    int fd = open(config.bbcache_file.buf, O_RDONLY);
+    if (fd < 0) {
+        ptl_logfile << "Basic block file ", config.bbcache_file,
+                    " not found: starting with empty file", endl;
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(BBCacheFileHeader)) {
+        close(fd);
+        return;
+    }
+
+    void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        ptl_logfile << "Unable to map basic block file ", config.bbcache_file, endl;
+        return;
+    }
+
+    const BBCacheFileHeader* header = (const BBCacheFileHeader*)map;
+    if (header->magic != BBCACHE_FILE_MAGIC ||
+            header->version != BBCACHE_FILE_VERSION ||
+            header->base_size != sizeof(BasicBlockBase) ||
+            header->transop_size != sizeof(TransOp)) {
+        ptl_logfile << "Basic block file ", config.bbcache_file,
+                    " is from a different simulator build: ignored", endl;
+        munmap(map, st.st_size);
+        return;
+    }
+
+    file_map = map;
+    file_map_size = st.st_size;
+
+    size_t offset = sizeof(BBCacheFileHeader);
+
+    foreach (i, header->count) {
+        const BBCacheRecord* rec = (const BBCacheRecord*)((byte*)map + offset);
+
+        if (offset + sizeof(BBCacheRecord) > file_map_size) break;
+        if (rec->size < sizeof(BBCacheRecord) + sizeof(BasicBlockBase) +
+                rec->transops * sizeof(TransOp)) break;
+        if (offset + rec->size > file_map_size) break;
+
+        index_record(rec);
+        offset += rec->size;
+    }
+
+    loaded_count = record_count;
+
+    ptl_logfile << "Loaded ", loaded_count, " basic blocks from ",
+                config.bbcache_file, endl;
+}
+
+//
+// Find a translation of the code in insnbuf, fetched by trans.fillbuf()
+//
+BasicBlock* bbcache_file_lookup(const TraceDecoder& trans, const byte* insnbuf) {
+    if likely (!config.bbcache_file.set()) return NULL;
+    if unlikely (!file_loaded) load_file();
+    if unlikely (!record_count) return NULL;
+
+    W64 rip = trans.bb.rip.rip;
+    W32 mode = decoder_mode(trans);
+
+    for (W32 i = buckets[bucket_of(rip)]; i != NO_RECORD; i = chain[i]) {
+        const BBCacheRecord* rec = records[i];
+
+        if (rec->rip != rip || rec->mode != mode) continue;
+        if (rec->bytes > trans.valid_byte_count) continue;
+        if (CRC32().update((byte*)insnbuf, rec->bytes) != rec->code_crc) continue;
+
+        BasicBlock* bb = rec->image()->clone();
+        bb->rip = trans.bb.rip;
+        return bb;
+    }
+
+    return NULL;
+}
+
+//
+// Add a new translation to the file
+//
+void bbcache_file_store(const TraceDecoder& trans, const BasicBlock* bb) {
+    if likely (!config.bbcache_file.set()) return;
+
+    size_t image_size = sizeof(BasicBlockBase) + (bb->count * sizeof(TransOp));
+    size_t size = ceil(sizeof(BBCacheRecord) + image_size, 16);
+
+    BBCacheRecord* rec = (BBCacheRecord*)malloc(size);
+    memset(rec, 0, size);
+
+    rec->rip = bb->rip.rip;
+    rec->mode = decoder_mode(trans);
+    rec->code_crc = bb->code_crc;
+    rec->bytes = bb->bytes;
+    rec->transops = bb->count;
+    rec->size = size;
+
+    BasicBlock* image = rec->image();
+    memcpy(image, bb, image_size);
+
+    // Only the translation is saved, not cache or pipeline state
+    image->hashlink.reset();
+    image->mfnlo_loc.reset();
+    image->mfnhi_loc.reset();
+    image->synthops = NULL;
+    image->refcount = 0;
+    image->hitcount = 0;
+    image->predcount = 0;
+    image->confidence = 0;
+    image->lastused = 0;
+    image->lasttarget = 0;
+    image->context_id = 0;
+    image->flush_epoch = 0;
+    image->successors[0] = NULL;
+    image->successors[1] = NULL;
+    image->link_generation = 0;
+
+    index_record(rec);
+}
+
+//
+// Write all known translations to the file. A new file is written and
+// renamed so other runs that use the same file never see a partial one.
+//
+void bbcache_file_save() {
+    if (!config.bbcache_file.set() || record_count == loaded_count) return;
+
+    stringbuf tmpname;
+    tmpname << config.bbcache_file, ".", getpid();
+
+    std::ofstream os(tmpname.buf, std::ios::binary);
+    if (!os) {
+        ptl_logfile << "Unable to write basic block file ", tmpname, endl;
+        return;
+    }
+
+    BBCacheFileHeader header;
+    setzero(header);
+    header.magic = BBCACHE_FILE_MAGIC;
+    header.version = BBCACHE_FILE_VERSION;
+    header.base_size = sizeof(BasicBlockBase);
+    header.transop_size = sizeof(TransOp);
+    header.count = record_count;
+    os.write((const char*)&header, sizeof(header));
+
+    foreach (i, record_count) {
+        os.write((const char*)records[i], records[i]->size);
+    }
+
+    os.close();
+
+    if (os.fail() || rename(tmpname.buf, config.bbcache_file.buf) < 0) {
+        ptl_logfile << "Unable to write basic block file ", config.bbcache_file, endl;
+        unlink(tmpname.buf);
+        return;
+    }
+
+    ptl_logfile << "Saved ", record_count, " basic blocks (",
+                (record_count - loaded_count), " new) to ", config.bbcache_file, endl;
+
+    loaded_count = record_count;
+}
@@ -13,6 +13,9 @@
 
 BasicBlockCache bbcache[NUM_SIM_CORES];
 W8 BasicBlockCache::cpuid_counter = 0;
+BasicBlockCache shared_bbcache(0);
+W32 bbcache_flush_epoch = 0;
+W32 bbcache_link_generation = 0;
 
 struct BasicBlockChunkListHashtableLinkManager {
     static inline BasicBlockChunkList* objof(selflistlink* link) {
@@ -1683,14 +1686,180 @@ bool assist_invalid_opcode(Context& ctx) {
 
 static const bool log_code_page_ops = 0;
 
+static inline W64 bb_footprint(const BasicBlock* bb) {
+    return sizeof(BasicBlockBase) + (bb->count * sizeof(TransOp));
+}
+
+//
+// Update size of cached BBs of the core that translated bb
+//
+static void account_bb_bytes(const BasicBlock* bb, bool insert) {
+    BasicBlockCache& owner = bbcache[bb->context_id];
+    W64 size = bb_footprint(bb);
+
+    // BBs added to a cache directly instead of by translate() were
+    // never counted
+    if (insert) owner.bytes += size;
+    else owner.bytes -= min(owner.bytes, size);
+
+    if (decoder_stats[owner.cpuid])
+        decoder_stats[owner.cpuid]->bbcache_bytes = owner.bytes;
+}
+
+//
+// Select the cache that holds BBs at rvp: the shared cache, or this
+// per-core cache if physical page of rvp is unknown. In the latter case
+// rvp is changed to the per-core key.
+//
+BasicBlockCache& BasicBlockCache::table_for(Context& ctx, RIPVirtPhys& rvp) {
+    if unlikely (rvp.mfnlo == RIPVirtPhys::INVALID) {
+        //
+        // Code page is not in the TLB: walk the page tables like
+        // fillbuf() would and look it up again
+        //
+        byte insnbyte;
+        PageFaultErrorCode pfec;
+        Waddr faultaddr;
+        if (ctx.copy_from_vm(&insnbyte, rvp.rip, 1, pfec, faultaddr, true) == 1)
+            rvp.update(ctx);
+    }
+
+    if unlikely (rvp.mfnlo == RIPVirtPhys::INVALID) {
+        rvp.mfnlo = 0;
+        rvp.mfnhi = 0;
+        return *this;
+    }
+
+    shared_bbcache.cpuid = cpuid;
+    return shared_bbcache;
+}
+
+//
+// Code page lists are global, so when invalidating a page the shared
+// cache may also find BBs of per-core caches on it.
+//
+BasicBlockCache& BasicBlockCache::owner_of(BasicBlock* bb) {
+    if likely (this != &shared_bbcache) return *this;
+
+    return (get(bb->rip) == bb) ? *this : bbcache[bb->context_id];
+}
+
+//
+// With -lazy-bbcache-flush a guest TLB flush only starts a new flush
+// epoch. A BB translated in an older epoch is used again if the code
+// bytes at its rip are the same in the current address space, otherwise
+// it is invalidated. Code pages are not write protected for the
+// simulator, so a recycled physical page can hold new code under an
+// old mfn; comparing the bytes also covers that case. The same bytes
+// decode differently in another mode (e.g. a compat mode process at the
+// same rip), so the mode in rvp must match too.
+//
+bool BasicBlockCache::revalidate(Context& ctx, BasicBlock* bb, const RIPVirtPhys& rvp) {
+    if likely (bb->flush_epoch == bbcache_flush_epoch) return true;
+
+    if unlikely ((bb->rip.use64 != rvp.use64) || (bb->rip.kernel != rvp.kernel) ||
+            (bb->rip.df != rvp.df)) {
+        if unlikely (!invalidate(bb, INVALIDATE_REASON_STALE)) retire(bb);
+        return false;
+    }
+
+    byte insnbuf[MAX_BB_BYTES];
+    PageFaultErrorCode pfec;
+    Waddr faultaddr;
+    int bytes = min((int)bb->bytes, MAX_BB_BYTES);
+    int n = ctx.copy_from_vm(insnbuf, bb->rip, bytes, pfec, faultaddr, true);
+
+    if likely ((n == bytes) && (CRC32().update(insnbuf, n) == bb->code_crc)) {
+        bb->flush_epoch = bbcache_flush_epoch;
+        DECODERSTAT->redecodes_avoided++;
+        return true;
+    }
+
+    if unlikely (!invalidate(bb, INVALIDATE_REASON_STALE)) retire(bb);
+    return false;
+}
+
+//
+// Each BB remembers the BBs fetched after it on its taken and not taken
+// paths, so fetch usually finds the next BB without probing the hash
+// table. Links hold no reference: all of them are dropped when any BB
+// is freed by bumping bbcache_link_generation.
+//
+static inline BasicBlock* follow_link(BasicBlock* prev, const RIPVirtPhys& rvp) {
+    if unlikely (prev->link_generation != bbcache_link_generation) return NULL;
+
+    foreach (i, 2) {
+        BasicBlock* next = prev->successors[i];
+        if (next && HashtableKeyManager<RIPVirtPhys, BB_CACHE_SIZE>::equal(next->rip, rvp) &&
+                (next->flush_epoch == bbcache_flush_epoch))
+            return next;
+    }
+
+    return NULL;
+}
+
+static inline void link_successor(BasicBlock* prev, BasicBlock* bb) {
+    if unlikely (prev->link_generation != bbcache_link_generation) {
+        prev->successors[0] = NULL;
+        prev->successors[1] = NULL;
+        prev->link_generation = bbcache_link_generation;
+    }
+
+    prev->successors[(bb->rip.rip == prev->rip_taken) ? 0 : 1] = bb;
+}
+
+//
+// Find an already translated basic block. prev is the BB fetched before
+// it, if any; the caller may already have released it, as it is only
+// freed here if it is also the stale BB being looked up.
+//
+BasicBlock* BasicBlockCache::lookup(Context& ctx, const RIPVirtPhys& rvp, BasicBlock* prev) {
+    BasicBlock* bb;
+
+    if likely (prev) {
+        bb = follow_link(prev, rvp);
+        if likely (bb) {
+            DECODERSTAT->link_hits++;
+            return bb;
+        }
+    }
+
+    if likely (!config.shared_bbcache || this == &shared_bbcache) {
+        bb = get(rvp);
+        if (bb && !revalidate(ctx, bb, rvp)) bb = NULL;
+    } else {
+        RIPVirtPhys key = rvp;
+        BasicBlockCache& cache = table_for(ctx, key);
+        bb = cache.get(key);
+        if (bb && !cache.revalidate(ctx, bb, rvp)) bb = NULL;
+
+        if (bb && bb->context_id != ctx.cpu_index)
+            DECODERSTAT->shared_hits++;
+    }
+
+    if (bb && prev) link_successor(prev, bb);
+
+    return bb;
+}
+
 bool BasicBlockCache::invalidate(BasicBlock* bb, int reason) {
-    BasicBlockChunkList* pagelist;
     if unlikely (bb->refcount) {
         if(logable(8))
             ptl_logfile << "Warning: basic block ", bb, " ", *bb, " is still in use somewhere (refcount ", bb->refcount, ")", endl;
         return false;
     }
 
+    remove_bb(bb, reason);
+    bb->free();
+    return true;
+}
+
+//
+// Take a BB out of its cache and code page lists without freeing it
+//
+void BasicBlockCache::remove_bb(BasicBlock* bb, int reason) {
+    BasicBlockChunkList* pagelist;
+
     if unlikely (bbcache_dump_file) {
         bbcache_dump_file << *bb << endl;
     }
@@ -1708,16 +1877,48 @@ bool BasicBlockCache::invalidate(BasicBlock* bb, int reason) {
         pagelist->remove(bb->mfnhi_loc);
     }
 
-    remove(bb);
-    W64 ct = bbcache[cpuid].count;
+    BasicBlockCache& owner = owner_of(bb);
+    owner.remove(bb);
+    W64 ct = owner.count;
     DECODERSTAT->bbcache.count = ct;
     DECODERSTAT->bbcache.invalidates[reason]++;
 
-    bb->free();
-    return true;
+    account_bb_bytes(bb, false);
+    bbcache_link_generation++;
+}
+
+//
+// A stale BB that a pipeline still holds cannot be freed yet, but it must
+// not be found again or its rip could never be translated. It is removed
+// from the cache and freed by free_retired_bbs() once it is released.
+//
+static dynarray<BasicBlock*> retired_bbs;
+
+void BasicBlockCache::retire(BasicBlock* bb) {
+    remove_bb(bb, INVALIDATE_REASON_STALE);
+    retired_bbs.push(bb);
+}
+
+static void free_retired_bbs() {
+    int n = 0;
+
+    foreach (i, retired_bbs.length) {
+        BasicBlock* bb = retired_bbs[i];
+        if (bb->refcount) retired_bbs[n++] = bb; else bb->free();
+    }
+
+    retired_bbs.resize(n);
 }
 
 bool BasicBlockCache::invalidate(const RIPVirtPhys& rvp, int reason) {
+    if unlikely (config.shared_bbcache && this != &shared_bbcache) {
+        BasicBlock* bb = shared_bbcache.get(rvp);
+        if (bb) {
+            shared_bbcache.cpuid = cpuid;
+            return shared_bbcache.invalidate(bb, reason);
+        }
+    }
+
     BasicBlock* bb = get(rvp);
     // BasicBlock* bb = get(rvp.rip);
     if (!bb) return true;
@@ -1761,11 +1962,16 @@ bool BasicBlockCache::invalidate_page(Waddr mfn, int reason) {
     //
     if unlikely (mfn == RIPVirtPhys::INVALID) return 0;
 
+    if unlikely (config.shared_bbcache && this != &shared_bbcache) {
+        shared_bbcache.cpuid = cpuid;
+        return shared_bbcache.invalidate_page(mfn, reason);
+    }
+
     BasicBlockChunkList* pagelist = bbpages.get(mfn);
 
     if (logable(3) | log_code_page_ops) ptl_logfile << "Invalidate page mfn ", mfn, ": pagelist ", pagelist, " has ", (pagelist ? pagelist->count() : 0), " entries", endl; // (dirty? ", smc_isdirty(mfn), ")", endl;
 
-    smc_cleardirty(mfn);
+    smc_cleardirty(mfn << 12);
 
     if unlikely (!pagelist) return 0;
 
@@ -1775,7 +1981,7 @@ bool BasicBlockCache::invalidate_page(Waddr mfn, int reason) {
     while ((entry = iter.next())) {
         BasicBlock* bb = *entry;
         if (logable(3) | log_code_page_ops) ptl_logfile << "  Invalidate bb ", bb, " (", bb->rip, ", ", bb->bytes, " bytes)", endl;
-        if unlikely (!bbcache[cpuid].invalidate(bb, reason)) {
+        if unlikely (!invalidate(bb, reason)) {
             if (logable(3) | log_code_page_ops) ptl_logfile << "  Could not invalidate bb ", bb, " (", bb->rip, ", ", bb->bytes, " bytes): still has refcount ", bb->refcount, endl;
             return false;
         }
@@ -2330,6 +2536,14 @@ ostream& printflags(ostream& os, W64 flags) {
 // references to some of the basic blocks.
 //
 BasicBlock* BasicBlockCache::translate(Context& ctx, const RIPVirtPhys& rvp) {
+    if likely (!config.shared_bbcache || this == &shared_bbcache)
+        return translate_and_add(ctx, rvp);
+
+    RIPVirtPhys key = rvp;
+    return table_for(ctx, key).translate_and_add(ctx, key);
+}
+
+BasicBlock* BasicBlockCache::translate_and_add(Context& ctx, const RIPVirtPhys& rvp) {
     if unlikely ((rvp.rip == config.start_log_at_rip) && (rvp.rip != 0xffffffffffffffffULL)) {
         config.start_log_at_iteration = 0;
         logenable = 1;
@@ -2348,10 +2562,12 @@ BasicBlock* BasicBlockCache::translate(Context& ctx, const RIPVirtPhys& rvp) {
        */
 
     BasicBlock* bb = get(rvp);
-    if likely (bb && bb->context_id == ctx.cpu_index) {
-        return bb;
+    if likely (bb && (this == &shared_bbcache || bb->context_id == ctx.cpu_index)) {
+        if likely (revalidate(ctx, bb, rvp)) return bb;
     }
 
+    if unlikely (retired_bbs.length) free_retired_bbs();
+
     bb = NULL;
 
     translate_timer.start();
@@ -2376,17 +2592,30 @@ BasicBlock* BasicBlockCache::translate(Context& ctx, const RIPVirtPhys& rvp) {
         assert(trans.valid_byte_count == 0);
     }
 
-    for (;;) {
-        if (!trans.translate()) break;
-    }
+    bb = bbcache_file_lookup(trans, insnbuf);
+    bool from_file = (bb != NULL);
 
-    if(trans.handle_exec_fault) {
-        return NULL;
+    if likely (!from_file) {
+        for (;;) {
+            if (!trans.translate()) break;
+        }
+
+        if(trans.handle_exec_fault) {
+            return NULL;
+        }
+
+        trans.bb.hitcount = 0;
+        trans.bb.predcount = 0;
+        trans.bb.code_crc = CRC32().update(insnbuf, min((int)trans.bb.bytes, MAX_BB_BYTES));
+        bb = trans.bb.clone();
+        bbcache_file_store(trans, bb);
     }
 
-    trans.bb.hitcount = 0;
-    trans.bb.predcount = 0;
-    bb = trans.bb.clone();
+    bb->flush_epoch = bbcache_flush_epoch;
+
+    // Bind uop implementations now rather than on first fetch
+    synth_uops_for_bb(*bb);
+
     //
     // Acquire a reference to the new basic block right away,
     // since we make allocations below that might reclaim it
@@ -2398,7 +2627,8 @@ BasicBlock* BasicBlockCache::translate(Context& ctx, const RIPVirtPhys& rvp) {
     W64 ct = this->count;
     DECODERSTAT->bbcache.count = ct;
     DECODERSTAT->bbcache.inserts++;
-    DECODERSTAT->throughput.basic_blocks++;
+    if unlikely (from_file) DECODERSTAT->file_hits++;
+    else DECODERSTAT->throughput.basic_blocks++;
 
     BasicBlockChunkList* pagelist;
 
@@ -2451,6 +2681,7 @@ BasicBlock* BasicBlockCache::translate(Context& ctx, const RIPVirtPhys& rvp) {
     }
 
     bb->context_id = ctx.cpu_index;
+    account_bb_bytes(bb, true);
 
     translate_timer.stop();
 
@@ -2552,15 +2783,28 @@ ostream& BasicBlockCache::print(ostream& os) {
 }
 
 void bbcache_reclaim(size_t bytes, int urgency) {
+    shared_bbcache.reclaim(bytes, urgency);
     foreach(i, NUM_SIM_CORES) {
         bbcache[i].reclaim(bytes, urgency);
     }
 }
 
+//
+// Flush the shared BB cache, counting its stats to the flushing core
+//
+void flush_shared_bbcache(int8_t context_id) {
+    if likely (!shared_bbcache.count) return;
+
+    shared_bbcache.cpuid = (context_id < 0) ? 0 : context_id;
+    shared_bbcache.flush(context_id);
+}
+
 void init_decode() {
 }
 
 void shutdown_decode() {
+    bbcache_file_save();
+    flush_shared_bbcache(0);
     foreach(i, NUM_SIM_CORES) {
         bbcache[i].flush(0);
     }
@@ -2568,8 +2812,9 @@ void shutdown_decode() {
 }
 
 void dump_bbcache_to_logfile() {
-    foreach(i, NUM_SIM_CORES) {
-        BasicBlockCache::Iterator iter(&bbcache[i]);
+    foreach(i, NUM_SIM_CORES + 1) {
+        BasicBlockCache& cache = (i < NUM_SIM_CORES) ? bbcache[i] : shared_bbcache;
+        BasicBlockCache::Iterator iter(&cache);
         BasicBlock* bb;
         while ((bb = iter.next())) {
             ptl_logfile << "BasicBlock: ", *bb, endl;
@@ -597,7 +597,15 @@ namespace superstl {
       return slot;
     }
 
-    static inline bool equal(const RIPVirtPhys& a, const RIPVirtPhys& b) { return (a == b); }
+    //
+    // Physical page of the first byte is part of the key so the shared
+    // BB cache never returns code of another address space. In per-core
+    // caches mfnlo is always 0, so only rip is compared.
+    //
+    static inline bool equal(const RIPVirtPhys& a, const RIPVirtPhys& b) {
+      return (a == b) && (a.mfnlo == b.mfnlo);
+    }
+
     static inline RIPVirtPhys dup(const RIPVirtPhys& key) { return key; }
     static inline void free(RIPVirtPhys& key) { }
   };
@@ -624,14 +632,30 @@ enum {
   INVALIDATE_REASON_RECLAIM,
   INVALIDATE_REASON_DIRTY,
   INVALIDATE_REASON_EMPTY,
+  INVALIDATE_REASON_STALE,
   INVALIDATE_REASON_COUNT
 };
 
+//
+// With -shared-bbcache the per-core caches only act as handles to the
+// single shared_bbcache: lookups, translations and invalidations are
+// forwarded to it and its decoder stats are counted to the requesting
+// core. Basic blocks are immutable once translated and are kept alive
+// by their refcount while any core's pipeline uses them. Blocks whose
+// code page has no physical address (MMIO) stay in the per-core cache.
+//
 struct BasicBlockCache: public SelfHashtable<RIPVirtPhys, BasicBlock, BB_CACHE_SIZE, BasicBlockHashtableLinkManager> {
   BasicBlockCache(): SelfHashtable<RIPVirtPhys, BasicBlock, BB_CACHE_SIZE, BasicBlockHashtableLinkManager>() {
       cpuid = cpuid_counter++;
+      bytes = 0;
+  }
+
+  BasicBlockCache(W8 cpuid): SelfHashtable<RIPVirtPhys, BasicBlock, BB_CACHE_SIZE, BasicBlockHashtableLinkManager>() {
+      this->cpuid = cpuid;
+      bytes = 0;
   }
 
+  BasicBlock* lookup(Context& ctx, const RIPVirtPhys& rvp, BasicBlock* prev = NULL);
   BasicBlock* translate(Context& ctx, const RIPVirtPhys& rvp);
   void translate_in_place(BasicBlock& targetbb, Context& ctx, Waddr rip);
   BasicBlock* translate_and_clone(Context& ctx, Waddr rip);
@@ -645,10 +669,35 @@ struct BasicBlockCache: public SelfHashtable<RIPVirtPhys, BasicBlock, BB_CACHE_S
   W8 cpuid;
   static W8 cpuid_counter;
 
+  // Bytes of translated BBs owned by this core
+  W64 bytes;
+
   ostream& print(ostream& os);
+
+private:
+  BasicBlockCache& table_for(Context& ctx, RIPVirtPhys& rvp);
+  BasicBlockCache& owner_of(BasicBlock* bb);
+  bool revalidate(Context& ctx, BasicBlock* bb, const RIPVirtPhys& rvp);
+  void remove_bb(BasicBlock* bb, int reason);
+  void retire(BasicBlock* bb);
+  BasicBlock* translate_and_add(Context& ctx, const RIPVirtPhys& rvp);
 };
 
 extern BasicBlockCache bbcache[NUM_SIM_CORES];
+extern BasicBlockCache shared_bbcache;
+
+void flush_shared_bbcache(int8_t context_id);
+
+// Incremented instead of flushing all caches with -lazy-bbcache-flush
+extern W32 bbcache_flush_epoch;
+
+// Incremented when any BB is freed, invalidating all successor links
+extern W32 bbcache_link_generation;
+
+// Persistent file of decoded basic blocks (-bbcache-file)
+BasicBlock* bbcache_file_lookup(const TraceDecoder& trans, const byte* insnbuf);
+void bbcache_file_store(const TraceDecoder& trans, const BasicBlock* bb);
+void bbcache_file_save();
 
 extern ofstream bbcache_dump_file;
 
@@ -657,7 +706,7 @@ static const char* decode_type_names[DECODE_TYPE_COUNT] = {
 };
 
 static const char* invalidate_reason_names[INVALIDATE_REASON_COUNT] = {
-  "smc", "dma", "spurious", "reclaim", "dirty", "empty"
+  "smc", "dma", "spurious", "reclaim", "dirty", "empty", "stale"
 };
 
 /* Decoder Stats */
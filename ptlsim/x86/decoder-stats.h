@@ -67,6 +67,21 @@ struct DecoderStats : public Statable
 
     StatObj<W64> reclaim_rounds;
 
+    /* Size of cached BBs translated by this core */
+    StatObj<W64> bbcache_bytes;
+
+    /* Shared BB cache lookups that found a BB translated by another core */
+    StatObj<W64> shared_hits;
+
+    /* BBs reused after a guest TLB flush with -lazy-bbcache-flush */
+    StatObj<W64> redecodes_avoided;
+
+    /* BBs loaded from -bbcache-file instead of decoded */
+    StatObj<W64> file_hits;
+
+    /* Lookups served by the successor links of the previous BB */
+    StatObj<W64> link_hits;
+
     DecoderStats(Statable *parent)
         : Statable("decode", parent)
           , throughput(this)
@@ -76,6 +91,11 @@ struct DecoderStats : public Statable
           , bbcache("bbcache", this)
           , pagecache("pagecache", this)
           , reclaim_rounds("reclaim_rounds", this)
+          , bbcache_bytes("bbcache_bytes", this)
+          , shared_hits("shared_hits", this)
+          , redecodes_avoided("redecodes_avoided", this)
+          , file_hits("file_hits", this)
+          , link_hits("link_hits", this)
     { }
 };
 
@@ -507,6 +507,8 @@ BasicBlock* BasicBlock::clone() {
   memcpy(bb, this, sizeof(BasicBlockBase));
 
   bb->synthops = NULL;
+  bb->successors[0] = NULL;
+  bb->successors[1] = NULL;
   // hashlink, mfnlo_loc, mfnhi_loc are always updated after cloning
   bb->hashlink.reset();
   bb->use(0);
@@ -243,6 +243,7 @@ static inline const char* exception_name(W64 exception) {
 // The userspace PTLsim only needs the RIP, use64, df, etc.
 //
 struct Context;
+class Stats;
 
 struct RIPVirtPhysBase {
   W64 rip;
@@ -804,6 +805,7 @@ struct Context: public CPUX86State {
   bool use32;
   bool use64;
   bool kernel_mode;
+  Stats* stats; // user_stats or kernel_stats, set by update_mode
   byte running;
   byte dirty; // VCPU was just brought online
   Waddr virt_addr_mask;
@@ -991,6 +993,9 @@ struct Context: public CPUX86State {
 
   W64 virt_to_pte_phys_addr(Waddr virtaddr, byte& level);
 
+  // Physical frame of code at virtaddr from the TLB, or RIPVirtPhys::INVALID
+  Waddr code_mfn(Waddr virtaddr);
+
   void update_mode_count();
   bool check_events() const;
   bool is_int_pending() const;
@@ -1706,6 +1711,12 @@ struct BasicBlockBase {
   W64 lastused;
   W64 lasttarget;
   W16 context_id;
+  W32 code_crc;
+  W32 flush_epoch;
+  // Last fetched successors, valid while link_generation matches
+  // bbcache_link_generation
+  BasicBlock* successors[2];
+  W32 link_generation;
 
   void acquire() {
     refcount++;
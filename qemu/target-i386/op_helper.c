@@ -614,6 +614,40 @@ void helper_simpoint(void)
      * to handle this 'simpoint'. */
     ptl_simpoint_reached(env->cpu_index);
 }
+
+void helper_bbv_interval(void)
+{
+    /* Basic block vector interval is complete, write it out */
+    ptl_bbv_interval_end();
+}
+
+static void warmup_access(target_ulong addr, int is_icache, int is_write)
+{
+    target_phys_addr_t page = cpu_get_phys_page_debug(env, addr);
+
+    /* Not mapped, access itself will raise the page fault */
+    if (page == -1)
+        return;
+
+    ptl_warmup_access(env->cpu_index, addr,
+            page + (addr & ~TARGET_PAGE_MASK), is_icache, is_write);
+}
+
+void helper_warmup_fetch(target_ulong pc)
+{
+    warmup_access(pc, 1, 0);
+}
+
+void helper_warmup_mem(target_ulong addr, uint32_t is_write)
+{
+    warmup_access(addr, 0, is_write);
+}
+
+void helper_warmup_branch(target_ulong ripafter, target_ulong riptaken,
+        target_ulong target)
+{
+    ptl_warmup_branch(env->cpu_index, ripafter, riptaken, target);
+}
 #endif
 
 static inline unsigned int get_sp_mask(unsigned int e2)
@@ -496,9 +496,58 @@ static inline void gen_op_addq_A0_reg_sN(int shift, int reg)
 }
 #endif
 
+#ifdef MARSS_QEMU
+/* Functional warmup (-fast-fwd-warmup): instruction fetches of each cache
+ * line, loads, stores and conditional branches call helpers that update
+ * simulated caches, TLBs and branch predictors. Code is translated again
+ * when warmup is enabled or disabled. */
+#define WARMUP_FETCH_LINE_BITS 6
+
+static target_ulong warmup_fetch_line;
+
+static inline void gen_warmup_mem(TCGv a0, int is_write)
+{
+    if (ptl_warmup_enabled) {
+        TCGv_i32 t0 = tcg_const_i32(is_write);
+        gen_helper_warmup_mem(a0, t0);
+        tcg_temp_free_i32(t0);
+    }
+}
+
+static void gen_warmup_fetch(target_ulong pc, int num_insns)
+{
+    target_ulong line = pc >> WARMUP_FETCH_LINE_BITS;
+
+    if (ptl_warmup_enabled &&
+            (num_insns == 0 || line != warmup_fetch_line)) {
+        TCGv t0 = tcg_const_tl(pc);
+        gen_helper_warmup_fetch(t0);
+        tcg_temp_free(t0);
+        warmup_fetch_line = line;
+    }
+}
+
+static void gen_warmup_branch(DisasContext *s, target_ulong val,
+                              target_ulong next_eip, target_ulong target)
+{
+    if (ptl_warmup_enabled) {
+        TCGv ripafter = tcg_const_tl(s->cs_base + next_eip);
+        TCGv riptaken = tcg_const_tl(s->cs_base + val);
+        TCGv t0 = tcg_const_tl(s->cs_base + target);
+        gen_helper_warmup_branch(ripafter, riptaken, t0);
+        tcg_temp_free(ripafter);
+        tcg_temp_free(riptaken);
+        tcg_temp_free(t0);
+    }
+}
+#endif
+
 static inline void gen_op_lds_T0_A0(int idx)
 {
     int mem_index = (idx >> 2) - 1;
+#ifdef MARSS_QEMU
+    gen_warmup_mem(cpu_A0, 0);
+#endif
     switch(idx & 3) {
     case 0:
         tcg_gen_qemu_ld8s(cpu_T[0], cpu_A0, mem_index);
@@ -516,6 +565,9 @@ static inline void gen_op_lds_T0_A0(int idx)
 static inline void gen_op_ld_v(int idx, TCGv t0, TCGv a0)
 {
     int mem_index = (idx >> 2) - 1;
+#ifdef MARSS_QEMU
+    gen_warmup_mem(a0, 0);
+#endif
     switch(idx & 3) {
     case 0:
         tcg_gen_qemu_ld8u(t0, a0, mem_index);
@@ -555,6 +607,9 @@ static inline void gen_op_ld_T1_A0(int idx)
 static inline void gen_op_st_v(int idx, TCGv t0, TCGv a0)
 {
     int mem_index = (idx >> 2) - 1;
+#ifdef MARSS_QEMU
+    gen_warmup_mem(a0, 1);
+#endif
     switch(idx & 3) {
     case 0:
         tcg_gen_qemu_st8(t0, a0, mem_index);
@@ -2297,9 +2352,15 @@ static inline void gen_jcc(DisasContext *s, int b,
         l1 = gen_new_label();
         gen_jcc1(s, cc_op, b, l1);
         
+#ifdef MARSS_QEMU
+        gen_warmup_branch(s, val, next_eip, next_eip);
+#endif
         gen_goto_tb(s, 0, next_eip);
 
         gen_set_label(l1);
+#ifdef MARSS_QEMU
+        gen_warmup_branch(s, val, next_eip, val);
+#endif
         gen_goto_tb(s, 1, val);
         s->is_jmp = DISAS_TB_JUMP;
     } else {
@@ -2308,10 +2369,16 @@ static inline void gen_jcc(DisasContext *s, int b,
         l2 = gen_new_label();
         gen_jcc1(s, cc_op, b, l1);
 
+#ifdef MARSS_QEMU
+        gen_warmup_branch(s, val, next_eip, next_eip);
+#endif
         gen_jmp_im(next_eip);
         tcg_gen_br(l2);
 
         gen_set_label(l1);
+#ifdef MARSS_QEMU
+        gen_warmup_branch(s, val, next_eip, val);
+#endif
         gen_jmp_im(val);
         gen_set_label(l2);
         gen_eob(s);
@@ -7753,6 +7820,52 @@ static void gen_simpoint_check_end(CPUState* env, DisasContext *dc, int num_insn
         tcg_gen_exit_tb((long)(dc->tb) + 2);
     }
 }
+
+static TCGArg *bbv_count_arg;
+static TCGArg *bbv_left_arg;
+
+/* Basic block vector profiling: add number of instructions of this block
+ * to its counter and to the interval count, which calls
+ * helper_bbv_interval() when the interval is complete. Both constants are
+ * patched in gen_bbv_count_end() once the block size is known. */
+static void gen_bbv_count_start(CPUState *env, target_ulong pc)
+{
+    if (ptl_bbv_enabled) {
+        TCGv_ptr addr;
+        TCGv_i64 count;
+        int done_label;
+
+        done_label = gen_new_label();
+        count = tcg_temp_new_i64();
+
+        addr = tcg_const_ptr((tcg_target_long)ptl_bbv_counter(pc));
+        tcg_gen_ld_i64(count, addr, 0);
+        bbv_count_arg = gen_opparam_ptr + 1;
+        tcg_gen_addi_i64(count, count, 0xdeadbeef);
+        tcg_gen_st_i64(count, addr, 0);
+        tcg_temp_free_ptr(addr);
+
+        addr = tcg_const_ptr((tcg_target_long)&ptl_bbv_insns_left);
+        tcg_gen_ld_i64(count, addr, 0);
+        bbv_left_arg = gen_opparam_ptr + 1;
+        tcg_gen_subi_i64(count, count, 0xdeadbeef);
+        tcg_gen_st_i64(count, addr, 0);
+        tcg_temp_free_ptr(addr);
+
+        tcg_gen_brcondi_i64(TCG_COND_GT, count, 0, done_label);
+        tcg_temp_free_i64(count);
+        gen_helper_bbv_interval();
+        gen_set_label(done_label);
+    }
+}
+
+static void gen_bbv_count_end(CPUState *env, int num_insns)
+{
+    if (ptl_bbv_enabled) {
+        *bbv_count_arg = num_insns;
+        *bbv_left_arg = num_insns;
+    }
+}
 #endif
 
 /* generate intermediate code in gen_opc_buf and gen_opparam_buf for
@@ -7848,6 +7961,7 @@ static inline void gen_intermediate_code_internal(CPUState *env,
     gen_icount_start();
 #ifdef MARSS_QEMU
     gen_simpoint_check_start(env, dc);
+    gen_bbv_count_start(env, pc_start);
 #endif
     for(;;) {
         if (unlikely(!QTAILQ_EMPTY(&env->breakpoints))) {
@@ -7874,6 +7988,9 @@ static inline void gen_intermediate_code_internal(CPUState *env,
         if (num_insns + 1 == max_insns && (tb->cflags & CF_LAST_IO))
             gen_io_start();
 
+#ifdef MARSS_QEMU
+        gen_warmup_fetch(pc_ptr, num_insns);
+#endif
         pc_ptr = disas_insn(dc, pc_ptr);
         num_insns++;
         /* stop translation if indicated */
@@ -7908,6 +8025,7 @@ static inline void gen_intermediate_code_internal(CPUState *env,
         gen_io_end();
 #ifdef MARSS_QEMU
     gen_simpoint_check_end(env, dc, num_insns);
+    gen_bbv_count_end(env, num_insns);
 #endif
     gen_icount_end(tb, num_insns);
     *gen_opc_ptr = INDEX_op_end;
@@ -0,0 +1,145 @@
+# Accuracy Report Plugin
+#
+# Compare IPC and cache miss rates of simulation runs against a reference
+# run of the same checkpoint, e.g. -sync-quantum runs against a strict run:
+#
+#   mstats.py -y --accuracy-report strict.yml quantum_100.yml quantum_1000.yml
+#
+# First file is the reference. Total stats (last document of each file) are
+# used.
+
+import sys
+mstats = sys.modules['__main__']
+
+def find_nodes(node, match, path=""):
+    '''Return (path, node) of all dict nodes for which match(node) is true'''
+    found = []
+    if type(node) != dict:
+        return found
+
+    if match(node):
+        found.append((path, node))
+
+    for key in sorted(node.keys()):
+        if str(key).startswith('_'):
+            continue
+        sub_path = "%s.%s" % (path, key) if path else str(key)
+        found += find_nodes(node[key], match, sub_path)
+
+    return found
+
+def is_thread_commit(node):
+    return 'commit' in node and type(node['commit']) == dict and \
+            'ipc' in node['commit']
+
+def is_cache(node):
+    return 'cpurequest' in node and type(node['cpurequest']) == dict
+
+def cache_miss_ratio(node):
+    count = node['cpurequest']['count']
+    hit = count['hit']
+    t_hit = hit['read']['hit'] + hit['write']['hit'] + \
+            hit['read']['forward'] + hit['write']['forward']
+    t_miss = count['miss']['read'] + count['miss']['write']
+    t_access = t_hit + t_miss
+    if t_access == 0:
+        return None
+    return float(t_miss) / float(t_access)
+
+def get_metrics(stat):
+    '''Collect IPC, miss ratio and late message counts of one stats dump'''
+    metrics = {}
+
+    for path, node in find_nodes(stat, is_thread_commit):
+        metrics["ipc:%s" % path] = float(node['commit']['ipc'])
+
+    late = 0
+    for path, node in find_nodes(stat, is_cache):
+        ratio = cache_miss_ratio(node)
+        if ratio is not None:
+            metrics["miss:%s" % path] = ratio
+        late += node.get('late_coherence', 0)
+
+    metrics['late_coherence'] = late
+
+    try:
+        metrics['seconds'] = float(stat['simulator']['run']['seconds'])
+    except (KeyError, TypeError):
+        pass
+
+    return metrics
+
+def rel_error(ref, val):
+    if ref == 0:
+        return 0.0 if val == 0 else float('inf')
+    return (val - ref) / ref * 100.0
+
+class AccuracyReportWriter(mstats.Writers):
+    '''Print IPC and miss rate error of each run against the first run'''
+
+    def set_options(self, parser):
+        parser.add_option("--accuracy-report", action="store_true",
+                default=False, help="Compare IPC and cache miss rates of " \
+                        "all runs against the first run")
+
+    def total_stats(self, stats):
+        '''Last document of each input file, in order of input files'''
+        files = []
+        totals = {}
+        for stat in stats:
+            name = stat.get('_file', str(len(files)))
+            if name not in totals:
+                files.append(name)
+            totals[name] = stat
+        return [(f, totals[f]) for f in files]
+
+    def report(self, ref_name, ref, name, run):
+        print("%s vs %s:" % (name, ref_name))
+
+        ipc_err = []
+        miss_err = []
+        for key in sorted(ref.keys()):
+            if not (key.startswith('ipc:') or key.startswith('miss:')):
+                continue
+            if key not in run:
+                print("  %-50s missing" % key)
+                continue
+
+            if key.startswith('ipc:'):
+                err = rel_error(ref[key], run[key])
+                ipc_err.append(abs(err))
+                print("  %-50s %10.4f %10.4f %9.2f%%" % (key, ref[key],
+                    run[key], err))
+            else:
+                # Miss rate error is in percentage points
+                err = (run[key] - ref[key]) * 100.0
+                miss_err.append(abs(err))
+                print("  %-50s %9.4f%% %9.4f%% %+8.3fpp" % (key,
+                    ref[key] * 100.0, run[key] * 100.0, err))
+
+        if ipc_err:
+            print("  IPC error          : mean %.2f%% max %.2f%%" % (
+                sum(ipc_err) / len(ipc_err), max(ipc_err)))
+        if miss_err:
+            print("  Miss rate error    : mean %.3fpp max %.3fpp" % (
+                sum(miss_err) / len(miss_err), max(miss_err)))
+        print("  Late coherence msgs: %d" % run['late_coherence'])
+        if run.get('seconds') and ref.get('seconds'):
+            print("  Wall-clock speedup : %.2fx" % (ref['seconds'] /
+                run['seconds']))
+
+    def write(self, stats, options):
+        if not options.accuracy_report:
+            return
+
+        totals = self.total_stats(stats)
+        if len(totals) < 2:
+            print("Accuracy report needs a reference and at least one " \
+                    "more stats file.")
+            return
+
+        ref_name, ref_stat = totals[0]
+        ref = get_metrics(ref_stat)
+
+        for name, stat in totals[1:]:
+            self.report(ref_name, ref, name, get_metrics(stat))
@@ -0,0 +1,186 @@
+# Binary Time Stats Plugin
+#
+# Read time-series stats written with '-time-stats-format binary':
+#
+#   mstats.py --time-stats-bin --time-stats-csv run.tstats > run.csv
+#
+# Each row of the file becomes one stats document, a tree of its counters
+# like YAML stats with 'sim_cycle' and 'time_ns' added, so other plugins
+# (node filter, flatten, ...) work on time stats too. --time-stats-csv
+# prints the rows in the same format as CSV time stats.
+#
+# This file can also be run directly to convert a file to CSV:
+#
+#   python mstats_plugins/time_stats.py run.tstats > run.csv
+
+import struct
+import sys
+
+MAGIC = b"MARSSTS1"
+VERSION = 1
+
+class TimeStatsError(Exception):
+    pass
+
+class TimeStatsFile(object):
+    '''Decoded binary time stats file'''
+
+    def __init__(self, filename):
+        self.filename = filename
+        self.names = []
+        self.is_float = []
+        self.cycles = []
+        self.rows = []
+
+        with open(filename, 'rb') as f:
+            self.data = bytearray(f.read())
+        self.pos = 0
+
+        self.read_header()
+        while self.pos < len(self.data):
+            self.read_block()
+
+        del self.data
+
+    def read(self, fmt):
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise TimeStatsError("%s: truncated file" % self.filename)
+        val = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return val
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise TimeStatsError("%s: truncated file" % self.filename)
+            c = self.data[self.pos]
+            self.pos += 1
+            value |= (c & 0x7f) << shift
+            shift += 7
+            if not (c & 0x80):
+                return value
+
+    def read_header(self):
+        magic = bytes(self.data[0:8])
+        self.pos = 8
+        if magic != MAGIC:
+            raise TimeStatsError("%s: not a binary time stats file" %
+                    self.filename)
+
+        version, count, self.period, self.freq_hz = self.read("<IIQQ")
+        if version != VERSION:
+            raise TimeStatsError("%s: unsupported version %d" %
+                    (self.filename, version))
+
+        for i in range(count):
+            is_float, length = self.read("<BH")
+            name = bytes(self.data[self.pos:self.pos + length]).decode()
+            self.pos += length
+            self.names.append(name)
+            self.is_float.append(is_float != 0)
+
+        self.last_cycle = 0
+        self.last = [0] * count
+
+    def read_block(self):
+        rows = self.varint()
+        first = len(self.rows)
+
+        for r in range(rows):
+            self.last_cycle += self.varint()
+            self.cycles.append(self.last_cycle)
+            self.rows.append([0] * len(self.names))
+
+        for i in range(len(self.names)):
+            for r in range(rows):
+                if self.is_float[i]:
+                    value = self.read("<d")[0]
+                else:
+                    z = self.varint()
+                    delta = (z >> 1) ^ -(z & 1)
+                    # Values are W64 counters, so wrap like the simulator
+                    value = (self.last[i] + delta) & 0xffffffffffffffff
+                    self.last[i] = value
+                self.rows[first + r][i] = value
+
+    def time_ns(self, cycle):
+        return (1e9 / float(self.freq_hz)) * float(cycle)
+
+    def write_csv(self, out):
+        out.write("sim_cycle,time_ns,%s\n" % ",".join(self.names))
+        for cycle, row in zip(self.cycles, self.rows):
+            values = [("%g" % v) if f else str(v)
+                    for v, f in zip(row, self.is_float)]
+            out.write("%d,%g,%s\n" % (cycle, self.time_ns(cycle),
+                ",".join(values)))
+
+    def documents(self, name):
+        '''One stats tree per row'''
+        docs = []
+        for cycle, row in zip(self.cycles, self.rows):
+            doc = {'sim_cycle' : cycle, 'time_ns' : self.time_ns(cycle),
+                    '_file' : self.filename, '_name' : name}
+            for key, value in zip(self.names, row):
+                node = doc
+                path = key.split('.')
+                for p in path[:-1]:
+                    node = node.setdefault(p, {})
+                node[path[-1]] = value
+            docs.append(doc)
+        return docs
+
+mstats = sys.modules['__main__']
+
+if hasattr(mstats, 'Readers'):
+    import os
+
+    class TimeStatsBinReader(mstats.Readers):
+        '''Read binary time stats files'''
+
+        def set_options(self, parser):
+            parser.add_option("--time-stats-bin", action="store_true",
+                    default=False, help="Treat arguments as binary time " \
+                            "stats files (-time-stats-format binary)")
+
+        def read(self, options, args):
+            options.time_stats_files = []
+            if not options.time_stats_bin:
+                return
+
+            docs = []
+            for filename in args:
+                try:
+                    tsf = TimeStatsFile(filename)
+                except TimeStatsError as e:
+                    mstats.error(str(e))
+                options.time_stats_files.append(tsf)
+                docs += tsf.documents(os.path.splitext(filename)[0])
+            return docs
+
+    class TimeStatsCSVWriter(mstats.Writers):
+        '''Print binary time stats in CSV time stats format'''
+
+        def set_options(self, parser):
+            parser.add_option("--time-stats-csv", action="store_true",
+                    default=False, help="Print binary time stats files " \
+                            "as CSV")
+
+        def write(self, stats, options):
+            if not options.time_stats_csv:
+                return
+            for tsf in options.time_stats_files:
+                tsf.write_csv(sys.stdout)
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("usage: %s <binary time stats file>" % sys.argv[0])
+        sys.exit(-1)
+
+    try:
+        TimeStatsFile(sys.argv[1]).write_csv(sys.stdout)
+    except TimeStatsError as e:
+        print("[ERROR] : %s" % str(e))
+        sys.exit(-1)